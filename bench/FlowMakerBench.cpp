@@ -0,0 +1,473 @@
+// Microbenchmarks for the FlowMaker hot paths.
+//
+// Every benchmark runs inside a scratch directory with synthetic data, with the
+// console output of the steps discarded. Results are printed as a table on stderr
+// and written as JSON (stdout, or the file given with --out) so runs can be diffed.
+//
+// Usage: flowmaker_bench [--filter <substring>] [--out <file.json>] [--min-time <seconds>]
+//                        [--max-flows <count>] [--quick]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Flow.h"
+#include "FlowExecutor.h"
+#include "FlowIO.h"
+#include "FlowRecord.h"
+#include "FlowSteps.h"
+#include "FlowStore.h"
+
+using namespace std;
+
+namespace fs = std::filesystem;
+
+// Deterministic generator so every run benchmarks the same data.
+class SyntheticData{
+    private:
+        uint64_t state;
+    public:
+        SyntheticData(uint64_t seed = 0x5EEDF10Full) : state(seed) {}
+
+        uint64_t next(){
+            uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        uint64_t below(uint64_t bound) {return next() % bound;}
+
+        string word(){
+            static const char *const words[] = {"flow", "step", "input", "output", "title", "value", "error", "request",
+                                                "session", "import", "report", "timeout", "user", "record", "column", "sample"};
+            return words[below(sizeof(words) / sizeof(words[0]))];
+        }
+
+        // CSV table of roughly targetBytes with an id, a name, two numbers and a label per row.
+        size_t writeCSV(const string &fileName, size_t targetBytes){
+            ofstream out(fileName);
+            size_t written = 0;
+            size_t rows = 0;
+            while (written < targetBytes){
+                string row = to_string(rows) + "," + word() + "_" + to_string(below(10000)) + "," + to_string(below(1000000)) +
+                             "," + to_string(below(100000) / 100.0) + "," + word() + " " + word() + "\n";
+                out << row;
+                written += row.size();
+                rows++;
+            }
+            return rows;
+        }
+
+        // Log-like text file of roughly targetBytes.
+        size_t writeText(const string &fileName, size_t targetBytes){
+            ofstream out(fileName);
+            size_t written = 0;
+            size_t lines = 0;
+            while (written < targetBytes){
+                string line = "2026-10-18 12:" + to_string(10 + below(50)) + " [" + word() + "] ";
+                size_t words = 4 + below(12);
+                for (size_t i = 0; i < words; ++i){
+                    line += word() + " ";
+                }
+                line += "\n";
+                out << line;
+                written += line.size();
+                lines++;
+            }
+            return lines;
+        }
+};
+
+// Throws away everything written to cout/cerr while alive.
+class ScopedSilence{
+    private:
+        class NullBuffer : public streambuf{
+            protected:
+                int overflow(int c) override {return c;}
+                streamsize xsputn(const char *, streamsize count) override {return count;}
+        };
+        NullBuffer nullBuffer;
+        streambuf *savedCout;
+        streambuf *savedCerr;
+    public:
+        ScopedSilence() : savedCout(cout.rdbuf(&nullBuffer)), savedCerr(cerr.rdbuf(&nullBuffer)) {}
+        ~ScopedSilence(){
+            cout.rdbuf(savedCout);
+            cerr.rdbuf(savedCerr);
+        }
+};
+
+// Flow output that drops everything, so executor runs measure the steps only.
+class DiscardOutput : public FlowOutput{
+    public:
+        void write(const string &) override {}
+        void writeError(const string &) override {}
+};
+
+struct BenchmarkResult{
+    string name;
+    string params;
+    size_t iterations = 0;
+    double meanNs = 0;
+    double medianNs = 0;
+    double minNs = 0;
+    double maxNs = 0;
+    double bytesPerIteration = 0;
+    double itemsPerIteration = 0;
+};
+
+class BenchmarkRunner{
+    private:
+        string filter;
+        double minTimeSeconds;
+        vector<BenchmarkResult> results;
+        ostream &log;
+    public:
+        BenchmarkRunner(const string &filter, double minTimeSeconds, ostream &log) : filter(filter), minTimeSeconds(minTimeSeconds), log(log) {}
+
+        bool enabled(const string &name) const {return filter.empty() || name.find(filter) != string::npos;}
+
+        // Times body() until minTimeSeconds have elapsed (at least three iterations).
+        // setup() runs before every iteration and is not included in the timings.
+        void run(const string &name, const string &params, double bytesPerIteration, double itemsPerIteration,
+                 const function<void()> &body, const function<void()> &setup = nullptr){
+            if (!enabled(name)){
+                return;
+            }
+            vector<double> samples;
+            double total = 0;
+            {
+                ScopedSilence silence;
+                if (setup){
+                    setup();
+                }
+                body();
+                while (samples.size() < 3 || (total < minTimeSeconds * 1e9 && samples.size() < 100000)){
+                    if (setup){
+                        setup();
+                    }
+                    auto start = chrono::steady_clock::now();
+                    body();
+                    auto stop = chrono::steady_clock::now();
+                    double elapsed = chrono::duration<double, nano>(stop - start).count();
+                    samples.push_back(elapsed);
+                    total += elapsed;
+                }
+            }
+
+            sort(samples.begin(), samples.end());
+            BenchmarkResult result;
+            result.name = name;
+            result.params = params;
+            result.iterations = samples.size();
+            result.meanNs = total / samples.size();
+            result.medianNs = samples[samples.size() / 2];
+            result.minNs = samples.front();
+            result.maxNs = samples.back();
+            result.bytesPerIteration = bytesPerIteration;
+            result.itemsPerIteration = itemsPerIteration;
+            results.push_back(result);
+
+            log << left << setw(44) << name << setw(18) << params << right << setw(14) << fixed << setprecision(3)
+                << result.medianNs / 1e6 << " ms";
+            if (bytesPerIteration > 0){
+                log << setw(12) << setprecision(1) << bytesPerIteration / (result.medianNs / 1e9) / 1e6 << " MB/s";
+            }
+            if (itemsPerIteration > 0){
+                log << setw(14) << setprecision(0) << itemsPerIteration / (result.medianNs / 1e9) << " items/s";
+            }
+            log << endl;
+        }
+
+        static string escapeJSON(const string &text){
+            string escaped;
+            for (char ch : text){
+                if (ch == '"' || ch == '\\'){
+                    escaped += '\\';
+                }
+                escaped += ch;
+            }
+            return escaped;
+        }
+
+        void writeJSON(ostream &out) const{
+            time_t now = time(nullptr);
+            char timestamp[32];
+            strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+            out << "{\n  \"context\": {\"date\": \"" << timestamp << "\", \"min_time_s\": " << minTimeSeconds << "},\n";
+            out << "  \"benchmarks\": [\n";
+            for (size_t i = 0; i < results.size(); ++i){
+                const BenchmarkResult &r = results[i];
+                double seconds = r.medianNs / 1e9;
+                out << setprecision(6) << defaultfloat;
+                out << "    {\"name\": \"" << escapeJSON(r.name) << "\", \"params\": \"" << escapeJSON(r.params) << "\""
+                    << ", \"iterations\": " << r.iterations
+                    << ", \"mean_ns\": " << fixed << setprecision(0) << r.meanNs
+                    << ", \"median_ns\": " << r.medianNs
+                    << ", \"min_ns\": " << r.minNs
+                    << ", \"max_ns\": " << r.maxNs
+                    << ", \"bytes_per_iteration\": " << r.bytesPerIteration
+                    << ", \"items_per_iteration\": " << r.itemsPerIteration
+                    << ", \"mb_per_second\": " << setprecision(3) << (r.bytesPerIteration > 0 ? r.bytesPerIteration / seconds / 1e6 : 0.0)
+                    << ", \"items_per_second\": " << setprecision(1) << (r.itemsPerIteration > 0 ? r.itemsPerIteration / seconds : 0.0)
+                    << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+            }
+            out << "  ]\n}\n";
+        }
+};
+
+string flowNameAt(size_t index) {return "Flow " + to_string(index);}
+
+// Flow shaped like the predefined flows, used for the store and executor benchmarks.
+Flow makeSampleFlow(const string &name){
+    Flow flow(name);
+    flow.addStep(new TitleStep());
+    flow.addStep(new TextStep());
+    flow.addStep(new TextInputStep("Input title, subtitle, title text and text"));
+    flow.addStep(new NumberInputStep("Input a number"));
+    flow.addStep(new NumberInputStep("Input a number"));
+    flow.addStep(new CalculusStep<double>(ArithmeticOperation::Addition, '+'));
+    flow.addStep(new DisplayStep());
+    flow.addStep(new TextFileInputStep("Input a .txt file"));
+    flow.addStep(new CSVFileInputStep("Input a .csv file"));
+    flow.addStep(new OutputStep());
+    flow.addStep(new EndStep());
+    return flow;
+}
+
+// Writes flow stores with `count` flows in both the CSV and the binary format.
+void writeFlowStores(size_t count, const string &csvPath, const string &binPath){
+    ofstream csvFile(csvPath);
+    ofstream binFile(binPath, ios::binary);
+    FlowRecordWriter header;
+    header.writeBytes(string(FLOWS_BIN_MAGIC, sizeof(FLOWS_BIN_MAGIC)));
+    header.writeU16(FLOWS_BIN_VERSION);
+    header.writeU16(0);
+    binFile << header.getBuffer();
+
+    Flow sample = makeSampleFlow("sample");
+    string stepList;
+    for (const FlowStep *step : sample.getSteps()){
+        stepList += step->getType() + ",";
+    }
+    for (size_t i = 0; i < count; ++i){
+        Flow flow = makeSampleFlow(flowNameAt(i));
+        csvFile << flow.getName() << ",2026-10-18 12:00:00," << stepList << "\n";
+        binFile << encodeFlowRecord(flow);
+    }
+}
+
+// Answers for every prompt of makeSampleFlow() when it runs through FlowExecutor.
+string sampleFlowAnswers(const string &textFile, const string &csvFile){
+    string script;
+    script += "Y\n";                                   // TitleStep
+    script += "Y\n";                                   // TextStep
+    script += "Y\nTitle\nSubtitle\nText title\nText\n";  // TextInputStep
+    script += "Y\n12\n";                               // NumberInputStep
+    script += "Y\n30\n";                               // NumberInputStep
+    script += "Y\nY\nN\nY\n+\n";                       // CalculusStep: select inputs 4 and 5, then the operation
+    script += "Y\n";                                   // DisplayStep
+    script += "Y\n" + textFile + "\n";                 // TextFileInputStep
+    script += "Y\n" + csvFile + "\n";                  // CSVFileInputStep
+    script += "Y\nbench_report\nReport\nGenerated by the benchmark\n";
+    for (int i = 0; i < 7; ++i){
+        script += "Y\n";                               // OutputStep: include every previous step
+    }
+    return script;
+}
+
+void benchmarkImports(BenchmarkRunner &runner, SyntheticData &data, size_t importBytes){
+    string csvFile = "bench_table.csv";
+    string textFile = "bench_text.txt";
+    size_t rows = data.writeCSV(csvFile, importBytes);
+    size_t lines = data.writeText(textFile, importBytes);
+    double csvBytes = static_cast<double>(fs::file_size(csvFile));
+    double textBytes = static_cast<double>(fs::file_size(textFile));
+
+    runner.run("CSVFileInputStep/parse", "rows=" + to_string(rows), csvBytes, static_cast<double>(rows), [&](){
+        CSVFileInputStep step("bench");
+        step.importFile(csvFile, cout, cerr);
+    });
+
+    runner.run("TextFileInputStep/import", "lines=" + to_string(lines), textBytes, static_cast<double>(lines), [&](){
+        TextFileInputStep step("bench");
+        step.importFile(textFile, cout);
+    });
+}
+
+// Keeps the compiler from discarding results that are otherwise unused.
+volatile double calculationSink;
+
+void benchmarkCalculus(BenchmarkRunner &runner, SyntheticData &data){
+    const ArithmeticOperation operations[] = {ArithmeticOperation::Addition, ArithmeticOperation::Division, ArithmeticOperation::Maximum};
+    const char *operationNames[] = {"add", "div", "max"};
+    for (size_t inputs : {1000, 100000, 1000000}){
+        vector<NumberInputStep> numberInputs(inputs);
+        for (NumberInputStep &numberInput : numberInputs){
+            numberInput.setUserInput(1.0 + static_cast<double>(data.below(1000)));
+        }
+        for (size_t op = 0; op < 3; ++op){
+            CalculusStep<double> step(operations[op], '+');
+            for (NumberInputStep &numberInput : numberInputs){
+                step.addNumberInput(&numberInput);
+            }
+            runner.run(string("CalculusStep/performCalculation/") + operationNames[op], "inputs=" + to_string(inputs), 0, static_cast<double>(inputs), [&](){
+                calculationSink = step.performCalculation();
+            });
+        }
+    }
+}
+
+void benchmarkFlowStore(BenchmarkRunner &runner, size_t maxFlows){
+    for (size_t count : {size_t(1000), size_t(10000), size_t(100000), size_t(1000000)}){
+        if (count > maxFlows){
+            break;
+        }
+        string params = "flows=" + to_string(count);
+        bool needed = runner.enabled("FlowStore/");
+        if (!needed){
+            return;
+        }
+        writeFlowStores(count, "pristine.csv", "pristine.bin");
+        fs::copy_file("pristine.csv", FLOWS_CSV_FILE, fs::copy_options::overwrite_existing);
+        fs::copy_file("pristine.bin", FLOWS_BIN_FILE, fs::copy_options::overwrite_existing);
+        double csvBytes = static_cast<double>(fs::file_size(FLOWS_CSV_FILE));
+        double binBytes = static_cast<double>(fs::file_size(FLOWS_BIN_FILE));
+        string lastFlow = flowNameAt(count - 1);
+        string middleFlow = flowNameAt(count / 2);
+
+        runner.run("FlowStore/readExistingFlowNames", params, csvBytes, static_cast<double>(count), [&](){
+            vector<string> names = readExistingFlowNames();
+            if (names.size() != count){
+                throw runtime_error("unexpected number of flows");
+            }
+        });
+        runner.run("FlowStore/loadFlowFromCSV", params, csvBytes, 1, [&](){
+            Flow flow = loadFlowFromCSV(lastFlow);
+        });
+        runner.run("FlowStore/readExistingFlowNamesFromBinary", params, binBytes, static_cast<double>(count), [&](){
+            vector<string> names = readExistingFlowNamesFromBinary();
+        });
+        runner.run("FlowStore/loadFlowFromBinary", params, binBytes, 1, [&](){
+            Flow flow = loadFlowFromBinary(lastFlow);
+        });
+        runner.run("FlowStore/deleteFlowFromCSV", params, csvBytes, 1, [&](){
+            deleteFlowFromCSV(middleFlow);
+        }, [&](){
+            fs::copy_file("pristine.csv", FLOWS_CSV_FILE, fs::copy_options::overwrite_existing);
+        });
+        runner.run("FlowStore/deleteFlowFromBinary", params, binBytes, 1, [&](){
+            deleteFlowFromBinary(middleFlow);
+        }, [&](){
+            fs::copy_file("pristine.bin", FLOWS_BIN_FILE, fs::copy_options::overwrite_existing);
+        });
+    }
+}
+
+void benchmarkOutput(BenchmarkRunner &runner, SyntheticData &data){
+    for (size_t lines : {1000, 100000}){
+        vector<string> outputData;
+        double bytes = 0;
+        for (size_t i = 0; i < lines; ++i){
+            outputData.push_back("Line " + to_string(i) + ": " + data.word() + " " + data.word() + " " + to_string(data.below(100000)));
+            bytes += outputData.back().size() + 1;
+        }
+        OutputStep step("bench_output", "Benchmark", "Synthetic output");
+        step.setOutputData(outputData);
+        runner.run("OutputStep/write", "lines=" + to_string(lines), bytes, static_cast<double>(lines), [&](){
+            step.setFilename("bench_output");
+            step.execute();
+        }, [&](){
+            fs::remove("bench_output.txt");
+        });
+    }
+}
+
+void benchmarkExecutor(BenchmarkRunner &runner, SyntheticData &data){
+    data.writeCSV("exec_table.csv", 64 * 1024);
+    data.writeText("exec_text.txt", 64 * 1024);
+    string answers = sampleFlowAnswers("exec_text.txt", "exec_table.csv");
+    Flow flow = makeSampleFlow("Executor Benchmark");
+    runner.run("FlowExecutor/executeFlow", "steps=" + to_string(flow.getSteps().size()), 0, static_cast<double>(flow.getSteps().size()), [&](){
+        ScriptedInput input = ScriptedInput::fromText(answers);
+        DiscardOutput output;
+        FlowExecutor executor(flow, input, output);
+        executor.executeFlow();
+    }, [&](){
+        fs::remove("bench_report.txt");
+    });
+}
+
+int main(int argc, char **argv){
+    string filter;
+    string outPath;
+    double minTimeSeconds = 0.5;
+    size_t maxFlows = 1000000;
+    size_t importBytes = 16 * 1024 * 1024;
+
+    for (int i = 1; i < argc; ++i){
+        string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc){
+            filter = argv[++i];
+        }
+        else if (arg == "--out" && i + 1 < argc){
+            outPath = fs::absolute(argv[++i]).string();
+        }
+        else if (arg == "--min-time" && i + 1 < argc){
+            minTimeSeconds = stod(argv[++i]);
+        }
+        else if (arg == "--max-flows" && i + 1 < argc){
+            maxFlows = stoul(argv[++i]);
+        }
+        else if (arg == "--quick"){
+            minTimeSeconds = 0.05;
+            maxFlows = 10000;
+            importBytes = 1024 * 1024;
+        }
+        else{
+            cerr << "Usage: " << argv[0] << " [--filter <substring>] [--out <file.json>] [--min-time <seconds>] [--max-flows <count>] [--quick]" << endl;
+            return 1;
+        }
+    }
+
+    fs::path originalDirectory = fs::current_path();
+    fs::path scratch = fs::temp_directory_path() / ("flowmaker_bench_" + to_string(time(nullptr)));
+    fs::create_directories(scratch);
+    fs::current_path(scratch);
+
+    ostream log(cerr.rdbuf());
+    ostream results(cout.rdbuf());
+    BenchmarkRunner runner(filter, minTimeSeconds, log);
+    SyntheticData data;
+    int status = 0;
+    try{
+        benchmarkImports(runner, data, importBytes);
+        benchmarkCalculus(runner, data);
+        benchmarkFlowStore(runner, maxFlows);
+        benchmarkOutput(runner, data);
+        benchmarkExecutor(runner, data);
+    }catch (const exception &e){
+        log << "Benchmark failed: " << e.what() << endl;
+        status = 1;
+    }
+
+    fs::current_path(originalDirectory);
+    fs::remove_all(scratch);
+
+    if (outPath.empty()){
+        runner.writeJSON(results);
+    }
+    else{
+        ofstream outFile(outPath);
+        runner.writeJSON(outFile);
+    }
+    return status;
+}
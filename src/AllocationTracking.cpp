@@ -0,0 +1,58 @@
+// Heap accounting for the step metrics: replaces the global operator new/delete to
+// count allocations in stepCounters. Only linked into the FlowMaker executable, so
+// that programs embedding the flowmaker library keep their own allocator; an embedder
+// that wants the heap columns filled in can add this file to its own sources.
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+
+#include "FlowMetrics.h"
+
+using namespace std;
+
+static void *trackedAllocate(size_t size){
+    void *pointer = malloc(size == 0 ? 1 : size);
+    if (pointer == nullptr){
+        return nullptr;
+    }
+    int64_t usable = static_cast<int64_t>(malloc_usable_size(pointer));
+    stepCounters.allocations++;
+    stepCounters.allocatedBytes += static_cast<uint64_t>(usable);
+    stepCounters.liveBytes += usable;
+    if (stepCounters.liveBytes > stepCounters.peakLiveBytes){
+        stepCounters.peakLiveBytes = stepCounters.liveBytes;
+    }
+    return pointer;
+}
+
+static void trackedFree(void *pointer){
+    if (pointer != nullptr){
+        stepCounters.liveBytes -= static_cast<int64_t>(malloc_usable_size(pointer));
+        free(pointer);
+    }
+}
+
+void *operator new(size_t size){
+    void *pointer = trackedAllocate(size);
+    if (pointer == nullptr){
+        throw bad_alloc();
+    }
+    return pointer;
+}
+
+void *operator new[](size_t size){
+    void *pointer = trackedAllocate(size);
+    if (pointer == nullptr){
+        throw bad_alloc();
+    }
+    return pointer;
+}
+
+void *operator new(size_t size, const nothrow_t &) noexcept {return trackedAllocate(size);}
+void *operator new[](size_t size, const nothrow_t &) noexcept {return trackedAllocate(size);}
+void operator delete(void *pointer) noexcept {trackedFree(pointer);}
+void operator delete[](void *pointer) noexcept {trackedFree(pointer);}
+void operator delete(void *pointer, size_t) noexcept {trackedFree(pointer);}
+void operator delete[](void *pointer, size_t) noexcept {trackedFree(pointer);}
+void operator delete(void *pointer, const nothrow_t &) noexcept {trackedFree(pointer);}
+void operator delete[](void *pointer, const nothrow_t &) noexcept {trackedFree(pointer);}
@@ -0,0 +1,285 @@
+#include "DisplayPreview.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <random>
+#include <unordered_set>
+
+#include "FlowSteps.h"
+
+using namespace std;
+
+static const size_t PREVIEW_HEAD_ROWS = 10;
+static const size_t PREVIEW_TAIL_ROWS = 5;
+static const size_t PREVIEW_SAMPLE_ROWS = 10;
+// Random rows the column summaries are computed from.
+static const size_t SUMMARY_ROWS = 1000;
+static const size_t PREVIEW_HEAD_LINES = 20;
+static const size_t PREVIEW_TAIL_LINES = 10;
+
+static void printRow(ostream &out, const vector<string> &row){
+    for (const string &cell : row){
+        out << cell << ", ";
+    }
+    out << endl;
+}
+
+static uint64_t rowBytes(const vector<string> &row){
+    uint64_t bytes = 0;
+    for (const string &cell : row){
+        bytes += cell.size();
+    }
+    return bytes;
+}
+
+static bool cellNumber(const string &cell, double &value){
+    const char *begin = cell.data();
+    const char *end = begin + cell.size();
+    while (begin < end && *begin == ' '){
+        begin++;
+    }
+    auto parsed = from_chars(begin, end, value);
+    return begin < end && parsed.ec == errc() && parsed.ptr == end && isfinite(value);
+}
+
+static void summarize(TablePreview &preview, const vector<string> &row){
+    if (preview.columns.size() < row.size()){
+        preview.columns.resize(row.size());
+    }
+    for (size_t column = 0; column < row.size(); ++column){
+        ColumnSummary &summary = preview.columns[column];
+        if (row[column].empty()){
+            continue;
+        }
+        summary.filled++;
+        double value;
+        if (cellNumber(row[column], value)){
+            summary.minimum = summary.numeric == 0 ? value : min(summary.minimum, value);
+            summary.maximum = summary.numeric == 0 ? value : max(summary.maximum, value);
+            summary.numeric++;
+        }
+    }
+    preview.summaryRows++;
+}
+
+// count distinct random numbers from [first, last), sorted (Floyd's algorithm).
+static vector<uint64_t> sampleIndexes(uint64_t first, uint64_t last, size_t count, mt19937_64 &random){
+    uint64_t range = last > first ? last - first : 0;
+    count = static_cast<size_t>(min<uint64_t>(count, range));
+    unordered_set<uint64_t> chosen;
+    for (uint64_t j = range - count; j < range; ++j){
+        uint64_t pick = uniform_int_distribution<uint64_t>(0, j)(random);
+        if (!chosen.insert(pick).second){
+            chosen.insert(j);
+        }
+    }
+    vector<uint64_t> indexes;
+    for (uint64_t index : chosen){
+        indexes.push_back(first + index);
+    }
+    sort(indexes.begin(), indexes.end());
+    return indexes;
+}
+
+static TablePreview previewRowsInMemory(const vector<vector<string>> &rows){
+    TablePreview preview;
+    preview.rowCount = rows.size();
+    // Seeded by the size, so the same table shows the same sample.
+    mt19937_64 random(rows.size());
+    size_t headCount = min<uint64_t>(PREVIEW_HEAD_ROWS, rows.size());
+    size_t tailCount = min<uint64_t>(PREVIEW_TAIL_ROWS, rows.size() - headCount);
+    preview.head.assign(rows.begin(), rows.begin() + headCount);
+    preview.tail.assign(rows.end() - tailCount, rows.end());
+    for (uint64_t index : sampleIndexes(headCount, rows.size() - tailCount, PREVIEW_SAMPLE_ROWS, random)){
+        preview.sample.emplace_back(index, rows[index]);
+    }
+    uint64_t summarizedBytes = 0;
+    for (uint64_t index : sampleIndexes(0, rows.size(), SUMMARY_ROWS, random)){
+        summarize(preview, rows[index]);
+        summarizedBytes += rowBytes(rows[index]);
+    }
+    preview.cellBytes = preview.summaryRows > 0 ? summarizedBytes * rows.size() / preview.summaryRows : 0;
+    preview.bytesEstimated = true;
+    preview.columnCount = preview.columns.size();
+    return preview;
+}
+
+TablePreview previewTable(const TableProducer &table){
+    const vector<vector<string>> *rows = table.getRowsInMemory();
+    if (rows != nullptr && rows->size() > FULL_DISPLAY_ROWS){
+        return previewRowsInMemory(*rows);
+    }
+
+    // One pass: the head, a ring of the last rows and reservoir samples (Algorithm R)
+    // for the shown rows and the summaries.
+    TablePreview preview;
+    mt19937_64 random(table.getRowCount());
+    unique_ptr<RowStream> stream = table.openTable();
+    vector<vector<string>> ring(PREVIEW_TAIL_ROWS);
+    vector<pair<uint64_t, vector<string>>> reservoir;
+    vector<vector<string>> summaryReservoir;
+    vector<string> row;
+    while (stream->next(row)){
+        uint64_t index = preview.rowCount++;
+        preview.cellBytes += rowBytes(row);
+        preview.columnCount = max(preview.columnCount, row.size());
+        if (index < FULL_DISPLAY_ROWS){
+            preview.head.push_back(row);
+        }
+        if (summaryReservoir.size() < SUMMARY_ROWS){
+            summaryReservoir.push_back(row);
+        }
+        else{
+            uint64_t slot = uniform_int_distribution<uint64_t>(0, index)(random);
+            if (slot < SUMMARY_ROWS){
+                summaryReservoir[slot] = row;
+            }
+        }
+        // Rows still in the ring may end up in the tail, so only older ones are sampled.
+        if (index >= PREVIEW_HEAD_ROWS + PREVIEW_TAIL_ROWS){
+            uint64_t candidate = index - PREVIEW_TAIL_ROWS;
+            uint64_t seen = candidate - PREVIEW_HEAD_ROWS;
+            if (reservoir.size() < PREVIEW_SAMPLE_ROWS){
+                reservoir.emplace_back(candidate, ring[candidate % PREVIEW_TAIL_ROWS]);
+            }
+            else{
+                uint64_t slot = uniform_int_distribution<uint64_t>(0, seen)(random);
+                if (slot < PREVIEW_SAMPLE_ROWS){
+                    reservoir[slot] = make_pair(candidate, ring[candidate % PREVIEW_TAIL_ROWS]);
+                }
+            }
+        }
+        ring[index % PREVIEW_TAIL_ROWS] = move(row);
+    }
+    if (preview.rowCount <= FULL_DISPLAY_ROWS){
+        preview.complete = true;
+        return preview;
+    }
+    preview.head.resize(PREVIEW_HEAD_ROWS);
+    for (uint64_t index = preview.rowCount - PREVIEW_TAIL_ROWS; index < preview.rowCount; ++index){
+        preview.tail.push_back(move(ring[index % PREVIEW_TAIL_ROWS]));
+    }
+    sort(reservoir.begin(), reservoir.end(), [](const pair<uint64_t, vector<string>> &a, const pair<uint64_t, vector<string>> &b){
+        return a.first < b.first;
+    });
+    preview.sample = move(reservoir);
+    for (const vector<string> &sampled : summaryReservoir){
+        summarize(preview, sampled);
+    }
+    return preview;
+}
+
+void printTablePreview(ostream &out, const TablePreview &preview){
+    if (preview.complete){
+        for (const vector<string> &row : preview.head){
+            printRow(out, row);
+        }
+        return;
+    }
+    out << "Rows: " << preview.rowCount << ", Columns: " << preview.columnCount << ", Bytes: " << (preview.bytesEstimated ? "about " : "") << preview.cellBytes << endl;
+    out << "First " << preview.head.size() << " rows:" << endl;
+    for (const vector<string> &row : preview.head){
+        printRow(out, row);
+    }
+    if (!preview.sample.empty()){
+        out << preview.sample.size() << " rows sampled at random:" << endl;
+        for (const pair<uint64_t, vector<string>> &sampled : preview.sample){
+            out << "Row " << sampled.first + 1 << ": ";
+            printRow(out, sampled.second);
+        }
+    }
+    out << "Last " << preview.tail.size() << " rows:" << endl;
+    for (const vector<string> &row : preview.tail){
+        printRow(out, row);
+    }
+    out << "Columns over " << preview.summaryRows << " sampled rows:" << endl;
+    for (size_t column = 0; column < preview.columns.size(); ++column){
+        const ColumnSummary &summary = preview.columns[column];
+        out << "Column " << column + 1 << ": " << summary.filled * 100 / preview.summaryRows << "% filled, " << summary.numeric * 100 / preview.summaryRows << "% numbers";
+        if (summary.numeric > 0){
+            out << " (" << summary.minimum << " to " << summary.maximum << ")";
+        }
+        out << endl;
+    }
+}
+
+void printTablePage(ostream &out, const TableProducer &table, uint64_t first, size_t count){
+    const vector<vector<string>> *rows = table.getRowsInMemory();
+    if (rows != nullptr){
+        for (uint64_t index = first; index < rows->size() && index < first + count; ++index){
+            out << "Row " << index + 1 << ": ";
+            printRow(out, (*rows)[index]);
+        }
+        return;
+    }
+    unique_ptr<RowStream> stream = table.openTable();
+    vector<string> row;
+    for (uint64_t index = 0; index < first + count && stream->next(row); ++index){
+        if (index >= first){
+            out << "Row " << index + 1 << ": ";
+            printRow(out, row);
+        }
+    }
+}
+
+bool printTextPreview(ostream &out, const string &text, const LineIndex &index){
+    size_t lineCount = index.getLineCount();
+    if (lineCount <= FULL_DISPLAY_LINES && text.size() <= FULL_DISPLAY_BYTES){
+        out << text << endl;
+        return true;
+    }
+    out << "Lines: " << lineCount << ", Bytes: " << text.size() << endl;
+    pair<uint64_t, uint64_t> head = index.getLineRange(0, PREVIEW_HEAD_LINES);
+    size_t tailLines = min(PREVIEW_TAIL_LINES, lineCount - min(PREVIEW_HEAD_LINES, lineCount));
+    pair<uint64_t, uint64_t> tail = index.getLineRange(lineCount - tailLines, tailLines);
+    out << "First lines:" << endl;
+    out.write(text.data() + head.first, head.second - head.first);
+    out << endl;
+    if (tailLines == 0){
+        return true;
+    }
+    out << "..." << endl;
+    out << "Last lines:" << endl;
+    out.write(text.data() + tail.first, tail.second - tail.first);
+    out << endl;
+    return false;
+}
+
+void printTextPage(ostream &out, const string &text, const LineIndex &index, uint64_t first, size_t count){
+    for (uint64_t line = first; line < index.getLineCount() && line < first + count; ++line){
+        out << line + 1 << ": ";
+        out.write(text.data() + index.getLineStart(line), index.getLineEnd(line) - index.getLineStart(line));
+        out << endl;
+    }
+}
+
+static void printMatch(ostream &out, const SearchMatch &match){
+    out << match.fileName << ":" << match.line << ": " << match.text << endl;
+}
+
+bool printMatchesPreview(ostream &out, const vector<SearchMatch> &matches){
+    if (matches.size() <= FULL_DISPLAY_LINES){
+        for (const SearchMatch &match : matches){
+            printMatch(out, match);
+        }
+        return true;
+    }
+    out << "First matches:" << endl;
+    for (size_t i = 0; i < PREVIEW_HEAD_LINES; ++i){
+        printMatch(out, matches[i]);
+    }
+    out << "..." << endl;
+    out << "Last matches:" << endl;
+    for (size_t i = matches.size() - PREVIEW_TAIL_LINES; i < matches.size(); ++i){
+        printMatch(out, matches[i]);
+    }
+    return false;
+}
+
+void printMatchesPage(ostream &out, const vector<SearchMatch> &matches, uint64_t first, size_t count){
+    for (uint64_t i = first; i < matches.size() && i < first + count; ++i){
+        out << i + 1 << ". ";
+        printMatch(out, matches[i]);
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef FLOWMAKER_DISPLAY_PREVIEW_H
+#define FLOWMAKER_DISPLAY_PREVIEW_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "LineIndex.h"
+#include "RowStream.h"
+
+struct SearchMatch;
+
+// What DisplayStep prints of large tables, texts and search results: a bounded preview instead of
+// every row, with explicit paging for the rest.
+
+// Tables of up to this many rows, and texts of up to this many lines and bytes (or
+// searches with up to that many matching lines), are still printed whole.
+static const size_t FULL_DISPLAY_ROWS = 50;
+static const size_t FULL_DISPLAY_LINES = 200;
+static const size_t FULL_DISPLAY_BYTES = 64 * 1024;
+// Rows or lines printed per page.
+static const size_t DISPLAY_PAGE_ROWS = 20;
+
+// Share of the cells of a column that are filled or numbers, over the summarized rows.
+struct ColumnSummary{
+    uint64_t filled = 0;
+    uint64_t numeric = 0;
+    double minimum = 0;
+    double maximum = 0;
+};
+
+struct TablePreview{
+    uint64_t rowCount = 0;
+    size_t columnCount = 0;
+    // Bytes of all cells; estimated from the summarized rows for tables in memory.
+    uint64_t cellBytes = 0;
+    bool bytesEstimated = false;
+    // Set if head holds every row and nothing else was collected.
+    bool complete = false;
+    std::vector<std::vector<std::string>> head;
+    // Random rows between head and tail, with their 0-based row numbers.
+    std::vector<std::pair<uint64_t, std::vector<std::string>>> sample;
+    std::vector<std::vector<std::string>> tail;
+    uint64_t summaryRows = 0;
+    std::vector<ColumnSummary> columns;
+};
+
+// Collects the preview of a table. Tables kept in memory are sampled directly, so
+// the cost does not depend on their size; other tables are read once, without
+// keeping more than the preview and a reservoir sample.
+TablePreview previewTable(const TableProducer &table);
+void printTablePreview(std::ostream &out, const TablePreview &preview);
+// Prints count rows from first (0-based). In-memory tables are indexed directly;
+// other tables are read up to the page.
+void printTablePage(std::ostream &out, const TableProducer &table, uint64_t first, size_t count);
+
+// Prints text whole if it is small, otherwise its first and last lines and totals.
+// Returns false if lines were left out.
+bool printTextPreview(std::ostream &out, const std::string &text, const LineIndex &index);
+void printTextPage(std::ostream &out, const std::string &text, const LineIndex &index, uint64_t first, size_t count);
+
+// Prints the matching lines of a search whole if there are few, otherwise the first
+// and last of them. Returns false if matches were left out.
+bool printMatchesPreview(std::ostream &out, const std::vector<SearchMatch> &matches);
+void printMatchesPage(std::ostream &out, const std::vector<SearchMatch> &matches, uint64_t first, size_t count);
+
+#endif
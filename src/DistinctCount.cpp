@@ -0,0 +1,197 @@
+#include "DistinctCount.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+
+#include "FlowTrace.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+// Cells handed to each pool thread per batch.
+static const size_t BATCH_CELLS_PER_THREAD = 65536;
+
+static const uint64_t HASH_SECRET[4] = {0xa0761d6478bd642full, 0xe7037ed1a0b428dbull, 0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull};
+
+static inline uint64_t multiplyMix(uint64_t a, uint64_t b){
+    unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+}
+
+static inline uint64_t read64(const char *data){
+    uint64_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+// Up to 8 bytes, zero-padded.
+static inline uint64_t readTail(const char *data, size_t size){
+    uint64_t value = 0;
+    memcpy(&value, data, size);
+    return value;
+}
+
+uint64_t hashCell(const char *data, size_t size){
+    uint64_t seed = HASH_SECRET[0] ^ multiplyMix(size ^ HASH_SECRET[1], HASH_SECRET[2]);
+    size_t remaining = size;
+    while (remaining > 16){
+        seed = multiplyMix(read64(data) ^ HASH_SECRET[1], read64(data + 8) ^ seed);
+        data += 16;
+        remaining -= 16;
+    }
+    uint64_t a;
+    uint64_t b;
+    if (remaining > 8){
+        a = read64(data);
+        b = readTail(data + 8, remaining - 8);
+    }
+    else{
+        a = readTail(data, remaining);
+        b = 0;
+    }
+    return multiplyMix(HASH_SECRET[1] ^ size, multiplyMix(a ^ HASH_SECRET[1], b ^ seed ^ HASH_SECRET[3]));
+}
+
+HyperLogLog::HyperLogLog(unsigned precision) : precision(precision){
+    if (precision < MIN_PRECISION || precision > MAX_PRECISION){
+        throw invalid_argument("the precision must be from " + to_string(MIN_PRECISION) + " to " + to_string(MAX_PRECISION));
+    }
+    registers.assign(size_t(1) << precision, 0);
+}
+
+void HyperLogLog::merge(const HyperLogLog &other){
+    if (other.precision != precision){
+        throw invalid_argument("cannot merge sketches of different precision");
+    }
+    for (size_t i = 0; i < registers.size(); ++i){
+        registers[i] = max(registers[i], other.registers[i]);
+    }
+}
+
+// sigma and tau of Ertl, "New cardinality estimation algorithms for HyperLogLog
+// sketches" (2017), correcting for empty and saturated registers.
+static double sigma(double x){
+    if (x == 1){
+        return numeric_limits<double>::infinity();
+    }
+    double y = 1;
+    double z = x;
+    double previous;
+    do{
+        x *= x;
+        previous = z;
+        z += x * y;
+        y += y;
+    }while (z != previous);
+    return z;
+}
+
+static double tau(double x){
+    if (x == 0 || x == 1){
+        return 0;
+    }
+    double y = 1;
+    double z = 1 - x;
+    double previous;
+    do{
+        x = sqrt(x);
+        previous = z;
+        y *= 0.5;
+        z -= (1 - x) * (1 - x) * y;
+    }while (z != previous);
+    return z / 3;
+}
+
+double HyperLogLog::estimate() const{
+    unsigned maxRank = 64 - precision + 1;
+    vector<uint64_t> histogram(maxRank + 1, 0);
+    for (uint8_t value : registers){
+        histogram[value]++;
+    }
+    double m = static_cast<double>(registers.size());
+    double z = m * tau(1 - histogram[maxRank] / m);
+    for (unsigned k = maxRank - 1; k >= 1; --k){
+        z = 0.5 * (z + histogram[k]);
+    }
+    z += m * sigma(histogram[0] / m);
+    return m * m / (2 * log(2)) / z;
+}
+
+double HyperLogLog::getStandardError() const{
+    return 1.04 / sqrt(static_cast<double>(registers.size()));
+}
+
+DistinctCountResult countDistinct(RowStream &rows, size_t column, unsigned precision, bool exact){
+    size_t threads = computePool().getThreadCount();
+    vector<HyperLogLog> sketches;
+    vector<unordered_set<string>> sets;
+    if (exact){
+        sets.resize(threads);
+    }
+    else{
+        sketches.assign(threads, HyperLogLog(precision));
+    }
+    vector<string> batch;
+    batch.reserve(threads * BATCH_CELLS_PER_THREAD);
+    DistinctCountResult result;
+    result.exact = exact;
+
+    auto countBatch = [&]{
+        FLOW_TRACE_SCOPE("distinct", "count batch", to_string(batch.size()) + " cells");
+        size_t slice = (batch.size() + threads - 1) / threads;
+        computePool().runBatch(threads, [&](size_t thread){
+            size_t last = min(batch.size(), (thread + 1) * slice);
+            for (size_t i = thread * slice; i < last; ++i){
+                if (exact){
+                    sets[thread].insert(move(batch[i]));
+                }
+                else{
+                    sketches[thread].addHash(hashCell(batch[i].data(), batch[i].size()));
+                }
+            }
+        });
+        result.values += batch.size();
+        batch.clear();
+    };
+
+    vector<string> row;
+    while (rows.next(row)){
+        if (column >= row.size()){
+            result.missing++;
+            continue;
+        }
+        batch.push_back(move(row[column]));
+        if (batch.size() == batch.capacity()){
+            countBatch();
+        }
+    }
+    if (!batch.empty()){
+        countBatch();
+    }
+
+    FLOW_TRACE_SCOPE("distinct", "merge", to_string(threads) + " per-thread counts");
+    if (exact){
+        auto largest = max_element(sets.begin(), sets.end(), [](const unordered_set<string> &a, const unordered_set<string> &b){
+            return a.size() < b.size();
+        });
+        unordered_set<string> merged = move(*largest);
+        largest->clear();
+        for (unordered_set<string> &set : sets){
+            merged.merge(set);
+        }
+        result.distinct = merged.size();
+    }
+    else{
+        for (size_t thread = 1; thread < threads; ++thread){
+            sketches[0].merge(sketches[thread]);
+        }
+        result.distinct = static_cast<uint64_t>(llround(sketches[0].estimate()));
+        result.standardError = sketches[0].getStandardError();
+    }
+    return result;
+}
@@ -0,0 +1,357 @@
+#include "ExternalSort.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+
+#include <unistd.h>
+
+#include "FlowMetrics.h"
+#include "FlowTrace.h"
+#include "RowFile.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+// Most runs merged at once; more are first merged into longer runs.
+static const size_t MAX_MERGE_FAN_IN = 64;
+// Below this many rows a buffer is sorted on the calling thread.
+static const size_t PARALLEL_SORT_THRESHOLD = 16384;
+
+static atomic<size_t> defaultMemoryBudget(ExternalSorter::DEFAULT_MEMORY_BUDGET);
+
+void ExternalSorter::setDefaultMemoryBudget(size_t bytes){
+    defaultMemoryBudget = bytes;
+}
+
+size_t ExternalSorter::getDefaultMemoryBudget(){
+    return defaultMemoryBudget;
+}
+
+static string trim(const string &text){
+    size_t first = text.find_first_not_of(" \t");
+    if (first == string::npos){
+        return "";
+    }
+    size_t last = text.find_last_not_of(" \t");
+    return text.substr(first, last - first + 1);
+}
+
+bool parseSortKeys(const string &spec, vector<SortKey> &keys){
+    keys.clear();
+    size_t start = 0;
+    while (start <= spec.size()){
+        size_t comma = spec.find(',', start);
+        string item = spec.substr(start, comma == string::npos ? string::npos : comma - start);
+        start = comma == string::npos ? spec.size() + 1 : comma + 1;
+
+        vector<string> parts;
+        size_t partStart = 0;
+        while (true){
+            size_t colon = item.find(':', partStart);
+            parts.push_back(trim(item.substr(partStart, colon == string::npos ? string::npos : colon - partStart)));
+            if (colon == string::npos){
+                break;
+            }
+            partStart = colon + 1;
+        }
+        if (parts[0].empty() || parts[0].find_first_not_of("0123456789") != string::npos){
+            return false;
+        }
+        SortKey key;
+        key.column = strtoul(parts[0].c_str(), nullptr, 10);
+        if (key.column == 0){
+            return false;
+        }
+        key.column--;
+        for (size_t i = 1; i < parts.size(); ++i){
+            if (parts[i] == "num"){
+                key.numeric = true;
+            }
+            else if (parts[i] == "text"){
+                key.numeric = false;
+            }
+            else if (parts[i] == "desc"){
+                key.descending = true;
+            }
+            else if (parts[i] == "asc"){
+                key.descending = false;
+            }
+            else{
+                return false;
+            }
+        }
+        keys.push_back(key);
+    }
+    return !keys.empty();
+}
+
+// Cells that are not numbers parse to NaN.
+static double parseNumber(const string &cell){
+    const char *begin = cell.data();
+    const char *end = begin + cell.size();
+    while (begin < end && (*begin == ' ' || *begin == '\t')){
+        ++begin;
+    }
+    while (end > begin && (end[-1] == ' ' || end[-1] == '\t')){
+        --end;
+    }
+    if (begin < end && *begin == '+'){
+        ++begin;
+    }
+    double value = 0;
+    from_chars_result parsed = from_chars(begin, end, value);
+    if (parsed.ec != errc() || parsed.ptr != end){
+        return numeric_limits<double>::quiet_NaN();
+    }
+    return value;
+}
+
+static void parseKeys(SortRecord &record, const vector<SortKey> &keys){
+    record.numbers.clear();
+    for (const SortKey &key : keys){
+        if (key.numeric){
+            record.numbers.push_back(key.column < record.cells.size() ? parseNumber(record.cells[key.column]) : numeric_limits<double>::quiet_NaN());
+        }
+    }
+}
+
+static const string &cellAt(const SortRecord &record, size_t column){
+    static const string empty;
+    return column < record.cells.size() ? record.cells[column] : empty;
+}
+
+static int compareRecords(const SortRecord &a, const SortRecord &b, const vector<SortKey> &keys){
+    size_t number = 0;
+    for (const SortKey &key : keys){
+        int order = 0;
+        if (key.numeric){
+            double x = a.numbers[number];
+            double y = b.numbers[number];
+            number++;
+            bool xMissing = isnan(x);
+            bool yMissing = isnan(y);
+            if (xMissing != yMissing){
+                // Not flipped for descending keys: cells that are not numbers stay last.
+                return xMissing ? 1 : -1;
+            }
+            if (xMissing){
+                order = cellAt(a, key.column).compare(cellAt(b, key.column));
+            }
+            else{
+                order = x < y ? -1 : (x > y ? 1 : 0);
+            }
+        }
+        else{
+            order = cellAt(a, key.column).compare(cellAt(b, key.column));
+        }
+        if (order != 0){
+            return key.descending ? (order < 0 ? 1 : -1) : (order < 0 ? -1 : 1);
+        }
+    }
+    return 0;
+}
+
+// Rough heap footprint of a buffered row, for the memory budget.
+static size_t recordBytes(const SortRecord &record){
+    size_t bytes = sizeof(SortRecord) + record.cells.capacity() * sizeof(string) + record.numbers.capacity() * sizeof(double);
+    for (const string &cell : record.cells){
+        // Short strings live inside the string object.
+        if (cell.capacity() > 15){
+            bytes += cell.capacity() + 1;
+        }
+    }
+    return bytes;
+}
+
+// k-way merge of sorted runs. Ties go to the earlier run, which keeps the sort stable.
+class RunMerger{
+    private:
+        const vector<SortKey> &keys;
+        vector<unique_ptr<RowFileReader>> readers;
+        vector<SortRecord> heads;
+        vector<size_t> heap;
+
+        // True if run a's head comes after run b's head: the heap keeps the smallest on top.
+        bool after(size_t a, size_t b) const{
+            int order = compareRecords(heads[a], heads[b], keys);
+            return order != 0 ? order > 0 : a > b;
+        }
+
+        void advance(size_t run){
+            if (readers[run]->next(heads[run].cells)){
+                parseKeys(heads[run], keys);
+                heap.push_back(run);
+                push_heap(heap.begin(), heap.end(), [this](size_t a, size_t b){return after(a, b);});
+            }
+        }
+    public:
+        RunMerger(const vector<SortKey> &keys, const vector<string> &files) : keys(keys), heads(files.size()){
+            for (const string &fileName : files){
+                readers.emplace_back(new RowFileReader(fileName));
+            }
+            for (size_t run = 0; run < readers.size(); ++run){
+                advance(run);
+            }
+        }
+
+        bool next(vector<string> &row){
+            if (heap.empty()){
+                return false;
+            }
+            pop_heap(heap.begin(), heap.end(), [this](size_t a, size_t b){return after(a, b);});
+            size_t run = heap.back();
+            heap.pop_back();
+            row.swap(heads[run].cells);
+            advance(run);
+            return true;
+        }
+};
+
+class MergedRowStream : public RowStream{
+    private:
+        shared_ptr<const SortedRows> owner;
+        RunMerger merger;
+    public:
+        MergedRowStream(shared_ptr<const SortedRows> owner, const vector<SortKey> &keys, const vector<string> &files) : owner(move(owner)), merger(keys, files) {}
+        bool next(vector<string> &row) override {return merger.next(row);}
+};
+
+class InMemorySortedStream : public RowStream{
+    private:
+        shared_ptr<const SortedRows> owner;
+        TableRowStream rows;
+    public:
+        InMemorySortedStream(shared_ptr<const SortedRows> owner, const vector<vector<string>> &table) : owner(move(owner)), rows(table) {}
+        bool next(vector<string> &row) override {return rows.next(row);}
+};
+
+SortedRows::~SortedRows(){
+    for (const string &fileName : runFiles){
+        unlink(fileName.c_str());
+    }
+}
+
+unique_ptr<RowStream> SortedRows::open() const{
+    if (runFiles.empty()){
+        return unique_ptr<RowStream>(new InMemorySortedStream(shared_from_this(), rows));
+    }
+    return unique_ptr<RowStream>(new MergedRowStream(shared_from_this(), keys, runFiles));
+}
+
+ExternalSorter::ExternalSorter(const vector<SortKey> &keys, size_t memoryBudget) : keys(keys), memoryBudget(memoryBudget), result(make_shared<SortedRows>(keys)) {}
+
+void ExternalSorter::add(vector<string> row){
+    SortRecord record;
+    record.cells = move(row);
+    parseKeys(record, keys);
+    bufferBytes += recordBytes(record);
+    buffer.push_back(move(record));
+    result->rowCount++;
+    if (bufferBytes >= memoryBudget){
+        spillBuffer();
+    }
+}
+
+// Stable-sorts equal slices of the buffer on the pool, then merges neighbouring
+// slices pairwise, also on the pool, until one sorted range is left.
+void ExternalSorter::sortBuffer(){
+    FLOW_TRACE_SCOPE("sort", "sort run", to_string(buffer.size()) + " rows");
+    auto less = [this](const SortRecord &a, const SortRecord &b){return compareRecords(a, b, keys) < 0;};
+    size_t slices = min(computePool().getThreadCount(), buffer.size() / (PARALLEL_SORT_THRESHOLD / 2));
+    if (slices <= 1){
+        stable_sort(buffer.begin(), buffer.end(), less);
+        return;
+    }
+    vector<size_t> bounds;
+    for (size_t i = 0; i <= slices; ++i){
+        bounds.push_back(buffer.size() * i / slices);
+    }
+    computePool().runBatch(slices, [&](size_t slice){
+        stable_sort(buffer.begin() + bounds[slice], buffer.begin() + bounds[slice + 1], less);
+    });
+    for (size_t width = 1; width < slices; width *= 2){
+        size_t pairs = (slices + 2 * width - 1) / (2 * width);
+        computePool().runBatch(pairs, [&](size_t pair){
+            size_t first = pair * 2 * width;
+            size_t middle = min(first + width, slices);
+            size_t last = min(first + 2 * width, slices);
+            if (middle < last){
+                inplace_merge(buffer.begin() + bounds[first], buffer.begin() + bounds[middle], buffer.begin() + bounds[last], less);
+            }
+        });
+    }
+}
+
+void ExternalSorter::spillBuffer(){
+    if (buffer.empty()){
+        return;
+    }
+    sortBuffer();
+    FLOW_TRACE_SCOPE("sort", "spill run", to_string(buffer.size()) + " rows");
+    string fileName = createTemporaryRowFile("flowmaker-sort");
+    result->runFiles.push_back(fileName);
+    RowFileWriter writer(fileName);
+    for (const SortRecord &record : buffer){
+        writer.write(record.cells);
+    }
+    uint64_t bytes = writer.close();
+    spilledBytes += bytes;
+    stepCounters.bytesWritten += bytes;
+    buffer.clear();
+    buffer.shrink_to_fit();
+    bufferBytes = 0;
+}
+
+// Replaces runs [first, first + count) with one merged run, keeping the run order
+// so that ties still resolve to the earlier row.
+void ExternalSorter::mergeRuns(size_t first, size_t count, const string &fileName){
+    vector<string> inputs(result->runFiles.begin() + first, result->runFiles.begin() + first + count);
+    try{
+        FLOW_TRACE_SCOPE("sort", "merge runs", to_string(count) + " runs");
+        RunMerger merger(keys, inputs);
+        RowFileWriter writer(fileName);
+        vector<string> row;
+        while (merger.next(row)){
+            writer.write(row);
+        }
+        uint64_t bytes = writer.close();
+        spilledBytes += bytes;
+        stepCounters.bytesWritten += bytes;
+    }catch (...){
+        unlink(fileName.c_str());
+        throw;
+    }
+    for (const string &input : inputs){
+        unlink(input.c_str());
+    }
+    result->runFiles.erase(result->runFiles.begin() + first + 1, result->runFiles.begin() + first + count);
+    result->runFiles[first] = fileName;
+}
+
+shared_ptr<SortedRows> ExternalSorter::finish(){
+    if (result->runFiles.empty()){
+        sortBuffer();
+        result->rows.reserve(buffer.size());
+        for (SortRecord &record : buffer){
+            result->rows.push_back(move(record.cells));
+        }
+        buffer.clear();
+        return move(result);
+    }
+
+    spillBuffer();
+    while (result->runFiles.size() > MAX_MERGE_FAN_IN){
+        for (size_t first = 0; first < result->runFiles.size(); ++first){
+            size_t count = min(MAX_MERGE_FAN_IN, result->runFiles.size() - first);
+            if (count > 1){
+                mergeRuns(first, count, createTemporaryRowFile("flowmaker-sort"));
+            }
+        }
+    }
+    return move(result);
+}
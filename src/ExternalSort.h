@@ -0,0 +1,87 @@
+#ifndef FLOWMAKER_EXTERNAL_SORT_H
+#define FLOWMAKER_EXTERNAL_SORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "RowStream.h"
+
+// One column of a sort order. Numeric keys compare as numbers, with cells that are
+// not numbers after all numbers in either direction; text keys compare bytewise.
+struct SortKey{
+    size_t column;
+    bool numeric = false;
+    bool descending = false;
+};
+
+// Parses keys such as "3:num:desc, 1" (1-based columns, each optionally followed by
+// "num" or "text" and "asc" or "desc"). Returns false if the text is malformed.
+bool parseSortKeys(const std::string &spec, std::vector<SortKey> &keys);
+
+// A row with its numeric keys parsed once, for comparisons.
+struct SortRecord{
+    std::vector<std::string> cells;
+    std::vector<double> numbers;
+};
+
+// The result of an ExternalSorter: the sorted rows in memory, or sorted runs in
+// temporary files that are merged as the rows are read. The files are removed with
+// the last reference to the result.
+class SortedRows : public std::enable_shared_from_this<SortedRows>{
+    private:
+        friend class ExternalSorter;
+
+        std::vector<SortKey> keys;
+        std::vector<std::vector<std::string>> rows;
+        std::vector<std::string> runFiles;
+        uint64_t rowCount = 0;
+    public:
+        SortedRows(const SortedRows &) = delete;
+        SortedRows &operator=(const SortedRows &) = delete;
+        explicit SortedRows(const std::vector<SortKey> &keys) : keys(keys) {}
+        ~SortedRows();
+
+        // Reads the rows in order. The stream keeps the result alive, so it can be
+        // handed to another thread such as the output writer.
+        std::unique_ptr<RowStream> open() const;
+        uint64_t getRowCount() const {return rowCount;}
+        // Number of runs spilled to disk; 0 if the sort fit in memory.
+        size_t getRunCount() const {return runFiles.size();}
+};
+
+// Sorts rows by a list of keys within a memory budget. Rows are buffered until the
+// budget is reached; the buffer is then sorted in parallel and written out as a
+// sorted run. The runs are merged k ways when the result is read. Equal rows keep
+// the order they were added in.
+class ExternalSorter{
+    private:
+        std::vector<SortKey> keys;
+        size_t memoryBudget;
+        std::vector<SortRecord> buffer;
+        size_t bufferBytes = 0;
+        std::shared_ptr<SortedRows> result;
+        uint64_t spilledBytes = 0;
+
+        void sortBuffer();
+        void spillBuffer();
+        void mergeRuns(size_t first, size_t count, const std::string &fileName);
+    public:
+        static const size_t DEFAULT_MEMORY_BUDGET = 256 * 1024 * 1024;
+        // Budget of sorters created without one; FlowMaker sets it from --sort-memory-mb.
+        static void setDefaultMemoryBudget(size_t bytes);
+        static size_t getDefaultMemoryBudget();
+
+        explicit ExternalSorter(const std::vector<SortKey> &keys, size_t memoryBudget = getDefaultMemoryBudget());
+
+        // Throws runtime_error if a run cannot be written.
+        void add(std::vector<std::string> row);
+        // Sorts what is left and returns the result. The sorter must not be used again.
+        std::shared_ptr<SortedRows> finish();
+        // Bytes written to temporary files so far.
+        uint64_t getSpilledBytes() const {return spilledBytes;}
+};
+
+#endif
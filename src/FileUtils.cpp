@@ -0,0 +1,38 @@
+#include "FileUtils.h"
+
+using namespace std;
+
+bool isValidFileName(const string &fileName){
+    string invalidChars = "\\/:*?\"<>|";
+    for (char ch : fileName){
+        if (invalidChars.find(ch) != string::npos){
+            return false;
+        }
+    }
+    if (fileName.empty() || fileName.find_first_not_of(" \t") == string::npos)
+    {
+        return false;
+    }
+    return true;
+}
+
+bool isValidImportPath(const string &path){
+    string invalidChars = "\\:\"<>|";
+    for (char ch : path){
+        if (invalidChars.find(ch) != string::npos){
+            return false;
+        }
+    }
+    return path.find_first_not_of(" \t") != string::npos;
+}
+
+bool readWholeFile(ifstream &inputFile, string &contents){
+    inputFile.seekg(0, ios::end);
+    streamsize size = inputFile.tellg();
+    inputFile.seekg(0, ios::beg);
+    if (size < 0){
+        return false;
+    }
+    contents.resize(static_cast<size_t>(size));
+    return size == 0 || static_cast<bool>(inputFile.read(&contents[0], size));
+}
@@ -0,0 +1,16 @@
+#ifndef FLOWMAKER_FILE_UTILS_H
+#define FLOWMAKER_FILE_UTILS_H
+
+#include <fstream>
+#include <string>
+
+bool isValidFileName(const std::string &fileName);
+
+// Like isValidFileName, but also accepts directories and glob patterns: '/', '*',
+// '?', '[' and ']' are allowed.
+bool isValidImportPath(const std::string &path);
+
+// Reads a whole file into contents. Returns false if the read fails.
+bool readWholeFile(std::ifstream &inputFile, std::string &contents);
+
+#endif
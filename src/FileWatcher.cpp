@@ -0,0 +1,178 @@
+#include "FileWatcher.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#endif
+
+using namespace std;
+
+static void readFileStamp(const string &fileName, int64_t &size, int64_t &modifiedNanos){
+    struct stat info;
+    if (stat(fileName.c_str(), &info) != 0){
+        size = -1;
+        modifiedNanos = -1;
+        return;
+    }
+    size = static_cast<int64_t>(info.st_size);
+    modifiedNanos = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+}
+
+static void addChanged(vector<string> &changed, const string &fileName){
+    if (find(changed.begin(), changed.end(), fileName) == changed.end()){
+        changed.push_back(fileName);
+    }
+}
+
+FileWatcher::FileWatcher(){
+#if defined(__linux__)
+    notifyFd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+#endif
+}
+
+FileWatcher::~FileWatcher(){
+    if (notifyFd >= 0){
+        close(notifyFd);
+    }
+}
+
+bool FileWatcher::watch(const string &fileName){
+    for (const WatchedFile &file : files){
+        if (file.fileName == fileName){
+            return true;
+        }
+    }
+    WatchedFile file;
+    file.fileName = fileName;
+    size_t slash = fileName.find_last_of('/');
+    if (slash == string::npos){
+        file.directory = ".";
+        file.name = fileName;
+    }
+    else{
+        file.directory = slash == 0 ? "/" : fileName.substr(0, slash);
+        file.name = fileName.substr(slash + 1);
+    }
+    readFileStamp(fileName, file.size, file.modifiedNanos);
+#if defined(__linux__)
+    if (notifyFd >= 0){
+        // Watching the directory sees the file replaced or created again, not just written.
+        int wd = inotify_add_watch(notifyFd, file.directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_CREATE);
+        if (wd < 0){
+            return false;
+        }
+        directories[wd] = file.directory;
+    }
+#endif
+    files.push_back(move(file));
+    return true;
+}
+
+bool FileWatcher::readEvents(vector<string> &changed){
+    bool found = false;
+#if defined(__linux__)
+    alignas(inotify_event) char buffer[8192];
+    while (true){
+        ssize_t length = read(notifyFd, buffer, sizeof(buffer));
+        if (length <= 0){
+            break;
+        }
+        for (char *position = buffer; position < buffer + length; ){
+            const inotify_event *event = reinterpret_cast<const inotify_event *>(position);
+            position += sizeof(inotify_event) + event->len;
+            if (event->mask & IN_Q_OVERFLOW){
+                // Events were lost; report everything rather than miss a change.
+                for (const WatchedFile &file : files){
+                    addChanged(changed, file.fileName);
+                }
+                found = true;
+                continue;
+            }
+            auto directory = directories.find(event->wd);
+            if (event->len == 0 || directory == directories.end()){
+                continue;
+            }
+            for (WatchedFile &file : files){
+                if (file.directory != directory->second || file.name != event->name){
+                    continue;
+                }
+                // A file opened for writing and closed unchanged is not reported.
+                int64_t size, modifiedNanos;
+                readFileStamp(file.fileName, size, modifiedNanos);
+                if (size != file.size || modifiedNanos != file.modifiedNanos){
+                    file.size = size;
+                    file.modifiedNanos = modifiedNanos;
+                    addChanged(changed, file.fileName);
+                    found = true;
+                }
+            }
+        }
+    }
+#endif
+    return found;
+}
+
+bool FileWatcher::pollFiles(vector<string> &changed){
+    bool found = false;
+    for (WatchedFile &file : files){
+        int64_t size, modifiedNanos;
+        readFileStamp(file.fileName, size, modifiedNanos);
+        if (size != file.size || modifiedNanos != file.modifiedNanos){
+            file.size = size;
+            file.modifiedNanos = modifiedNanos;
+            addChanged(changed, file.fileName);
+            found = true;
+        }
+    }
+    return found;
+}
+
+vector<string> FileWatcher::waitForChanges(int stopFd){
+    vector<string> changed;
+    bool settling = false;
+    while (true){
+        pollfd descriptors[2];
+        nfds_t count = 0;
+        int notifyIndex = -1, stopIndex = -1;
+        if (notifyFd >= 0){
+            notifyIndex = static_cast<int>(count);
+            descriptors[count++] = pollfd{notifyFd, POLLIN, 0};
+        }
+        if (stopFd >= 0){
+            stopIndex = static_cast<int>(count);
+            descriptors[count++] = pollfd{stopFd, POLLIN, 0};
+        }
+        int timeout = settling ? SETTLE_MILLISECONDS : (notifyFd >= 0 ? -1 : POLL_MILLISECONDS);
+        int ready = poll(descriptors, count, timeout);
+        if (ready < 0){
+            if (errno == EINTR){
+                continue;
+            }
+            throw runtime_error(string("Cannot wait for file changes: ") + strerror(errno));
+        }
+        if (stopIndex >= 0 && (descriptors[stopIndex].revents & (POLLIN | POLLHUP))){
+            return vector<string>();
+        }
+        bool found;
+        if (notifyIndex >= 0){
+            found = (descriptors[notifyIndex].revents & POLLIN) && readEvents(changed);
+        }
+        else{
+            found = pollFiles(changed);
+        }
+        // A file written in several steps is reported once the writes have stopped.
+        if (found){
+            settling = true;
+        }
+        else if (settling){
+            return changed;
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef FLOWMAKER_FILE_WATCHER_H
+#define FLOWMAKER_FILE_WATCHER_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Waits for a set of files to change. On Linux the directories of the files are
+// watched with inotify, so that files replaced by a rename (as editors save them) are
+// seen as well; elsewhere, or if inotify cannot be used, the size and modification
+// time of the files are polled.
+class FileWatcher{
+    private:
+        struct WatchedFile{
+            std::string fileName;
+            std::string directory;
+            std::string name;
+            int64_t size;
+            int64_t modifiedNanos;
+        };
+
+        int notifyFd = -1;
+        // Directory of each inotify watch.
+        std::unordered_map<int, std::string> directories;
+        std::vector<WatchedFile> files;
+
+        // Add the watched files that changed to changed; return false if none did.
+        bool readEvents(std::vector<std::string> &changed);
+        bool pollFiles(std::vector<std::string> &changed);
+    public:
+        // Changes that follow the first one within this time are reported with it.
+        static const int SETTLE_MILLISECONDS = 100;
+        // How often files are polled without inotify.
+        static const int POLL_MILLISECONDS = 500;
+
+        FileWatcher();
+        FileWatcher(const FileWatcher &) = delete;
+        FileWatcher &operator=(const FileWatcher &) = delete;
+        ~FileWatcher();
+
+        // Returns false if the directory of the file cannot be watched.
+        bool watch(const std::string &fileName);
+        bool usesNotifications() const {return notifyFd >= 0;}
+        // Blocks until watched files are written, replaced or deleted and returns their
+        // names as passed to watch(). Returns nothing once stopFd (unless -1) can be read.
+        std::vector<std::string> waitForChanges(int stopFd);
+};
+
+#endif
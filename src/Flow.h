@@ -0,0 +1,85 @@
+#ifndef FLOWMAKER_FLOW_H
+#define FLOWMAKER_FLOW_H
+
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "FlowStep.h"
+#include "StepRegistry.h"
+
+class Flow{
+    private:
+        std::string name;
+        std::vector<FlowStep *> steps;
+
+    public:
+        Flow(const std::string &name) : name(name) {}
+
+        // A flow owns its steps, so it can be moved but not copied.
+        Flow(const Flow &) = delete;
+        Flow &operator=(const Flow &) = delete;
+
+        Flow(Flow &&other) noexcept : name(std::move(other.name)), steps(std::move(other.steps)){
+            other.steps.clear();
+        }
+
+        Flow &operator=(Flow &&other) noexcept{
+            if (this != &other){
+                for (FlowStep *step : steps){
+                    delete step;
+                }
+                name = std::move(other.name);
+                steps = std::move(other.steps);
+                other.steps.clear();
+            }
+            return *this;
+        }
+
+        ~Flow(){
+            for (FlowStep *step : steps){
+                delete step;
+            }
+        }
+
+        void addStep(FlowStep *step){
+            try{
+                steps.push_back(step);
+            }catch (const std::bad_alloc &e){
+                std::cerr << "Memory allocation error when adding a step: " << e.what() << std::endl;
+            }
+        }
+
+        // Puts step in place of the step at index, which is deleted.
+        void replaceStep(size_t index, FlowStep *step){
+            delete steps[index];
+            steps[index] = step;
+        }
+
+        void displayAvailableSteps() const{
+            std::cout << "Available Steps:" << std::endl;
+            for (const StepTypeInfo *info : StepRegistry::instance().getStepTypes()){
+                std::cout << info->menuKey << ". " << info->typeName << ": " << info->summary << std::endl;
+            }
+        }
+
+        void displayFlowSteps() const{
+            std::cout << "\tFlow Steps:" << std::endl;
+            for (size_t i = 0; i < steps.size(); ++i){
+                std::cout << "\t";
+                std::cout << i + 1 << ". " << steps[i]->getType() << std::endl;
+            }
+        }
+
+        void run(){
+            for (FlowStep *step : steps){
+                step->execute();
+            }
+        }
+
+        std::string getName() const {return name;}
+        const std::vector<FlowStep *> &getSteps() const {return steps;}
+};
+
+#endif
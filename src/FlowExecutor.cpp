@@ -0,0 +1,1575 @@
+#include "FlowExecutor.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <ctime>
+#include <exception>
+#include <mutex>
+#include <sys/stat.h>
+
+#include "DisplayPreview.h"
+#include "DistinctCount.h"
+#include "ExternalSort.h"
+#include "FileUtils.h"
+#include "FlowSteps.h"
+#include "FlowTrace.h"
+#include "HashJoin.h"
+#include "ImportPrefetcher.h"
+#include "OutputWriter.h"
+#include "PipelinedRowStream.h"
+#include "QuantileSketch.h"
+#include "RegexTransform.h"
+#include "TextSearch.h"
+
+using namespace std;
+
+FlowExecutor::FlowExecutor(Flow &flow) : FlowExecutor(flow, consoleInput(), consoleOutput()) {}
+
+FlowExecutor::FlowExecutor(Flow &flow, FlowInput &input, FlowOutput &output) : flow(flow), input(input), recordingOutput(output), out(recordingOutput), err(recordingOutput, true){
+    err.tie(&out);
+}
+
+void FlowExecutor::RecordingOutput::record(RunOutput::Kind kind, const string &text){
+    if (!outputs.empty() && outputs.back().kind == kind){
+        outputs.back().text += text;
+    }
+    else{
+        outputs.push_back(RunOutput{kind, text, ""});
+    }
+}
+
+void FlowExecutor::RecordingOutput::write(const string &text){
+    target.write(text);
+    if (recording){
+        record(RunOutput::Text, text);
+    }
+}
+
+void FlowExecutor::RecordingOutput::writeError(const string &text){
+    target.writeError(text);
+    if (recording){
+        record(RunOutput::Error, text);
+    }
+}
+
+void FlowExecutor::RecordingOutput::addFile(const string &fileName, string contents){
+    outputs.push_back(RunOutput{RunOutput::File, move(contents), fileName});
+}
+
+// How many queued answers startPrefetches() looks through for file names.
+static const size_t PREFETCH_LOOKAHEAD = 64;
+
+FlowExecutor::~FlowExecutor(){
+    discardPrefetches();
+}
+
+// "name (rows 1-20)" for one file of an import, counting rows from 1.
+static string describeImportSource(const ImportSource &source){
+    if (source.rowCount == 0){
+        return source.fileName + " (no rows)";
+    }
+    if (source.rowCount == 1){
+        return source.fileName + " (row " + to_string(source.firstRow + 1) + ")";
+    }
+    return source.fileName + " (rows " + to_string(source.firstRow + 1) + "-" + to_string(source.firstRow + source.rowCount) + ")";
+}
+
+bool FlowExecutor::AnswerAwaiter::await_ready(){
+    executor.out.flush();
+    executor.err.flush();
+    waitStart = chrono::steady_clock::now();
+    if (!executor.input.isAsynchronous()){
+        received = executor.input.readLine(line);
+        return true;
+    }
+    return false;
+}
+
+// The step measurement is paused first: once requestLine() returns false, the flow
+// may already be running again on another thread and this awaiter must not be touched.
+bool FlowExecutor::AnswerAwaiter::await_suspend(coroutine_handle<> handle){
+    if (executor.activeMeasurement){
+        executor.activeMeasurement->pause();
+        paused = true;
+    }
+    return !executor.input.requestLine(line, received, handle);
+}
+
+string FlowExecutor::AnswerAwaiter::await_resume(){
+    if (paused){
+        executor.activeMeasurement->resume();
+    }
+    executor.stepInputWait += chrono::duration<double>(chrono::steady_clock::now() - waitStart).count();
+    if (!received){
+        throw FlowInputClosed();
+    }
+    executor.stepRecords[executor.currentStepIndex].answers.push_back(line);
+    return move(line);
+}
+
+FlowTask<char> FlowExecutor::askChar(){
+    while (true){
+        string answer = co_await readAnswer();
+        size_t pos = answer.find_first_not_of(" \t");
+        if (pos != string::npos){
+            co_return answer[pos];
+        }
+    }
+}
+
+FlowTask<bool> FlowExecutor::askYesNo(){
+    char answer = co_await askChar();
+    co_return answer == 'Y' || answer == 'y';
+}
+
+bool FlowExecutor::parseNumber(const string &text, double &value){
+    const char *begin = text.c_str();
+    char *end = nullptr;
+    value = strtod(begin, &end);
+    if (end == begin){
+        return false;
+    }
+    while (*end == ' ' || *end == '\t'){
+        ++end;
+    }
+    return *end == '\0';
+}
+
+void FlowExecutor::prefetchImport(const string &fileName, bool parseCSV){
+    if (find(prefetchedImports.begin(), prefetchedImports.end(), fileName) != prefetchedImports.end()){
+        return;
+    }
+    struct stat info;
+    if (stat(fileName.c_str(), &info) != 0 || !S_ISREG(info.st_mode)){
+        return;
+    }
+    if (parseCSV){
+        ImportPrefetcher::instance().prefetch(fileName, CSVFileInputStep::parseCSVContents);
+    }
+    else{
+        ImportPrefetcher::instance().prefetch(fileName);
+    }
+    prefetchedImports.push_back(fileName);
+}
+
+void FlowExecutor::startPrefetches(){
+    bool hasTextImport = false;
+    bool hasCSVImport = false;
+    for (FlowStep *step : flow.getSteps()){
+        string fileName;
+        if (TextFileInputStep *textFileInputStep = dynamic_cast<TextFileInputStep *>(step)){
+            hasTextImport = true;
+            fileName = textFileInputStep->getFileName();
+            if (!fileName.empty() && TextFileInputStep::prepareFileName(fileName)){
+                prefetchImport(fileName, false);
+            }
+        }
+        else if (CSVFileInputStep *csvFileInputStep = dynamic_cast<CSVFileInputStep *>(step)){
+            hasCSVImport = true;
+            fileName = csvFileInputStep->getFileName();
+            if (!fileName.empty() && CSVFileInputStep::prepareFileName(fileName)){
+                prefetchImport(fileName, true);
+            }
+        }
+    }
+    if (!hasTextImport && !hasCSVImport){
+        return;
+    }
+
+    // Any queued answer naming an existing file of the right kind is a likely import;
+    // a wrong guess only costs a read.
+    vector<string> queued;
+    input.peekLines(queued, PREFETCH_LOOKAHEAD);
+    for (string answer : queued){
+        string textName = answer;
+        if (hasTextImport && TextFileInputStep::prepareFileName(textName)){
+            prefetchImport(textName, false);
+        }
+        if (hasCSVImport && CSVFileInputStep::prepareFileName(answer)){
+            prefetchImport(answer, true);
+        }
+    }
+}
+
+shared_ptr<PrefetchedImport> FlowExecutor::takePrefetchedImport(const string &fileName){
+    auto it = find(prefetchedImports.begin(), prefetchedImports.end(), fileName);
+    if (it == prefetchedImports.end()){
+        return nullptr;
+    }
+    prefetchedImports.erase(it);
+    return ImportPrefetcher::instance().take(fileName);
+}
+
+void FlowExecutor::discardPrefetches(){
+    for (const string &fileName : prefetchedImports){
+        ImportPrefetcher::instance().discard(fileName);
+    }
+    prefetchedImports.clear();
+}
+
+void FlowExecutor::finishPendingWrites(){
+    if (pendingWrites.empty()){
+        return;
+    }
+    FLOW_TRACE_SCOPE("output", "wait for writes");
+    for (PendingWrite &write : pendingWrites){
+        OutputWriteResult result = write.result.get();
+        // A recorded run keeps the file instead of the message, which a replay prints
+        // with the name the file gets then. Runs whose files failed are not kept.
+        bool recording = recordingOutput.recording;
+        if (recording){
+            out.flush();
+            err.flush();
+            ifstream written(result.fileName, ios::binary);
+            string contents;
+            if (result.succeeded && written.is_open() && readWholeFile(written, contents)){
+                recordingOutput.addFile(write.fileName, move(contents));
+            }
+            else{
+                recording = false;
+            }
+        }
+        recordingOutput.recording = false;
+        if (result.succeeded){
+            out << result.message << endl;
+        }
+        else{
+            err << result.message << endl;
+        }
+        recordingOutput.recording = recording;
+        for (StepMetrics &metrics : lastRunMetrics.steps){
+            if (metrics.index == write.stepIndex){
+                metrics.bytesWritten += result.bytesWritten;
+            }
+        }
+    }
+    pendingWrites.clear();
+}
+
+void FlowExecutor::replayOutputs(vector<RunOutput> &outputs){
+    FLOW_TRACE_SCOPE("result cache", "replay", lastRunMetrics.flowName);
+    for (RunOutput &output : outputs){
+        if (output.kind == RunOutput::Text){
+            out << output.text;
+            out.flush();
+        }
+        else if (output.kind == RunOutput::Error){
+            err << output.text;
+            err.flush();
+        }
+        else{
+            unique_ptr<OutputStep> write(new OutputStep(output.fileName));
+            write->setContents(make_shared<const string>(move(output.text)));
+            pendingWrites.push_back(PendingWrite{0, OutputWriter::instance().queue(move(write)), output.fileName});
+            finishPendingWrites();
+        }
+    }
+}
+
+FlowTask<void> FlowExecutor::run(){
+    lastRunMetrics = RunMetrics();
+    lastRunMetrics.flowName = flow.getName();
+    lastRunMetrics.startedAt = time(nullptr);
+    auto runStart = chrono::steady_clock::now();
+    // Whole runs are cached only when every step runs and is reset at the end.
+    bool cacheRun = stepsToRun.empty() && !keepResults && ResultCache::instance().isEnabled();
+    uint64_t flowHash = 0;
+    bool replayed = false;
+    runCompleted = false;
+    recordedInputs.clear();
+    recordingOutput.outputs.clear();
+    recordingOutput.recording = false;
+    try{
+        FLOW_TRACE_SCOPE("flow", lastRunMetrics.flowName);
+        const vector<FlowStep *> &steps = flow.getSteps();
+        stepRecords.assign(steps.size(), StepRecord());
+        if (cacheRun){
+            // Taken before the run, which changes the configuration of some steps.
+            flowHash = ResultCache::hashFlow(flow);
+            vector<string> queued;
+            input.peekLines(queued, ResultCache::MAX_ANSWERS);
+            RecordedRun recorded;
+            lastRunMetrics.resultCacheChecked = true;
+            if (ResultCache::instance().lookup(flowHash, queued, recorded)){
+                lastRunMetrics.resultCacheHit = true;
+                replayed = true;
+                for (size_t answer = 0; answer < recorded.answers.size(); ++answer){
+                    co_await readAnswer();
+                }
+                replayOutputs(recorded.outputs);
+            }
+            else{
+                recordingOutput.recording = true;
+            }
+        }
+        if (!replayed){
+            startPrefetches();
+        }
+        vector<string> outputData;
+        for (size_t i = 0; i < steps.size() && !replayed; ++i){
+            FlowStep *currentStep = steps[i];
+            const string stepType = currentStep->getType();
+            currentStepIndex = i;
+            if (i < stepsToRun.size() && !stepsToRun[i]){
+                out << i + 1 << ". " << stepType << ": kept from the previous run." << endl;
+                continue;
+            }
+            StepRecorder recorder(*this, i + 1, stepType);
+            FLOW_TRACE_SCOPE("step", stepType, lastRunMetrics.flowName);
+
+            if (currentStep->getType() == "TitleStep"){
+                out << i + 1 << ". " << currentStep->getType() << ": " << currentStep->getDescription() << endl;
+                out << "Do you want to complete this step? (Y/N): ";
+                if (co_await askYesNo()){
+                    TitleStep *titleStep = dynamic_cast<TitleStep *>(currentStep);
+                    if (titleStep){
+                        titleStep->setCompleteTitleStep(true);
+                    }
+                }
+                else{
+                    out << "Step skipped." << endl;
+                }
+            }
+
+            else if (currentStep->getType() == "TextStep"){
+                out << i + 1 << ". " << currentStep->getType() << ": " << currentStep->getDescription() << endl;
+                out << "Do you want to complete this step? (Y/N): ";
+                if (co_await askYesNo()){
+                    TextStep *textStep = dynamic_cast<TextStep *>(currentStep);
+                    if (textStep){
+                        textStep->setCompleteTextStep(true);
+                        textStep->setStepNumberTextStep(i);
+                    }
+                }
+                else{
+                    out << "Step skipped." << endl;
+                }
+            }
+
+            else if (currentStep->getType() == "TextInputStep")
+            {
+                out << i + 1 << ". " << currentStep->getType() << ": " << currentStep->getDescription() << endl;
+                out << "Do you want to complete this step? (Y/N): ";
+                if (co_await askYesNo())
+                {
+                    out << "The text you need to complete:" << endl;
+                    string input;
+                    bool verify = false;
+                    for (size_t j = 0; j < i; j++)
+                    {
+                        currentStep = steps[j];
+                        if (currentStep->getType() == "TitleStep")
+                        {
+                            TitleStep *titleStep = dynamic_cast<TitleStep *>(currentStep);
+                            if (titleStep && titleStep->getCompleteTitleStep())
+                            {
+                                verify = true;
+                                out << "Enter Title: ";
+                                input = co_await readAnswer();
+                                titleStep->setTitle(input);
+                                out << "Enter Subtitle: ";
+                                input = co_await readAnswer();
+                                titleStep->setSubtitle(input);
+                            }
+                        }
+                        else if (currentStep->getType() == "TextStep")
+                        {
+                            TextStep *textStep = dynamic_cast<TextStep *>(currentStep);
+                            if (textStep && textStep->getCompleteTextStep())
+                            {
+                                verify = true;
+                                out << "Enter Text Title: ";
+                                input = co_await readAnswer();
+                                textStep->setTitle(input);
+                                out << "Enter Text: ";
+                                input = co_await readAnswer();
+                                textStep->setText(input);
+                            }
+                        }
+                    }
+                    if (!verify)
+                    {
+                        out << "No step to input" << endl;
+                    }
+                }
+            }
+
+            else if (currentStep->getType() == "DisplayStep"){
+                out << i + 1 << ". " << currentStep->getType() << ": " << currentStep->getDescription() << endl;
+                out << "Do you want to complete this step? (Y/N): ";
+                if (co_await askYesNo()){
+                    out << "Display of the input so far:" << endl;
+                    bool verify = false;
+                    // Tables and texts shown as a preview, which can be paged afterwards.
+                    struct PageableItem{
+                        string label;
+                        const TableProducer *table;
+                        const TextFileInputStep *text;
+                        const vector<SearchMatch> *matches;
+                        uint64_t rowCount;
+                    };
+                    vector<PageableItem> pageable;
+                    int numberTitle = 0;
+                    int numberText = 0;
+                    int numberNumber = 0;
+                    int numberCalculus = 0;
+                    int numberTextFileInput = 0;
+                    int numberCSVFileInput = 0;
+                    int numberXLSXFileInput = 0;
+                    int numberSort = 0;
+                    int numberJoin = 0;
+                    int numberSearch = 0;
+                    int numberTextStats = 0;
+                    int numberQuantile = 0;
+                    int numberDistinctCount = 0;
+                    int numberRegexTransform = 0;
+                    for (size_t k = 0; k < i; k++){
+                        FlowStep *previousStep = steps[k];
+                        if (previousStep->getType() == "TitleStep"){
+                            TitleStep *titleStep = dynamic_cast<TitleStep *>(previousStep);
+                            if (titleStep){
+                                out << "Title " << numberTitle + 1 << ": " << titleStep->getTitle() << endl;
+                                out << "Subtitle " << numberTitle + 1 << ": " << titleStep->getSubtitle() << endl;
+                                numberTitle++;
+                                verify = true;
+                            }
+                        }
+
+                        else if (previousStep->getType() == "TextStep"){
+                            TextStep *textStep = dynamic_cast<TextStep *>(previousStep);
+                            if (textStep){
+                                out << "Text title " << numberText + 1 << ": " << textStep->getTitle() << endl;
+                                out << "Text " << numberText + 1 << ": " << textStep->getText() << endl;
+                                numberText++;
+                                verify = true;
+                            }
+                        }
+
+                        else if (previousStep->getType() == "NumberInputStep"){
+                            NumberInputStep *numberInputStep = dynamic_cast<NumberInputStep *>(previousStep);
+                            if (numberInputStep){
+                                out << "Number Input " << numberNumber + 1 << ": " << numberInputStep->getUserInput() << endl;
+                                numberNumber++;
+                                verify = true;
+                            }
+                        }
+
+                        else if (previousStep->getType() == "CalculusStep"){
+                            CalculusStep<double> *calculusStep = dynamic_cast<CalculusStep<double> *>(previousStep);
+                            if (calculusStep){
+                                char operationSymbol = calculusStep->getOperationSymbol();
+                                out << "Calculus Step " << numberCalculus + 1 << ": ";
+
+                                if (operationSymbol == 'm' || operationSymbol == 'M'){
+                                    string operationName = (operationSymbol == 'm') ? "min" : "max";
+                                    out << operationName << "(";
+                                }
+
+                                for (size_t i = 0; i < calculusStep->getNumberInputs().size(); ++i){
+                                    out << calculusStep->getNumberInputs()[i]->getUserInput();
+                                    if (i < calculusStep->getNumberInputs().size() - 1){
+                                        if (operationSymbol == 'm' || operationSymbol == 'M'){
+                                            out << ", ";
+                                        }
+                                        else{
+                                            out << " " << operationSymbol << " ";
+                                        }
+                                    }
+                                }
+
+                                if (operationSymbol == 'm' || operationSymbol == 'M'){
+                                    out << ") = ";
+                                }
+                                else{
+                                    out << " = ";
+                                }
+                                out << calculusStep->performCalculation() << endl;
+                                numberCalculus++;
+                                verify = true;
+                            }
+                        }
+
+                        else if (previousStep->getType() == "TextFileInputStep"){
+                            TextFileInputStep *textFileInputStep = dynamic_cast<TextFileInputStep *>(previousStep);
+                            if (textFileInputStep){
+                                if (textFileInputStep->isFileImported()){
+                                    out << "Text File " << numberTextFileInput + 1 << " name: " << textFileInputStep->getFileName() << endl;
+                                    if (textFileInputStep->getSources().size() > 1){
+                                        for (const ImportSource &source : textFileInputStep->getSources()){
+                                            out << "Text File " << numberTextFileInput + 1 << " part: " << describeImportSource(source) << endl;
+                                        }
+                                    }
+                                    out << "Text File " << numberTextFileInput + 1 << " content: \n";
+                                    if (!printTextPreview(out, textFileInputStep->getFileContent(), textFileInputStep->getLineIndex())){
+                                        pageable.push_back(PageableItem{"Text File " + to_string(numberTextFileInput + 1) + " (" + textFileInputStep->getFileName() + ")", nullptr, textFileInputStep, nullptr, textFileInputStep->getLineCount()});
+                                    }
+                                    numberTextFileInput++;
+                                    verify = true;
+                                }
+                                else{
+                                    out << "Text File " << numberTextFileInput + 1 << " was not imported successfully." << endl;
+                                    numberTextFileInput++;
+                                    verify = true;
+                                }
+                            }
+                        }
+
+                        else if (previousStep->getType() == "CSVFileInputStep"){
+                            CSVFileInputStep *csvFileInputStep = dynamic_cast<CSVFileInputStep *>(previousStep);
+                            if (csvFileInputStep){
+                                if (csvFileInputStep->isFileImported()){
+                                    out << "CSV File " << numberCSVFileInput + 1 << " name: " << csvFileInputStep->getFileName() << endl;
+                                    if (csvFileInputStep->getSources().size() > 1){
+                                        for (const ImportSource &source : csvFileInputStep->getSources()){
+                                            out << "CSV File " << numberCSVFileInput + 1 << " part: " << describeImportSource(source) << endl;
+                                        }
+                                    }
+                                    out << "CSV File " << numberCSVFileInput + 1 << " content: \n"
+                                        << endl;
+                                    TablePreview preview = previewTable(*csvFileInputStep);
+                                    printTablePreview(out, preview);
+                                    if (!preview.complete){
+                                        pageable.push_back(PageableItem{"CSV File " + to_string(numberCSVFileInput + 1) + " (" + csvFileInputStep->getFileName() + ")", csvFileInputStep, nullptr, nullptr, preview.rowCount});
+                                    }
+                                    numberCSVFileInput++;
+                                    verify = true;
+                                }
+                                else{
+                                    out << "CSV File " << numberCSVFileInput + 1 << " was not imported successfully." << endl;
+                                    numberCSVFileInput++;
+                                    verify = true;
+                                }
+                            }
+                        }
+
+                        else if (previousStep->getType() == "XLSXFileInputStep"){
+                            XLSXFileInputStep *xlsxFileInputStep = dynamic_cast<XLSXFileInputStep *>(previousStep);
+                            if (xlsxFileInputStep){
+                                if (xlsxFileInputStep->isFileImported()){
+                                    out << "Spreadsheet " << numberXLSXFileInput + 1 << " name: " << xlsxFileInputStep->getFileName() << endl;
+                                    out << "Spreadsheet " << numberXLSXFileInput + 1 << " content: \n"
+                                        << endl;
+                                    TablePreview preview = previewTable(*xlsxFileInputStep);
+                                    printTablePreview(out, preview);
+                                    if (!preview.complete){
+                                        pageable.push_back(PageableItem{"Spreadsheet " + to_string(numberXLSXFileInput + 1) + " (" + xlsxFileInputStep->getFileName() + ")", xlsxFileInputStep, nullptr, nullptr, preview.rowCount});
+                                    }
+                                }
+                                else{
+                                    out << "Spreadsheet " << numberXLSXFileInput + 1 << " was not imported successfully." << endl;
+                                }
+                                numberXLSXFileInput++;
+                                verify = true;
+                            }
+                        }
+
+                        else if (previousStep->getType() == "SortStep"){
+                            SortStep *sortStep = dynamic_cast<SortStep *>(previousStep);
+                            if (sortStep && sortStep->hasTable()){
+                                out << "Sorted Table " << numberSort + 1 << " of: " << sortStep->getSourceName() << " (keys " << sortStep->getKeySpec() << ")" << endl;
+                                out << "Sorted Table " << numberSort + 1 << " content: \n"
+                                    << endl;
+                                TablePreview preview = previewTable(*sortStep);
+                                printTablePreview(out, preview);
+                                if (!preview.complete){
+                                    pageable.push_back(PageableItem{"Sorted Table " + to_string(numberSort + 1) + " (" + sortStep->getTableName() + ")", sortStep, nullptr, nullptr, preview.rowCount});
+                                }
+                                numberSort++;
+                                verify = true;
+                            }
+                        }
+
+                        else if (previousStep->getType() == "JoinStep"){
+                            JoinStep *joinStep = dynamic_cast<JoinStep *>(previousStep);
+                            if (joinStep && joinStep->hasTable()){
+                                out << "Joined Table " << numberJoin + 1 << " of: " << joinStep->getTableName() << " (keys " << joinStep->getLeftKeys() << " = " << joinStep->getRightKeys() << ")" << endl;
+                                out << "Joined Table " << numberJoin + 1 << " content: \n"
+                                    << endl;
+                                TablePreview preview = previewTable(*joinStep);
+                                printTablePreview(out, preview);
+                                if (!preview.complete){
+                                    pageable.push_back(PageableItem{"Joined Table " + to_string(numberJoin + 1) + " (" + joinStep->getTableName() + ")", joinStep, nullptr, nullptr, preview.rowCount});
+                                }
+                                numberJoin++;
+                                verify = true;
+                            }
+                        }
+
+                        else if (previousStep->getType() == "SearchStep"){
+                            SearchStep *searchStep = dynamic_cast<SearchStep *>(previousStep);
+                            if (searchStep && searchStep->isSearched()){
+                                out << "Search " << numberSearch + 1 << " of: " << searchStep->getTextName() << " (patterns " << searchStep->getPatterns() << ")" << endl;
+                                out << "Search " << numberSearch + 1 << " matching lines: " << searchStep->getMatches().size() << "\n"
+                                    << endl;
+                                if (!printMatchesPreview(out, searchStep->getMatches())){
+                                    pageable.push_back(PageableItem{"Search " + to_string(numberSearch + 1) + " (" + searchStep->getTextName() + ")", nullptr, nullptr, &searchStep->getMatches(), searchStep->getMatches().size()});
+                                }
+                                numberSearch++;
+                                verify = true;
+                            }
+                        }
+
+                        else if (previousStep->getType() == "TextStatsStep"){
+                            TextStatsStep *textStatsStep = dynamic_cast<TextStatsStep *>(previousStep);
+                            if (textStatsStep && textStatsStep->isComputed()){
+                                const TextStats &stats = textStatsStep->getStats();
+                                out << "Text Statistics " << numberTextStats + 1 << " of: " << textStatsStep->getTextName() << endl;
+                                out << "Lines: " << stats.lines << ", Words: " << stats.words << ", Bytes: " << stats.bytes << ", Tokens: " << stats.tokens << " (" << stats.distinctTokens << " distinct)" << endl;
+                                out << "Most frequent tokens:" << endl;
+                                for (const TokenCount &token : stats.topTokens){
+                                    out << token.token << ": " << token.count << endl;
+                                }
+                                numberTextStats++;
+                                verify = true;
+                            }
+                        }
+
+                        else if (previousStep->getType() == "QuantileStep"){
+                            QuantileStep *quantileStep = dynamic_cast<QuantileStep *>(previousStep);
+                            if (quantileStep && quantileStep->isComputed()){
+                                out << "Quantiles " << numberQuantile + 1 << " of: " << quantileStep->getSourceName() << " (column " << quantileStep->getColumn() << ")" << endl;
+                                for (const string &line : quantileStep->describeResults()){
+                                    out << line << endl;
+                                }
+                                numberQuantile++;
+                                verify = true;
+                            }
+                        }
+
+                        else if (previousStep->getType() == "DistinctCountStep"){
+                            DistinctCountStep *distinctCountStep = dynamic_cast<DistinctCountStep *>(previousStep);
+                            if (distinctCountStep && distinctCountStep->isComputed()){
+                                out << "Distinct Count " << numberDistinctCount + 1 << " of: " << distinctCountStep->getSourceName() << " (column " << distinctCountStep->getColumn() << ")" << endl;
+                                for (const string &line : distinctCountStep->describeResults()){
+                                    out << line << endl;
+                                }
+                                numberDistinctCount++;
+                                verify = true;
+                            }
+                        }
+
+                        else if (previousStep->getType() == "RegexTransformStep"){
+                            RegexTransformStep *regexTransformStep = dynamic_cast<RegexTransformStep *>(previousStep);
+                            if (regexTransformStep && regexTransformStep->hasTable()){
+                                out << "Regex Transform " << numberRegexTransform + 1 << " of: " << regexTransformStep->getTextName() << " (pattern " << regexTransformStep->getPattern() << ")" << endl;
+                                out << "Regex Transform " << numberRegexTransform + 1 << " content: \n"
+                                    << endl;
+                                TablePreview preview = previewTable(*regexTransformStep);
+                                printTablePreview(out, preview);
+                                if (!preview.complete){
+                                    pageable.push_back(PageableItem{"Regex Transform " + to_string(numberRegexTransform + 1) + " (" + regexTransformStep->getTableName() + ")", regexTransformStep, nullptr, nullptr, preview.rowCount});
+                                }
+                                numberRegexTransform++;
+                                verify = true;
+                            }
+                        }
+                    }
+                    if (verify == false){
+                        out << "Nothing to display." << endl;
+                    }
+                    if (!pageable.empty()){
+                        out << "Do you want to page through a previewed table, text or search? (Y/N): ";
+                        bool paging = co_await askYesNo();
+                        while (paging){
+                            size_t item = 0;
+                            if (pageable.size() > 1){
+                                for (size_t p = 0; p < pageable.size(); ++p){
+                                    out << p + 1 << ". " << pageable[p].label << ", " << pageable[p].rowCount << (pageable[p].text ? " lines" : pageable[p].matches ? " matches" : " rows") << endl;
+                                }
+                                double choice;
+                                while (true){
+                                    out << "Enter the number of the table, text or search to page: ";
+                                    if (parseNumber(co_await readAnswer(), choice) && choice >= 1 && choice <= pageable.size() && choice == static_cast<size_t>(choice)){
+                                        break;
+                                    }
+                                    err << "Invalid input. Please enter a number from 1 to " << pageable.size() << "." << endl;
+                                }
+                                item = static_cast<size_t>(choice) - 1;
+                            }
+                            const PageableItem &page = pageable[item];
+                            while (true){
+                                out << "Enter the first " << (page.text ? "line" : page.matches ? "match" : "row") << " to show (1-" << page.rowCount << ", empty to stop): ";
+                                string answer = co_await readAnswer();
+                                double first;
+                                if (answer.find_first_not_of(" \t") == string::npos){
+                                    break;
+                                }
+                                if (!parseNumber(answer, first) || first < 1 || first > page.rowCount || first != static_cast<uint64_t>(first)){
+                                    err << "Invalid input. Please enter a number from 1 to " << page.rowCount << "." << endl;
+                                    continue;
+                                }
+                                if (page.text){
+                                    printTextPage(out, page.text->getFileContent(), page.text->getLineIndex(), static_cast<uint64_t>(first) - 1, DISPLAY_PAGE_ROWS);
+                                }
+                                else if (page.matches){
+                                    printMatchesPage(out, *page.matches, static_cast<uint64_t>(first) - 1, DISPLAY_PAGE_ROWS);
+                                }
+                                else{
+                                    printTablePage(out, *page.table, static_cast<uint64_t>(first) - 1, DISPLAY_PAGE_ROWS);
+                                }
+                            }
+                            paging = false;
+                            if (pageable.size() > 1){
+                                out << "Do you want to page through another one? (Y/N): ";
+                                paging = co_await askYesNo();
+                            }
+                        }
+                    }
+                }
+            }
+
+            else if (currentStep->getType() == "NumberInputStep"){
+                out << i + 1 << ". " << currentStep->getType() << ": " << currentStep->getDescription() << endl;
+                out << "Do you want to complete this step? (Y/N): ";
+                if (co_await askYesNo()){
+                    NumberInputStep *numberInputStep = dynamic_cast<NumberInputStep *>(currentStep);
+                    if (numberInputStep){
+                        double userInput;
+                        bool validInput = false;
+                        while (!validInput){
+                            out << "Enter a number: ";
+                            if (!parseNumber(co_await readAnswer(), userInput)){
+                                err << "Invalid input. Please enter a valid number." << endl;
+                            }
+                            else{
+                                validInput = true;
+                                numberInputStep->setUserInput(userInput);
+                                out << "Number entered is: " << userInput << endl;
+                            }
+                        }
+                    }
+                }
+            }
+
+            else if (currentStep->getType() == "CalculusStep"){
+                out << i + 1 << ". " << currentStep->getType() << ": " << currentStep->getDescription() << endl;
+                out << "Do you want to complete this step? (Y/N): ";
+                if (co_await askYesNo()){
+                    CalculusStep<double> *calculusStep = dynamic_cast<CalculusStep<double> *>(currentStep);
+                    if (calculusStep){
+                        out << "Choose two number inputs for the calculation:" << endl;
+                        vector<int> selectedInputs;
+                        int inputChoice;
+                        bool verifyExistanceNumbers = false;
+                        for (size_t j = 0; j < i; ++j){
+                            FlowStep *previousStep = steps[j];
+                            if (previousStep->getType() == "NumberInputStep"){
+                                NumberInputStep *numberInputStep = dynamic_cast<NumberInputStep *>(previousStep);
+                                verifyExistanceNumbers = true;
+                                if (numberInputStep){
+                                    out << "Select Number Input Step " << j + 1 << "? (Number is: " << numberInputStep->getUserInput() << ") (Y/N): ";
+                                    if (co_await askYesNo()){
+                                        selectedInputs.push_back(j);
+                                        if (selectedInputs.size() >= 2){
+                                            break;
+                                        }
+                                        j = -1;
+                                    }
+                                }
+                            }
+                        }
+
+                        try{
+                            if (!verifyExistanceNumbers){
+                                throw runtime_error("No number input step from previous steps. Cancelling calculation.");
+                            }
+                            if (selectedInputs.size() != 2){
+                                throw runtime_error("Invalid number of selected inputs. Cancelling calculation.");
+                            }
+
+                            // A loaded step comes with the operands it was saved with; the ones chosen now replace them.
+                            calculusStep->clearNumberInputs();
+                            for (int selectedInput : selectedInputs){
+                                NumberInputStep *inputStep = dynamic_cast<NumberInputStep *>(steps[selectedInput]);
+                                if (inputStep){
+                                    calculusStep->addNumberInput(inputStep);
+                                }
+                            }
+
+                            out << "Choose the arithmetic operation (+, -, *, /, m (min), M (max)): ";
+                            char operationSymbol;
+                            bool validOperation = false;
+
+                            while (!validOperation){
+                                operationSymbol = co_await askChar();
+
+                                switch (operationSymbol){
+                                case '+':
+                                case '-':
+                                case '*':
+                                case '/':
+                                case 'm':
+                                case 'M':
+                                    validOperation = true;
+                                    break;
+                                default:
+                                    out << "Invalid symbol. Please choose a valid arithmetic operation (+, -, *, /, m (min), M (max)): ";
+                                }
+                            }
+
+                            switch (operationSymbol){
+                            case '+':
+                                calculusStep->setOperation(ArithmeticOperation::Addition);
+                                calculusStep->setOperationSymbol('+');
+                                break;
+                            case '-':
+                                calculusStep->setOperation(ArithmeticOperation::Subtraction);
+                                calculusStep->setOperationSymbol('-');
+                                break;
+                            case '*':
+                                calculusStep->setOperation(ArithmeticOperation::Multiplication);
+                                calculusStep->setOperationSymbol('*');
+                                break;
+                            case '/':
+                                calculusStep->setOperation(ArithmeticOperation::Division);
+                                calculusStep->setOperationSymbol('/');
+                                break;
+                            case 'm':
+                                calculusStep->setOperation(ArithmeticOperation::Minimum);
+                                calculusStep->setOperationSymbol('m');
+                                break;
+                            case 'M':
+                                calculusStep->setOperation(ArithmeticOperation::Maximum);
+                                calculusStep->setOperationSymbol('M');
+                                break;
+                            default:
+                                out << "Invalid symbol. Defaulting to addition." << endl;
+                                calculusStep->setOperation(ArithmeticOperation::Addition);
+                                calculusStep->setOperationSymbol('+');
+                            }
+
+                            double result = calculusStep->performCalculation();
+                            out << "Calculation Result: " << result << endl;
+                        }catch (const runtime_error &ex){
+                            err << "Error: " << ex.what() << endl;
+                        }
+                    }
+                }
+            }
+
+            else if (currentStep->getType() == "TextFileInputStep"){
+                out << i + 1 << ". " << currentStep->getType() << ": " << currentStep->getDescription() << endl;
+                out << "Do you want to complete this step? (Y/N): ";
+                if (co_await askYesNo()){
+                    TextFileInputStep *textFileInputStep = dynamic_cast<TextFileInputStep *>(currentStep);
+                    if (textFileInputStep){
+                        string fileName;
+                        while (true){
+                            out << "Enter the name of the text file (.txt): ";
+                            fileName = co_await readAnswer();
+                            if (TextFileInputStep::prepareFileName(fileName)){
+                                break;
+                            }
+                            out << "Invalid file name. Please enter a valid file name." << endl;
+                        }
+                        out << "Entered File Name: " << fileName << endl;
+                        textFileInputStep->importFile(fileName, out, takePrefetchedImport(fileName));
+                    }
+                }
+            }
+
+            else if (currentStep->getType() == "CSVFileInputStep"){
+                out << i + 1 << ". " << currentStep->getType() << ": " << currentStep->getDescription() << endl;
+                out << "Do you want to complete this step? (Y/N): ";
+                if (co_await askYesNo()){
+                    CSVFileInputStep *csvFileInputStep = dynamic_cast<CSVFileInputStep *>(currentStep);
+                    if (csvFileInputStep){
+                        string fileName;
+                        while (true){
+                            out << "Enter the name of the CSV file (.csv): ";
+                            fileName = co_await readAnswer();
+                            if (CSVFileInputStep::prepareFileName(fileName)){
+                                break;
+                            }
+                            out << "Invalid file name. Please enter a valid CSV file name." << endl;
+                        }
+                        out << "Entered File Name: " << fileName << endl;
+                        csvFileInputStep->importFile(fileName, out, err, takePrefetchedImport(fileName));
+                    }
+                }
+            }
+
+            else if (currentStep->getType() == "XLSXFileInputStep"){
+                out << i + 1 << ". " << currentStep->getType() << ": " << currentStep->getDescription() << endl;
+                out << "Do you want to complete this step? (Y/N): ";
+                if (co_await askYesNo()){
+                    XLSXFileInputStep *xlsxFileInputStep = dynamic_cast<XLSXFileInputStep *>(currentStep);
+                    if (xlsxFileInputStep){
+                        string fileName;
+                        while (true){
+                            out << "Enter the name of the spreadsheet file (.xlsx): ";
+                            fileName = co_await readAnswer();
+                            if (XLSXFileInputStep::prepareFileName(fileName)){
+                                break;
+                            }
+                            out << "Invalid file name. Please enter a valid spreadsheet file name." << endl;
+                        }
+                        out << "Enter the sheet name or number (empty for the first sheet): ";
+                        string sheetName = co_await readAnswer();
+                        out << "Entered File Name: " << fileName << endl;
+                        xlsxFileInputStep->importFile(fileName, sheetName, out, err);
+                    }
+                }
+            }
+
+            else if (currentStep->getType() == "SortStep"){
+                out << i + 1 << ". " << currentStep->getType() << ": " << currentStep->getDescription() << endl;
+                out << "Do you want to complete this step? (Y/N): ";
+                if (co_await askYesNo()){
+                    SortStep *sortStep = dynamic_cast<SortStep *>(currentStep);
+                    if (sortStep){
+                        const TableProducer *source = nullptr;
+                        for (size_t j = 0; j < i && source == nullptr; ++j){
+                            const TableProducer *table = dynamic_cast<const TableProducer *>(steps[j]);
+                            if (table && table->hasTable()){
+                                out << "Sort the table of step " << j + 1 << " (" << steps[j]->getType() << ": " << table->getTableName() << ")? (Y/N): ";
+                                if (co_await askYesNo()){
+                                    source = table;
+                                    stepRecords[i].sources.push_back(j);
+                                }
+                            }
+                        }
+                        if (source == nullptr){
+                            err << "Error: No imported table selected from previous steps. Cancelling sort." << endl;
+                        }
+                        else{
+                            vector<SortKey> keys;
+                            string keySpec;
+                            while (true){
+                                out << "Enter the sort keys (column[:num][:desc], separated by commas): ";
+                                keySpec = co_await readAnswer();
+                                if (parseSortKeys(keySpec, keys)){
+                                    break;
+                                }
+                                out << "Invalid sort keys. Example: 3:num:desc,1" << endl;
+                            }
+                            out << "Is the first row a header? (Y/N): ";
+                            bool headerRow = co_await askYesNo();
+                            sortStep->sortTable(*source, keySpec, headerRow, out, err);
+                        }
+                    }
+                }
+            }
+
+            else if (currentStep->getType() == "JoinStep"){
+                out << i + 1 << ". " << currentStep->getType() << ": " << currentStep->getDescription() << endl;
+                out << "Do you want to complete this step? (Y/N): ";
+                if (co_await askYesNo()){
+                    JoinStep *joinStep = dynamic_cast<JoinStep *>(currentStep);
+                    if (joinStep){
+                        const TableProducer *sources[2] = {nullptr, nullptr};
+                        const char *ordinals[2] = {"first", "second"};
+                        for (int side = 0; side < 2; ++side){
+                            for (size_t j = 0; j < i && sources[side] == nullptr; ++j){
+                                const TableProducer *table = dynamic_cast<const TableProducer *>(steps[j]);
+                                if (table && table->hasTable() && table != sources[0]){
+                                    out << "Use the table of step " << j + 1 << " (" << steps[j]->getType() << ": " << table->getTableName() << ") as the " << ordinals[side] << " table? (Y/N): ";
+                                    if (co_await askYesNo()){
+                                        sources[side] = table;
+                                        stepRecords[i].sources.push_back(j);
+                                    }
+                                }
+                            }
+                        }
+                        if (sources[0] == nullptr || sources[1] == nullptr){
+                            err << "Error: Two imported tables are needed from previous steps. Cancelling join." << endl;
+                        }
+                        else{
+                            string keys[2];
+                            vector<size_t> columns[2];
+                            while (true){
+                                for (int side = 0; side < 2; ++side){
+                                    while (true){
+                                        out << "Enter the key columns of the " << ordinals[side] << " table (e.g. 1,3): ";
+                                        keys[side] = co_await readAnswer();
+                                        if (parseJoinColumns(keys[side], columns[side])){
+                                            break;
+                                        }
+                                        out << "Invalid key columns. Example: 1,3" << endl;
+                                    }
+                                }
+                                if (columns[0].size() == columns[1].size()){
+                                    break;
+                                }
+                                out << "Both tables need the same number of key columns." << endl;
+                            }
+                            out << "Keep rows of the first table without a match? (Y/N): ";
+                            bool keepUnmatched = co_await askYesNo();
+                            out << "Is the first row of each table a header? (Y/N): ";
+                            bool headerRow = co_await askYesNo();
+                            joinStep->joinTables(*sources[0], *sources[1], keys[0], keys[1], keepUnmatched, headerRow, out, err);
+                        }
+                    }
+                }
+            }
+
+            else if (currentStep->getType() == "SearchStep"){
+                out << i + 1 << ". " << currentStep->getType() << ": " << currentStep->getDescription() << endl;
+                out << "Do you want to complete this step? (Y/N): ";
+                if (co_await askYesNo()){
+                    SearchStep *searchStep = dynamic_cast<SearchStep *>(currentStep);
+                    if (searchStep){
+                        const TextFileInputStep *source = nullptr;
+                        for (size_t j = 0; j < i && source == nullptr; ++j){
+                            const TextFileInputStep *text = dynamic_cast<const TextFileInputStep *>(steps[j]);
+                            if (text && text->isFileImported()){
+                                out << "Search the text of step " << j + 1 << " (" << steps[j]->getType() << ": " << text->getFileName() << ")? (Y/N): ";
+                                if (co_await askYesNo()){
+                                    source = text;
+                                    stepRecords[i].sources.push_back(j);
+                                }
+                            }
+                        }
+                        if (source == nullptr){
+                            err << "Error: No imported text selected from previous steps. Cancelling search." << endl;
+                        }
+                        else{
+                            string patterns;
+                            while (true){
+                                out << "Enter the search patterns, separated by '|': ";
+                                patterns = co_await readAnswer();
+                                if (!parseSearchPatterns(patterns).empty()){
+                                    break;
+                                }
+                                out << "Invalid search patterns. Example: ERROR|timed out" << endl;
+                            }
+                            out << "Ignore upper and lower case? (Y/N): ";
+                            bool ignoreCase = co_await askYesNo();
+                            out << "Index the text for repeated searches? (Y/N): ";
+                            bool useIndex = co_await askYesNo();
+                            searchStep->search(*source, patterns, ignoreCase, useIndex, out, err);
+                        }
+                    }
+                }
+            }
+
+            else if (currentStep->getType() == "TextStatsStep"){
+                out << i + 1 << ". " << currentStep->getType() << ": " << currentStep->getDescription() << endl;
+                out << "Do you want to complete this step? (Y/N): ";
+                if (co_await askYesNo()){
+                    TextStatsStep *textStatsStep = dynamic_cast<TextStatsStep *>(currentStep);
+                    if (textStatsStep){
+                        const TextFileInputStep *source = nullptr;
+                        for (size_t j = 0; j < i && source == nullptr; ++j){
+                            const TextFileInputStep *text = dynamic_cast<const TextFileInputStep *>(steps[j]);
+                            if (text && text->isFileImported()){
+                                out << "Count the text of step " << j + 1 << " (" << steps[j]->getType() << ": " << text->getFileName() << ")? (Y/N): ";
+                                if (co_await askYesNo()){
+                                    source = text;
+                                    stepRecords[i].sources.push_back(j);
+                                }
+                            }
+                        }
+                        if (source == nullptr){
+                            err << "Error: No imported text selected from previous steps. Cancelling statistics." << endl;
+                        }
+                        else{
+                            double topCount;
+                            while (true){
+                                out << "How many of the most frequent tokens should be listed? ";
+                                if (parseNumber(co_await readAnswer(), topCount) && topCount >= 0 && topCount <= 100000 && topCount == static_cast<size_t>(topCount)){
+                                    break;
+                                }
+                                err << "Invalid input. Please enter a whole number from 0 to 100000." << endl;
+                            }
+                            out << "Count tokens ignoring upper and lower case? (Y/N): ";
+                            bool ignoreCase = co_await askYesNo();
+                            textStatsStep->computeStats(*source, static_cast<size_t>(topCount), ignoreCase, out, err);
+                        }
+                    }
+                }
+            }
+
+            else if (currentStep->getType() == "QuantileStep"){
+                out << i + 1 << ". " << currentStep->getType() << ": " << currentStep->getDescription() << endl;
+                out << "Do you want to complete this step? (Y/N): ";
+                if (co_await askYesNo()){
+                    QuantileStep *quantileStep = dynamic_cast<QuantileStep *>(currentStep);
+                    if (quantileStep){
+                        const TableProducer *source = nullptr;
+                        for (size_t j = 0; j < i && source == nullptr; ++j){
+                            const TableProducer *table = dynamic_cast<const TableProducer *>(steps[j]);
+                            if (table && table->hasTable()){
+                                out << "Summarize the table of step " << j + 1 << " (" << steps[j]->getType() << ": " << table->getTableName() << ")? (Y/N): ";
+                                if (co_await askYesNo()){
+                                    source = table;
+                                    stepRecords[i].sources.push_back(j);
+                                }
+                            }
+                        }
+                        if (source == nullptr){
+                            err << "Error: No imported table selected from previous steps. Cancelling percentiles." << endl;
+                        }
+                        else{
+                            double column;
+                            while (true){
+                                out << "Enter the column to summarize (1-based): ";
+                                if (parseNumber(co_await readAnswer(), column) && column >= 1 && column <= 1000000 && column == static_cast<size_t>(column)){
+                                    break;
+                                }
+                                err << "Invalid input. Please enter a column number from 1." << endl;
+                            }
+                            vector<double> ranks;
+                            string percentiles;
+                            while (true){
+                                out << "Enter the percentiles to estimate (e.g. 50,95,99): ";
+                                percentiles = co_await readAnswer();
+                                if (parsePercentiles(percentiles, ranks)){
+                                    break;
+                                }
+                                out << "Invalid percentiles. Enter numbers from 0 to 100 separated by commas." << endl;
+                            }
+                            out << "Is the first row a header? (Y/N): ";
+                            bool headerRow = co_await askYesNo();
+                            quantileStep->computeQuantiles(*source, static_cast<size_t>(column), percentiles, headerRow, out, err);
+                        }
+                    }
+                }
+            }
+
+            else if (currentStep->getType() == "DistinctCountStep"){
+                out << i + 1 << ". " << currentStep->getType() << ": " << currentStep->getDescription() << endl;
+                out << "Do you want to complete this step? (Y/N): ";
+                if (co_await askYesNo()){
+                    DistinctCountStep *distinctCountStep = dynamic_cast<DistinctCountStep *>(currentStep);
+                    if (distinctCountStep){
+                        const TableProducer *source = nullptr;
+                        for (size_t j = 0; j < i && source == nullptr; ++j){
+                            const TableProducer *table = dynamic_cast<const TableProducer *>(steps[j]);
+                            if (table && table->hasTable()){
+                                out << "Count the values of the table of step " << j + 1 << " (" << steps[j]->getType() << ": " << table->getTableName() << ")? (Y/N): ";
+                                if (co_await askYesNo()){
+                                    source = table;
+                                    stepRecords[i].sources.push_back(j);
+                                }
+                            }
+                        }
+                        if (source == nullptr){
+                            err << "Error: No imported table selected from previous steps. Cancelling distinct count." << endl;
+                        }
+                        else{
+                            double column;
+                            while (true){
+                                out << "Enter the column to count (1-based): ";
+                                if (parseNumber(co_await readAnswer(), column) && column >= 1 && column <= 1000000 && column == static_cast<size_t>(column)){
+                                    break;
+                                }
+                                err << "Invalid input. Please enter a column number from 1." << endl;
+                            }
+                            out << "Count exactly (uses memory for every distinct value)? (Y/N): ";
+                            bool exact = co_await askYesNo();
+                            double precision = HyperLogLog::DEFAULT_PRECISION;
+                            while (!exact){
+                                out << "Enter the sketch precision from " << HyperLogLog::MIN_PRECISION << " to " << HyperLogLog::MAX_PRECISION << " (" << HyperLogLog::DEFAULT_PRECISION << " gives about 0.8% error): ";
+                                if (parseNumber(co_await readAnswer(), precision) && precision >= HyperLogLog::MIN_PRECISION && precision <= HyperLogLog::MAX_PRECISION && precision == static_cast<unsigned>(precision)){
+                                    break;
+                                }
+                                err << "Invalid input. Please enter a whole number from " << HyperLogLog::MIN_PRECISION << " to " << HyperLogLog::MAX_PRECISION << "." << endl;
+                            }
+                            out << "Is the first row a header? (Y/N): ";
+                            bool headerRow = co_await askYesNo();
+                            distinctCountStep->countValues(*source, static_cast<size_t>(column), exact, static_cast<unsigned>(precision), headerRow, out, err);
+                        }
+                    }
+                }
+            }
+
+            else if (currentStep->getType() == "RegexTransformStep"){
+                out << i + 1 << ". " << currentStep->getType() << ": " << currentStep->getDescription() << endl;
+                out << "Do you want to complete this step? (Y/N): ";
+                if (co_await askYesNo()){
+                    RegexTransformStep *regexTransformStep = dynamic_cast<RegexTransformStep *>(currentStep);
+                    if (regexTransformStep){
+                        const TextFileInputStep *source = nullptr;
+                        for (size_t j = 0; j < i && source == nullptr; ++j){
+                            const TextFileInputStep *text = dynamic_cast<const TextFileInputStep *>(steps[j]);
+                            if (text && text->isFileImported()){
+                                out << "Transform the text of step " << j + 1 << " (" << steps[j]->getType() << ": " << text->getFileName() << ")? (Y/N): ";
+                                if (co_await askYesNo()){
+                                    source = text;
+                                    stepRecords[i].sources.push_back(j);
+                                }
+                            }
+                        }
+                        if (source == nullptr){
+                            err << "Error: No imported text selected from previous steps. Cancelling transform." << endl;
+                        }
+                        else{
+                            string pattern;
+                            while (true){
+                                out << "Enter the regular expression, with one capture group per column: ";
+                                pattern = co_await readAnswer();
+                                try{
+                                    compileRegex(pattern);
+                                    break;
+                                }catch (const invalid_argument &e){
+                                    out << "Invalid regular expression: " << e.what() << ". Example: ^(\\S+) (\\w+) (.*)$" << endl;
+                                }
+                            }
+                            regexTransformStep->transform(*source, pattern, out, err);
+                        }
+                    }
+                }
+            }
+
+            else if (currentStep->getType() == "OutputStep"){
+                out << i + 1 << ". " << currentStep->getType() << ": " << currentStep->getDescription() << endl;
+                out << "Do you want to complete this step? (Y/N): ";
+                if (co_await askYesNo()){
+                    string filenameOutput;
+                    string titleOutput;
+                    string descriptionOutput;
+                    bool validFileName = false;
+                    while (!validFileName){
+                        out << "Enter filename for the output: ";
+                        filenameOutput = co_await readAnswer();
+                        if (isValidFileName(filenameOutput)){
+                            validFileName = true;
+                        }
+                        else{
+                            err << "Error: Invalid filename. Please enter a valid filename." << endl;
+                        }
+                    }
+
+                    out << "Enter title for the output: ";
+                    titleOutput = co_await readAnswer();
+
+                    out << "Enter description for the output: ";
+                    descriptionOutput = co_await readAnswer();
+
+                    int numberOutputTitleStep = 0;
+                    int numberOutputTextStep = 0;
+                    int numberOutputNumberStep = 0;
+                    int numberOutputCalculusStep = 0;
+                    int numberOutputTextFileStep = 0;
+                    int numberOutputCsvFileStep = 0;
+                    int numberOutputXLSXFileStep = 0;
+                    int numberOutputSortStep = 0;
+                    int numberOutputJoinStep = 0;
+                    int numberOutputSearchStep = 0;
+                    int numberOutputTextStatsStep = 0;
+                    int numberOutputQuantileStep = 0;
+                    int numberOutputDistinctCountStep = 0;
+                    int numberOutputRegexTransformStep = 0;
+                    vector<OutputRows> outputRows;
+
+                    OutputStep *outputStep = dynamic_cast<OutputStep *>(currentStep);
+                    if (outputStep){
+                        outputData.clear();
+                        for (size_t m = 0; m < i; ++m){
+                            FlowStep *previousStep = steps[m];
+
+                            if (previousStep->getType() == "TitleStep"){
+                                TitleStep *titleStep = dynamic_cast<TitleStep *>(previousStep);
+                                if (titleStep){
+                                    out << "Do you want to output the title and subtitle of the " << titleStep->getType() << " " << numberOutputTitleStep + 1 << "? (Y/N): ";
+                                    if (co_await askYesNo()){
+                                        outputData.push_back("Title " + to_string(numberOutputTitleStep + 1) + ": " + titleStep->getTitle());
+                                        outputData.push_back("Subtitle " + to_string(numberOutputTitleStep + 1) + ": " + titleStep->getSubtitle());
+                                    }
+                                    numberOutputTitleStep++;
+                                }
+                            }
+
+                            else if (previousStep->getType() == "TextStep"){
+                                TextStep *textStep = dynamic_cast<TextStep *>(previousStep);
+                                if (textStep){
+                                    out << "Do you want to output the title and text of the " << textStep->getType() << " " << numberOutputTextStep + 1 << "? (Y/N): ";
+                                    if (co_await askYesNo()){
+                                        outputData.push_back("Text Title " + to_string(numberOutputTextStep + 1) + ": " + textStep->getTitle());
+                                        outputData.push_back("Text " + to_string(numberOutputTextStep + 1) + ": " + textStep->getText());
+                                    }
+                                    numberOutputTextStep++;
+                                }
+                            }
+
+                            else if (previousStep->getType() == "NumberInputStep"){
+                                NumberInputStep *numberInputStep = dynamic_cast<NumberInputStep *>(previousStep);
+                                if (numberInputStep){
+                                    out << "Do you want to output the number of the " << numberInputStep->getType() << " " << numberOutputNumberStep + 1 << "? (Y/N): ";
+                                    if (co_await askYesNo()){
+                                        outputData.push_back("Number Input " + to_string(numberOutputNumberStep + 1) + ": " + to_string(numberInputStep->getUserInput()));
+                                    }
+                                    numberOutputNumberStep++;
+                                }
+                            }
+
+                            else if (previousStep->getType() == "CalculusStep"){
+                                CalculusStep<double> *calculusStep = dynamic_cast<CalculusStep<double> *>(previousStep);
+                                if (calculusStep){
+                                    out << "Do you want to output the calculus of the " << calculusStep->getType() << " " << numberOutputCalculusStep + 1 << "? (Y/N): ";
+                                    if (co_await askYesNo()){
+                                        char operationSymbol = calculusStep->getOperationSymbol();
+                                        string calculusOutput = "Calculus Result " + to_string(numberOutputCalculusStep + 1) + ": ";
+
+                                        if (operationSymbol == 'm' || operationSymbol == 'M'){
+                                            string operationName = (operationSymbol == 'm') ? "min" : "max";
+                                            calculusOutput += operationName + "(";
+                                        }
+
+                                        for (size_t i = 0; i < calculusStep->getNumberInputs().size(); ++i){
+                                            calculusOutput += to_string(calculusStep->getNumberInputs()[i]->getUserInput());
+                                            if (i < calculusStep->getNumberInputs().size() - 1){
+                                                if (operationSymbol == 'm' || operationSymbol == 'M'){
+                                                    calculusOutput += ", ";
+                                                }
+                                                else{
+                                                    calculusOutput += " " + to_string(operationSymbol) + " ";
+                                                }
+                                            }
+                                        }
+
+                                        if (operationSymbol == 'm' || operationSymbol == 'M'){
+                                            calculusOutput += ")";
+                                        }
+                                        else{
+                                            calculusOutput += " = ";
+                                        }
+
+                                        calculusOutput += to_string(calculusStep->performCalculation());
+                                        outputData.push_back(calculusOutput);
+                                    }
+                                    numberOutputCalculusStep++;
+                                }
+                            }
+
+                            else if (previousStep->getType() == "TextFileInputStep"){
+                                TextFileInputStep *textFileInputStep = dynamic_cast<TextFileInputStep *>(previousStep);
+                                if (textFileInputStep){
+                                    out << "Do you want to output the text contents of the " << textFileInputStep->getType() << " " << numberOutputTextFileStep + 1 << "? (Y/N): ";
+                                    if (co_await askYesNo()){
+                                        outputData.push_back("Name of the Text File Input " + to_string(numberOutputTextFileStep + 1) + ": " + textFileInputStep->getFileName());
+                                        if (textFileInputStep->getSources().size() > 1){
+                                            for (const ImportSource &source : textFileInputStep->getSources()){
+                                                outputData.push_back("Part of the Text File Input " + to_string(numberOutputTextFileStep + 1) + ": " + describeImportSource(source));
+                                            }
+                                        }
+                                        outputData.push_back("Content of the Text File Input " + to_string(numberOutputTextFileStep + 1) + ": ");
+                                        outputData.push_back(textFileInputStep->getFileContent());
+                                    }
+                                    numberOutputTextFileStep++;
+                                }
+                            }
+
+                            else if (previousStep->getType() == "CSVFileInputStep"){
+                                CSVFileInputStep *csvFileInputStep = dynamic_cast<CSVFileInputStep *>(previousStep);
+                                if (csvFileInputStep){
+                                    out << "Do you want to output the text contents of the" << csvFileInputStep->getType() << " " << numberOutputCsvFileStep + 1 << "? (Y/N): ";
+                                    if (co_await askYesNo()){
+                                        outputData.push_back("Name of the CSV File Input " + to_string(numberOutputCsvFileStep + 1) + ": " + csvFileInputStep->getFileName());
+                                        if (csvFileInputStep->getSources().size() > 1){
+                                            for (const ImportSource &source : csvFileInputStep->getSources()){
+                                                outputData.push_back("Part of the CSV File Input " + to_string(numberOutputCsvFileStep + 1) + ": " + describeImportSource(source));
+                                            }
+                                        }
+                                        outputData.push_back("Content of the CSV File Input " + to_string(numberOutputCsvFileStep + 1) + ": ");
+                                        const vector<vector<string>> &csvData = csvFileInputStep->getCSVData();
+                                        for (size_t row = 0; row < csvData.size(); ++row){
+                                            string rowContent;
+                                            for (size_t col = 0; col < csvData[row].size(); ++col){
+                                                rowContent += csvData[row][col] + ", ";
+                                            }
+                                            outputData.push_back(rowContent);
+                                        }
+                                    }
+                                    numberOutputCsvFileStep++;
+                                }
+                            }
+
+                            else if (previousStep->getType() == "XLSXFileInputStep"){
+                                XLSXFileInputStep *xlsxFileInputStep = dynamic_cast<XLSXFileInputStep *>(previousStep);
+                                if (xlsxFileInputStep){
+                                    out << "Do you want to output the contents of the " << xlsxFileInputStep->getType() << " " << numberOutputXLSXFileStep + 1 << "? (Y/N): ";
+                                    if (co_await askYesNo()){
+                                        outputData.push_back("Name of the Spreadsheet Input " + to_string(numberOutputXLSXFileStep + 1) + ": " + xlsxFileInputStep->getFileName());
+                                        outputData.push_back("Content of the Spreadsheet Input " + to_string(numberOutputXLSXFileStep + 1) + ": ");
+                                        const vector<vector<string>> &tableData = xlsxFileInputStep->getTableData();
+                                        for (size_t row = 0; row < tableData.size(); ++row){
+                                            string rowContent;
+                                            for (size_t col = 0; col < tableData[row].size(); ++col){
+                                                rowContent += tableData[row][col] + ", ";
+                                            }
+                                            outputData.push_back(rowContent);
+                                        }
+                                    }
+                                    numberOutputXLSXFileStep++;
+                                }
+                            }
+
+                            else if (previousStep->getType() == "SortStep"){
+                                SortStep *sortStep = dynamic_cast<SortStep *>(previousStep);
+                                if (sortStep && sortStep->hasTable()){
+                                    out << "Do you want to output the sorted table of the " << sortStep->getType() << " " << numberOutputSortStep + 1 << "? (Y/N): ";
+                                    if (co_await askYesNo()){
+                                        outputData.push_back("Sorted Table " + to_string(numberOutputSortStep + 1) + " of: " + sortStep->getSourceName() + " (keys " + sortStep->getKeySpec() + ")");
+                                        outputData.push_back("Content of the Sorted Table " + to_string(numberOutputSortStep + 1) + ": ");
+                                        // Streamed by the writer, so a table spilled to disk is never loaded whole.
+                                        outputRows.push_back(OutputRows{outputData.size(), openTableForScan(*sortStep)});
+                                    }
+                                    numberOutputSortStep++;
+                                }
+                            }
+
+                            else if (previousStep->getType() == "JoinStep"){
+                                JoinStep *joinStep = dynamic_cast<JoinStep *>(previousStep);
+                                if (joinStep && joinStep->hasTable()){
+                                    out << "Do you want to output the joined table of the " << joinStep->getType() << " " << numberOutputJoinStep + 1 << "? (Y/N): ";
+                                    if (co_await askYesNo()){
+                                        outputData.push_back("Joined Table " + to_string(numberOutputJoinStep + 1) + " of: " + joinStep->getTableName() + " (keys " + joinStep->getLeftKeys() + " = " + joinStep->getRightKeys() + ")");
+                                        outputData.push_back("Content of the Joined Table " + to_string(numberOutputJoinStep + 1) + ": ");
+                                        outputRows.push_back(OutputRows{outputData.size(), openTableForScan(*joinStep)});
+                                    }
+                                    numberOutputJoinStep++;
+                                }
+                            }
+
+                            else if (previousStep->getType() == "SearchStep"){
+                                SearchStep *searchStep = dynamic_cast<SearchStep *>(previousStep);
+                                if (searchStep && searchStep->isSearched()){
+                                    out << "Do you want to output the matching lines of the " << searchStep->getType() << " " << numberOutputSearchStep + 1 << "? (Y/N): ";
+                                    if (co_await askYesNo()){
+                                        outputData.push_back("Search " + to_string(numberOutputSearchStep + 1) + " of: " + searchStep->getTextName() + " (patterns " + searchStep->getPatterns() + ")");
+                                        outputData.push_back("Matching lines of the Search " + to_string(numberOutputSearchStep + 1) + ": " + to_string(searchStep->getMatches().size()));
+                                        for (const SearchMatch &match : searchStep->getMatches()){
+                                            outputData.push_back(match.fileName + ":" + to_string(match.line) + ": " + match.text);
+                                        }
+                                    }
+                                    numberOutputSearchStep++;
+                                }
+                            }
+
+                            else if (previousStep->getType() == "TextStatsStep"){
+                                TextStatsStep *textStatsStep = dynamic_cast<TextStatsStep *>(previousStep);
+                                if (textStatsStep && textStatsStep->isComputed()){
+                                    out << "Do you want to output the statistics of the " << textStatsStep->getType() << " " << numberOutputTextStatsStep + 1 << "? (Y/N): ";
+                                    if (co_await askYesNo()){
+                                        const TextStats &stats = textStatsStep->getStats();
+                                        outputData.push_back("Text Statistics " + to_string(numberOutputTextStatsStep + 1) + " of: " + textStatsStep->getTextName());
+                                        outputData.push_back("Lines: " + to_string(stats.lines) + ", Words: " + to_string(stats.words) + ", Bytes: " + to_string(stats.bytes) + ", Tokens: " + to_string(stats.tokens) + " (" + to_string(stats.distinctTokens) + " distinct)");
+                                        outputData.push_back("Most frequent tokens:");
+                                        for (const TokenCount &token : stats.topTokens){
+                                            outputData.push_back(token.token + ": " + to_string(token.count));
+                                        }
+                                    }
+                                    numberOutputTextStatsStep++;
+                                }
+                            }
+
+                            else if (previousStep->getType() == "QuantileStep"){
+                                QuantileStep *quantileStep = dynamic_cast<QuantileStep *>(previousStep);
+                                if (quantileStep && quantileStep->isComputed()){
+                                    out << "Do you want to output the percentiles of the " << quantileStep->getType() << " " << numberOutputQuantileStep + 1 << "? (Y/N): ";
+                                    if (co_await askYesNo()){
+                                        outputData.push_back("Quantiles " + to_string(numberOutputQuantileStep + 1) + " of: " + quantileStep->getSourceName() + " (column " + to_string(quantileStep->getColumn()) + ")");
+                                        for (const string &line : quantileStep->describeResults()){
+                                            outputData.push_back(line);
+                                        }
+                                    }
+                                    numberOutputQuantileStep++;
+                                }
+                            }
+
+                            else if (previousStep->getType() == "DistinctCountStep"){
+                                DistinctCountStep *distinctCountStep = dynamic_cast<DistinctCountStep *>(previousStep);
+                                if (distinctCountStep && distinctCountStep->isComputed()){
+                                    out << "Do you want to output the distinct count of the " << distinctCountStep->getType() << " " << numberOutputDistinctCountStep + 1 << "? (Y/N): ";
+                                    if (co_await askYesNo()){
+                                        outputData.push_back("Distinct Count " + to_string(numberOutputDistinctCountStep + 1) + " of: " + distinctCountStep->getSourceName() + " (column " + to_string(distinctCountStep->getColumn()) + ")");
+                                        for (const string &line : distinctCountStep->describeResults()){
+                                            outputData.push_back(line);
+                                        }
+                                    }
+                                    numberOutputDistinctCountStep++;
+                                }
+                            }
+
+                            else if (previousStep->getType() == "RegexTransformStep"){
+                                RegexTransformStep *regexTransformStep = dynamic_cast<RegexTransformStep *>(previousStep);
+                                if (regexTransformStep && regexTransformStep->hasTable()){
+                                    out << "Do you want to output the extracted table of the " << regexTransformStep->getType() << " " << numberOutputRegexTransformStep + 1 << "? (Y/N): ";
+                                    if (co_await askYesNo()){
+                                        outputData.push_back("Regex Transform " + to_string(numberOutputRegexTransformStep + 1) + " of: " + regexTransformStep->getTextName() + " (pattern " + regexTransformStep->getPattern() + ")");
+                                        outputData.push_back("Content of the Regex Transform " + to_string(numberOutputRegexTransformStep + 1) + ": ");
+                                        outputRows.push_back(OutputRows{outputData.size(), openTableForScan(*regexTransformStep)});
+                                    }
+                                    numberOutputRegexTransformStep++;
+                                }
+                            }
+                        }
+                    }
+
+                    outputStep->setFilename(filenameOutput);
+                    outputStep->setTitle(titleOutput);
+                    outputStep->setDescription(descriptionOutput);
+                    // Written in the background; the result is reported by the EndStep.
+                    unique_ptr<OutputStep> write(new OutputStep(filenameOutput, titleOutput, descriptionOutput));
+                    write->setOutputData(move(outputData));
+                    write->setOutputRows(move(outputRows));
+                    pendingWrites.push_back(PendingWrite{i + 1, OutputWriter::instance().queue(move(write)), filenameOutput});
+                }
+                else{
+                    out << "Output step skipped." << endl;
+                }
+            }
+
+            else if (currentStep->getType() == "EndStep"){
+                out << i + 1 << ". " << currentStep->getType() << ": " << currentStep->getDescription() << endl;
+                finishPendingWrites();
+                out << "Flow Completed!" << endl;
+                runCompleted = true;
+                if (recordingOutput.recording){
+                    for (const FlowStep *step : steps){
+                        ResultCache::addStepInputs(step, recordedInputs);
+                    }
+                }
+                if (!keepResults){
+                    for (FlowStep *step : steps){
+                        step->reset();
+                    }
+                }
+            }
+        }
+    }
+    catch (const exception &ex){
+        err << "Error: " << ex.what() << endl;
+    }
+    catch (...){
+        err << "An unknown error occurred." << endl;
+    }
+    // A flow that stopped early still reports the files it queued.
+    finishPendingWrites();
+    discardPrefetches();
+    out.flush();
+    err.flush();
+    if (recordingOutput.recording && runCompleted){
+        RecordedRun recorded;
+        for (const StepRecord &record : stepRecords){
+            recorded.answers.insert(recorded.answers.end(), record.answers.begin(), record.answers.end());
+        }
+        recorded.inputs = move(recordedInputs);
+        recorded.outputs = move(recordingOutput.outputs);
+        ResultCache::instance().store(flowHash, recorded);
+    }
+    recordingOutput.recording = false;
+    recordingOutput.outputs.clear();
+    lastRunMetrics.wallSeconds = chrono::duration<double>(chrono::steady_clock::now() - runStart).count();
+    exportRunMetrics(lastRunMetrics);
+    exportTrace();
+}
+
+void FlowExecutor::executeFlow(){
+    // With a blocking input the task never suspends and is done when start() returns.
+    FlowTask<void> task = run();
+    mutex doneMutex;
+    condition_variable doneSignal;
+    bool done = false;
+    task.start([&](){
+        lock_guard<mutex> guard(doneMutex);
+        done = true;
+        doneSignal.notify_all();
+    });
+    unique_lock<mutex> guard(doneMutex);
+    doneSignal.wait(guard, [&](){return done;});
+    task.getResult();
+}
@@ -0,0 +1,158 @@
+#ifndef FLOWMAKER_FLOW_EXECUTOR_H
+#define FLOWMAKER_FLOW_EXECUTOR_H
+
+#include <chrono>
+#include <coroutine>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Flow.h"
+#include "FlowIO.h"
+#include "FlowMetrics.h"
+#include "FlowTask.h"
+#include "ImportPrefetcher.h"
+#include "OutputWriter.h"
+#include "ResultCache.h"
+
+// Runs a flow step by step, asking its input for every answer and printing to its
+// output. Executors built from a flow alone use the console.
+class FlowExecutor{
+    public:
+        // What a run saw of one step, so that the step can be run again on its own.
+        struct StepRecord{
+            // The answers the step read, in order.
+            std::vector<std::string> answers;
+            // Earlier steps (0-based) whose table or text the step was given. Empty
+            // for steps that do not pick their sources, which may use any earlier step.
+            std::vector<size_t> sources;
+        };
+    private:
+        // Passes everything on to the output of the run and, while recording is set,
+        // keeps it for the result cache.
+        class RecordingOutput : public FlowOutput{
+            private:
+                FlowOutput &target;
+                void record(RunOutput::Kind kind, const std::string &text);
+            public:
+                bool recording = false;
+                std::vector<RunOutput> outputs;
+
+                RecordingOutput(FlowOutput &target) : target(target) {}
+                void write(const std::string &text) override;
+                void writeError(const std::string &text) override;
+                void addFile(const std::string &fileName, std::string contents);
+        };
+
+        Flow &flow;
+        FlowInput &input;
+        RecordingOutput recordingOutput;
+        FlowOutputStream out;
+        FlowOutputStream err;
+        RunMetrics lastRunMetrics;
+        double stepInputWait = 0;
+
+        StepMeasurement *activeMeasurement = nullptr;
+        // Imports this run asked ImportPrefetcher for and has not taken yet.
+        std::vector<std::string> prefetchedImports;
+
+        // Output files queued by OutputStep and not reported yet.
+        struct PendingWrite{
+            size_t stepIndex;
+            std::future<OutputWriteResult> result;
+            // As the flow asked for it.
+            std::string fileName;
+        };
+        std::vector<PendingWrite> pendingWrites;
+        std::vector<StepRecord> stepRecords;
+        size_t currentStepIndex = 0;
+        // Steps to run; the others are left as the previous run left them. Empty runs all.
+        std::vector<bool> stepsToRun;
+        bool keepResults = false;
+        // Files the run imported, noted for the result cache before the steps are reset.
+        std::vector<RunInput> recordedInputs;
+        bool runCompleted = false;
+
+        // Appends the metrics of step `index` when the loop iteration ends, however it ends.
+        class StepRecorder{
+            private:
+                FlowExecutor &executor;
+                size_t index;
+                std::string type;
+                StepMeasurement measurement;
+            public:
+                StepRecorder(FlowExecutor &executor, size_t index, const std::string &type) : executor(executor), index(index), type(type){
+                    executor.stepInputWait = 0;
+                    executor.activeMeasurement = &measurement;
+                }
+
+                ~StepRecorder(){
+                    StepMetrics metrics = measurement.finish(index, type);
+                    metrics.inputWaitSeconds = executor.stepInputWait;
+                    executor.lastRunMetrics.steps.push_back(metrics);
+                    executor.activeMeasurement = nullptr;
+                }
+        };
+
+        // Awaitable for the next answer. Flushes the pending prompt first, completes
+        // without suspending for blocking inputs and throws FlowInputClosed when the
+        // input has no more answers.
+        class AnswerAwaiter{
+            private:
+                FlowExecutor &executor;
+                std::string line;
+                bool received = false;
+                bool paused = false;
+                std::chrono::steady_clock::time_point waitStart;
+            public:
+                AnswerAwaiter(FlowExecutor &executor) : executor(executor) {}
+                bool await_ready();
+                bool await_suspend(std::coroutine_handle<> handle);
+                std::string await_resume();
+        };
+
+        AnswerAwaiter readAnswer() {return AnswerAwaiter(*this);}
+        // First non-blank character of the next non-blank answer.
+        FlowTask<char> askChar();
+        // True if that character is 'Y' or 'y'.
+        FlowTask<bool> askYesNo();
+        static bool parseNumber(const std::string &text, double &value);
+
+        // Prefetches the imports whose names are known before the run reaches them:
+        // names kept in the saved steps and answers the input already has queued.
+        void startPrefetches();
+        void prefetchImport(const std::string &fileName, bool parseCSV);
+        // The prefetched import of fileName, or nullptr if there is none to use.
+        std::shared_ptr<PrefetchedImport> takePrefetchedImport(const std::string &fileName);
+        void discardPrefetches();
+        // Waits for the queued output files, reports each one and adds what it wrote
+        // to the metrics of its step.
+        void finishPendingWrites();
+        // Prints what a recorded run printed and writes its output files again.
+        void replayOutputs(std::vector<RunOutput> &outputs);
+    public:
+        FlowExecutor(Flow &flow);
+        FlowExecutor(Flow &flow, FlowInput &input, FlowOutput &output);
+        FlowExecutor(const FlowExecutor &) = delete;
+        FlowExecutor &operator=(const FlowExecutor &) = delete;
+        ~FlowExecutor();
+
+        const RunMetrics &getLastRunMetrics() const {return lastRunMetrics;}
+        // One record per step of the flow, filled in by the last run.
+        const std::vector<StepRecord> &getStepRecords() const {return stepRecords;}
+        // Runs only the steps marked in steps; the results of the others are kept and
+        // they read no answers. For reruns of a flow run before with keepResults.
+        void setStepsToRun(const std::vector<bool> &steps) {stepsToRun = steps;}
+        // Keeps the results of the steps when the flow ends instead of resetting them.
+        void setKeepResults(bool keep) {keepResults = keep;}
+
+        // Runs the flow as a coroutine that suspends whenever an asynchronous input
+        // has no answer yet. The caller owns the task and decides where it runs.
+        FlowTask<void> run();
+
+        // Runs the flow to the end on the calling thread.
+        void executeFlow();
+};
+
+#endif
@@ -0,0 +1,96 @@
+#include "FlowIO.h"
+
+#include <iostream>
+
+using namespace std;
+
+bool ConsoleInput::readLine(string &line){
+    if (!getline(cin, line)){
+        return false;
+    }
+    if (!line.empty() && line.back() == '\r'){
+        line.pop_back();
+    }
+    return true;
+}
+
+void ConsoleOutput::write(const string &text){
+    cout << text << flush;
+}
+
+void ConsoleOutput::writeError(const string &text){
+    cerr << text << flush;
+}
+
+ScriptedInput ScriptedInput::fromText(const string &text){
+    vector<string> lines;
+    size_t lineStart = 0;
+    while (lineStart < text.size()){
+        size_t lineEnd = text.find('\n', lineStart);
+        if (lineEnd == string::npos){
+            lineEnd = text.size();
+        }
+        string line = text.substr(lineStart, lineEnd - lineStart);
+        if (!line.empty() && line.back() == '\r'){
+            line.pop_back();
+        }
+        lines.push_back(line);
+        lineStart = lineEnd + 1;
+    }
+    return ScriptedInput(lines);
+}
+
+bool ScriptedInput::readLine(string &line){
+    if (next >= lines.size()){
+        return false;
+    }
+    line = lines[next++];
+    return true;
+}
+
+void ScriptedInput::peekLines(vector<string> &queued, size_t maxLines){
+    for (size_t i = next; i < lines.size() && i < next + maxLines; ++i){
+        queued.push_back(lines[i]);
+    }
+}
+
+FlowInput &consoleInput(){
+    static ConsoleInput input;
+    return input;
+}
+
+FlowOutput &consoleOutput(){
+    static ConsoleOutput output;
+    return output;
+}
+
+FlowOutputBuffer::int_type FlowOutputBuffer::overflow(int_type ch){
+    if (!traits_type::eq_int_type(ch, traits_type::eof())){
+        pending.push_back(traits_type::to_char_type(ch));
+    }
+    return traits_type::not_eof(ch);
+}
+
+streamsize FlowOutputBuffer::xsputn(const char *text, streamsize count){
+    pending.append(text, static_cast<size_t>(count));
+    return count;
+}
+
+int FlowOutputBuffer::sync(){
+    if (pending.empty()){
+        return 0;
+    }
+    try{
+        if (errorStream){
+            output.writeError(pending);
+        }
+        else{
+            output.write(pending);
+        }
+    }catch (...){
+        pending.clear();
+        return -1;
+    }
+    pending.clear();
+    return 0;
+}
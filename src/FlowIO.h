@@ -0,0 +1,145 @@
+#ifndef FLOWMAKER_FLOW_IO_H
+#define FLOWMAKER_FLOW_IO_H
+
+#include <coroutine>
+#include <functional>
+#include <ostream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+// Source of the answers a flow run asks for, one line per prompt.
+//
+// Blocking inputs only implement readLine(); the executor calls it directly and never
+// suspends. Asynchronous inputs return true from isAsynchronous() and implement
+// requestLine() instead, so a flow waiting for an answer costs no thread.
+class FlowInput{
+    public:
+        // Reads the next answer without its line terminator. Returns false once the
+        // input has no more answers.
+        virtual bool readLine(std::string &) {return false;}
+
+        virtual bool isAsynchronous() const {return false;}
+
+        // Appends up to maxLines answers that are already queued, without consuming
+        // them. Inputs that cannot look ahead append nothing.
+        virtual void peekLines(std::vector<std::string> &, size_t) {}
+
+        // Fills in line and received (false at the end of the input) and returns true
+        // if an answer is ready now. Otherwise returns false, fills them in later from
+        // any thread and then resumes `resume` exactly once.
+        virtual bool requestLine(std::string &line, bool &received, std::coroutine_handle<>){
+            received = readLine(line);
+            return true;
+        }
+
+        virtual ~FlowInput() {}
+};
+
+// Destination of everything a flow run prints. Text arrives in whole lines, except
+// for prompts, which are written just before the next answer is read.
+class FlowOutput{
+    public:
+        virtual void write(const std::string &text) = 0;
+        virtual void writeError(const std::string &text) = 0;
+        virtual ~FlowOutput() {}
+};
+
+// Thrown by the executor when the input ends while the flow still asks for answers.
+class FlowInputClosed : public std::runtime_error{
+    public:
+        FlowInputClosed() : std::runtime_error("The flow input ended before the flow was completed.") {}
+};
+
+class ConsoleInput : public FlowInput{
+    public:
+        bool readLine(std::string &line) override;
+};
+
+class ConsoleOutput : public FlowOutput{
+    public:
+        void write(const std::string &text) override;
+        void writeError(const std::string &text) override;
+};
+
+// Answers taken from a fixed list, e.g. a recorded session or a test script.
+class ScriptedInput : public FlowInput{
+    private:
+        std::vector<std::string> lines;
+        size_t next = 0;
+    public:
+        ScriptedInput(const std::vector<std::string> &lines = {}) : lines(lines) {}
+
+        // Splits text at '\n'; a trailing '\r' is dropped from every line.
+        static ScriptedInput fromText(const std::string &text);
+
+        bool readLine(std::string &line) override;
+        void peekLines(std::vector<std::string> &queued, size_t maxLines) override;
+        void addLine(const std::string &line) {lines.push_back(line);}
+        size_t getRemaining() const {return lines.size() - next;}
+};
+
+class CallbackInput : public FlowInput{
+    private:
+        std::function<bool(std::string &)> readCallback;
+    public:
+        CallbackInput(std::function<bool(std::string &)> readCallback) : readCallback(std::move(readCallback)) {}
+        bool readLine(std::string &line) override {return readCallback(line);}
+};
+
+class CallbackOutput : public FlowOutput{
+    private:
+        std::function<void(const std::string &)> writeCallback;
+        std::function<void(const std::string &)> errorCallback;
+    public:
+        // Errors go to writeCallback as well when no errorCallback is given.
+        CallbackOutput(std::function<void(const std::string &)> writeCallback, std::function<void(const std::string &)> errorCallback = nullptr)
+            : writeCallback(std::move(writeCallback)), errorCallback(std::move(errorCallback)) {}
+
+        void write(const std::string &text) override {writeCallback(text);}
+        void writeError(const std::string &text) override {(errorCallback ? errorCallback : writeCallback)(text);}
+};
+
+// Output that keeps everything, for tests and for callers that want the transcript.
+class StringOutput : public FlowOutput{
+    private:
+        std::string text;
+        std::string errors;
+    public:
+        void write(const std::string &newText) override {text += newText;}
+        void writeError(const std::string &newText) override {errors += newText;}
+        const std::string &getText() const {return text;}
+        const std::string &getErrors() const {return errors;}
+        void clear() {text.clear(); errors.clear();}
+};
+
+// Shared console endpoints used by executors built without an explicit input/output.
+FlowInput &consoleInput();
+FlowOutput &consoleOutput();
+
+// Stream buffer collecting what a step prints and handing it to a FlowOutput on flush.
+class FlowOutputBuffer : public std::streambuf{
+    private:
+        FlowOutput &output;
+        bool errorStream;
+        std::string pending;
+    protected:
+        int_type overflow(int_type ch) override;
+        std::streamsize xsputn(const char *text, std::streamsize count) override;
+        int sync() override;
+    public:
+        FlowOutputBuffer(FlowOutput &output, bool errorStream) : output(output), errorStream(errorStream) {}
+};
+
+// ostream over a FlowOutput, so the executor can keep using operator<< and endl.
+class FlowOutputStream : public std::ostream{
+    private:
+        FlowOutputBuffer buffer;
+    public:
+        FlowOutputStream(FlowOutput &output, bool errorStream = false) : std::ostream(nullptr), buffer(output, errorStream){
+            rdbuf(&buffer);
+        }
+};
+
+#endif
@@ -0,0 +1,206 @@
+#include "FlowMetrics.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+
+using namespace std;
+
+thread_local StepCounters stepCounters;
+
+StepCounters countersSince(const StepCounters &before){
+    StepCounters counters;
+    counters.bytesRead = stepCounters.bytesRead - before.bytesRead;
+    counters.bytesWritten = stepCounters.bytesWritten - before.bytesWritten;
+    counters.rowsParsed = stepCounters.rowsParsed - before.rowsParsed;
+    counters.allocations = stepCounters.allocations - before.allocations;
+    counters.allocatedBytes = stepCounters.allocatedBytes - before.allocatedBytes;
+    counters.liveBytes = stepCounters.liveBytes - before.liveBytes;
+    return counters;
+}
+
+void creditCounters(const StepCounters &counters){
+    stepCounters.bytesRead += counters.bytesRead;
+    stepCounters.bytesWritten += counters.bytesWritten;
+    stepCounters.rowsParsed += counters.rowsParsed;
+    stepCounters.allocations += counters.allocations;
+    stepCounters.allocatedBytes += counters.allocatedBytes;
+    stepCounters.liveBytes += counters.liveBytes;
+    if (stepCounters.liveBytes > stepCounters.peakLiveBytes){
+        stepCounters.peakLiveBytes = stepCounters.liveBytes;
+    }
+}
+
+string escapeMetricsString(const string &text){
+    string escaped;
+    for (char ch : text){
+        if (ch == '"' || ch == '\\'){
+            escaped += '\\';
+            escaped += ch;
+        }
+        else if (ch == '\n'){
+            escaped += "\\n";
+        }
+        else if (static_cast<unsigned char>(ch) >= 0x20){
+            escaped += ch;
+        }
+    }
+    return escaped;
+}
+
+void writeHistogramJSON(ostream &out, const LatencyHistogram &histogram){
+    const vector<double> &bounds = LatencyHistogram::bucketBounds();
+    out << "{\"count\": " << histogram.getCount() << ", \"sum_seconds\": " << histogram.getSum()
+        << ", \"p50_seconds\": " << histogram.quantile(0.5) << ", \"p99_seconds\": " << histogram.quantile(0.99) << ", \"buckets\": [";
+    const vector<uint64_t> &counts = histogram.getBucketCounts();
+    bool first = true;
+    for (size_t bucket = 0; bucket < counts.size(); ++bucket){
+        if (counts[bucket] == 0){
+            continue;
+        }
+        out << (first ? "" : ", ") << "{\"le\": ";
+        first = false;
+        if (bucket < bounds.size()){
+            out << bounds[bucket];
+        }
+        else{
+            out << "\"+Inf\"";
+        }
+        out << ", \"count\": " << counts[bucket] << "}";
+    }
+    out << "]}";
+}
+
+void writeMetricsJSON(ostream &out, const RunMetrics &run, const MetricsAggregate &aggregate){
+    char timestamp[32];
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%S", localtime(&run.startedAt));
+    out << "{\n  \"flow\": \"" << escapeMetricsString(run.flowName) << "\",\n";
+    out << "  \"started_at\": \"" << timestamp << "\",\n";
+    out << "  \"wall_seconds\": " << run.wallSeconds << ",\n";
+    out << "  \"result_cache\": \"" << (!run.resultCacheChecked ? "off" : run.resultCacheHit ? "hit" : "miss") << "\",\n";
+    out << "  \"steps\": [\n";
+    for (size_t i = 0; i < run.steps.size(); ++i){
+        const StepMetrics &step = run.steps[i];
+        out << "    {\"index\": " << step.index << ", \"type\": \"" << escapeMetricsString(step.type) << "\""
+            << ", \"wall_seconds\": " << step.wallSeconds << ", \"input_wait_seconds\": " << step.inputWaitSeconds
+            << ", \"bytes_read\": " << step.bytesRead
+            << ", \"bytes_written\": " << step.bytesWritten << ", \"rows_parsed\": " << step.rowsParsed
+            << ", \"allocations\": " << step.allocations << ", \"allocated_bytes\": " << step.allocatedBytes
+            << ", \"peak_bytes\": " << step.peakBytes << "}" << (i + 1 < run.steps.size() ? "," : "") << "\n";
+    }
+    out << "  ],\n  \"aggregate\": {\n    \"runs\": " << aggregate.getRuns() << ",\n";
+    out << "    \"result_cache_hits\": " << aggregate.getResultCacheHits() << ",\n    \"result_cache_misses\": " << aggregate.getResultCacheMisses() << ",\n";
+    out << "    \"step_latency\": {";
+    bool first = true;
+    for (const auto &entry : aggregate.getStepLatency()){
+        out << (first ? "\n" : ",\n") << "      \"" << escapeMetricsString(entry.first) << "\": ";
+        writeHistogramJSON(out, entry.second);
+        first = false;
+    }
+    out << "\n    },\n    \"flow_latency\": {";
+    first = true;
+    for (const auto &entry : aggregate.getFlowLatency()){
+        out << (first ? "\n" : ",\n") << "      \"" << escapeMetricsString(entry.first) << "\": ";
+        writeHistogramJSON(out, entry.second);
+        first = false;
+    }
+    out << "\n    }\n  }\n}\n";
+}
+
+void writePrometheusHistogram(ostream &out, const string &name, const string &label, const map<string, LatencyHistogram> &histograms){
+    const vector<double> &bounds = LatencyHistogram::bucketBounds();
+    out << "# TYPE " << name << " histogram\n";
+    for (const auto &entry : histograms){
+        string labelValue = label + "=\"" + escapeMetricsString(entry.first) + "\"";
+        const vector<uint64_t> &counts = entry.second.getBucketCounts();
+        uint64_t cumulative = 0;
+        for (size_t bucket = 0; bucket < counts.size(); ++bucket){
+            cumulative += counts[bucket];
+            out << name << "_bucket{" << labelValue << ",le=\"";
+            if (bucket < bounds.size()){
+                out << bounds[bucket];
+            }
+            else{
+                out << "+Inf";
+            }
+            out << "\"} " << cumulative << "\n";
+        }
+        out << name << "_sum{" << labelValue << "} " << entry.second.getSum() << "\n";
+        out << name << "_count{" << labelValue << "} " << entry.second.getCount() << "\n";
+    }
+    out << "# TYPE " << name << "_quantile gauge\n";
+    for (const auto &entry : histograms){
+        string labelValue = label + "=\"" + escapeMetricsString(entry.first) + "\"";
+        out << name << "_quantile{" << labelValue << ",quantile=\"0.5\"} " << entry.second.quantile(0.5) << "\n";
+        out << name << "_quantile{" << labelValue << ",quantile=\"0.99\"} " << entry.second.quantile(0.99) << "\n";
+    }
+}
+
+void writeMetricsPrometheus(ostream &out, const RunMetrics &run, const MetricsAggregate &aggregate){
+    struct Gauge{
+        const char *name;
+        const char *help;
+        double (*value)(const StepMetrics &);
+    };
+    static const Gauge gauges[] = {
+        {"flowmaker_step_wall_seconds", "Wall time of the step in the last run.", [](const StepMetrics &m) {return m.wallSeconds;}},
+        {"flowmaker_step_input_wait_seconds", "Time the step spent waiting for answers in the last run.", [](const StepMetrics &m) {return m.inputWaitSeconds;}},
+        {"flowmaker_step_bytes_read", "Bytes read by the step in the last run.", [](const StepMetrics &m) {return static_cast<double>(m.bytesRead);}},
+        {"flowmaker_step_bytes_written", "Bytes written by the step in the last run.", [](const StepMetrics &m) {return static_cast<double>(m.bytesWritten);}},
+        {"flowmaker_step_rows_parsed", "Rows or lines parsed by the step in the last run.", [](const StepMetrics &m) {return static_cast<double>(m.rowsParsed);}},
+        {"flowmaker_step_allocations", "Heap allocations made by the step in the last run.", [](const StepMetrics &m) {return static_cast<double>(m.allocations);}},
+        {"flowmaker_step_allocated_bytes", "Heap bytes allocated by the step in the last run.", [](const StepMetrics &m) {return static_cast<double>(m.allocatedBytes);}},
+        {"flowmaker_step_peak_bytes", "Peak heap growth during the step in the last run.", [](const StepMetrics &m) {return static_cast<double>(m.peakBytes);}},
+    };
+    string flowLabel = "flow=\"" + escapeMetricsString(run.flowName) + "\"";
+    for (const Gauge &gauge : gauges){
+        out << "# HELP " << gauge.name << " " << gauge.help << "\n";
+        out << "# TYPE " << gauge.name << " gauge\n";
+        for (const StepMetrics &step : run.steps){
+            out << gauge.name << "{" << flowLabel << ",step=\"" << step.index << "\",step_type=\"" << escapeMetricsString(step.type) << "\"} "
+                << gauge.value(step) << "\n";
+        }
+    }
+    out << "# HELP flowmaker_runs_total Flow runs recorded by this process.\n";
+    out << "# TYPE flowmaker_runs_total counter\n";
+    out << "flowmaker_runs_total " << aggregate.getRuns() << "\n";
+    out << "# HELP flowmaker_result_cache_hits_total Flow runs replayed from the result cache.\n";
+    out << "# TYPE flowmaker_result_cache_hits_total counter\n";
+    out << "flowmaker_result_cache_hits_total " << aggregate.getResultCacheHits() << "\n";
+    out << "# HELP flowmaker_result_cache_misses_total Flow runs that found no result to replay.\n";
+    out << "# TYPE flowmaker_result_cache_misses_total counter\n";
+    out << "flowmaker_result_cache_misses_total " << aggregate.getResultCacheMisses() << "\n";
+    out << "# HELP flowmaker_step_duration_seconds Step wall time over all runs of this process.\n";
+    writePrometheusHistogram(out, "flowmaker_step_duration_seconds", "step_type", aggregate.getStepLatency());
+    out << "# HELP flowmaker_flow_duration_seconds Flow wall time over all runs of this process.\n";
+    writePrometheusHistogram(out, "flowmaker_flow_duration_seconds", "flow", aggregate.getFlowLatency());
+}
+
+string metricsExportFile;
+MetricsAggregate metricsAggregate;
+
+void exportRunMetrics(const RunMetrics &run){
+    static mutex exportMutex;
+    lock_guard<mutex> lock(exportMutex);
+    metricsAggregate.record(run);
+    if (metricsExportFile.empty()){
+        return;
+    }
+    try{
+        ofstream metricsFile(metricsExportFile);
+        if (!metricsFile.is_open()){
+            throw runtime_error("Unable to open the metrics file '" + metricsExportFile + "' for writing.");
+        }
+        size_t pos = metricsExportFile.find_last_of(".");
+        if (pos != string::npos && metricsExportFile.substr(pos) == ".json"){
+            writeMetricsJSON(metricsFile, run, metricsAggregate);
+        }
+        else{
+            writeMetricsPrometheus(metricsFile, run, metricsAggregate);
+        }
+    }catch (const exception &e){
+        cerr << "Error: " << e.what() << endl;
+    }
+}
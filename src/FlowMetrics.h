@@ -0,0 +1,213 @@
+#ifndef FLOWMAKER_FLOW_METRICS_H
+#define FLOWMAKER_FLOW_METRICS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Counters updated while a step runs on the current thread. The executor snapshots
+// them around every step to attribute I/O and heap usage to it.
+struct StepCounters{
+    uint64_t bytesRead = 0;
+    uint64_t bytesWritten = 0;
+    uint64_t rowsParsed = 0;
+    uint64_t allocations = 0;
+    uint64_t allocatedBytes = 0;
+    int64_t liveBytes = 0;
+    int64_t peakLiveBytes = 0;
+};
+
+extern thread_local StepCounters stepCounters;
+
+// What the current thread counted since `before`. Work done on a helper thread is
+// measured with this and credited to the step it was done for with creditCounters().
+StepCounters countersSince(const StepCounters &before);
+void creditCounters(const StepCounters &counters);
+
+// Measurements for one step of one flow run.
+struct StepMetrics{
+    size_t index = 0;
+    std::string type;
+    double wallSeconds = 0;
+    // Part of wallSeconds spent waiting on the flow input for an answer.
+    double inputWaitSeconds = 0;
+    uint64_t bytesRead = 0;
+    uint64_t bytesWritten = 0;
+    uint64_t rowsParsed = 0;
+    uint64_t allocations = 0;
+    uint64_t allocatedBytes = 0;
+    uint64_t peakBytes = 0;
+};
+
+struct RunMetrics{
+    std::string flowName;
+    time_t startedAt = 0;
+    double wallSeconds = 0;
+    std::vector<StepMetrics> steps;
+    // Whether the run looked for a recorded result and whether it replayed one
+    // instead of running its steps.
+    bool resultCacheChecked = false;
+    bool resultCacheHit = false;
+};
+
+// Records the counters of the current thread from construction to finish(). A step
+// that suspends calls pause() before and resume() after, possibly on another
+// thread, so only the slices in which it ran are counted.
+class StepMeasurement{
+    private:
+        StepCounters sliceStart;
+        StepCounters totals;
+        int64_t peakGrowth = 0;
+        std::chrono::steady_clock::time_point start;
+
+        void beginSlice(){
+            sliceStart = stepCounters;
+            stepCounters.peakLiveBytes = stepCounters.liveBytes;
+        }
+
+        void endSlice(){
+            totals.bytesRead += stepCounters.bytesRead - sliceStart.bytesRead;
+            totals.bytesWritten += stepCounters.bytesWritten - sliceStart.bytesWritten;
+            totals.rowsParsed += stepCounters.rowsParsed - sliceStart.rowsParsed;
+            totals.allocations += stepCounters.allocations - sliceStart.allocations;
+            totals.allocatedBytes += stepCounters.allocatedBytes - sliceStart.allocatedBytes;
+            peakGrowth = std::max(peakGrowth, totals.liveBytes + stepCounters.peakLiveBytes - sliceStart.liveBytes);
+            totals.liveBytes += stepCounters.liveBytes - sliceStart.liveBytes;
+            if (stepCounters.peakLiveBytes < sliceStart.peakLiveBytes){
+                stepCounters.peakLiveBytes = sliceStart.peakLiveBytes;
+            }
+        }
+    public:
+        StepMeasurement() : start(std::chrono::steady_clock::now()){
+            beginSlice();
+        }
+
+        void pause() {endSlice();}
+        void resume() {beginSlice();}
+
+        StepMetrics finish(size_t index, const std::string &type){
+            endSlice();
+            StepMetrics metrics;
+            metrics.index = index;
+            metrics.type = type;
+            metrics.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            metrics.bytesRead = totals.bytesRead;
+            metrics.bytesWritten = totals.bytesWritten;
+            metrics.rowsParsed = totals.rowsParsed;
+            metrics.allocations = totals.allocations;
+            metrics.allocatedBytes = totals.allocatedBytes;
+            metrics.peakBytes = peakGrowth > 0 ? static_cast<uint64_t>(peakGrowth) : 0;
+            return metrics;
+        }
+};
+
+// Latency histogram with fixed log-spaced buckets from 1us to 100s. The JSON export
+// lists only the non-empty buckets.
+class LatencyHistogram{
+    private:
+        std::vector<uint64_t> bucketCounts;
+        uint64_t count = 0;
+        double sum = 0;
+        double maxValue = 0;
+    public:
+        static const std::vector<double> &bucketBounds(){
+            static const std::vector<double> bounds = [](){
+                std::vector<double> values;
+                for (double decade = 1e-6; decade < 100; decade *= 10){
+                    values.push_back(decade);
+                    values.push_back(decade * 2.5);
+                    values.push_back(decade * 5);
+                }
+                values.push_back(100);
+                return values;
+            }();
+            return bounds;
+        }
+
+        LatencyHistogram() : bucketCounts(bucketBounds().size() + 1, 0) {}
+
+        void record(double seconds){
+            const std::vector<double> &bounds = bucketBounds();
+            size_t bucket = std::lower_bound(bounds.begin(), bounds.end(), seconds) - bounds.begin();
+            bucketCounts[bucket]++;
+            count++;
+            sum += seconds;
+            maxValue = std::max(maxValue, seconds);
+        }
+
+        // Estimate interpolated linearly inside the bucket holding the quantile.
+        double quantile(double q) const{
+            if (count == 0){
+                return 0;
+            }
+            const std::vector<double> &bounds = bucketBounds();
+            double rank = q * static_cast<double>(count);
+            uint64_t seen = 0;
+            for (size_t bucket = 0; bucket < bucketCounts.size(); ++bucket){
+                if (bucketCounts[bucket] == 0){
+                    continue;
+                }
+                if (static_cast<double>(seen + bucketCounts[bucket]) >= rank){
+                    double lower = bucket == 0 ? 0 : bounds[bucket - 1];
+                    double upper = bucket < bounds.size() ? bounds[bucket] : maxValue;
+                    double fraction = (rank - static_cast<double>(seen)) / static_cast<double>(bucketCounts[bucket]);
+                    return std::min(lower + (upper - lower) * fraction, maxValue);
+                }
+                seen += bucketCounts[bucket];
+            }
+            return maxValue;
+        }
+
+        uint64_t getCount() const {return count;}
+        double getSum() const {return sum;}
+        const std::vector<uint64_t> &getBucketCounts() const {return bucketCounts;}
+};
+
+// Step latencies aggregated over every run of this process.
+class MetricsAggregate{
+    private:
+        uint64_t runs = 0;
+        uint64_t resultCacheHits = 0;
+        uint64_t resultCacheMisses = 0;
+        std::map<std::string, LatencyHistogram> stepLatency;
+        std::map<std::string, LatencyHistogram> flowLatency;
+    public:
+        void record(const RunMetrics &run){
+            runs++;
+            if (run.resultCacheChecked){
+                (run.resultCacheHit ? resultCacheHits : resultCacheMisses)++;
+            }
+            flowLatency[run.flowName].record(run.wallSeconds);
+            for (const StepMetrics &step : run.steps){
+                stepLatency[step.type].record(step.wallSeconds);
+            }
+        }
+
+        uint64_t getRuns() const {return runs;}
+        uint64_t getResultCacheHits() const {return resultCacheHits;}
+        uint64_t getResultCacheMisses() const {return resultCacheMisses;}
+        const std::map<std::string, LatencyHistogram> &getStepLatency() const {return stepLatency;}
+        const std::map<std::string, LatencyHistogram> &getFlowLatency() const {return flowLatency;}
+};
+
+std::string escapeMetricsString(const std::string &text);
+void writeHistogramJSON(std::ostream &out, const LatencyHistogram &histogram);
+void writeMetricsJSON(std::ostream &out, const RunMetrics &run, const MetricsAggregate &aggregate);
+void writePrometheusHistogram(std::ostream &out, const std::string &name, const std::string &label, const std::map<std::string, LatencyHistogram> &histograms);
+void writeMetricsPrometheus(std::ostream &out, const RunMetrics &run, const MetricsAggregate &aggregate);
+
+// Where the executor writes the metrics after each run; the format follows the
+// extension (.json for JSON, anything else for the Prometheus text format).
+extern std::string metricsExportFile;
+extern MetricsAggregate metricsAggregate;
+
+// Adds the run to metricsAggregate and writes metricsExportFile. Safe to call from
+// several threads at once.
+void exportRunMetrics(const RunMetrics &run);
+
+#endif
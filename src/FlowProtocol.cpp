@@ -0,0 +1,50 @@
+#include "FlowProtocol.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "FlowRecord.h"
+
+using namespace std;
+
+static void appendOneFrame(string &buffer, FrameType type, const char *payload, size_t size){
+    FlowRecordWriter writer;
+    writer.writeU32(static_cast<uint32_t>(size + 1));
+    writer.writeU8(static_cast<uint8_t>(type));
+    buffer += writer.getBuffer();
+    buffer.append(payload, size);
+}
+
+void appendFrame(string &buffer, FrameType type, const string &payload){
+    const size_t maxPayload = FLOW_FRAME_MAX_SIZE - 1;
+    if (payload.size() <= maxPayload){
+        appendOneFrame(buffer, type, payload.data(), payload.size());
+        return;
+    }
+    if (type != FrameType::Output && type != FrameType::Error){
+        appendOneFrame(buffer, type, payload.data(), maxPayload);
+        return;
+    }
+    // Printed text is only ever concatenated by the reader, so it may be cut anywhere.
+    for (size_t offset = 0; offset < payload.size(); offset += maxPayload){
+        appendOneFrame(buffer, type, payload.data() + offset, min(maxPayload, payload.size() - offset));
+    }
+}
+
+bool takeFrame(const string &buffer, size_t &offset, Frame &frame){
+    if (buffer.size() - offset < sizeof(uint32_t)){
+        return false;
+    }
+    FlowRecordReader reader(buffer.data() + offset, buffer.data() + buffer.size());
+    uint32_t length = reader.readU32();
+    if (length == 0 || length > FLOW_FRAME_MAX_SIZE){
+        throw runtime_error("Invalid frame length " + to_string(length) + ".");
+    }
+    if (reader.remaining() < length){
+        return false;
+    }
+    frame.type = static_cast<FrameType>(reader.readU8());
+    frame.payload.assign(buffer, offset + sizeof(uint32_t) + 1, length - 1);
+    offset += sizeof(uint32_t) + length;
+    return true;
+}
@@ -0,0 +1,55 @@
+#ifndef FLOWMAKER_FLOW_PROTOCOL_H
+#define FLOWMAKER_FLOW_PROTOCOL_H
+
+#include <cstdint>
+#include <string>
+
+/*
+ * Framed protocol spoken over the server socket. Every frame is a u32 little-endian
+ * length, then a one-byte frame type and (length - 1) bytes of payload.
+ *
+ * Client to server:
+ *   'S' start    payload: flow name. Starts a session running that flow.
+ *   'A' answer   payload: one line answering the pending prompt.
+ *   'L' list     no payload. The server replies with a 'N' frame.
+ *   'Q' quit     no payload. Abandons the running session.
+ * Server to client:
+ *   'O' output   payload: text printed by the flow.
+ *   'E' error    payload: text the flow printed as an error.
+ *   'I' input    no payload. The flow waits for an 'A' frame.
+ *   'D' done     payload: "ok", or "aborted" when the session was cut short.
+ *   'N' names    payload: the flow names, one per line.
+ *   'X' refused  payload: why the last request was rejected.
+ */
+
+const std::string FLOWS_SOCKET_FILE = "flowmaker.sock";
+const uint32_t FLOW_FRAME_MAX_SIZE = 1 << 20;
+
+enum class FrameType : uint8_t {
+    Start = 'S',
+    Answer = 'A',
+    List = 'L',
+    Quit = 'Q',
+    Output = 'O',
+    Error = 'E',
+    Input = 'I',
+    Done = 'D',
+    Names = 'N',
+    Refused = 'X'
+};
+
+struct Frame{
+    FrameType type;
+    std::string payload;
+};
+
+// Output and Error payloads longer than a frame allows are sent as several frames of
+// the same type; the payloads of other frame types are cut to fit one frame.
+void appendFrame(std::string &buffer, FrameType type, const std::string &payload = "");
+
+// Decodes the frame starting at buffer[offset] and moves offset past it. Returns
+// false if the buffer does not hold the whole frame yet; throws runtime_error for
+// a malformed frame.
+bool takeFrame(const std::string &buffer, size_t &offset, Frame &frame);
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef FLOWMAKER_FLOW_RECORD_H
+#define FLOWMAKER_FLOW_RECORD_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+class FlowStep;
+
+// Little-endian encoder for one flow record of the binary flow store.
+class FlowRecordWriter{
+    private:
+        std::string buffer;
+        const std::vector<FlowStep *> *steps = nullptr;
+    public:
+        FlowRecordWriter(const std::vector<FlowStep *> *steps = nullptr) : steps(steps) {}
+
+        void writeU8(uint8_t value) {buffer.push_back(static_cast<char>(value));}
+
+        void writeU16(uint16_t value){
+            for (int i = 0; i < 2; ++i){
+                buffer.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+            }
+        }
+
+        void writeU32(uint32_t value){
+            for (int i = 0; i < 4; ++i){
+                buffer.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+            }
+        }
+
+        void writeU64(uint64_t value){
+            for (int i = 0; i < 8; ++i){
+                buffer.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+            }
+        }
+
+        void writeDouble(double value){
+            uint64_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            writeU64(bits);
+        }
+
+        void writeString(const std::string &value){
+            writeU32(static_cast<uint32_t>(value.size()));
+            buffer.append(value);
+        }
+
+        void writeBytes(const std::string &bytes) {buffer.append(bytes);}
+
+        // Index of a step inside the flow being written, or -1 if it is not part of it.
+        int32_t indexOfStep(const FlowStep *step) const{
+            if (steps == nullptr){
+                return -1;
+            }
+            for (size_t i = 0; i < steps->size(); ++i){
+                if ((*steps)[i] == step){
+                    return static_cast<int32_t>(i);
+                }
+            }
+            return -1;
+        }
+
+        const std::string &getBuffer() const {return buffer;}
+        void clear() {buffer.clear();}
+};
+
+// Bounds-checked decoder over a slice of the binary flow store. Reads past the end
+// return zero values and mark the reader as failed instead of throwing.
+class FlowRecordReader{
+    private:
+        const char *cursor;
+        const char *end;
+        bool failed = false;
+        const std::vector<FlowStep *> *steps = nullptr;
+
+        bool require(size_t size){
+            if (failed || static_cast<size_t>(end - cursor) < size){
+                failed = true;
+                return false;
+            }
+            return true;
+        }
+
+        uint64_t readLittleEndian(size_t size){
+            if (!require(size)){
+                return 0;
+            }
+            uint64_t value = 0;
+            for (size_t i = 0; i < size; ++i){
+                value |= static_cast<uint64_t>(static_cast<unsigned char>(cursor[i])) << (8 * i);
+            }
+            cursor += size;
+            return value;
+        }
+    public:
+        FlowRecordReader(const char *begin, const char *end, const std::vector<FlowStep *> *steps = nullptr) : cursor(begin), end(end), steps(steps) {}
+
+        uint8_t readU8() {return static_cast<uint8_t>(readLittleEndian(1));}
+        uint16_t readU16() {return static_cast<uint16_t>(readLittleEndian(2));}
+        uint32_t readU32() {return static_cast<uint32_t>(readLittleEndian(4));}
+        uint64_t readU64() {return readLittleEndian(8);}
+
+        double readDouble(){
+            uint64_t bits = readU64();
+            double value;
+            memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+        std::string readString(){
+            uint32_t size = readU32();
+            if (!require(size)){
+                return "";
+            }
+            std::string value(cursor, size);
+            cursor += size;
+            return value;
+        }
+
+        // Returns a reader over the next `size` bytes and advances past them.
+        FlowRecordReader readSlice(size_t size){
+            if (!require(size)){
+                return FlowRecordReader(end, end, steps);
+            }
+            FlowRecordReader slice(cursor, cursor + size, steps);
+            cursor += size;
+            return slice;
+        }
+
+        // Step already loaded at the given index of the flow being read, or nullptr.
+        FlowStep *stepAt(int32_t index) const{
+            if (steps == nullptr || index < 0 || static_cast<size_t>(index) >= steps->size()){
+                return nullptr;
+            }
+            return (*steps)[index];
+        }
+
+        bool hasFailed() const {return failed;}
+        bool atEnd() const {return cursor >= end;}
+        size_t remaining() const {return static_cast<size_t>(end - cursor);}
+};
+
+#endif
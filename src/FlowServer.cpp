@@ -0,0 +1,759 @@
+#include "FlowServer.h"
+
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "Flow.h"
+#include "FlowExecutor.h"
+#include "FlowIO.h"
+#include "FlowStore.h"
+#include "FlowTask.h"
+#include "FlowTrace.h"
+
+using namespace std;
+
+// epoll ids below FIRST_CONNECTION_ID belong to the server's own descriptors.
+static const uint64_t LISTEN_EVENT_ID = 1;
+static const uint64_t WAKE_EVENT_ID = 2;
+static const uint64_t SIGNAL_EVENT_ID = 3;
+static const uint64_t FIRST_CONNECTION_ID = 16;
+
+// Bytes a session queues before its flow waits for the loop to take them.
+static const size_t SESSION_OUTPUT_LIMIT = 2 * FLOW_FRAME_MAX_SIZE;
+// Bytes of unsent replies, or of unhandled requests, a connection holds before the
+// server stops reading from it.
+static const size_t CONNECTION_BUFFER_LIMIT = 4 * FLOW_FRAME_MAX_SIZE;
+
+static runtime_error systemError(const string &what){
+    return runtime_error(what + ": " + strerror(errno));
+}
+
+// Size and modification time of a file, or an empty string if it does not exist.
+static string fileStamp(const string &fileName){
+    struct stat info;
+    if (stat(fileName.c_str(), &info) != 0){
+        return "";
+    }
+    return to_string(info.st_size) + ":" + to_string(info.st_mtim.tv_sec) + "." + to_string(info.st_mtim.tv_nsec);
+}
+
+void FlowCatalog::refresh(){
+    string newBinaryStamp = fileStamp(FLOWS_BIN_FILE);
+    string newCSVStamp = fileStamp(FLOWS_CSV_FILE);
+    if (newBinaryStamp == binaryStamp && newCSVStamp == csvStamp){
+        return;
+    }
+    FLOW_TRACE_SCOPE("server", "refresh catalog");
+    binaryStamp = newBinaryStamp;
+    csvStamp = newCSVStamp;
+    records = newBinaryStamp.empty() ? map<string, string>() : readFlowRecordsFromBinary();
+    if (!newCSVStamp.empty()){
+        // Flows saved before the binary store existed are only listed in the CSV export.
+        for (const string &flowName : readExistingFlowNames()){
+            if (!flowName.empty() && records.find(flowName) == records.end()){
+                Flow flow = loadFlowFromCSV(flowName);
+                if (!flow.getSteps().empty()){
+                    records.emplace(flowName, encodeFlowRecord(flow));
+                }
+            }
+        }
+    }
+}
+
+bool FlowCatalog::find(const string &flowName, string &record) const{
+    auto it = records.find(flowName);
+    if (it == records.end()){
+        return false;
+    }
+    record = it->second;
+    return true;
+}
+
+vector<string> FlowCatalog::getNames() const{
+    vector<string> names;
+    for (const auto &entry : records){
+        names.push_back(entry.first);
+    }
+    return names;
+}
+
+// One flow run for one client. The flow is a coroutine run by the server's thread
+// pool: it suspends at every prompt and is resumed on a pool thread once the client
+// answers, so a waiting session holds no thread. Its output is queued as frames for
+// the event loop.
+class FlowSession{
+    private:
+        class SessionInput : public FlowInput{
+            private:
+                FlowSession &session;
+            public:
+                SessionInput(FlowSession &session) : session(session) {}
+                bool isAsynchronous() const override {return true;}
+                void peekLines(vector<string> &queued, size_t maxLines) override {session.peekAnswers(queued, maxLines);}
+                bool requestLine(string &line, bool &received, coroutine_handle<> resume) override{
+                    return session.requestAnswer(line, received, resume);
+                }
+        };
+
+        class SessionOutput : public FlowOutput{
+            private:
+                FlowSession &session;
+            public:
+                SessionOutput(FlowSession &session) : session(session) {}
+                void write(const string &text) override {session.post(FrameType::Output, text);}
+                void writeError(const string &text) override {session.post(FrameType::Error, text);}
+        };
+
+        FlowServer &server;
+        ThreadPool &pool;
+        uint64_t connectionId;
+        string record;
+        mutex lock;
+        deque<string> answers;
+        bool inputClosed = false;
+        // The prompt the flow is suspended at, if any.
+        string *pendingLine = nullptr;
+        bool *pendingReceived = nullptr;
+        coroutine_handle<> pendingResume;
+        string outgoing;
+        condition_variable outputTaken;
+        bool discardOutput = false;
+        bool notified = false;
+        bool finished = false;
+        // Only touched by the event loop.
+        bool started = false;
+        SessionInput input;
+        SessionOutput output;
+        // Declared in this order so the task frame goes before the executor it uses.
+        unique_ptr<Flow> flow;
+        unique_ptr<FlowExecutor> executor;
+        FlowTask<void> task;
+
+        // Appends a frame; the caller holds the lock. Returns true if the loop must be woken.
+        bool appendOutgoing(FrameType type, const string &payload){
+            appendFrame(outgoing, type, payload);
+            bool wake = !notified;
+            notified = true;
+            return wake;
+        }
+
+        // Queues the payload a frame at a time. A flow that writes faster than its client
+        // reads waits here, on its pool thread, until the loop has taken the queued frames.
+        void post(FrameType type, const string &payload){
+            const size_t pieceSize = FLOW_FRAME_MAX_SIZE - 1;
+            size_t position = 0;
+            do{
+                bool wake;
+                {
+                    unique_lock<mutex> guard(lock);
+                    outputTaken.wait(guard, [this](){return outgoing.size() < SESSION_OUTPUT_LIMIT || discardOutput;});
+                    if (discardOutput){
+                        return;
+                    }
+                    wake = appendOutgoing(type, payload.substr(position, pieceSize));
+                }
+                if (wake){
+                    server.notifySession(connectionId);
+                }
+                position += pieceSize;
+            } while (position < payload.size());
+        }
+
+        // Queues the final frame. It is marked finished under the same lock, so the
+        // loop cannot take the frame and miss that the session is over. The loop may
+        // destroy the session as soon as the lock is released.
+        void finish(){
+            FlowServer &notifyServer = server;
+            uint64_t notifyId = connectionId;
+            bool wake;
+            {
+                lock_guard<mutex> guard(lock);
+                wake = appendOutgoing(FrameType::Done, inputClosed ? "aborted" : "ok");
+                finished = true;
+            }
+            if (wake){
+                notifyServer.notifySession(notifyId);
+            }
+        }
+
+        // The Input frame is queued under the same lock that parks the flow, so it
+        // always precedes whatever the flow writes after it is resumed.
+        bool requestAnswer(string &line, bool &received, coroutine_handle<> resume){
+            bool wake;
+            {
+                lock_guard<mutex> guard(lock);
+                if (!answers.empty()){
+                    line = move(answers.front());
+                    answers.pop_front();
+                    received = true;
+                    return true;
+                }
+                if (inputClosed){
+                    received = false;
+                    return true;
+                }
+                pendingLine = &line;
+                pendingReceived = &received;
+                pendingResume = resume;
+                wake = appendOutgoing(FrameType::Input, "");
+            }
+            if (wake){
+                server.notifySession(connectionId);
+            }
+            return false;
+        }
+
+        // Answers a client sent ahead of the prompts, for prefetching imports.
+        void peekAnswers(vector<string> &queued, size_t maxLines){
+            lock_guard<mutex> guard(lock);
+            for (size_t i = 0; i < answers.size() && i < maxLines; ++i){
+                queued.push_back(answers[i]);
+            }
+        }
+
+        // Hands the next answer, or the end of the input, to a suspended flow. The caller
+        // holds the lock; the flow is resumed on the pool.
+        void resumePending(){
+            if (!pendingResume){
+                return;
+            }
+            if (!answers.empty()){
+                *pendingLine = move(answers.front());
+                answers.pop_front();
+                *pendingReceived = true;
+            }
+            else{
+                *pendingReceived = false;
+            }
+            coroutine_handle<> resume = exchange(pendingResume, nullptr);
+            pool.submit([resume](){resume.resume();});
+        }
+
+        void runFlow(){
+            flow.reset(new Flow(decodeFlowRecord(record)));
+            executor.reset(new FlowExecutor(*flow, input, output));
+            task = executor->run();
+            task.start([this](){
+                try{
+                    task.getResult();
+                }catch (const exception &e){
+                    post(FrameType::Error, string("Error: ") + e.what() + "\n");
+                }
+                finish();
+            });
+        }
+    public:
+        FlowSession(FlowServer &server, ThreadPool &pool, uint64_t connectionId, const string &record)
+            : server(server), pool(pool), connectionId(connectionId), record(record), input(*this), output(*this) {}
+
+        FlowSession(const FlowSession &) = delete;
+        FlowSession &operator=(const FlowSession &) = delete;
+
+        // Runs the flow on the pool; later calls do nothing.
+        void start(){
+            if (started){
+                return;
+            }
+            started = true;
+            pool.submit([this](){
+                try{
+                    runFlow();
+                }catch (const exception &e){
+                    post(FrameType::Error, string("Error: ") + e.what() + "\n");
+                    finish();
+                }
+            });
+        }
+
+        void addAnswer(const string &answer){
+            lock_guard<mutex> guard(lock);
+            answers.push_back(answer);
+            resumePending();
+        }
+
+        // Ends the input; the flow stops at its next prompt.
+        void closeInput(){
+            lock_guard<mutex> guard(lock);
+            inputClosed = true;
+            resumePending();
+        }
+
+        // Ends the input and drops whatever the flow writes from now on, for a client
+        // that is gone. A flow waiting for its output to be taken goes on.
+        void detach(){
+            lock_guard<mutex> guard(lock);
+            inputClosed = true;
+            discardOutput = true;
+            outgoing.clear();
+            notified = false;
+            resumePending();
+            outputTaken.notify_all();
+        }
+
+        // Moves the queued frames to buffer. Returns true once the flow has finished
+        // and every frame it produced was handed over.
+        bool takeOutput(string &buffer){
+            lock_guard<mutex> guard(lock);
+            buffer += outgoing;
+            outgoing.clear();
+            notified = false;
+            outputTaken.notify_all();
+            return finished;
+        }
+};
+
+struct ServerConnection{
+    uint64_t id;
+    int fd;
+    string readBuffer;
+    string writeBuffer;
+    size_t writeOffset = 0;
+    uint32_t events = EPOLLIN;
+    // The client shut down its side; the connection closes once it has every reply.
+    bool inputEnded = false;
+    shared_ptr<FlowSession> session;
+};
+
+static size_t pendingWrite(const ServerConnection &connection){
+    return connection.writeBuffer.size() - connection.writeOffset;
+}
+
+FlowServer::FlowServer(const string &socketPath, size_t workerCount) : socketPath(socketPath), nextConnectionId(FIRST_CONNECTION_ID), workerCount(workerCount){
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)){
+        throw runtime_error("Invalid socket path '" + socketPath + "'.");
+    }
+    memcpy(address.sun_path, socketPath.c_str(), socketPath.size());
+
+    // A socket file nobody listens on is left over from a server that did not exit
+    // cleanly; a socket somebody listens on belongs to a running server. Anything
+    // else at the path is not ours to remove.
+    struct stat existing;
+    bool leftOver = lstat(socketPath.c_str(), &existing) == 0;
+    if (leftOver && !S_ISSOCK(existing.st_mode)){
+        throw runtime_error("'" + socketPath + "' exists and is not a socket.");
+    }
+    int probeFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (probeFd >= 0){
+        bool inUse = connect(probeFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0;
+        close(probeFd);
+        if (inUse){
+            throw runtime_error("Another server is already listening on '" + socketPath + "'.");
+        }
+    }
+    if (leftOver){
+        unlink(socketPath.c_str());
+    }
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0){
+        throw systemError("Unable to create the server socket");
+    }
+    if (bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || listen(listenFd, SOMAXCONN) != 0){
+        runtime_error error = systemError("Unable to listen on '" + socketPath + "'");
+        close(listenFd);
+        throw error;
+    }
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd < 0 || wakeFd < 0){
+        runtime_error error = systemError("Unable to set up the event loop");
+        close(listenFd);
+        unlink(socketPath.c_str());
+        throw error;
+    }
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.u64 = LISTEN_EVENT_ID;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+    event.data.u64 = WAKE_EVENT_ID;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+}
+
+FlowServer::~FlowServer(){
+    // Every flow is resumed with a closed input and runs to its end before the
+    // sessions go away. Nothing is sent anymore, so their output is dropped.
+    for (auto &entry : connections){
+        if (entry.second->session){
+            entry.second->session->detach();
+        }
+    }
+    if (pool){
+        pool->waitIdle();
+    }
+    for (auto &entry : connections){
+        close(entry.second->fd);
+    }
+    connections.clear();
+    detachedSessions.clear();
+    if (signalFd >= 0){
+        close(signalFd);
+    }
+    close(wakeFd);
+    close(epollFd);
+    close(listenFd);
+    unlink(socketPath.c_str());
+}
+
+void FlowServer::stop(){
+    running = false;
+    uint64_t one = 1;
+    if (write(wakeFd, &one, sizeof(one)) < 0 && errno != EAGAIN){
+        cerr << "Error: Unable to wake the server: " << strerror(errno) << endl;
+    }
+}
+
+void FlowServer::notifySession(uint64_t connectionId){
+    {
+        lock_guard<mutex> guard(readyMutex);
+        readyConnections.push_back(connectionId);
+    }
+    uint64_t one = 1;
+    if (write(wakeFd, &one, sizeof(one)) < 0 && errno != EAGAIN){
+        cerr << "Error: Unable to wake the server: " << strerror(errno) << endl;
+    }
+}
+
+void FlowServer::run(){
+    // SIGINT and SIGTERM are read from a signalfd. They are blocked before the pool
+    // starts, so its threads inherit the mask and never take the signals.
+    sigset_t signals;
+    sigset_t previousSignals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, &previousSignals);
+    if (!pool){
+        pool.reset(new ThreadPool(workerCount));
+    }
+    if (signalFd < 0){
+        signalFd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+        epoll_event event;
+        event.events = EPOLLIN;
+        event.data.u64 = SIGNAL_EVENT_ID;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, signalFd, &event);
+    }
+
+    running = true;
+    epoll_event events[256];
+    while (running){
+        int count = epoll_wait(epollFd, events, 256, -1);
+        if (count < 0){
+            if (errno == EINTR){
+                continue;
+            }
+            cerr << "Error: " << systemError("epoll_wait failed").what() << endl;
+            break;
+        }
+        for (int i = 0; i < count; ++i){
+            uint64_t id = events[i].data.u64;
+            if (id == LISTEN_EVENT_ID){
+                acceptConnections();
+            }
+            else if (id == WAKE_EVENT_ID){
+                uint64_t value;
+                while (read(wakeFd, &value, sizeof(value)) > 0){
+                }
+                collectSessionOutput();
+            }
+            else if (id == SIGNAL_EVENT_ID){
+                signalfd_siginfo info;
+                while (read(signalFd, &info, sizeof(info)) > 0){
+                }
+                running = false;
+            }
+            else{
+                auto it = connections.find(id);
+                if (it == connections.end()){
+                    continue;
+                }
+                ServerConnection &connection = *it->second;
+                if (events[i].events & (EPOLLERR | EPOLLHUP)){
+                    closeConnection(id);
+                    continue;
+                }
+                if (events[i].events & EPOLLOUT){
+                    serviceConnection(connection);
+                    if (connections.find(id) == connections.end()){
+                        continue;
+                    }
+                }
+                if (events[i].events & EPOLLIN){
+                    readConnection(connection);
+                }
+            }
+        }
+    }
+    pthread_sigmask(SIG_SETMASK, &previousSignals, nullptr);
+}
+
+void FlowServer::acceptConnections(){
+    while (true){
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0){
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR){
+                cerr << "Error: " << systemError("accept failed").what() << endl;
+            }
+            return;
+        }
+        unique_ptr<ServerConnection> connection(new ServerConnection());
+        connection->id = nextConnectionId++;
+        connection->fd = fd;
+        epoll_event event;
+        event.events = EPOLLIN;
+        event.data.u64 = connection->id;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0){
+            close(fd);
+            continue;
+        }
+        connections.emplace(connection->id, move(connection));
+    }
+}
+
+void FlowServer::readConnection(ServerConnection &connection){
+    char chunk[64 * 1024];
+    // The socket is level triggered, so what is left once the buffer is full is read
+    // on a later round.
+    while (connection.readBuffer.size() < CONNECTION_BUFFER_LIMIT){
+        ssize_t received = read(connection.fd, chunk, sizeof(chunk));
+        if (received > 0){
+            connection.readBuffer.append(chunk, static_cast<size_t>(received));
+            continue;
+        }
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)){
+            break;
+        }
+        if (received < 0 && errno == EINTR){
+            continue;
+        }
+        // The client is gone or only stopped sending; the frames it sent before are
+        // still handled and answered.
+        connection.inputEnded = true;
+        break;
+    }
+    serviceConnection(connection);
+}
+
+// Handles the complete frames in the read buffer and sends the replies. While the
+// unsent replies are over the limit, the remaining frames wait in the buffer and the
+// connection is not read from.
+void FlowServer::serviceConnection(ServerConnection &connection){
+    uint64_t id = connection.id;
+    while (true){
+        bool held = pendingWrite(connection) >= CONNECTION_BUFFER_LIMIT;
+        size_t offset = 0;
+        bool handled = false;
+        try{
+            Frame frame;
+            while (pendingWrite(connection) < CONNECTION_BUFFER_LIMIT && takeFrame(connection.readBuffer, offset, frame)){
+                handleFrame(connection, frame);
+                handled = true;
+            }
+        }catch (const exception &e){
+            // A malformed frame leaves no way to find the next one.
+            if (connection.session){
+                connection.session->start();
+            }
+            closeConnection(id);
+            return;
+        }
+        connection.readBuffer.erase(0, offset);
+        // A flow starts once the frames that came with its Start frame are handled, so
+        // answers sent ahead are queued before it looks at them.
+        if (connection.session){
+            connection.session->start();
+        }
+        flushConnection(connection);
+        if (connections.find(id) == connections.end()){
+            return;
+        }
+        // Frames held back by a full buffer are handled once the flush made room.
+        if (pendingWrite(connection) >= CONNECTION_BUFFER_LIMIT || (!handled && !held)){
+            break;
+        }
+    }
+    // Below the limit every complete frame was handled. Once a client that shut down
+    // its side has sent its last request, its flow gets no more answers and the
+    // connection closes when the last reply is out.
+    if (connection.inputEnded && pendingWrite(connection) < CONNECTION_BUFFER_LIMIT){
+        if (connection.session){
+            connection.session->closeInput();
+        }
+        else if (pendingWrite(connection) == 0){
+            closeConnection(id);
+        }
+    }
+}
+
+void FlowServer::handleFrame(ServerConnection &connection, const Frame &frame){
+    switch (frame.type){
+    case FrameType::Start:{
+        if (connection.session){
+            appendFrame(connection.writeBuffer, FrameType::Refused, "A flow is already running on this connection.");
+            return;
+        }
+        string record;
+        catalog.refresh();
+        if (!catalog.find(frame.payload, record)){
+            appendFrame(connection.writeBuffer, FrameType::Refused, "Flow '" + frame.payload + "' not found.");
+            return;
+        }
+        try{
+            connection.session = make_shared<FlowSession>(*this, *pool, connection.id, record);
+        }catch (const system_error &e){
+            appendFrame(connection.writeBuffer, FrameType::Refused, string("Unable to start the session: ") + e.what());
+        }
+        return;
+    }
+    case FrameType::Answer:
+        if (connection.session){
+            connection.session->addAnswer(frame.payload);
+        }
+        else{
+            appendFrame(connection.writeBuffer, FrameType::Refused, "No flow is running on this connection.");
+        }
+        return;
+    case FrameType::List:{
+        catalog.refresh();
+        string names;
+        for (const string &name : catalog.getNames()){
+            names += name + "\n";
+        }
+        appendFrame(connection.writeBuffer, FrameType::Names, names);
+        return;
+    }
+    case FrameType::Quit:
+        if (connection.session){
+            connection.session->closeInput();
+        }
+        return;
+    default:
+        appendFrame(connection.writeBuffer, FrameType::Refused, "Unknown request type.");
+    }
+}
+
+void FlowServer::collectSessionOutput(){
+    vector<uint64_t> ready;
+    {
+        lock_guard<mutex> guard(readyMutex);
+        ready.swap(readyConnections);
+    }
+    bool checkDetached = false;
+    for (uint64_t id : ready){
+        auto it = connections.find(id);
+        if (it == connections.end() || !it->second->session){
+            checkDetached = true;
+            continue;
+        }
+        serviceConnection(*it->second);
+    }
+    if (checkDetached){
+        string discarded;
+        for (size_t i = 0; i < detachedSessions.size();){
+            if (detachedSessions[i]->takeOutput(discarded)){
+                detachedSessions[i] = detachedSessions.back();
+                detachedSessions.pop_back();
+            }
+            else{
+                ++i;
+            }
+            discarded.clear();
+        }
+    }
+}
+
+// Moves a session's queued frames to the write buffer while it is under the limit; a
+// session left waiting on a full buffer is taken from again as the buffer drains.
+void FlowServer::takeSessionOutput(ServerConnection &connection){
+    if (!connection.session || pendingWrite(connection) >= CONNECTION_BUFFER_LIMIT){
+        return;
+    }
+    if (connection.writeOffset > connection.writeBuffer.size() / 2){
+        connection.writeBuffer.erase(0, connection.writeOffset);
+        connection.writeOffset = 0;
+    }
+    if (connection.session->takeOutput(connection.writeBuffer)){
+        connection.session.reset();
+    }
+}
+
+void FlowServer::flushConnection(ServerConnection &connection){
+    while (true){
+        takeSessionOutput(connection);
+        if (connection.writeOffset == connection.writeBuffer.size()){
+            break;
+        }
+        ssize_t sent = send(connection.fd, connection.writeBuffer.data() + connection.writeOffset,
+                            connection.writeBuffer.size() - connection.writeOffset, MSG_NOSIGNAL);
+        if (sent > 0){
+            connection.writeOffset += static_cast<size_t>(sent);
+            continue;
+        }
+        if (sent < 0 && errno == EINTR){
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)){
+            if (connection.writeOffset > connection.writeBuffer.size() / 2){
+                connection.writeBuffer.erase(0, connection.writeOffset);
+                connection.writeOffset = 0;
+            }
+            updateEvents(connection);
+            return;
+        }
+        closeConnection(connection.id);
+        return;
+    }
+    connection.writeBuffer.clear();
+    connection.writeOffset = 0;
+    updateEvents(connection);
+}
+
+// Waits for the socket to take more while replies are unsent, and stops reading from
+// a client that sends requests without reading the replies.
+void FlowServer::updateEvents(ServerConnection &connection){
+    uint32_t events = !connection.inputEnded && pendingWrite(connection) < CONNECTION_BUFFER_LIMIT ? EPOLLIN : 0;
+    if (pendingWrite(connection) > 0){
+        events |= EPOLLOUT;
+    }
+    if (connection.events == events){
+        return;
+    }
+    connection.events = events;
+    epoll_event event;
+    event.events = events;
+    event.data.u64 = connection.id;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+}
+
+void FlowServer::closeConnection(uint64_t connectionId){
+    auto it = connections.find(connectionId);
+    if (it == connections.end()){
+        return;
+    }
+    ServerConnection &connection = *it->second;
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, connection.fd, nullptr);
+    close(connection.fd);
+    if (connection.session){
+        connection.session->detach();
+        detachedSessions.push_back(connection.session);
+    }
+    connections.erase(it);
+}
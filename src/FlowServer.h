@@ -0,0 +1,79 @@
+#ifndef FLOWMAKER_FLOW_SERVER_H
+#define FLOWMAKER_FLOW_SERVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "FlowProtocol.h"
+#include "ThreadPool.h"
+
+class FlowSession;
+struct ServerConnection;
+
+// Saved flows kept in memory as binary store records. refresh() reloads them when
+// flows.bin or flows.csv changed since the last call.
+class FlowCatalog{
+    private:
+        std::map<std::string, std::string> records;
+        std::string binaryStamp;
+        std::string csvStamp;
+    public:
+        void refresh();
+        bool find(const std::string &flowName, std::string &record) const;
+        std::vector<std::string> getNames() const;
+};
+
+// Long-running server that runs flow sessions for clients of a Unix domain socket
+// (see FlowProtocol.h). One epoll loop owns every socket; the flows run as coroutines
+// on a fixed thread pool and hand their output back to the loop.
+class FlowServer{
+    private:
+        std::string socketPath;
+        int listenFd = -1;
+        int epollFd = -1;
+        int wakeFd = -1;
+        int signalFd = -1;
+        std::atomic<bool> running{false};
+        uint64_t nextConnectionId;
+        std::unordered_map<uint64_t, std::unique_ptr<ServerConnection>> connections;
+        // Sessions whose client disconnected; joined once their flow gives up.
+        std::vector<std::shared_ptr<FlowSession>> detachedSessions;
+        std::mutex readyMutex;
+        std::vector<uint64_t> readyConnections;
+        FlowCatalog catalog;
+        size_t workerCount;
+        // Created by run() once SIGINT and SIGTERM are blocked, so its threads never take them.
+        std::unique_ptr<ThreadPool> pool;
+
+        void acceptConnections();
+        void readConnection(ServerConnection &connection);
+        void handleFrame(ServerConnection &connection, const Frame &frame);
+        void serviceConnection(ServerConnection &connection);
+        void takeSessionOutput(ServerConnection &connection);
+        void flushConnection(ServerConnection &connection);
+        void closeConnection(uint64_t connectionId);
+        void collectSessionOutput();
+        void updateEvents(ServerConnection &connection);
+    public:
+        // 0 workers means one per hardware thread.
+        FlowServer(const std::string &socketPath = FLOWS_SOCKET_FILE, size_t workerCount = 0);
+        FlowServer(const FlowServer &) = delete;
+        FlowServer &operator=(const FlowServer &) = delete;
+        ~FlowServer();
+
+        // Serves clients until stop() is called or the process gets SIGINT or SIGTERM.
+        void run();
+        // Makes run() return. Safe to call from any thread.
+        void stop();
+        // Called by a session when it has output for its connection.
+        void notifySession(uint64_t connectionId);
+        size_t getConnectionCount() const {return connections.size();}
+};
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef FLOWMAKER_FLOW_STEP_H
+#define FLOWMAKER_FLOW_STEP_H
+
+#include <string>
+
+#include "FlowRecord.h"
+
+class FlowStep{
+    public:
+        virtual void execute() = 0;
+        virtual std::string getType() const = 0;
+        virtual std::string getDescription() const = 0;
+        virtual FlowStep *clone() const = 0;
+        // Clears what the last run left in the step. The configuration (what writeConfig
+        // stores) is kept, so a flow saved after a run keeps its settings.
+        virtual void reset() {}
+        // Persist and restore the step configuration in the binary flow store.
+        virtual void writeConfig(FlowRecordWriter &) const {}
+        virtual void readConfig(FlowRecordReader &) {}
+        virtual ~FlowStep() {}
+};
+
+#endif
@@ -0,0 +1,850 @@
+#include "FlowSteps.h"
+
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string_view>
+#include <sys/stat.h>
+
+#include "FileUtils.h"
+#include "FlowMetrics.h"
+#include "FlowTrace.h"
+#include "DistinctCount.h"
+#include "ExternalSort.h"
+#include "HashJoin.h"
+#include "ImportCache.h"
+#include "ImportPrefetcher.h"
+#include "MultiFileImport.h"
+#include "PipelinedRowStream.h"
+#include "QuantileSketch.h"
+#include "RegexTransform.h"
+#include "StepRegistry.h"
+#include "TextSearch.h"
+#include "XLSXReader.h"
+
+using namespace std;
+
+static StepRegistration<TitleStep> titleStepRegistration('1', "Step with a title and subtitle.");
+
+static StepRegistration<TextStep> textStepRegistration('2', "Step with a title and text.");
+
+FlowStep *createLoadedTextInputStep() {return new TextInputStep("Input title, subtitle, title text and text");}
+static StepRegistration<TextInputStep> textInputStepRegistration('3', "Step which allows the user to input a title and text.", createLoadedTextInputStep, createStepWithDescription<TextInputStep>);
+
+FlowStep *createLoadedNumberInputStep() {return new NumberInputStep("Input a number");}
+static StepRegistration<NumberInputStep> numberInputStepRegistration('4', "Step to input a number.", createLoadedNumberInputStep, createStepWithDescription<NumberInputStep>);
+
+FlowStep *createCalculusStep() {return new CalculusStep<double>(ArithmeticOperation::Addition, '+');}
+static StepRegistration<CalculusStep<double>> calculusStepRegistration('5', "Step to perform arithmetic operations.", createCalculusStep);
+
+static StepRegistration<DisplayStep> displayStepRegistration('6', "Step which displays the input for each of the steps until now.");
+
+// Appends `extension` unless the name already ends with it (optionally followed by
+// ".gz" or ".zst") or names a directory or glob pattern. Returns false for names isValidImportPath rejects.
+static bool prepareImportFileName(string &fileName, const string &extension){
+    if (!isValidImportPath(fileName)){
+        return false;
+    }
+    if (isMultiFileImport(fileName)){
+        return true;
+    }
+    for (const string &suffix : {extension, extension + ".gz", extension + ".zst"}){
+        if (fileName.size() >= suffix.size() && fileName.compare(fileName.size() - suffix.size(), suffix.size(), suffix) == 0){
+            return true;
+        }
+    }
+    fileName += extension;
+    return true;
+}
+
+bool TextFileInputStep::prepareFileName(string &fileName){
+    return prepareImportFileName(fileName, ".txt");
+}
+
+void TextFileInputStep::appendContents(const string &sourceName, const string &contents, ostream &out){
+    FLOW_TRACE_SCOPE("import", "parse", sourceName);
+    size_t importedBytes = contents.size();
+    searchIndex.reset();
+    // The lines of the file, from the index saved next to it if that is still valid.
+    LineIndex fileIndex;
+    if (!LineIndex::isPersistent() || !LineIndex::load(sourceName, contents.size(), fileIndex)){
+        fileIndex.extend(contents);
+        if (LineIndex::isPersistent()){
+            try{
+                fileIndex.save(sourceName);
+            }catch (const exception &e){
+                out << "Could not save the line index: " << e.what() << endl;
+            }
+        }
+    }
+    size_t firstLine = lineIndex.getLineCount();
+    fileContent += contents;
+    lineIndex.append(fileIndex);
+    if (!contents.empty() && contents.back() != '\n'){
+        fileContent += '\n';
+        importedBytes++;
+        lineIndex.extend(fileContent);
+    }
+    size_t importedLines = lineIndex.getLineCount() - firstLine;
+    sources.push_back(ImportSource{sourceName, firstLine, importedLines});
+    stepCounters.bytesRead += importedBytes;
+    stepCounters.rowsParsed += importedLines;
+}
+
+void TextFileInputStep::importFiles(ostream &out){
+    vector<string> files = expandImportPath(fileName, ".txt");
+    if (files.empty()){
+        out << "No files match '" << fileName << "'." << endl;
+        return;
+    }
+    size_t imported = 0;
+    for (const ImportShard &shard : loadImportShards(files)){
+        if (!shard.error.empty()){
+            out << "Error reading the file '" << shard.fileName << "': " << shard.error << endl;
+        }
+        else if (!shard.contents){
+            out << "File '" << shard.fileName << "' not found or unable to open." << endl;
+        }
+        else{
+            appendContents(shard.fileName, *shard.contents, out);
+            imported++;
+        }
+    }
+    fileImported = imported > 0;
+    out << imported << " of " << files.size() << " files imported successfully." << endl;
+}
+
+void TextFileInputStep::importFile(const string &newFileName, ostream &out, shared_ptr<PrefetchedImport> prefetched){
+    fileName = newFileName;
+    if (isMultiFileImport(fileName)){
+        importFiles(out);
+        return;
+    }
+    shared_ptr<const string> contents;
+    try{
+        if (prefetched && !prefetched->error.empty()){
+            throw runtime_error(prefetched->error);
+        }
+        contents = prefetched ? prefetched->contents : ImportCache::instance().load(fileName);
+    }catch (const exception &e){
+        out << "Error reading the file: " << e.what() << endl;
+        fileImported = false;
+        return;
+    }
+    if (!contents){
+        out << "File not found or unable to open." << endl;
+        return;
+    }
+
+    fileImported = true;
+    appendContents(fileName, *contents, out);
+    out << "File imported successfully." << endl;
+}
+
+shared_ptr<const TrigramIndex> TextFileInputStep::getSearchIndex() const{
+    if (!searchIndex){
+        searchIndex = make_shared<TrigramIndex>(fileContent);
+    }
+    return searchIndex;
+}
+
+void TextFileInputStep::execute(){
+    string enteredName;
+    while (true){
+        cout << "Enter the name of the text file (.txt): ";
+        getline(cin, enteredName);
+
+        if (!prepareFileName(enteredName)){
+            cout << "Invalid file name. Please enter a valid file name." << endl;
+        }
+        else{
+            break;
+        }
+    }
+
+    cout << "Entered File Name: " << enteredName << endl;
+    importFile(enteredName, cout);
+}
+
+FlowStep *createLoadedTextFileInputStep() {return new TextFileInputStep("Input a .txt file");}
+static StepRegistration<TextFileInputStep> textFileInputStepRegistration('7', "Step which lets the user to input a .txt file.", createLoadedTextFileInputStep, createStepWithDescription<TextFileInputStep>);
+
+// Splits the file into rows at '\n' and into cells at ','. A trailing comma does
+// not start an extra cell and an empty line gives an empty row.
+void CSVFileInputStep::parseCSVContents(const string &contents, vector<vector<string>> &rows){
+    string_view remaining(contents);
+    while (!remaining.empty()){
+        size_t lineEnd = remaining.find('\n');
+        string_view line = remaining.substr(0, lineEnd);
+        remaining.remove_prefix(lineEnd == string_view::npos ? remaining.size() : lineEnd + 1);
+        stepCounters.bytesRead += line.size() + 1;
+        stepCounters.rowsParsed++;
+
+        vector<string> row;
+        size_t cellStart = 0;
+        while (cellStart < line.size()){
+            size_t comma = line.find(',', cellStart);
+            if (comma == string_view::npos){
+                row.emplace_back(line.substr(cellStart));
+                break;
+            }
+            row.emplace_back(line.substr(cellStart, comma - cellStart));
+            cellStart = comma + 1;
+        }
+        rows.push_back(move(row));
+    }
+}
+
+bool CSVFileInputStep::prepareFileName(string &fileName){
+    return prepareImportFileName(fileName, ".csv");
+}
+
+void CSVFileInputStep::importFiles(ostream &out, ostream &err){
+    vector<string> files = expandImportPath(fileName, ".csv");
+    if (files.empty()){
+        out << "No files match '" << fileName << "'." << endl;
+        return;
+    }
+    csvData.clear();
+    sources.clear();
+    size_t imported = 0;
+    for (ImportShard &shard : loadImportShards(files, parseCSVContents)){
+        if (!shard.error.empty()){
+            err << "Error opening or reading the file '" << shard.fileName << "': " << shard.error << endl;
+        }
+        else if (!shard.contents){
+            out << "File '" << shard.fileName << "' not found or unable to open." << endl;
+        }
+        else{
+            sources.push_back(ImportSource{shard.fileName, csvData.size(), shard.rows.size()});
+            move(shard.rows.begin(), shard.rows.end(), back_inserter(csvData));
+            imported++;
+        }
+    }
+    fileImported = imported > 0;
+    out << imported << " of " << files.size() << " CSV files imported successfully." << endl;
+}
+
+void CSVFileInputStep::importFile(const string &newFileName, ostream &out, ostream &err, shared_ptr<PrefetchedImport> prefetched){
+    fileName = newFileName;
+    if (isMultiFileImport(fileName)){
+        importFiles(out, err);
+        return;
+    }
+    try{
+        if (prefetched && !prefetched->error.empty()){
+            throw runtime_error(prefetched->error);
+        }
+        shared_ptr<const string> contents = prefetched ? prefetched->contents : ImportCache::instance().load(fileName);
+        if (!contents){
+            out << "File not found or unable to open." << endl;
+            return;
+        }
+
+        fileImported = true;
+        csvData.clear();
+        sources.clear();
+        if (prefetched && prefetched->parsed){
+            // Nobody else can reach an import whose last reference is ours.
+            if (prefetched.use_count() == 1){
+                csvData = move(prefetched->rows);
+            }
+            else{
+                csvData = prefetched->rows;
+            }
+        }
+        else{
+            FLOW_TRACE_SCOPE("import", "parse", fileName);
+            parseCSVContents(*contents, csvData);
+        }
+        sources.push_back(ImportSource{fileName, 0, csvData.size()});
+        out << "CSV file imported successfully." << endl;
+    }catch (const exception &e){
+        err << "Error opening or reading the file: " << e.what() << endl;
+        fileImported = false;
+    }
+}
+
+void CSVFileInputStep::execute(){
+    string enteredName;
+    while (true){
+        cout << "Enter the name of the CSV file (.csv): ";
+        getline(cin, enteredName);
+
+        if (!prepareFileName(enteredName)){
+            cout << "Invalid file name. Please enter a valid CSV file name." << endl;
+        }
+
+        else{
+            break;
+        }
+    }
+
+    cout << "Entered File Name: " << enteredName << endl;
+    importFile(enteredName, cout, cerr);
+}
+
+FlowStep *createLoadedCSVFileInputStep() {return new CSVFileInputStep("Input a .csv file");}
+static StepRegistration<CSVFileInputStep> csvFileInputStepRegistration('8', "Step which lets the user to input a .csv file.", createLoadedCSVFileInputStep, createStepWithDescription<CSVFileInputStep>);
+
+bool XLSXFileInputStep::prepareFileName(string &fileName){
+    if (!isValidFileName(fileName)){
+        return false;
+    }
+    const string extension = ".xlsx";
+    if (fileName.size() < extension.size() || fileName.compare(fileName.size() - extension.size(), extension.size(), extension) != 0){
+        fileName += extension;
+    }
+    return true;
+}
+
+void XLSXFileInputStep::importFile(const string &newFileName, const string &newSheetName, ostream &out, ostream &err){
+    fileName = newFileName;
+    sheetName = newSheetName;
+    struct stat info;
+    if (stat(fileName.c_str(), &info) != 0 || !S_ISREG(info.st_mode)){
+        out << "File not found or unable to open." << endl;
+        return;
+    }
+    tableData.clear();
+    try{
+        FLOW_TRACE_SCOPE("import", "parse", fileName);
+        XLSXSheetReader reader(fileName, sheetName);
+        vector<string> row;
+        while (reader.nextRow(row)){
+            tableData.push_back(move(row));
+            stepCounters.rowsParsed++;
+        }
+        stepCounters.bytesRead += reader.getBytesRead();
+        fileImported = true;
+        out << "Sheet '" << reader.getSheetName() << "' imported successfully (" << tableData.size() << " rows)." << endl;
+    }catch (const exception &e){
+        err << "Error opening or reading the file: " << e.what() << endl;
+        tableData.clear();
+        fileImported = false;
+    }
+}
+
+void XLSXFileInputStep::execute(){
+    string enteredName;
+    while (true){
+        cout << "Enter the name of the spreadsheet file (.xlsx): ";
+        getline(cin, enteredName);
+
+        if (!prepareFileName(enteredName)){
+            cout << "Invalid file name. Please enter a valid spreadsheet file name." << endl;
+        }
+        else{
+            break;
+        }
+    }
+
+    string enteredSheet;
+    cout << "Enter the sheet name or number (empty for the first sheet): ";
+    getline(cin, enteredSheet);
+
+    cout << "Entered File Name: " << enteredName << endl;
+    importFile(enteredName, enteredSheet, cout, cerr);
+}
+
+FlowStep *createLoadedXLSXFileInputStep() {return new XLSXFileInputStep("Input a sheet of a .xlsx file");}
+static StepRegistration<XLSXFileInputStep> xlsxFileInputStepRegistration('a', "Step which lets the user to input a sheet of a .xlsx file.", createLoadedXLSXFileInputStep, createStepWithDescription<XLSXFileInputStep>);
+
+// A header row kept by a step, followed by the rows it produced.
+class HeaderedRowStream : public RowStream{
+    private:
+        vector<string> header;
+        bool headerPending;
+        unique_ptr<RowStream> rows;
+    public:
+        HeaderedRowStream(const vector<string> &header, bool hasHeader, unique_ptr<RowStream> rows) : header(header), headerPending(hasHeader), rows(move(rows)) {}
+
+        bool next(vector<string> &row) override{
+            if (headerPending){
+                headerPending = false;
+                row = header;
+                return true;
+            }
+            return rows->next(row);
+        }
+};
+
+bool SortStep::sortTable(const TableProducer &source, const string &newKeySpec, bool newHeaderRow, ostream &out, ostream &err){
+    vector<SortKey> keys;
+    if (!parseSortKeys(newKeySpec, keys)){
+        err << "Error: Invalid sort keys '" << newKeySpec << "'." << endl;
+        return false;
+    }
+    keySpec = newKeySpec;
+    headerRow = newHeaderRow;
+    sourceName = source.getTableName();
+    header.clear();
+    sortedRows.reset();
+    try{
+        FLOW_TRACE_SCOPE("sort", "sort table", sourceName);
+        ExternalSorter sorter(keys);
+        unique_ptr<RowStream> rows = openTableForScan(source);
+        vector<string> row;
+        bool first = true;
+        while (rows->next(row)){
+            if (first && headerRow){
+                header = move(row);
+            }
+            else{
+                sorter.add(move(row));
+            }
+            first = false;
+            stepCounters.rowsParsed++;
+        }
+        shared_ptr<SortedRows> sorted = sorter.finish();
+        out << "Sorted " << sorted->getRowCount() << " rows of " << sourceName << " by " << keys.size() << (keys.size() == 1 ? " key" : " keys");
+        if (sorted->getRunCount() > 0){
+            out << " (" << sorted->getRunCount() << " runs merged from disk)";
+        }
+        out << "." << endl;
+        sortedRows = move(sorted);
+        return true;
+    }catch (const exception &e){
+        err << "Error sorting the table: " << e.what() << endl;
+        return false;
+    }
+}
+
+uint64_t SortStep::getRowCount() const{
+    if (!sortedRows){
+        return 0;
+    }
+    return sortedRows->getRowCount() + (headerRow ? 1 : 0);
+}
+
+unique_ptr<RowStream> SortStep::openTable() const{
+    return unique_ptr<RowStream>(new HeaderedRowStream(header, headerRow, sortedRows->open()));
+}
+
+FlowStep *createLoadedSortStep() {return new SortStep("Sort an imported table");}
+static StepRegistration<SortStep> sortStepRegistration('b', "Step which sorts an imported table by one or more columns.", createLoadedSortStep, createStepWithDescription<SortStep>);
+
+// Yields a row read ahead of the stream before the rest of it.
+class PeekedRowStream : public RowStream{
+    private:
+        unique_ptr<RowStream> rows;
+        vector<string> first;
+        bool firstPending;
+    public:
+        explicit PeekedRowStream(unique_ptr<RowStream> source) : rows(move(source)){
+            firstPending = rows->next(first);
+        }
+
+        bool empty() const {return !firstPending;}
+        const vector<string> &peek() const {return first;}
+
+        bool next(vector<string> &row) override{
+            if (firstPending){
+                firstPending = false;
+                row = move(first);
+                return true;
+            }
+            return rows->next(row);
+        }
+};
+
+bool JoinStep::joinTables(const TableProducer &left, const TableProducer &right, const string &newLeftKeys, const string &newRightKeys, bool newKeepUnmatchedLeft, bool newHeaderRow, ostream &out, ostream &err){
+    JoinSpec spec;
+    if (!parseJoinColumns(newLeftKeys, spec.leftColumns)){
+        err << "Error: Invalid key columns '" << newLeftKeys << "'." << endl;
+        return false;
+    }
+    if (!parseJoinColumns(newRightKeys, spec.rightColumns)){
+        err << "Error: Invalid key columns '" << newRightKeys << "'." << endl;
+        return false;
+    }
+    if (spec.leftColumns.size() != spec.rightColumns.size()){
+        err << "Error: Both tables need the same number of key columns." << endl;
+        return false;
+    }
+    spec.keepUnmatchedLeft = newKeepUnmatchedLeft;
+    leftKeys = newLeftKeys;
+    rightKeys = newRightKeys;
+    keepUnmatchedLeft = newKeepUnmatchedLeft;
+    headerRow = newHeaderRow;
+    leftName = left.getTableName();
+    rightName = right.getTableName();
+    header.clear();
+    joinedRows.reset();
+    try{
+        FLOW_TRACE_SCOPE("join", "join tables", leftName + " / " + rightName);
+        // The first row of each table gives the width the joined rows are padded to.
+        PeekedRowStream leftRows(openTableForScan(left));
+        PeekedRowStream rightRows(openTableForScan(right));
+        spec.leftWidth = leftRows.peek().size();
+        spec.rightWidth = rightRows.peek().size();
+        uint64_t leftCount = left.getRowCount();
+        uint64_t rightCount = right.getRowCount();
+        vector<string> row;
+        if (headerRow){
+            leftRows.next(header);
+            header.resize(spec.leftWidth);
+            if (rightRows.next(row)){
+                for (size_t column = 0; column < row.size(); ++column){
+                    if (find(spec.rightColumns.begin(), spec.rightColumns.end(), column) == spec.rightColumns.end()){
+                        header.push_back(row[column]);
+                    }
+                }
+            }
+            leftCount -= min<uint64_t>(leftCount, 1);
+            rightCount -= min<uint64_t>(rightCount, 1);
+        }
+        HashJoiner joiner(spec);
+        shared_ptr<JoinedRows> joined = joiner.join(leftRows, leftCount, rightRows, rightCount);
+        stepCounters.rowsParsed += leftCount + rightCount;
+        out << "Joined " << leftName << " with " << rightName << " into " << joined->getRowCount() << " rows (hash table built on " << (joiner.isBuiltOnLeft() ? leftName : rightName);
+        if (joiner.getPartitionCount() > 0){
+            out << ", " << joiner.getPartitionCount() << " partitions spilled to disk";
+        }
+        out << ")." << endl;
+        joinedRows = move(joined);
+        return true;
+    }catch (const exception &e){
+        err << "Error joining the tables: " << e.what() << endl;
+        return false;
+    }
+}
+
+uint64_t JoinStep::getRowCount() const{
+    if (!joinedRows){
+        return 0;
+    }
+    return joinedRows->getRowCount() + (headerRow ? 1 : 0);
+}
+
+unique_ptr<RowStream> JoinStep::openTable() const{
+    return unique_ptr<RowStream>(new HeaderedRowStream(header, headerRow, joinedRows->open()));
+}
+
+FlowStep *createLoadedJoinStep() {return new JoinStep("Join two imported tables");}
+static StepRegistration<JoinStep> joinStepRegistration('c', "Step which joins two imported tables on key columns.", createLoadedJoinStep, createStepWithDescription<JoinStep>);
+
+bool SearchStep::search(const TextFileInputStep &text, const string &newPatterns, bool newIgnoreCase, bool newUseIndex, ostream &out, ostream &err){
+    vector<string> patternList = parseSearchPatterns(newPatterns);
+    if (patternList.empty()){
+        err << "Error: No search pattern entered." << endl;
+        return false;
+    }
+    patterns = newPatterns;
+    ignoreCase = newIgnoreCase;
+    useIndex = newUseIndex;
+    textName = text.getFileName();
+    matches.clear();
+    patternLines.clear();
+    searched = false;
+    try{
+        FLOW_TRACE_SCOPE("search", "search text", textName);
+        MultiPatternMatcher matcher(patternList, ignoreCase);
+        shared_ptr<const TrigramIndex> index = useIndex ? text.getSearchIndex() : nullptr;
+        SearchResult result = searchText(text.getFileContent(), matcher, patternList, index.get());
+
+        const string &content = text.getFileContent();
+        const vector<ImportSource> &sources = text.getSources();
+        for (const SearchHit &hit : result.hits){
+            auto source = upper_bound(sources.begin(), sources.end(), hit.line, [](size_t line, const ImportSource &importSource){
+                return line < importSource.firstRow;
+            });
+            string fileName = source == sources.begin() ? textName : prev(source)->fileName;
+            size_t firstRow = source == sources.begin() ? 0 : prev(source)->firstRow;
+            matches.push_back(SearchMatch{fileName, hit.line - firstRow + 1, content.substr(hit.begin, hit.end - hit.begin)});
+        }
+        patternLines = move(result.patternLines);
+        searched = true;
+        stepCounters.rowsParsed += result.linesChecked;
+
+        out << "Found " << matches.size() << (matches.size() == 1 ? " matching line" : " matching lines") << " in " << textName;
+        if (result.usedIndex){
+            out << " (" << result.linesChecked << " candidate lines from the index)";
+        }
+        else if (useIndex){
+            out << " (patterns shorter than 3 bytes, scanned without the index)";
+        }
+        out << "." << endl;
+        for (size_t i = 0; i < patternList.size(); ++i){
+            out << "  " << patternList[i] << ": " << patternLines[i] << (patternLines[i] == 1 ? " line" : " lines") << endl;
+        }
+        return true;
+    }catch (const exception &e){
+        err << "Error searching the text: " << e.what() << endl;
+        return false;
+    }
+}
+
+FlowStep *createLoadedSearchStep() {return new SearchStep("Search an imported text file");}
+static StepRegistration<SearchStep> searchStepRegistration('d', "Step which searches an imported text file for one or more patterns.", createLoadedSearchStep, createStepWithDescription<SearchStep>);
+
+bool TextStatsStep::computeStats(const TextFileInputStep &text, size_t newTopCount, bool newIgnoreCase, ostream &out, ostream &err){
+    topCount = newTopCount;
+    ignoreCase = newIgnoreCase;
+    textName = text.getFileName();
+    computed = false;
+    try{
+        FLOW_TRACE_SCOPE("stats", "text statistics", textName);
+        stats = computeTextStats(text.getFileContent(), topCount, ignoreCase);
+    }catch (const exception &e){
+        err << "Error counting the text: " << e.what() << endl;
+        return false;
+    }
+    computed = true;
+    stepCounters.rowsParsed += stats.lines;
+    out << "Counted " << stats.lines << " lines, " << stats.words << " words and " << stats.tokens << " tokens (" << stats.distinctTokens << " distinct) in " << textName << "." << endl;
+    return true;
+}
+
+FlowStep *createLoadedTextStatsStep() {return new TextStatsStep("Count an imported text file");}
+static StepRegistration<TextStatsStep> textStatsStepRegistration('e', "Step which counts the lines, words and most frequent tokens of an imported text file.", createLoadedTextStatsStep, createStepWithDescription<TextStatsStep>);
+
+bool QuantileStep::computeQuantiles(const TableProducer &source, size_t newColumn, const string &newPercentiles, bool newHeaderRow, ostream &out, ostream &err){
+    vector<double> newRanks;
+    if (newColumn == 0){
+        err << "Error: Columns are numbered from 1." << endl;
+        return false;
+    }
+    if (!parsePercentiles(newPercentiles, newRanks)){
+        err << "Error: Invalid percentiles '" << newPercentiles << "'." << endl;
+        return false;
+    }
+    column = newColumn;
+    percentiles = newPercentiles;
+    headerRow = newHeaderRow;
+    sourceName = source.getTableName();
+    computed = false;
+    try{
+        FLOW_TRACE_SCOPE("quantile", "column quantiles", sourceName);
+        unique_ptr<RowStream> rows = openTableForScan(source);
+        vector<string> header;
+        if (headerRow){
+            rows->next(header);
+        }
+        ColumnQuantiles result = computeColumnQuantiles(*rows, column - 1, newRanks);
+        valueCount = result.values;
+        skippedCount = result.skipped;
+        minimum = result.minimum;
+        maximum = result.maximum;
+        ranks = move(newRanks);
+        quantiles = move(result.quantiles);
+    }catch (const exception &e){
+        err << "Error computing the percentiles: " << e.what() << endl;
+        return false;
+    }
+    computed = true;
+    stepCounters.rowsParsed += valueCount + skippedCount;
+    out << "Sketched " << valueCount << " values of column " << column << " of " << sourceName;
+    if (skippedCount > 0){
+        out << " (" << skippedCount << (skippedCount == 1 ? " cell that is" : " cells that are") << " not a number skipped)";
+    }
+    out << "." << endl;
+    return true;
+}
+
+vector<string> QuantileStep::describeResults() const{
+    vector<string> lines;
+    lines.push_back("Values: " + to_string(valueCount) + ", Skipped: " + to_string(skippedCount));
+    if (valueCount == 0){
+        return lines;
+    }
+    ostringstream range;
+    range << "Min: " << minimum << ", Max: " << maximum;
+    lines.push_back(range.str());
+    for (size_t i = 0; i < ranks.size(); ++i){
+        ostringstream line;
+        line << "p" << ranks[i] * 100 << ": " << quantiles[i];
+        lines.push_back(line.str());
+    }
+    return lines;
+}
+
+FlowStep *createLoadedQuantileStep() {return new QuantileStep("Estimate percentiles of a column");}
+static StepRegistration<QuantileStep> quantileStepRegistration('f', "Step which estimates percentiles of a numeric column of an imported table.", createLoadedQuantileStep, createStepWithDescription<QuantileStep>);
+
+bool DistinctCountStep::countValues(const TableProducer &source, size_t newColumn, bool newExact, unsigned newPrecision, bool newHeaderRow, ostream &out, ostream &err){
+    if (newColumn == 0){
+        err << "Error: Columns are numbered from 1." << endl;
+        return false;
+    }
+    column = newColumn;
+    exact = newExact;
+    precision = newPrecision;
+    headerRow = newHeaderRow;
+    sourceName = source.getTableName();
+    computed = false;
+    try{
+        FLOW_TRACE_SCOPE("distinct", "count distinct", sourceName);
+        unique_ptr<RowStream> rows = openTableForScan(source);
+        vector<string> header;
+        if (headerRow){
+            rows->next(header);
+        }
+        DistinctCountResult result = countDistinct(*rows, column - 1, precision, exact);
+        valueCount = result.values;
+        missingCount = result.missing;
+        distinctCount = result.distinct;
+        standardError = result.standardError;
+    }catch (const exception &e){
+        err << "Error counting distinct values: " << e.what() << endl;
+        return false;
+    }
+    computed = true;
+    stepCounters.rowsParsed += valueCount + missingCount;
+    out << "Counted " << (exact ? "" : "about ") << distinctCount << " distinct values in " << valueCount << " cells of column " << column << " of " << sourceName << "." << endl;
+    return true;
+}
+
+vector<string> DistinctCountStep::describeResults() const{
+    vector<string> lines;
+    lines.push_back("Values: " + to_string(valueCount) + ", Rows without the column: " + to_string(missingCount));
+    if (exact){
+        lines.push_back("Distinct values: " + to_string(distinctCount) + " (exact)");
+    }
+    else{
+        ostringstream line;
+        line << "Distinct values: about " << distinctCount << " (HyperLogLog precision " << precision << ", standard error " << standardError * 100 << "%)";
+        lines.push_back(line.str());
+    }
+    return lines;
+}
+
+FlowStep *createLoadedDistinctCountStep() {return new DistinctCountStep("Count distinct values of a column");}
+static StepRegistration<DistinctCountStep> distinctCountStepRegistration('g', "Step which counts the distinct values of a column of an imported table.", createLoadedDistinctCountStep, createStepWithDescription<DistinctCountStep>);
+
+// Rows shared with the step that made them, kept alive while they are read.
+class SharedTableRowStream : public TableRowStream{
+    private:
+        shared_ptr<const vector<vector<string>>> table;
+    public:
+        explicit SharedTableRowStream(const shared_ptr<const vector<vector<string>>> &table) : TableRowStream(*table), table(table) {}
+};
+
+bool RegexTransformStep::transform(const TextFileInputStep &text, const string &newPattern, ostream &out, ostream &err){
+    shared_ptr<const CompiledRegex> regex;
+    try{
+        regex = compileRegex(newPattern);
+    }catch (const invalid_argument &e){
+        err << "Error: Invalid regular expression: " << e.what() << endl;
+        return false;
+    }
+    pattern = newPattern;
+    textName = text.getFileName();
+    rows.reset();
+    try{
+        FLOW_TRACE_SCOPE("regex", "transform text", textName);
+        RegexTransformResult result = transformLines(text.getFileContent(), text.getLineIndex(), *regex);
+        columnCount = max<size_t>(regex->getGroupCount(), 1);
+        linesChecked = result.linesChecked;
+        rows = make_shared<const vector<vector<string>>>(move(result.rows));
+        stepCounters.rowsParsed += linesChecked;
+        out << "Extracted " << rows->size() << (rows->size() == 1 ? " row" : " rows") << " of " << columnCount << (columnCount == 1 ? " column" : " columns")
+            << " from " << linesChecked << (linesChecked == 1 ? " line" : " lines") << " of " << textName << "." << endl;
+        return true;
+    }catch (const exception &e){
+        err << "Error transforming the text: " << e.what() << endl;
+        return false;
+    }
+}
+
+unique_ptr<RowStream> RegexTransformStep::openTable() const{
+    return unique_ptr<RowStream>(new SharedTableRowStream(rows));
+}
+
+FlowStep *createLoadedRegexTransformStep() {return new RegexTransformStep("Extract columns from an imported text file");}
+static StepRegistration<RegexTransformStep> regexTransformStepRegistration('h', "Step which extracts columns from the lines of an imported text file with a regular expression.", createLoadedRegexTransformStep, createStepWithDescription<RegexTransformStep>);
+
+bool OutputStep::writeFile(string &message){
+    try{
+        FLOW_TRACE_SCOPE("output", "resolve filename", filename);
+        handleFilenameConflict();
+    }catch (const exception &e){
+        message = e.what();
+        return false;
+    }
+    try{
+        FLOW_TRACE_SCOPE("output", "write", filename);
+        ofstream outputFile(filename);
+        if (!outputFile.is_open()){
+            throw runtime_error("Error: Unable to open the output file for writing.");
+        }
+
+        if (contents){
+            outputFile << *contents;
+        }
+        else{
+            outputFile << "Title of the output file: " << title << endl;
+            outputFile << "Description of the output file: " << description << endl;
+            outputFile << "\n\n";
+
+            size_t section = 0;
+            for (size_t line = 0; line <= outputData.size(); ++line){
+                for (; section < outputRows.size() && outputRows[section].position <= line; ++section){
+                    vector<string> row;
+                    while (outputRows[section].rows->next(row)){
+                        for (const string &cell : row){
+                            outputFile << cell << ", ";
+                        }
+                        outputFile << '\n';
+                    }
+                }
+                if (line < outputData.size()){
+                    outputFile << outputData[line] << endl;
+                }
+            }
+        }
+
+        stepCounters.bytesWritten += static_cast<uint64_t>(outputFile.tellp());
+        outputFile.close();
+        if (outputFile.fail()){
+            throw runtime_error("Error: Failed to write data to the output file.");
+        }
+        message = "Output file '" + filename + "' created successfully.";
+        return true;
+    }catch (const exception &e){
+        message = e.what();
+        return false;
+    }
+}
+
+void OutputStep::writeOutput(ostream &out, ostream &err){
+    string message;
+    if (writeFile(message)){
+        out << message << endl;
+    }
+    else{
+        err << message << endl;
+    }
+}
+
+void OutputStep::execute(){
+    writeOutput(cout, cerr);
+}
+
+static StepRegistration<OutputStep> outputStepRegistration('9', "Step which lets the user to output a .txt file with the information he desires.");
+
+static StepRegistration<EndStep> endStepRegistration('0', "Step which adds automatically after finishing the flow.");
+
+vector<string> getImportedFiles(const FlowStep *step){
+    vector<string> files;
+    string fileName;
+    if (const TextFileInputStep *text = dynamic_cast<const TextFileInputStep *>(step)){
+        for (const ImportSource &source : text->getSources()){
+            files.push_back(source.fileName);
+        }
+        fileName = text->getFileName();
+    }
+    else if (const CSVFileInputStep *csv = dynamic_cast<const CSVFileInputStep *>(step)){
+        for (const ImportSource &source : csv->getSources()){
+            files.push_back(source.fileName);
+        }
+        fileName = csv->getFileName();
+    }
+    else if (const XLSXFileInputStep *xlsx = dynamic_cast<const XLSXFileInputStep *>(step)){
+        fileName = xlsx->getFileName();
+    }
+    if (files.empty() && !fileName.empty()){
+        files.push_back(fileName);
+    }
+    return files;
+}
@@ -0,0 +1,1204 @@
+#ifndef FLOWMAKER_FLOW_STEPS_H
+#define FLOWMAKER_FLOW_STEPS_H
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "FlowStep.h"
+#include "LineIndex.h"
+#include "RowStream.h"
+#include "TextStats.h"
+
+struct PrefetchedImport;
+class SortedRows;
+class JoinedRows;
+class TrigramIndex;
+
+// The rows of an import that came from one file. A directory or glob import has one
+// per file, in the order they were appended.
+struct ImportSource{
+    std::string fileName;
+    size_t firstRow;
+    size_t rowCount;
+};
+
+enum class ArithmeticOperation {
+    Addition,
+    Subtraction,
+    Multiplication,
+    Division,
+    Minimum,
+    Maximum
+};
+
+class TitleStep : public FlowStep{
+    private:
+        std::string title;
+        std::string subtitle;
+        bool complete = false;
+    public:
+        static constexpr const char *TYPE_NAME = "TitleStep";
+
+        TitleStep(const std::string &title = "Default Title for TitleStep", const std::string &subtitle = "Default Subtitle for TitleStep") : title(title), subtitle(subtitle) {}
+
+        void reset() override{
+            complete = false;
+        }
+
+        void execute() override{
+            std::cout << "Title: " << title << std::endl;
+            std::cout << "Subtitle: " << subtitle << std::endl;
+        }
+
+        FlowStep *clone() const override{
+            try{
+                return new TitleStep(*this);
+            }catch (const std::bad_alloc &e){
+                std::cerr << "Memory allocation error: " << e.what() << std::endl;
+                return nullptr;
+            }
+        }
+
+        void writeConfig(FlowRecordWriter &writer) const override{
+            writer.writeString(title);
+            writer.writeString(subtitle);
+        }
+
+        void readConfig(FlowRecordReader &reader) override{
+            title = reader.readString();
+            subtitle = reader.readString();
+        }
+
+        std::string getType() const override {return TYPE_NAME;}
+        std::string getDescription() const override {return "Step with a title and subtitle.";}
+        std::string getTitle() const {return title;}
+        std::string getSubtitle() const {return subtitle;}
+        bool getCompleteTitleStep() const {return complete;}
+        void setCompleteTitleStep(bool newComplete) {complete = newComplete;}
+        void setTitle(const std::string &newTitle) {title = newTitle;}
+        void setSubtitle(const std::string &newSubtitle) {subtitle = newSubtitle;}
+};
+
+class TextStep : public FlowStep{
+    private:
+        std::string title;
+        std::string text;
+        bool complete = false;
+        int stepNumber;
+    public:
+        static constexpr const char *TYPE_NAME = "TextStep";
+
+        TextStep(const std::string &title = "Default Title for TextStep", const std::string &text = "Default text for TextStep") : title(title), text(text) {}
+
+        void reset() override{
+            complete = false;
+        }
+
+        void execute() override{
+            std::cout << "Text Title: " << title << std::endl;
+            std::cout << "Text: " << text << std::endl;
+        }
+
+        FlowStep *clone() const override{
+            try{
+                return new TextStep(*this);
+            }catch (const std::bad_alloc &e){
+                std::cerr << "Memory allocation error: " << e.what() << std::endl;
+                return nullptr;
+            }
+        }
+
+        void writeConfig(FlowRecordWriter &writer) const override{
+            writer.writeString(title);
+            writer.writeString(text);
+        }
+
+        void readConfig(FlowRecordReader &reader) override{
+            title = reader.readString();
+            text = reader.readString();
+        }
+
+        std::string getType() const override {return TYPE_NAME;}
+        std::string getDescription() const override {return "Step with a title for the text and text.";}
+        std::string getTitle() const {return title;}
+        std::string getText() const {return text;}
+        bool getCompleteTextStep() const {return complete;}
+        int getStepNumberTextStep() const {return stepNumber;}
+        void setStepNumberTextStep(int newStepNumber) {stepNumber = newStepNumber;}
+        void setCompleteTextStep(bool newComplete) {complete = newComplete;}
+        void setTitle(const std::string &newTitle) {title = newTitle;}
+        void setText(const std::string &newText) {text = newText;}
+};
+
+class TextInputStep : public FlowStep{
+    private:
+        std::string description;
+    public:
+        static constexpr const char *TYPE_NAME = "TextInputStep";
+
+        TextInputStep(const std::string &description = "Default Description") : description(description) {}
+
+        void execute() override{
+            std::cout << "Text Input Step Description: " << description << std::endl;
+        }
+
+        FlowStep *clone() const override{
+            try{
+                return new TextInputStep(*this);
+            }catch (const std::bad_alloc &e){
+                std::cerr << "Memory allocation error: " << e.what() << std::endl;
+                return nullptr;
+            }
+        }
+
+        void writeConfig(FlowRecordWriter &writer) const override{
+            writer.writeString(description);
+        }
+
+        void readConfig(FlowRecordReader &reader) override{
+            description = reader.readString();
+        }
+
+        std::string getType() const override {return TYPE_NAME;}
+        std::string getDescription() const override {return ("Step to input the text.\nDescription of the user that created the step: " + description);}
+};
+
+class NumberInputStep : public FlowStep{
+    private:
+        std::string description;
+        double userInput = 0.0;
+    public:
+        static constexpr const char *TYPE_NAME = "NumberInputStep";
+
+        NumberInputStep(const std::string &description = "Default Number Input Description") : description(description) {}
+
+        void execute() override{
+            std::cout << "Number Input Step Description: " << description << std::endl;
+        }
+
+        void reset() override{
+            userInput = 0.0;
+        }
+
+        FlowStep *clone() const override{
+            try{
+                return new NumberInputStep(*this);
+            }catch (const std::bad_alloc &e){
+                std::cerr << "Memory allocation error: " << e.what() << std::endl;
+                return nullptr;
+            }
+        }
+
+        void writeConfig(FlowRecordWriter &writer) const override{
+            writer.writeString(description);
+        }
+
+        void readConfig(FlowRecordReader &reader) override{
+            description = reader.readString();
+        }
+
+        std::string getType() const override {return TYPE_NAME;}
+        std::string getDescription() const override {return ("Step to input a number.\nDescription of the user that created this step: " + description);}
+        double getUserInput() const {return userInput;}
+        void setUserInput(double input) {userInput = input;}
+};
+
+template <typename T>
+class CalculusStep : public FlowStep{
+    private:
+        ArithmeticOperation operation;
+        std::vector<NumberInputStep *> numberInputs;
+        char operationSymbol;
+    public:
+        static constexpr const char *TYPE_NAME = "CalculusStep";
+
+        CalculusStep(ArithmeticOperation operation, char operationSymbol) : operation(operation), operationSymbol(operationSymbol) {}
+
+        void addNumberInput(NumberInputStep *inputStep){
+            if (inputStep == nullptr){
+                throw std::invalid_argument("Input step pointer is null");
+            }
+            numberInputs.push_back(inputStep);
+        }
+
+        void clearNumberInputs() {numberInputs.clear();}
+
+        void setOperation(ArithmeticOperation op){
+            if (op != ArithmeticOperation::Addition && op != ArithmeticOperation::Subtraction &&
+                op != ArithmeticOperation::Multiplication && op != ArithmeticOperation::Division &&
+                op != ArithmeticOperation::Minimum && op != ArithmeticOperation::Maximum)
+            {
+                throw std::invalid_argument("Invalid arithmetic operation");
+            }
+            operation = op;
+        }
+
+        T performCalculation() const{
+            T result = 0;
+            switch (operation){
+            case ArithmeticOperation::Addition:
+                for (NumberInputStep *step : numberInputs){
+                    result += static_cast<T>(step->getUserInput());
+                }
+                break;
+            case ArithmeticOperation::Subtraction:
+                if (!numberInputs.empty()){
+                    result = static_cast<T>(numberInputs[0]->getUserInput());
+                    for (size_t i = 1; i < numberInputs.size(); ++i){
+                        result -= static_cast<T>(numberInputs[i]->getUserInput());
+                    }
+                }
+                break;
+            case ArithmeticOperation::Multiplication:
+                result = 1;
+                for (NumberInputStep *step : numberInputs){
+                    result *= static_cast<T>(step->getUserInput());
+                }
+                break;
+            case ArithmeticOperation::Division:
+                if (!numberInputs.empty()){
+                    result = static_cast<T>(numberInputs[0]->getUserInput());
+                    for (size_t i = 1; i < numberInputs.size(); ++i){
+                        if (numberInputs[i]->getUserInput() != 0){
+                            result /= static_cast<T>(numberInputs[i]->getUserInput());
+                        }
+                        else{
+                            throw std::runtime_error("Division by zero detected. Skipping.");
+                        }
+                    }
+                }
+                break;
+            case ArithmeticOperation::Minimum:
+                if (!numberInputs.empty()){
+                    result = static_cast<T>(numberInputs[0]->getUserInput());
+                    for (size_t i = 1; i < numberInputs.size(); ++i){
+                        result = std::min(result, static_cast<T>(numberInputs[i]->getUserInput()));
+                    }
+                }
+                break;
+            case ArithmeticOperation::Maximum:
+                if (!numberInputs.empty()){
+                    result = static_cast<T>(numberInputs[0]->getUserInput());
+                    for (size_t i = 1; i < numberInputs.size(); ++i){
+                        result = std::max(result, static_cast<T>(numberInputs[i]->getUserInput()));
+                    }
+                }
+                break;
+            }
+            return result;
+        }
+
+        void execute() override{
+            std::cout << "Performing Calculus Step: ";
+            switch (operation){
+            case ArithmeticOperation::Addition:
+                std::cout << "Addition" << std::endl;
+                break;
+            case ArithmeticOperation::Subtraction:
+                std::cout << "Subtraction" << std::endl;
+                break;
+            case ArithmeticOperation::Multiplication:
+                std::cout << "Multiplication" << std::endl;
+                break;
+            case ArithmeticOperation::Division:
+                std::cout << "Division" << std::endl;
+                break;
+            case ArithmeticOperation::Minimum:
+                std::cout << "Minimum" << std::endl;
+                break;
+            case ArithmeticOperation::Maximum:
+                std::cout << "Maximum" << std::endl;
+                break;
+            }
+            try{
+                std::cout << "Result: " << performCalculation() << std::endl;
+            }catch (const std::runtime_error &e){
+                std::cout << "Error: " << e.what() << std::endl;
+            }
+        }
+
+        FlowStep *clone() const override{
+            try{
+                return new CalculusStep<T>(*this);
+            }catch (const std::bad_alloc &e){
+                std::cerr << "Memory allocation error: " << e.what() << std::endl;
+                return nullptr;
+            }
+        }
+        // Operands are stored as indices of NumberInputSteps earlier in the same flow.
+        void writeConfig(FlowRecordWriter &writer) const override{
+            writer.writeU8(static_cast<uint8_t>(operation));
+            writer.writeU8(static_cast<uint8_t>(operationSymbol));
+            writer.writeU32(static_cast<uint32_t>(numberInputs.size()));
+            for (const NumberInputStep *inputStep : numberInputs){
+                writer.writeU32(static_cast<uint32_t>(writer.indexOfStep(inputStep)));
+            }
+        }
+
+        void readConfig(FlowRecordReader &reader) override{
+            uint8_t storedOperation = reader.readU8();
+            char storedSymbol = static_cast<char>(reader.readU8());
+            if (storedOperation > static_cast<uint8_t>(ArithmeticOperation::Maximum)){
+                throw std::runtime_error("Invalid arithmetic operation in stored CalculusStep.");
+            }
+            operation = static_cast<ArithmeticOperation>(storedOperation);
+            operationSymbol = storedSymbol;
+            numberInputs.clear();
+            uint32_t inputCount = reader.readU32();
+            for (uint32_t i = 0; i < inputCount && !reader.hasFailed(); ++i){
+                int32_t index = static_cast<int32_t>(reader.readU32());
+                NumberInputStep *inputStep = dynamic_cast<NumberInputStep *>(reader.stepAt(index));
+                if (inputStep){
+                    numberInputs.push_back(inputStep);
+                }
+                else{
+                    std::cerr << "Warning: CalculusStep operand " << index << " is not a previous NumberInputStep and was dropped." << std::endl;
+                }
+            }
+        }
+
+        std::string getType() const override {return TYPE_NAME;}
+        std::string getDescription() const override {return "Step to perform arithmetic operations. (+, -, *, /, m (min), M (max))";}
+        void setOperationSymbol(char symbol) {operationSymbol = symbol;}
+        char getOperationSymbol() const {return operationSymbol;}
+        const std::vector<NumberInputStep *> &getNumberInputs() const {return numberInputs;}
+};
+
+class DisplayStep : public FlowStep{
+    public:
+        static constexpr const char *TYPE_NAME = "DisplayStep";
+
+        DisplayStep() {}
+
+        void execute() override{
+            std::cout << "Displaying the Flow" << std::endl;
+        }
+
+        std::string getType() const override {return TYPE_NAME;}
+        std::string getDescription() const override {return "Displaying the flow.";}
+
+        FlowStep *clone() const override{
+            try{
+                return new DisplayStep(*this);
+            }catch (const std::bad_alloc &e){
+                std::cerr << "Memory allocation error: " << e.what() << std::endl;
+                return nullptr;
+            }
+        }
+};
+
+class TextFileInputStep : public FlowStep{
+    private:
+        std::string description;
+        std::string fileName;
+        bool fileImported = false;
+        std::string fileContent;
+        // Built while the files are imported.
+        LineIndex lineIndex;
+        std::vector<ImportSource> sources;
+        // Built by the first indexed search and kept while the content is unchanged.
+        mutable std::shared_ptr<const TrigramIndex> searchIndex;
+
+        void appendContents(const std::string &sourceName, const std::string &contents, std::ostream &out);
+        void importFiles(std::ostream &out);
+    public:
+        static constexpr const char *TYPE_NAME = "TextFileInputStep";
+
+        TextFileInputStep(const std::string &description = "Default Description") : description(description) {}
+
+        void reset() override{
+            fileImported = false;
+            fileContent = "";
+            lineIndex = LineIndex();
+            sources.clear();
+            searchIndex.reset();
+        }
+
+        // Checks an entered file name and appends ".txt" unless it already ends with it
+        // or names a directory or glob pattern.
+        static bool prepareFileName(std::string &fileName);
+
+        // Reads the file and appends its contents to the step. Progress goes to out.
+        // A prefetched import of the file is used instead of reading it again. For a
+        // directory or glob every matching file is read, concurrently, and appended in
+        // name order.
+        void importFile(const std::string &newFileName, std::ostream &out, std::shared_ptr<PrefetchedImport> prefetched = nullptr);
+
+        void execute() override;
+
+        FlowStep *clone() const override{
+            try{
+                return new TextFileInputStep(*this);
+            }catch (const std::bad_alloc &e){
+                std::cerr << "Memory allocation error: " << e.what() << std::endl;
+                return nullptr;
+            }
+        }
+
+        bool isFileImported() const {return fileImported;}
+        const std::string &getFileContent() const {return fileContent;}
+        std::string getFileName() const {return fileName;}
+        const std::vector<ImportSource> &getSources() const {return sources;}
+        size_t getLineCount() const {return lineIndex.getLineCount();}
+        // Trigram index of the content for SearchStep, built on first use.
+        std::shared_ptr<const TrigramIndex> getSearchIndex() const;
+        // Line offsets of the content, for paging and slicing line ranges.
+        const LineIndex &getLineIndex() const {return lineIndex;}
+        void writeConfig(FlowRecordWriter &writer) const override{
+            writer.writeString(description);
+            writer.writeString(fileName);
+        }
+
+        void readConfig(FlowRecordReader &reader) override{
+            description = reader.readString();
+            fileName = reader.readString();
+        }
+
+        std::string getType() const override {return TYPE_NAME;}
+        std::string getDescription() const override {return ("Step to input a text file (.txt).\nDescription of the user that created the step: " + description);}
+};
+
+class CSVFileInputStep : public FlowStep, public TableProducer{
+    private:
+        std::string description;
+        std::string fileName;
+        bool fileImported = false;
+        std::vector<std::vector<std::string>> csvData;
+        std::vector<ImportSource> sources;
+
+        void importFiles(std::ostream &out, std::ostream &err);
+    public:
+        static constexpr const char *TYPE_NAME = "CSVFileInputStep";
+
+        CSVFileInputStep(const std::string &description = "Default Description") : description(description) {}
+
+        // Splits the file into rows at '\n' and into cells at ','. A trailing comma does
+        // not start an extra cell and an empty line gives an empty row.
+        static void parseCSVContents(const std::string &contents, std::vector<std::vector<std::string>> &rows);
+
+        void reset() override{
+            fileImported = false;
+            csvData.clear();
+            sources.clear();
+        }
+
+        // Checks an entered file name and appends ".csv" unless it already ends with it
+        // or names a directory or glob pattern.
+        static bool prepareFileName(std::string &fileName);
+
+        // Reads and parses the file, replacing the rows read before. Progress goes to
+        // out and read errors to err. A prefetched import of the file is used instead
+        // of reading and parsing it again. For a directory or glob every matching file
+        // is read and parsed, concurrently, and the rows are concatenated in name order.
+        void importFile(const std::string &newFileName, std::ostream &out, std::ostream &err, std::shared_ptr<PrefetchedImport> prefetched = nullptr);
+
+        void execute() override;
+
+        FlowStep *clone() const override{
+            try{
+                return new CSVFileInputStep(*this);
+            }catch (const std::bad_alloc &e){
+                std::cerr << "Memory allocation error: " << e.what() << std::endl;
+                return nullptr;
+            }
+        }
+
+        void writeConfig(FlowRecordWriter &writer) const override{
+            writer.writeString(description);
+            writer.writeString(fileName);
+        }
+
+        void readConfig(FlowRecordReader &reader) override{
+            description = reader.readString();
+            fileName = reader.readString();
+        }
+
+        std::string getType() const override {return TYPE_NAME;}
+        std::string getDescription() const override {return ("Step to input a CSV file (.csv).\nDescription of the user that created the step: " + description);}
+        bool isFileImported() const {return fileImported;}
+        const std::vector<std::vector<std::string>> &getCSVData() const {return csvData;}
+        std::string getFileName() const {return fileName;}
+        const std::vector<ImportSource> &getSources() const {return sources;}
+
+        bool hasTable() const override {return fileImported;}
+        std::unique_ptr<RowStream> openTable() const override {return std::unique_ptr<RowStream>(new TableRowStream(csvData));}
+        uint64_t getRowCount() const override {return csvData.size();}
+        const std::vector<std::vector<std::string>> *getRowsInMemory() const override {return &csvData;}
+        std::string getTableName() const override {return fileName;}
+};
+
+class XLSXFileInputStep : public FlowStep, public TableProducer{
+    private:
+        std::string description;
+        std::string fileName;
+        std::string sheetName;
+        bool fileImported = false;
+        std::vector<std::vector<std::string>> tableData;
+    public:
+        static constexpr const char *TYPE_NAME = "XLSXFileInputStep";
+
+        XLSXFileInputStep(const std::string &description = "Default Description") : description(description) {}
+
+        void reset() override{
+            fileImported = false;
+            tableData.clear();
+        }
+
+        // Checks an entered file name and appends ".xlsx" unless it already ends with it.
+        static bool prepareFileName(std::string &fileName);
+
+        // Streams the rows of one sheet (by name or 1-based number, the first if empty)
+        // into the same table as a CSV import, replacing the rows read before. Progress
+        // goes to out and read errors to err.
+        void importFile(const std::string &newFileName, const std::string &newSheetName, std::ostream &out, std::ostream &err);
+
+        void execute() override;
+
+        FlowStep *clone() const override{
+            try{
+                return new XLSXFileInputStep(*this);
+            }catch (const std::bad_alloc &e){
+                std::cerr << "Memory allocation error: " << e.what() << std::endl;
+                return nullptr;
+            }
+        }
+
+        void writeConfig(FlowRecordWriter &writer) const override{
+            writer.writeString(description);
+            writer.writeString(fileName);
+            writer.writeString(sheetName);
+        }
+
+        void readConfig(FlowRecordReader &reader) override{
+            description = reader.readString();
+            fileName = reader.readString();
+            sheetName = reader.readString();
+        }
+
+        std::string getType() const override {return TYPE_NAME;}
+        std::string getDescription() const override {return ("Step to input a sheet of a spreadsheet file (.xlsx).\nDescription of the user that created the step: " + description);}
+        bool isFileImported() const {return fileImported;}
+        const std::vector<std::vector<std::string>> &getTableData() const {return tableData;}
+        std::string getFileName() const {return fileName;}
+        std::string getSheetName() const {return sheetName;}
+
+        bool hasTable() const override {return fileImported;}
+        std::unique_ptr<RowStream> openTable() const override {return std::unique_ptr<RowStream>(new TableRowStream(tableData));}
+        uint64_t getRowCount() const override {return tableData.size();}
+        const std::vector<std::vector<std::string>> *getRowsInMemory() const override {return &tableData;}
+        std::string getTableName() const override {return fileName;}
+};
+
+class SortStep : public FlowStep, public TableProducer{
+    private:
+        std::string description;
+        std::string keySpec;
+        bool headerRow = false;
+        std::string sourceName;
+        std::vector<std::string> header;
+        std::shared_ptr<const SortedRows> sortedRows;
+    public:
+        static constexpr const char *TYPE_NAME = "SortStep";
+
+        SortStep(const std::string &description = "Default Description") : description(description) {}
+
+        void reset() override{
+            sourceName = "";
+            header.clear();
+            sortedRows.reset();
+        }
+
+        // Sorts the table of source by the keys in newKeySpec (see parseSortKeys), keeping
+        // the first row in place if newHeaderRow is set. Tables over the sort memory budget
+        // are sorted in runs spilled to temporary files. Progress goes to out and errors
+        // to err; returns false if the keys are malformed or the sort failed.
+        bool sortTable(const TableProducer &source, const std::string &newKeySpec, bool newHeaderRow, std::ostream &out, std::ostream &err);
+
+        void execute() override{
+            std::cout << "Sort Step Description: " << description << std::endl;
+            std::cout << "Sort keys: " << keySpec << std::endl;
+        }
+
+        FlowStep *clone() const override{
+            try{
+                return new SortStep(*this);
+            }catch (const std::bad_alloc &e){
+                std::cerr << "Memory allocation error: " << e.what() << std::endl;
+                return nullptr;
+            }
+        }
+
+        void writeConfig(FlowRecordWriter &writer) const override{
+            writer.writeString(description);
+            writer.writeString(keySpec);
+            writer.writeU8(headerRow ? 1 : 0);
+        }
+
+        void readConfig(FlowRecordReader &reader) override{
+            description = reader.readString();
+            keySpec = reader.readString();
+            headerRow = reader.readU8() != 0;
+        }
+
+        std::string getType() const override {return TYPE_NAME;}
+        std::string getDescription() const override {return ("Step to sort an imported table by one or more columns.\nDescription of the user that created the step: " + description);}
+        std::string getKeySpec() const {return keySpec;}
+        bool hasHeaderRow() const {return headerRow;}
+        std::string getSourceName() const {return sourceName;}
+        // Rows of the sorted table, header first; 0 before the step ran.
+        uint64_t getRowCount() const override;
+
+        bool hasTable() const override {return sortedRows != nullptr;}
+        // The stream keeps the sorted rows alive and may outlive the step.
+        std::unique_ptr<RowStream> openTable() const override;
+        std::string getTableName() const override {return "sorted " + sourceName;}
+};
+
+class JoinStep : public FlowStep, public TableProducer{
+    private:
+        std::string description;
+        std::string leftKeys;
+        std::string rightKeys;
+        bool keepUnmatchedLeft = false;
+        bool headerRow = false;
+        std::string leftName;
+        std::string rightName;
+        std::vector<std::string> header;
+        std::shared_ptr<const JoinedRows> joinedRows;
+    public:
+        static constexpr const char *TYPE_NAME = "JoinStep";
+
+        JoinStep(const std::string &description = "Default Description") : description(description) {}
+
+        void reset() override{
+            leftName = "";
+            rightName = "";
+            header.clear();
+            joinedRows.reset();
+        }
+
+        // Joins the rows of left and right whose key columns (see parseJoinColumns) are
+        // equal, keeping left rows without a match if newKeepUnmatchedLeft is set. With
+        // newHeaderRow the first rows of both tables are joined into the header instead.
+        // The hash table is built on the smaller table and spilled in partitions when it
+        // exceeds the join memory budget. Progress goes to out and errors to err; returns
+        // false if the keys are malformed or the join failed.
+        bool joinTables(const TableProducer &left, const TableProducer &right, const std::string &newLeftKeys, const std::string &newRightKeys, bool newKeepUnmatchedLeft, bool newHeaderRow, std::ostream &out, std::ostream &err);
+
+        void execute() override{
+            std::cout << "Join Step Description: " << description << std::endl;
+            std::cout << "Key columns: " << leftKeys << " = " << rightKeys << std::endl;
+        }
+
+        FlowStep *clone() const override{
+            try{
+                return new JoinStep(*this);
+            }catch (const std::bad_alloc &e){
+                std::cerr << "Memory allocation error: " << e.what() << std::endl;
+                return nullptr;
+            }
+        }
+
+        void writeConfig(FlowRecordWriter &writer) const override{
+            writer.writeString(description);
+            writer.writeString(leftKeys);
+            writer.writeString(rightKeys);
+            writer.writeU8(keepUnmatchedLeft ? 1 : 0);
+            writer.writeU8(headerRow ? 1 : 0);
+        }
+
+        void readConfig(FlowRecordReader &reader) override{
+            description = reader.readString();
+            leftKeys = reader.readString();
+            rightKeys = reader.readString();
+            keepUnmatchedLeft = reader.readU8() != 0;
+            headerRow = reader.readU8() != 0;
+        }
+
+        std::string getType() const override {return TYPE_NAME;}
+        std::string getDescription() const override {return ("Step to join two imported tables on key columns.\nDescription of the user that created the step: " + description);}
+        std::string getLeftKeys() const {return leftKeys;}
+        std::string getRightKeys() const {return rightKeys;}
+        bool keepsUnmatchedLeft() const {return keepUnmatchedLeft;}
+        bool hasHeaderRow() const {return headerRow;}
+        // Rows of the joined table, header first; 0 before the step ran.
+        uint64_t getRowCount() const override;
+
+        bool hasTable() const override {return joinedRows != nullptr;}
+        // The stream keeps the joined rows alive and may outlive the step.
+        std::unique_ptr<RowStream> openTable() const override;
+        std::string getTableName() const override {return leftName + " joined with " + rightName;}
+};
+
+// A line of text found by a SearchStep.
+struct SearchMatch{
+    std::string fileName;
+    // 1-based line number within fileName.
+    size_t line;
+    std::string text;
+};
+
+class SearchStep : public FlowStep{
+    private:
+        std::string description;
+        std::string patterns;
+        bool ignoreCase = false;
+        bool useIndex = false;
+        bool searched = false;
+        std::string textName;
+        std::vector<SearchMatch> matches;
+        std::vector<uint64_t> patternLines;
+    public:
+        static constexpr const char *TYPE_NAME = "SearchStep";
+
+        SearchStep(const std::string &description = "Default Description") : description(description) {}
+
+        void reset() override{
+            searched = false;
+            textName = "";
+            matches.clear();
+            patternLines.clear();
+        }
+
+        // Finds the lines of the imported text that contain any of newPatterns (separated
+        // by '|'), ignoring ASCII case if newIgnoreCase is set. The text is scanned in
+        // parallel, or with newUseIndex looked up in the text's trigram index, which is
+        // built once and reused by later searches of the same text. Progress goes to out
+        // and errors to err; returns false if no pattern was given.
+        bool search(const TextFileInputStep &text, const std::string &newPatterns, bool newIgnoreCase, bool newUseIndex, std::ostream &out, std::ostream &err);
+
+        void execute() override{
+            std::cout << "Search Step Description: " << description << std::endl;
+            std::cout << "Search patterns: " << patterns << std::endl;
+        }
+
+        FlowStep *clone() const override{
+            try{
+                return new SearchStep(*this);
+            }catch (const std::bad_alloc &e){
+                std::cerr << "Memory allocation error: " << e.what() << std::endl;
+                return nullptr;
+            }
+        }
+
+        void writeConfig(FlowRecordWriter &writer) const override{
+            writer.writeString(description);
+            writer.writeString(patterns);
+            writer.writeU8(ignoreCase ? 1 : 0);
+            writer.writeU8(useIndex ? 1 : 0);
+        }
+
+        void readConfig(FlowRecordReader &reader) override{
+            description = reader.readString();
+            patterns = reader.readString();
+            ignoreCase = reader.readU8() != 0;
+            useIndex = reader.readU8() != 0;
+        }
+
+        std::string getType() const override {return TYPE_NAME;}
+        std::string getDescription() const override {return ("Step to search an imported text file for one or more patterns.\nDescription of the user that created the step: " + description);}
+        std::string getPatterns() const {return patterns;}
+        bool isSearched() const {return searched;}
+        std::string getTextName() const {return textName;}
+        const std::vector<SearchMatch> &getMatches() const {return matches;}
+        // Lines matching each pattern, in the order of getPatterns().
+        const std::vector<uint64_t> &getPatternLines() const {return patternLines;}
+};
+
+class RegexTransformStep : public FlowStep, public TableProducer{
+    private:
+        std::string description;
+        std::string pattern;
+        std::string textName;
+        size_t columnCount = 0;
+        uint64_t linesChecked = 0;
+        std::shared_ptr<const std::vector<std::vector<std::string>>> rows;
+    public:
+        static constexpr const char *TYPE_NAME = "RegexTransformStep";
+
+        RegexTransformStep(const std::string &description = "Default Description") : description(description) {}
+
+        void reset() override{
+            textName = "";
+            columnCount = 0;
+            linesChecked = 0;
+            rows.reset();
+        }
+
+        // Turns every line of the imported text that matches newPattern into a row of
+        // its capture groups (or of the whole match if there are none); other lines
+        // are left out. The pattern is compiled once per process and the lines are
+        // matched on several threads. Progress goes to out and errors to err; returns
+        // false if the pattern is invalid or matching failed.
+        bool transform(const TextFileInputStep &text, const std::string &newPattern, std::ostream &out, std::ostream &err);
+
+        void execute() override{
+            std::cout << "Regex Transform Step Description: " << description << std::endl;
+            std::cout << "Regular expression: " << pattern << std::endl;
+        }
+
+        FlowStep *clone() const override{
+            try{
+                return new RegexTransformStep(*this);
+            }catch (const std::bad_alloc &e){
+                std::cerr << "Memory allocation error: " << e.what() << std::endl;
+                return nullptr;
+            }
+        }
+
+        void writeConfig(FlowRecordWriter &writer) const override{
+            writer.writeString(description);
+            writer.writeString(pattern);
+        }
+
+        void readConfig(FlowRecordReader &reader) override{
+            description = reader.readString();
+            pattern = reader.readString();
+        }
+
+        std::string getType() const override {return TYPE_NAME;}
+        std::string getDescription() const override {return ("Step to extract columns from the lines of an imported text file with a regular expression.\nDescription of the user that created the step: " + description);}
+        std::string getPattern() const {return pattern;}
+        std::string getTextName() const {return textName;}
+        size_t getColumnCount() const {return columnCount;}
+        uint64_t getLinesChecked() const {return linesChecked;}
+        uint64_t getRowCount() const override {return rows ? rows->size() : 0;}
+
+        bool hasTable() const override {return rows != nullptr;}
+        // The stream keeps the rows alive and may outlive the step.
+        std::unique_ptr<RowStream> openTable() const override;
+        const std::vector<std::vector<std::string>> *getRowsInMemory() const override {return rows.get();}
+        std::string getTableName() const override {return "fields of " + textName;}
+};
+
+class TextStatsStep : public FlowStep{
+    private:
+        std::string description;
+        size_t topCount = 10;
+        bool ignoreCase = false;
+        bool computed = false;
+        std::string textName;
+        TextStats stats;
+    public:
+        static constexpr const char *TYPE_NAME = "TextStatsStep";
+
+        TextStatsStep(const std::string &description = "Default Description") : description(description) {}
+
+        void reset() override{
+            computed = false;
+            textName = "";
+            stats = TextStats();
+        }
+
+        // Counts the lines, words, bytes and tokens of the imported text and keeps the
+        // newTopCount most frequent tokens, counted in lowercase if newIgnoreCase is set.
+        // The text is counted in parallel chunks. Progress goes to out and errors to err.
+        bool computeStats(const TextFileInputStep &text, size_t newTopCount, bool newIgnoreCase, std::ostream &out, std::ostream &err);
+
+        void execute() override{
+            std::cout << "Text Statistics Step Description: " << description << std::endl;
+            std::cout << "Most frequent tokens listed: " << topCount << std::endl;
+        }
+
+        FlowStep *clone() const override{
+            try{
+                return new TextStatsStep(*this);
+            }catch (const std::bad_alloc &e){
+                std::cerr << "Memory allocation error: " << e.what() << std::endl;
+                return nullptr;
+            }
+        }
+
+        void writeConfig(FlowRecordWriter &writer) const override{
+            writer.writeString(description);
+            writer.writeU32(static_cast<uint32_t>(topCount));
+            writer.writeU8(ignoreCase ? 1 : 0);
+        }
+
+        void readConfig(FlowRecordReader &reader) override{
+            description = reader.readString();
+            topCount = reader.readU32();
+            ignoreCase = reader.readU8() != 0;
+        }
+
+        std::string getType() const override {return TYPE_NAME;}
+        std::string getDescription() const override {return ("Step to count the lines, words and most frequent tokens of an imported text file.\nDescription of the user that created the step: " + description);}
+        bool isComputed() const {return computed;}
+        std::string getTextName() const {return textName;}
+        const TextStats &getStats() const {return stats;}
+};
+
+class QuantileStep : public FlowStep{
+    private:
+        std::string description;
+        size_t column = 1;
+        std::string percentiles;
+        bool headerRow = false;
+        bool computed = false;
+        std::string sourceName;
+        uint64_t valueCount = 0;
+        uint64_t skippedCount = 0;
+        double minimum = 0;
+        double maximum = 0;
+        std::vector<double> ranks;
+        std::vector<double> quantiles;
+    public:
+        static constexpr const char *TYPE_NAME = "QuantileStep";
+
+        QuantileStep(const std::string &description = "Default Description") : description(description) {}
+
+        void reset() override{
+            computed = false;
+            sourceName = "";
+            valueCount = 0;
+            skippedCount = 0;
+            minimum = 0;
+            maximum = 0;
+            ranks.clear();
+            quantiles.clear();
+        }
+
+        // Estimates newPercentiles (such as "50,95,99") of the numbers in column
+        // newColumn (1-based) of the table of source, skipping its first row if
+        // newHeaderRow is set, with a t-digest of constant size built in parallel.
+        // Progress goes to out and errors to err; returns false if the percentiles
+        // are malformed.
+        bool computeQuantiles(const TableProducer &source, size_t newColumn, const std::string &newPercentiles, bool newHeaderRow, std::ostream &out, std::ostream &err);
+
+        void execute() override{
+            std::cout << "Quantile Step Description: " << description << std::endl;
+            std::cout << "Percentiles of column " << column << ": " << percentiles << std::endl;
+        }
+
+        FlowStep *clone() const override{
+            try{
+                return new QuantileStep(*this);
+            }catch (const std::bad_alloc &e){
+                std::cerr << "Memory allocation error: " << e.what() << std::endl;
+                return nullptr;
+            }
+        }
+
+        void writeConfig(FlowRecordWriter &writer) const override{
+            writer.writeString(description);
+            writer.writeU32(static_cast<uint32_t>(column));
+            writer.writeString(percentiles);
+            writer.writeU8(headerRow ? 1 : 0);
+        }
+
+        void readConfig(FlowRecordReader &reader) override{
+            description = reader.readString();
+            column = reader.readU32();
+            percentiles = reader.readString();
+            headerRow = reader.readU8() != 0;
+        }
+
+        std::string getType() const override {return TYPE_NAME;}
+        std::string getDescription() const override {return ("Step to estimate percentiles of a numeric column of an imported table.\nDescription of the user that created the step: " + description);}
+        bool isComputed() const {return computed;}
+        std::string getSourceName() const {return sourceName;}
+        size_t getColumn() const {return column;}
+        // One line per result: the value count, range and each percentile.
+        std::vector<std::string> describeResults() const;
+};
+
+class DistinctCountStep : public FlowStep{
+    private:
+        std::string description;
+        size_t column = 1;
+        unsigned precision = 14;
+        bool exact = false;
+        bool headerRow = false;
+        bool computed = false;
+        std::string sourceName;
+        uint64_t valueCount = 0;
+        uint64_t missingCount = 0;
+        uint64_t distinctCount = 0;
+        double standardError = 0;
+    public:
+        static constexpr const char *TYPE_NAME = "DistinctCountStep";
+
+        DistinctCountStep(const std::string &description = "Default Description") : description(description) {}
+
+        void reset() override{
+            computed = false;
+            sourceName = "";
+            valueCount = 0;
+            missingCount = 0;
+            distinctCount = 0;
+            standardError = 0;
+        }
+
+        // Counts the distinct cells of column newColumn (1-based) of the table of source,
+        // skipping its first row if newHeaderRow is set. Unless newExact is set the
+        // count is estimated with a HyperLogLog sketch of 2^newPrecision registers per
+        // thread. Progress goes to out and errors to err.
+        bool countValues(const TableProducer &source, size_t newColumn, bool newExact, unsigned newPrecision, bool newHeaderRow, std::ostream &out, std::ostream &err);
+
+        void execute() override{
+            std::cout << "Distinct Count Step Description: " << description << std::endl;
+            std::cout << "Column: " << column << (exact ? " (exact)" : "") << std::endl;
+        }
+
+        FlowStep *clone() const override{
+            try{
+                return new DistinctCountStep(*this);
+            }catch (const std::bad_alloc &e){
+                std::cerr << "Memory allocation error: " << e.what() << std::endl;
+                return nullptr;
+            }
+        }
+
+        void writeConfig(FlowRecordWriter &writer) const override{
+            writer.writeString(description);
+            writer.writeU32(static_cast<uint32_t>(column));
+            writer.writeU8(static_cast<uint8_t>(precision));
+            writer.writeU8(exact ? 1 : 0);
+            writer.writeU8(headerRow ? 1 : 0);
+        }
+
+        void readConfig(FlowRecordReader &reader) override{
+            description = reader.readString();
+            column = reader.readU32();
+            precision = reader.readU8();
+            exact = reader.readU8() != 0;
+            headerRow = reader.readU8() != 0;
+        }
+
+        std::string getType() const override {return TYPE_NAME;}
+        std::string getDescription() const override {return ("Step to count the distinct values of a column of an imported table.\nDescription of the user that created the step: " + description);}
+        bool isComputed() const {return computed;}
+        std::string getSourceName() const {return sourceName;}
+        size_t getColumn() const {return column;}
+        // One line per result: the value count and the distinct count with its error.
+        std::vector<std::string> describeResults() const;
+};
+
+// Rows streamed into an output file after its first `position` lines of data.
+struct OutputRows{
+    size_t position;
+    std::shared_ptr<RowStream> rows;
+};
+
+class OutputStep : public FlowStep{
+    private:
+        std::string filename;
+        std::string title;
+        std::string description;
+        std::vector<std::string> outputData;
+        std::vector<OutputRows> outputRows;
+        // Written instead of the title, description and data when set.
+        std::shared_ptr<const std::string> contents;
+    public:
+        static constexpr const char *TYPE_NAME = "OutputStep";
+
+        OutputStep(const std::string &filename = "Default File Name", const std::string &title = "Default File Title", const std::string &description = "Default File Description") : filename(filename), title(title), description(description) {}
+
+        void reset() override{
+            outputData.clear();
+            outputRows.clear();
+            contents.reset();
+        }
+
+        FlowStep *clone() const override{
+            try{
+                return new OutputStep(*this);
+            }
+            catch (const std::bad_alloc &e){
+                std::cerr << "Memory allocation error: " << e.what() << std::endl;
+                return nullptr;
+            }
+        }
+
+        void writeConfig(FlowRecordWriter &writer) const override{
+            writer.writeString(filename);
+            writer.writeString(title);
+            writer.writeString(description);
+        }
+
+        void readConfig(FlowRecordReader &reader) override{
+            filename = reader.readString();
+            title = reader.readString();
+            description = reader.readString();
+        }
+
+        void setOutputData(const std::vector<std::string> &data) {outputData = data;}
+        void setOutputData(std::vector<std::string> &&data) {outputData = std::move(data);}
+        const std::vector<std::string> &getOutputData() const {return outputData;}
+        // Tables written row by row as the file is written, instead of being copied
+        // into the output data first.
+        void setOutputRows(std::vector<OutputRows> &&rows) {outputRows = std::move(rows);}
+        // Writes the file with these contents, e.g. those of a file of an earlier run.
+        void setContents(std::shared_ptr<const std::string> newContents) {contents = std::move(newContents);}
+        const std::string *getContents() const {return contents.get();}
+        std::string getFilename() const {return filename;}
+        std::string getTitle() const {return title;}
+        std::string getType() const override {return TYPE_NAME;}
+        std::string getDescription() const {return "Step to output a text file (.txt).";}
+        void setFilename(const std::string &newFilename) {filename = newFilename;}
+        void setTitle(const std::string &newTitle) {title = newTitle;}
+        void setDescription(const std::string &newDescription) {description = newDescription;}
+
+        void handleFilenameConflict(){
+            size_t pos = filename.find_last_of(".");
+            if (pos == std::string::npos || filename.substr(pos) != ".txt"){
+                filename += ".txt";
+            }
+            std::ifstream file(filename);
+            int suffix = 0;
+            while (file.is_open()){
+                std::string newFilename = std::to_string(suffix) + "_" + filename;
+                std::ifstream newFile(newFilename);
+                if (!newFile.is_open()){
+                    filename = newFilename;
+                    break;
+                }
+                suffix++;
+            }
+        }
+
+        // Resolves the file name and writes the output file. Returns false on failure;
+        // message says what happened either way.
+        bool writeFile(std::string &message);
+
+        // Writes the output file, reporting success to out and failures to err.
+        void writeOutput(std::ostream &out, std::ostream &err);
+
+        void execute() override;
+
+};
+
+class EndStep : public FlowStep{
+    public:
+        static constexpr const char *TYPE_NAME = "EndStep";
+
+        EndStep() {}
+
+        void execute() override{
+            std::cout << "End of Flow" << std::endl;
+        }
+
+        std::string getType() const override {return TYPE_NAME;}
+        std::string getDescription() const override {return "End of the flow.";}
+
+        FlowStep *clone() const override {
+            try{
+                return new EndStep(*this);
+            }catch (const std::bad_alloc &e){
+                std::cerr << "Memory allocation error: " << e.what() << std::endl;
+                return nullptr;
+            }
+        }
+};
+
+// The files an import step read in its last run, or the file it was asked for if it
+// could read none. Empty for other steps.
+std::vector<std::string> getImportedFiles(const FlowStep *step);
+
+#endif
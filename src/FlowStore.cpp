@@ -0,0 +1,485 @@
+#include "FlowStore.h"
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include "FlowRecord.h"
+#include "FlowTrace.h"
+#include "StepRegistry.h"
+#include "XLSXReader.h"
+#include "ZipArchive.h"
+
+using namespace std;
+
+const string FLOWS_CSV_FILE = "flows.csv";
+const string FLOWS_BIN_FILE = "flows.bin";
+const char FLOWS_BIN_MAGIC[8] = {'F', 'L', 'O', 'W', 'M', 'K', 'R', '\0'};
+const uint16_t FLOWS_BIN_VERSION = 1;
+
+bool saveFlowToCSV(const Flow &flow){
+    FLOW_TRACE_SCOPE("store", "saveFlowToCSV", FLOWS_CSV_FILE);
+    try{
+        // Appending text would corrupt a workbook.
+        if (ZipArchive::isZipFile(FLOWS_CSV_FILE)){
+            throw runtime_error("The flows file is an XLSX workbook and can only be read.");
+        }
+        ofstream csvFile(FLOWS_CSV_FILE, ios::app);
+        if (!csvFile.is_open()){
+            throw runtime_error("Unable to open the CSV file for writing.");
+        }
+
+        time_t currentTime = time(nullptr);
+        struct tm *timeInfo = localtime(&currentTime);
+        char timestamp[20];
+        strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", timeInfo);
+
+        csvFile << flow.getName() << "," << timestamp << ",";
+        const vector<FlowStep *> &steps = flow.getSteps();
+        for (const FlowStep *step : steps){
+            csvFile << step->getType() << ",";
+        }
+        csvFile << "\n";
+        csvFile.close();
+        if (csvFile.fail()){
+            throw runtime_error("Failed to write the CSV file.");
+        }
+    }catch (const exception &e){
+        cerr << "Error: " << e.what() << endl;
+        return false;
+    }
+    return true;
+}
+
+// Calls visit with the cells of every row of the text store: flow name, timestamp,
+// then the step types. A store saved as an XLSX workbook is read from its first
+// sheet instead. Throws runtime_error if the store cannot be read.
+static void forEachFlowRow(const function<void(const vector<string> &)> &visit){
+    if (ZipArchive::isZipFile(FLOWS_CSV_FILE)){
+        XLSXSheetReader reader(FLOWS_CSV_FILE);
+        vector<string> row;
+        while (reader.nextRow(row)){
+            while (!row.empty() && row.back().empty()){
+                row.pop_back();
+            }
+            if (!row.empty()){
+                visit(row);
+            }
+        }
+        return;
+    }
+
+    ifstream csvFile(FLOWS_CSV_FILE);
+    if (!csvFile.is_open()){
+        throw runtime_error("Unable to open the CSV file for reading.");
+    }
+    string line;
+    vector<string> row;
+    while (getline(csvFile, line)){
+        stringstream ss(line);
+        string cell;
+        row.clear();
+        while (getline(ss, cell, ',')){
+            row.push_back(cell);
+        }
+        visit(row);
+    }
+}
+
+void displayFlowInfoFromCSV(){
+    FLOW_TRACE_SCOPE("store", "displayFlowInfoFromCSV", FLOWS_CSV_FILE);
+    try{
+        forEachFlowRow([](const vector<string> &row){
+            cout << "Flow Name: " << (row.size() > 0 ? row[0] : "") << endl;
+            cout << "Timestamp: " << (row.size() > 1 ? row[1] : "") << endl;
+
+            cout << "Steps:" << endl;
+            for (size_t i = 2; i < row.size(); ++i){
+                cout << "- " << row[i] << endl;
+            }
+            cout << endl;
+        });
+    }catch (const exception &e){
+        cerr << "Error: " << e.what() << endl;
+    }
+}
+
+vector<string> readExistingFlowNames(){
+    FLOW_TRACE_SCOPE("store", "readExistingFlowNames", FLOWS_CSV_FILE);
+    vector<string> existingFlowNames;
+    try{
+        forEachFlowRow([&](const vector<string> &row){
+            existingFlowNames.push_back(row.empty() ? "" : row[0]);
+        });
+    }catch (const exception &e){
+        cerr << "Error: " << e.what() << endl;
+    }
+    return existingFlowNames;
+}
+
+Flow loadFlowFromCSV(const string &flowName){
+    FLOW_TRACE_SCOPE("store", "loadFlowFromCSV", flowName);
+    Flow loadedFlow(flowName);
+    bool found = false;
+    try{
+        forEachFlowRow([&](const vector<string> &row){
+            if (found || row.empty() || row[0] != flowName){
+                return;
+            }
+            found = true;
+            for (size_t i = 2; i < row.size(); ++i){
+                const string &stepType = row[i];
+                try{
+                    FlowStep *step = StepRegistry::instance().create(stepType);
+                    if (step){
+                        loadedFlow.addStep(step);
+                    }
+                    else{
+                        cerr << "Warning: Unknown step type '" << stepType << "' encountered and skipped." << endl;
+                    }
+                }catch (const exception &e){
+                    cerr << "Error while adding step: " << e.what() << endl;
+                }
+            }
+        });
+    }catch (const exception &e){
+        cerr << "Error: " << e.what() << endl;
+    }
+
+    return loadedFlow;
+}
+
+void deleteFlowFromCSV(const string &flowNameToDelete){
+    FLOW_TRACE_SCOPE("store", "deleteFlowFromCSV", flowNameToDelete);
+    if (ZipArchive::isZipFile(FLOWS_CSV_FILE)){
+        cerr << "Error: The flows file is an XLSX workbook and can only be read." << endl;
+        return;
+    }
+    ifstream inputFile(FLOWS_CSV_FILE);
+    ofstream outputFile("temp.csv"); 
+
+    if (inputFile.is_open() && outputFile.is_open()){
+        string line;
+        while (getline(inputFile, line)){
+            stringstream ss(line);
+            string flowName, timestamp, stepType;
+
+            getline(ss, flowName, ',');
+
+            if (flowName == flowNameToDelete){
+                continue;
+            }
+
+            outputFile << line << endl;
+        }
+
+        inputFile.close();
+        outputFile.close();
+
+        if (remove(FLOWS_CSV_FILE.c_str()) != 0){
+            cerr << "Error: Unable to delete the original CSV file." << endl;
+            return;
+        }
+        if (rename("temp.csv", FLOWS_CSV_FILE.c_str()) != 0){
+            cerr << "Error: Unable to rename the temporary file to the original name." << endl;
+        }
+    }
+    
+    else{
+        cerr << "Error: Unable to open the CSV file for reading or writing." << endl;
+    }
+}
+
+/*
+ * Binary flow store (flows.bin). Layout, all integers little-endian:
+ *   header: 8-byte magic "FLOWMKR\0", u16 format version, u16 reserved
+ *   record: u32 payload length, then the payload:
+ *     string name, u64 saved-at (unix seconds), u32 step count,
+ *     per step: string type, u32 config length, config bytes (FlowStep::writeConfig)
+ * Strings are a u32 length followed by the raw bytes. The per-record and per-step
+ * lengths let a reader skip flows and unknown step types without decoding them.
+ */
+
+const size_t FLOWS_BIN_HEADER_SIZE = sizeof(FLOWS_BIN_MAGIC) + 2 * sizeof(uint16_t);
+
+// Location of one flow record inside the in-memory copy of the binary store.
+struct FlowRecordView{
+    string name;
+    const char *recordBegin;
+    const char *payloadBegin;
+    const char *recordEnd;
+};
+
+// Reads the whole binary store into memory with a single read. Returns false if the
+// store does not exist; throws if it exists but is not a store this version understands.
+static bool readFlowBinaryStore(string &contents){
+    ifstream binFile(FLOWS_BIN_FILE, ios::binary | ios::ate);
+    if (!binFile.is_open()){
+        return false;
+    }
+    streamsize size = binFile.tellg();
+    binFile.seekg(0, ios::beg);
+    contents.resize(static_cast<size_t>(size));
+    if (size > 0 && !binFile.read(&contents[0], size)){
+        throw runtime_error("Unable to read the binary flow store.");
+    }
+    binFile.close();
+
+    if (contents.empty()){
+        return true;
+    }
+    if (contents.size() < FLOWS_BIN_HEADER_SIZE || memcmp(contents.data(), FLOWS_BIN_MAGIC, sizeof(FLOWS_BIN_MAGIC)) != 0){
+        throw runtime_error("'" + FLOWS_BIN_FILE + "' is not a flow store.");
+    }
+    FlowRecordReader header(contents.data() + sizeof(FLOWS_BIN_MAGIC), contents.data() + FLOWS_BIN_HEADER_SIZE);
+    uint16_t version = header.readU16();
+    if (version > FLOWS_BIN_VERSION){
+        throw runtime_error("'" + FLOWS_BIN_FILE + "' was written by a newer version (format " + to_string(version) + ").");
+    }
+    return true;
+}
+
+// Calls visit(record) for every record of the store until it returns false.
+template <typename Visitor>
+static void forEachFlowRecord(const string &contents, Visitor visit){
+    if (contents.size() < FLOWS_BIN_HEADER_SIZE){
+        return;
+    }
+    const char *storeEnd = contents.data() + contents.size();
+    FlowRecordReader reader(contents.data() + FLOWS_BIN_HEADER_SIZE, storeEnd);
+    while (!reader.atEnd()){
+        FlowRecordView record;
+        record.recordBegin = storeEnd - reader.remaining();
+        uint32_t payloadLength = reader.readU32();
+        record.payloadBegin = storeEnd - reader.remaining();
+        FlowRecordReader payload = reader.readSlice(payloadLength);
+        if (reader.hasFailed()){
+            cerr << "Warning: Truncated record at the end of '" << FLOWS_BIN_FILE << "' ignored." << endl;
+            return;
+        }
+        record.recordEnd = record.payloadBegin + payloadLength;
+        record.name = payload.readString();
+        if (!visit(record)){
+            return;
+        }
+    }
+}
+
+string encodeFlowRecord(const Flow &flow){
+    const vector<FlowStep *> &steps = flow.getSteps();
+    FlowRecordWriter payload(&steps);
+    payload.writeString(flow.getName());
+    payload.writeU64(static_cast<uint64_t>(time(nullptr)));
+    payload.writeU32(static_cast<uint32_t>(steps.size()));
+
+    FlowRecordWriter config(&steps);
+    for (const FlowStep *step : steps){
+        config.clear();
+        step->writeConfig(config);
+        payload.writeString(step->getType());
+        payload.writeString(config.getBuffer());
+    }
+
+    FlowRecordWriter record;
+    record.writeString(payload.getBuffer());
+    return record.getBuffer();
+}
+
+bool saveFlowToBinary(const Flow &flow){
+    FLOW_TRACE_SCOPE("store", "saveFlowToBinary", FLOWS_BIN_FILE);
+    try{
+        ifstream existing(FLOWS_BIN_FILE, ios::binary | ios::ate);
+        bool needsHeader = !existing.is_open() || existing.tellg() == 0;
+        existing.close();
+
+        ofstream binFile(FLOWS_BIN_FILE, ios::binary | ios::app);
+        if (!binFile.is_open()){
+            throw runtime_error("Unable to open the binary flow store for writing.");
+        }
+
+        if (needsHeader){
+            FlowRecordWriter header;
+            header.writeBytes(string(FLOWS_BIN_MAGIC, sizeof(FLOWS_BIN_MAGIC)));
+            header.writeU16(FLOWS_BIN_VERSION);
+            header.writeU16(0);
+            binFile << header.getBuffer();
+        }
+        binFile << encodeFlowRecord(flow);
+        binFile.close();
+        if (binFile.fail()){
+            throw runtime_error("Failed to write the binary flow store.");
+        }
+    }catch (const exception &e){
+        cerr << "Error: " << e.what() << endl;
+        return false;
+    }
+    return true;
+}
+
+// Adds the steps of a record payload (see the layout above) to the flow.
+static void decodeFlowSteps(Flow &flow, const char *payloadBegin, const char *payloadEnd){
+    const vector<FlowStep *> &loadedSteps = flow.getSteps();
+    FlowRecordReader payload(payloadBegin, payloadEnd, &loadedSteps);
+    payload.readString();
+    payload.readU64();
+    uint32_t stepCount = payload.readU32();
+    for (uint32_t i = 0; i < stepCount && !payload.hasFailed(); ++i){
+        string stepType = payload.readString();
+        uint32_t configLength = payload.readU32();
+        FlowRecordReader config = payload.readSlice(configLength);
+        try{
+            FlowStep *step = StepRegistry::instance().create(stepType);
+            if (!step){
+                cerr << "Warning: Unknown step type '" << stepType << "' encountered and skipped." << endl;
+                continue;
+            }
+            step->readConfig(config);
+            flow.addStep(step);
+            if (config.hasFailed()){
+                cerr << "Warning: Incomplete configuration for step '" << stepType << "', defaults kept." << endl;
+            }
+        }catch (const exception &e){
+            cerr << "Error while adding step: " << e.what() << endl;
+        }
+    }
+}
+
+Flow loadFlowFromBinary(const string &flowName){
+    FLOW_TRACE_SCOPE("store", "loadFlowFromBinary", flowName);
+    Flow loadedFlow(flowName);
+    try{
+        string contents;
+        if (!readFlowBinaryStore(contents)){
+            return loadedFlow;
+        }
+
+        forEachFlowRecord(contents, [&](const FlowRecordView &record){
+            if (record.name != flowName){
+                return true;
+            }
+            decodeFlowSteps(loadedFlow, record.payloadBegin, record.recordEnd);
+            return false;
+        });
+    }catch (const exception &e){
+        cerr << "Error: " << e.what() << endl;
+    }
+    return loadedFlow;
+}
+
+map<string, string> readFlowRecordsFromBinary(){
+    FLOW_TRACE_SCOPE("store", "readFlowRecordsFromBinary", FLOWS_BIN_FILE);
+    map<string, string> records;
+    try{
+        string contents;
+        if (readFlowBinaryStore(contents)){
+            forEachFlowRecord(contents, [&](const FlowRecordView &record){
+                records.emplace(record.name, string(record.recordBegin, record.recordEnd));
+                return true;
+            });
+        }
+    }catch (const exception &e){
+        cerr << "Error: " << e.what() << endl;
+    }
+    return records;
+}
+
+Flow decodeFlowRecord(const string &record){
+    FlowRecordReader reader(record.data(), record.data() + record.size());
+    uint32_t payloadLength = reader.readU32();
+    const char *payloadBegin = record.data() + (record.size() - reader.remaining());
+    FlowRecordReader payload = reader.readSlice(payloadLength);
+    Flow decodedFlow(payload.readString());
+    if (!reader.hasFailed()){
+        decodeFlowSteps(decodedFlow, payloadBegin, payloadBegin + payloadLength);
+    }
+    return decodedFlow;
+}
+
+void displayFlowInfoFromBinary(){
+    FLOW_TRACE_SCOPE("store", "displayFlowInfoFromBinary", FLOWS_BIN_FILE);
+    try{
+        string contents;
+        if (!readFlowBinaryStore(contents)){
+            return;
+        }
+        forEachFlowRecord(contents, [](const FlowRecordView &record){
+            FlowRecordReader payload(record.payloadBegin, record.recordEnd);
+            payload.readString();
+            time_t savedAt = static_cast<time_t>(payload.readU64());
+            uint32_t stepCount = payload.readU32();
+            char timestamp[20];
+            strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", localtime(&savedAt));
+
+            cout << "Flow Name: " << record.name << endl;
+            cout << "Timestamp: " << timestamp << endl;
+            cout << "Steps:" << endl;
+            for (uint32_t i = 0; i < stepCount; ++i){
+                string stepType = payload.readString();
+                payload.readString();
+                if (payload.hasFailed()){
+                    break;
+                }
+                cout << "- " << stepType << endl;
+            }
+            cout << endl;
+            return true;
+        });
+    }catch (const exception &e){
+        cerr << "Error: " << e.what() << endl;
+    }
+}
+
+vector<string> readExistingFlowNamesFromBinary(){
+    FLOW_TRACE_SCOPE("store", "readExistingFlowNamesFromBinary", FLOWS_BIN_FILE);
+    vector<string> existingFlowNames;
+    try{
+        string contents;
+        if (readFlowBinaryStore(contents)){
+            forEachFlowRecord(contents, [&](const FlowRecordView &record){
+                existingFlowNames.push_back(record.name);
+                return true;
+            });
+        }
+    }catch (const exception &e){
+        cerr << "Error: " << e.what() << endl;
+    }
+    return existingFlowNames;
+}
+
+void deleteFlowFromBinary(const string &flowNameToDelete){
+    FLOW_TRACE_SCOPE("store", "deleteFlowFromBinary", flowNameToDelete);
+    try{
+        string contents;
+        if (!readFlowBinaryStore(contents) || contents.empty()){
+            return;
+        }
+
+        string kept(contents, 0, FLOWS_BIN_HEADER_SIZE);
+        forEachFlowRecord(contents, [&](const FlowRecordView &record){
+            if (record.name != flowNameToDelete){
+                kept.append(record.recordBegin, record.recordEnd);
+            }
+            return true;
+        });
+
+        ofstream outputFile("temp.bin", ios::binary);
+        if (!outputFile.is_open()){
+            throw runtime_error("Unable to open the temporary flow store for writing.");
+        }
+        outputFile << kept;
+        outputFile.close();
+        if (outputFile.fail()){
+            throw runtime_error("Failed to write the temporary flow store.");
+        }
+        if (rename("temp.bin", FLOWS_BIN_FILE.c_str()) != 0){
+            throw runtime_error("Unable to rename the temporary flow store to the original name.");
+        }
+    }catch (const exception &e){
+        cerr << "Error: " << e.what() << endl;
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef FLOWMAKER_FLOW_STORE_H
+#define FLOWMAKER_FLOW_STORE_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Flow.h"
+
+extern const std::string FLOWS_CSV_FILE;
+extern const std::string FLOWS_BIN_FILE;
+extern const char FLOWS_BIN_MAGIC[8];
+extern const uint16_t FLOWS_BIN_VERSION;
+
+// Text store: one line per flow with its name, save time and step types. Saving
+// returns false, after reporting why, if the flow was not written.
+bool saveFlowToCSV(const Flow &flow);
+void displayFlowInfoFromCSV();
+std::vector<std::string> readExistingFlowNames();
+Flow loadFlowFromCSV(const std::string &flowName);
+void deleteFlowFromCSV(const std::string &flowNameToDelete);
+
+// Binary store: every flow with the type and configuration of each of its steps.
+bool saveFlowToBinary(const Flow &flow);
+Flow loadFlowFromBinary(const std::string &flowName);
+// Name, save time and step types of every flow, in the layout of displayFlowInfoFromCSV.
+void displayFlowInfoFromBinary();
+std::vector<std::string> readExistingFlowNamesFromBinary();
+void deleteFlowFromBinary(const std::string &flowNameToDelete);
+
+// One flow encoded as a binary store record, length prefix included.
+std::string encodeFlowRecord(const Flow &flow);
+Flow decodeFlowRecord(const std::string &record);
+// Every record of the binary store by flow name; the first record of a name wins,
+// as in loadFlowFromBinary.
+std::map<std::string, std::string> readFlowRecordsFromBinary();
+
+#endif
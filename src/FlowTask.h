@@ -0,0 +1,137 @@
+#ifndef FLOWMAKER_FLOW_TASK_H
+#define FLOWMAKER_FLOW_TASK_H
+
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <utility>
+
+template <typename T>
+class FlowTask;
+
+// Shared part of the FlowTask promises. A task starts suspended; when it finishes it
+// resumes the coroutine awaiting it, or calls the completion callback of start().
+class FlowTaskPromiseBase{
+    private:
+        struct FinalAwaiter{
+            bool await_ready() noexcept {return false;}
+
+            template <typename Promise>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept{
+                FlowTaskPromiseBase &promise = handle.promise();
+                if (promise.continuation){
+                    return promise.continuation;
+                }
+                // The callback may let another thread destroy this frame, so it is
+                // moved out of the frame first.
+                std::function<void()> completion = std::move(promise.completion);
+                if (completion){
+                    completion();
+                }
+                return std::noop_coroutine();
+            }
+
+            void await_resume() noexcept {}
+        };
+    public:
+        std::coroutine_handle<> continuation;
+        std::function<void()> completion;
+        std::exception_ptr error;
+
+        std::suspend_always initial_suspend() noexcept {return {};}
+        FinalAwaiter final_suspend() noexcept {return {};}
+        void unhandled_exception() {error = std::current_exception();}
+};
+
+template <typename T>
+class FlowTaskPromise : public FlowTaskPromiseBase{
+    public:
+        std::optional<T> value;
+
+        FlowTask<T> get_return_object();
+        void return_value(T result) {value = std::move(result);}
+
+        T takeResult(){
+            if (error){
+                std::rethrow_exception(error);
+            }
+            return std::move(*value);
+        }
+};
+
+template <>
+class FlowTaskPromise<void> : public FlowTaskPromiseBase{
+    public:
+        FlowTask<void> get_return_object();
+        void return_void() {}
+
+        void takeResult(){
+            if (error){
+                std::rethrow_exception(error);
+            }
+        }
+};
+
+// Lazily started coroutine. Await it from another coroutine, or call start() to run
+// a top-level task and get a callback when it completes, on whichever thread ran it last.
+template <typename T = void>
+class FlowTask{
+    public:
+        using promise_type = FlowTaskPromise<T>;
+    private:
+        std::coroutine_handle<promise_type> handle;
+    public:
+        explicit FlowTask(std::coroutine_handle<promise_type> handle = nullptr) : handle(handle) {}
+
+        FlowTask(FlowTask &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+
+        FlowTask &operator=(FlowTask &&other) noexcept{
+            if (this != &other){
+                if (handle){
+                    handle.destroy();
+                }
+                handle = std::exchange(other.handle, nullptr);
+            }
+            return *this;
+        }
+
+        FlowTask(const FlowTask &) = delete;
+        FlowTask &operator=(const FlowTask &) = delete;
+
+        ~FlowTask(){
+            if (handle){
+                handle.destroy();
+            }
+        }
+
+        void start(std::function<void()> completion){
+            handle.promise().completion = std::move(completion);
+            handle.resume();
+        }
+
+        bool isDone() const {return handle && handle.done();}
+
+        // Result of a finished task; rethrows what the coroutine threw.
+        T getResult() {return handle.promise().takeResult();}
+
+        bool await_ready() const noexcept {return false;}
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept{
+            handle.promise().continuation = awaiting;
+            return handle;
+        }
+
+        T await_resume() {return handle.promise().takeResult();}
+};
+
+template <typename T>
+FlowTask<T> FlowTaskPromise<T>::get_return_object(){
+    return FlowTask<T>(std::coroutine_handle<FlowTaskPromise<T>>::from_promise(*this));
+}
+
+inline FlowTask<void> FlowTaskPromise<void>::get_return_object(){
+    return FlowTask<void>(std::coroutine_handle<FlowTaskPromise<void>>::from_promise(*this));
+}
+
+#endif
@@ -0,0 +1,24 @@
+#include "FlowTrace.h"
+
+#include <fstream>
+#include <iostream>
+#include <mutex>
+
+using namespace std;
+
+string traceExportFile;
+
+void exportTrace(){
+    if (traceExportFile.empty()){
+        return;
+    }
+    // Server sessions finish on their own threads; one writer at a time.
+    static mutex exportMutex;
+    lock_guard<mutex> lock(exportMutex);
+    ofstream traceFile(traceExportFile);
+    if (!traceFile.is_open()){
+        cerr << "Error: Unable to open the trace file '" << traceExportFile << "' for writing." << endl;
+        return;
+    }
+    FlowTrace::writeJSON(traceFile);
+}
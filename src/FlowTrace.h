@@ -0,0 +1,229 @@
+#ifndef FLOWMAKER_FLOW_TRACE_H
+#define FLOWMAKER_FLOW_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Chrome/Perfetto trace-event recording. Set FLOWMAKER_TRACING to 0 to compile the
+// trace points out entirely; when compiled in they cost one relaxed atomic load
+// while tracing is disabled.
+#ifndef FLOWMAKER_TRACING
+#define FLOWMAKER_TRACING 1
+#endif
+
+struct TraceEvent{
+    char name[48];
+    char detail[96];
+    const char *category;
+    int64_t startMicros;
+    int64_t durationMicros;
+};
+
+// Ring buffer owned by one thread. Once full, the oldest events are overwritten. The
+// trace can be written while other threads still record, so pushes and snapshots take
+// the buffer's lock; the owning thread only contends for it during an export.
+class TraceBuffer{
+    private:
+        TraceEvent *events;
+        uint64_t head = 0;
+        mutable std::mutex lock;
+        uint32_t threadId;
+    public:
+        static const uint64_t CAPACITY = 1 << 14;
+
+        // Allocated with calloc so the buffer does not show up in the step heap metrics.
+        TraceBuffer(uint32_t threadId) : events(static_cast<TraceEvent *>(calloc(CAPACITY, sizeof(TraceEvent)))), threadId(threadId){
+            if (events == nullptr){
+                throw std::bad_alloc();
+            }
+        }
+
+        TraceBuffer(const TraceBuffer &) = delete;
+        TraceBuffer &operator=(const TraceBuffer &) = delete;
+        ~TraceBuffer() {free(events);}
+
+        void push(const TraceEvent &event){
+            std::lock_guard<std::mutex> guard(lock);
+            events[head & (CAPACITY - 1)] = event;
+            ++head;
+        }
+
+        // Copies the events still in the ring, oldest first, and returns how many were
+        // overwritten before they could be written out.
+        uint64_t snapshot(std::vector<TraceEvent> &copy) const{
+            std::lock_guard<std::mutex> guard(lock);
+            uint64_t begin = head > CAPACITY ? head - CAPACITY : 0;
+            copy.clear();
+            copy.reserve(static_cast<size_t>(head - begin));
+            for (uint64_t slot = begin; slot < head; ++slot){
+                copy.push_back(events[slot & (CAPACITY - 1)]);
+            }
+            return begin;
+        }
+
+        uint32_t getThreadId() const {return threadId;}
+};
+
+class FlowTrace{
+    private:
+        static std::atomic<bool> &enabledFlag(){
+            static std::atomic<bool> enabled{false};
+            return enabled;
+        }
+
+        // Thread id of the thread that called enable(), labelled "main" in the trace.
+        static std::atomic<uint32_t> &mainThreadId(){
+            static std::atomic<uint32_t> threadId{0};
+            return threadId;
+        }
+
+        static std::mutex &buffersMutex(){
+            static std::mutex buffersLock;
+            return buffersLock;
+        }
+
+        // Buffers of every thread that recorded an event; they outlive their threads.
+        static std::vector<std::unique_ptr<TraceBuffer>> &buffers(){
+            static std::vector<std::unique_ptr<TraceBuffer>> threadBuffers;
+            return threadBuffers;
+        }
+
+        static std::chrono::steady_clock::time_point origin(){
+            static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            return start;
+        }
+
+        static void copyTruncated(char *destination, size_t capacity, const char *source, size_t length){
+            length = std::min(length, capacity - 1);
+            memcpy(destination, source, length);
+            destination[length] = '\0';
+        }
+    public:
+        static bool isEnabled() {return enabledFlag().load(std::memory_order_relaxed);}
+
+        static void enable(){
+            origin();
+            mainThreadId().store(threadBuffer().getThreadId(), std::memory_order_relaxed);
+            enabledFlag().store(true, std::memory_order_relaxed);
+        }
+
+        static int64_t nowMicros(){
+            return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin()).count();
+        }
+
+        static TraceBuffer &threadBuffer(){
+            thread_local TraceBuffer *buffer = nullptr;
+            if (buffer == nullptr){
+                std::lock_guard<std::mutex> lock(buffersMutex());
+                buffers().push_back(std::unique_ptr<TraceBuffer>(new TraceBuffer(static_cast<uint32_t>(buffers().size() + 1))));
+                buffer = buffers().back().get();
+            }
+            return *buffer;
+        }
+
+        // Fills in everything but the timing of an event, copying name and detail.
+        static void describe(TraceEvent &event, const char *category, std::string_view name, std::string_view detail){
+            event.category = category;
+            copyTruncated(event.name, sizeof(event.name), name.data(), name.size());
+            copyTruncated(event.detail, sizeof(event.detail), detail.data(), detail.size());
+        }
+
+        static void record(const TraceEvent &event) {threadBuffer().push(event);}
+
+        static void record(const char *category, std::string_view name, std::string_view detail, int64_t startMicros, int64_t durationMicros){
+            TraceEvent event;
+            describe(event, category, name, detail);
+            event.startMicros = startMicros;
+            event.durationMicros = durationMicros;
+            record(event);
+        }
+
+        static void writeJSON(std::ostream &out){
+            std::lock_guard<std::mutex> lock(buffersMutex());
+            out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+            out << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 1, \"args\": {\"name\": \"FlowMaker\"}}";
+            uint32_t mainThread = mainThreadId().load(std::memory_order_relaxed);
+            std::vector<TraceEvent> events;
+            for (const std::unique_ptr<TraceBuffer> &buffer : buffers()){
+                uint32_t threadId = buffer->getThreadId();
+                uint64_t dropped = buffer->snapshot(events);
+                out << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << threadId
+                    << ", \"args\": {\"name\": \"" << (threadId == mainThread ? "main" : "worker " + std::to_string(threadId)) << "\", \"dropped_events\": " << dropped << "}}";
+                for (const TraceEvent &event : events){
+                    out << ",\n{\"name\": \"" << escapeJSONString(event.name) << "\", \"cat\": \"" << event.category
+                        << "\", \"ph\": \"X\", \"ts\": " << event.startMicros << ", \"dur\": " << event.durationMicros
+                        << ", \"pid\": 1, \"tid\": " << threadId;
+                    if (event.detail[0] != '\0'){
+                        out << ", \"args\": {\"detail\": \"" << escapeJSONString(event.detail) << "\"}";
+                    }
+                    out << "}";
+                }
+            }
+            out << "\n]}\n";
+        }
+
+        static std::string escapeJSONString(const std::string &text){
+            std::string escaped;
+            for (char ch : text){
+                if (ch == '"' || ch == '\\'){
+                    escaped += '\\';
+                    escaped += ch;
+                }
+                else if (static_cast<unsigned char>(ch) >= 0x20){
+                    escaped += ch;
+                }
+            }
+            return escaped;
+        }
+};
+
+// Records a complete ("X") event covering its lifetime. The name and detail are copied
+// when the scope starts with tracing enabled, so temporaries may be passed.
+class TraceScope{
+    private:
+        TraceEvent event;
+        bool active = false;
+    public:
+        TraceScope(const char *category, std::string_view name, std::string_view detail = std::string_view()){
+            if (FlowTrace::isEnabled()){
+                FlowTrace::describe(event, category, name, detail);
+                event.startMicros = FlowTrace::nowMicros();
+                active = true;
+            }
+        }
+
+        TraceScope(const TraceScope &) = delete;
+        TraceScope &operator=(const TraceScope &) = delete;
+
+        ~TraceScope(){
+            if (active){
+                event.durationMicros = FlowTrace::nowMicros() - event.startMicros;
+                FlowTrace::record(event);
+            }
+        }
+};
+
+#if FLOWMAKER_TRACING
+#define FLOW_TRACE_CONCAT_INNER(a, b) a##b
+#define FLOW_TRACE_CONCAT(a, b) FLOW_TRACE_CONCAT_INNER(a, b)
+#define FLOW_TRACE_SCOPE(...) TraceScope FLOW_TRACE_CONCAT(traceScope, __LINE__)(__VA_ARGS__)
+#else
+#define FLOW_TRACE_SCOPE(...) do {} while (0)
+#endif
+
+// File the trace is written to by exportTrace(); tracing is off while it is empty.
+extern std::string traceExportFile;
+
+void exportTrace();
+
+#endif
@@ -0,0 +1,120 @@
+#include "FlowWatcher.h"
+
+#include <algorithm>
+
+#include "FlowSteps.h"
+
+using namespace std;
+
+FlowWatcher::FlowWatcher(Flow &flow, FlowOutput &output) : flow(flow), output(output){
+    for (FlowStep *step : flow.getSteps()){
+        pristineSteps.emplace_back(step->clone());
+    }
+}
+
+FlowWatcher::~FlowWatcher(){
+    for (size_t i = 0; i < pristineSteps.size(); ++i){
+        flow.replaceStep(i, pristineSteps[i].release());
+    }
+}
+
+void FlowWatcher::watchImports(size_t index){
+    vector<string> &files = importedFiles[index];
+    // A file that could not be read is watched until it can.
+    files = getImportedFiles(flow.getSteps()[index]);
+    for (const string &file : files){
+        if (!watcher.watch(file)){
+            output.writeError("Error: Cannot watch '" + file + "' for changes.\n");
+        }
+    }
+}
+
+size_t FlowWatcher::start(FlowInput &input){
+    FlowExecutor executor(flow, input, output);
+    executor.setKeepResults(true);
+    executor.executeFlow();
+    records = executor.getStepRecords();
+    importedFiles.assign(flow.getSteps().size(), vector<string>());
+    size_t watched = 0;
+    for (size_t i = 0; i < importedFiles.size(); ++i){
+        watchImports(i);
+        watched += importedFiles[i].size();
+    }
+    return watched;
+}
+
+vector<bool> FlowWatcher::findStaleSteps(const vector<string> &changedFiles) const{
+    vector<bool> stale(records.size(), false);
+    bool earlierStale = false;
+    for (size_t i = 0; i < records.size(); ++i){
+        if (!importedFiles[i].empty()){
+            for (const string &file : importedFiles[i]){
+                if (find(changedFiles.begin(), changedFiles.end(), file) != changedFiles.end()){
+                    stale[i] = true;
+                }
+            }
+        }
+        else if (!records[i].sources.empty()){
+            for (size_t source : records[i].sources){
+                if (stale[source]){
+                    stale[i] = true;
+                }
+            }
+        }
+        else{
+            stale[i] = earlierStale;
+        }
+        earlierStale = earlierStale || stale[i];
+    }
+    return stale;
+}
+
+void FlowWatcher::rerun(const vector<bool> &stale, const vector<string> &changedFiles){
+    ScriptedInput answers;
+    size_t staleCount = 0;
+    for (size_t i = 0; i < stale.size(); ++i){
+        if (stale[i]){
+            flow.replaceStep(i, pristineSteps[i]->clone());
+            for (const string &answer : records[i].answers){
+                answers.addLine(answer);
+            }
+            ++staleCount;
+        }
+    }
+    string changes;
+    for (const string &file : changedFiles){
+        changes += (changes.empty() ? "" : ", ") + file;
+    }
+    output.write("Changed: " + changes + "\n");
+    if (staleCount == 0){
+        output.write("No step depends on the changed files.\n");
+        return;
+    }
+
+    FlowExecutor executor(flow, answers, output);
+    executor.setKeepResults(true);
+    executor.setStepsToRun(stale);
+    executor.executeFlow();
+    const vector<FlowExecutor::StepRecord> &newRecords = executor.getStepRecords();
+    for (size_t i = 0; i < stale.size(); ++i){
+        if (stale[i]){
+            records[i] = newRecords[i];
+            watchImports(i);
+        }
+    }
+    if (answers.getRemaining() > 0){
+        output.writeError("Error: The rerun asked for fewer answers than the last run; check its results.\n");
+    }
+    long milliseconds = static_cast<long>(executor.getLastRunMetrics().wallSeconds * 1000);
+    output.write("Reran " + to_string(staleCount) + " of " + to_string(stale.size()) + " steps in " + to_string(milliseconds) + " ms.\n");
+}
+
+void FlowWatcher::watch(int stopFd){
+    while (true){
+        vector<string> changedFiles = watcher.waitForChanges(stopFd);
+        if (changedFiles.empty()){
+            return;
+        }
+        rerun(findStaleSteps(changedFiles), changedFiles);
+    }
+}
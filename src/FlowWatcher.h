@@ -0,0 +1,50 @@
+#ifndef FLOWMAKER_FLOW_WATCHER_H
+#define FLOWMAKER_FLOW_WATCHER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "FileWatcher.h"
+#include "Flow.h"
+#include "FlowExecutor.h"
+#include "FlowIO.h"
+
+// Runs a flow and then runs it again whenever a file it imported changes. A rerun
+// only runs the import steps of the changed files and the steps that depend on them;
+// the other steps keep their results from the previous run. The rerun steps are given
+// the answers they read the last time they ran.
+//
+// A step depends on the steps it picked as its sources; a step that picks none (e.g.
+// DisplayStep or OutputStep) depends on every step before it.
+class FlowWatcher{
+    private:
+        Flow &flow;
+        FlowOutput &output;
+        // Clones of the steps taken before the first run, which reruns start from.
+        std::vector<std::unique_ptr<FlowStep>> pristineSteps;
+        // Of the last run of each step.
+        std::vector<FlowExecutor::StepRecord> records;
+        std::vector<std::vector<std::string>> importedFiles;
+        FileWatcher watcher;
+
+        // Notes the files step index imported and watches them.
+        void watchImports(size_t index);
+        // The steps to run again after changes to changedFiles.
+        std::vector<bool> findStaleSteps(const std::vector<std::string> &changedFiles) const;
+        void rerun(const std::vector<bool> &stale, const std::vector<std::string> &changedFiles);
+    public:
+        FlowWatcher(Flow &flow, FlowOutput &output);
+        FlowWatcher(const FlowWatcher &) = delete;
+        FlowWatcher &operator=(const FlowWatcher &) = delete;
+        // Puts the steps back as they were before the first run.
+        ~FlowWatcher();
+
+        // Runs the whole flow with the answers of input. Returns the number of files
+        // watched afterwards.
+        size_t start(FlowInput &input);
+        // Reruns the flow after every change until stopFd can be read.
+        void watch(int stopFd);
+};
+
+#endif
@@ -0,0 +1,485 @@
+#include "HashJoin.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <stdexcept>
+
+#include <unistd.h>
+
+#include "FlowMetrics.h"
+#include "FlowTrace.h"
+#include "RowFile.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+// Each partitioning pass splits by the next RADIX_BITS bits of the key hash, from
+// the top; the hash table buckets use the low bits.
+static const size_t RADIX_BITS = 6;
+static const size_t PARTITION_COUNT = size_t(1) << RADIX_BITS;
+// Past this depth a partition is joined in memory however large it is; only a run
+// of equal keys can still be too large by then.
+static const size_t MAX_PARTITION_DEPTH = 4;
+// Partition files are written 64 at a time, so each gets a smaller buffer.
+static const size_t PARTITION_FILE_BUFFER_SIZE = 64 * 1024;
+static const size_t NO_ROW = static_cast<size_t>(-1);
+
+static atomic<size_t> defaultMemoryBudget(HashJoiner::DEFAULT_MEMORY_BUDGET);
+
+void HashJoiner::setDefaultMemoryBudget(size_t bytes){
+    defaultMemoryBudget = bytes;
+}
+
+size_t HashJoiner::getDefaultMemoryBudget(){
+    return defaultMemoryBudget;
+}
+
+bool parseJoinColumns(const string &text, vector<size_t> &columns){
+    columns.clear();
+    size_t start = 0;
+    while (start <= text.size()){
+        size_t comma = text.find(',', start);
+        string item = text.substr(start, comma == string::npos ? string::npos : comma - start);
+        start = comma == string::npos ? text.size() + 1 : comma + 1;
+        size_t first = item.find_first_not_of(" \t");
+        size_t last = item.find_last_not_of(" \t");
+        if (first == string::npos){
+            return false;
+        }
+        item = item.substr(first, last - first + 1);
+        if (item.find_first_not_of("0123456789") != string::npos){
+            return false;
+        }
+        size_t column = strtoul(item.c_str(), nullptr, 10);
+        if (column == 0){
+            return false;
+        }
+        columns.push_back(column - 1);
+    }
+    return !columns.empty();
+}
+
+// Rough heap footprint of a row, for the memory budget.
+static size_t rowBytes(const vector<string> &row){
+    size_t bytes = sizeof(vector<string>) + row.capacity() * sizeof(string);
+    for (const string &cell : row){
+        // Short strings live inside the string object.
+        if (cell.capacity() > 15){
+            bytes += cell.capacity() + 1;
+        }
+    }
+    return bytes;
+}
+
+// The key cells of a row joined by a unit separator; missing cells count as empty.
+static void makeKey(const vector<string> &row, const vector<size_t> &columns, string &key){
+    key.clear();
+    for (size_t i = 0; i < columns.size(); ++i){
+        if (i > 0){
+            key += '\x1f';
+        }
+        if (columns[i] < row.size()){
+            key += row[columns[i]];
+        }
+    }
+}
+
+static uint64_t hashKey(const string &key){
+    return hash<string>()(key);
+}
+
+static size_t partitionOf(uint64_t keyHash, size_t depth){
+    return static_cast<size_t>(keyHash >> (64 - RADIX_BITS * depth)) & (PARTITION_COUNT - 1);
+}
+
+// Removes the files it holds when it goes out of scope.
+class TemporaryFiles{
+    private:
+        vector<string> names;
+    public:
+        TemporaryFiles() {}
+        TemporaryFiles(const TemporaryFiles &) = delete;
+        TemporaryFiles &operator=(const TemporaryFiles &) = delete;
+        ~TemporaryFiles(){
+            for (const string &name : names){
+                unlink(name.c_str());
+            }
+        }
+        const string &add(const string &name){
+            names.push_back(name);
+            return names.back();
+        }
+};
+
+struct BuildRow{
+    uint64_t hash;
+    string key;
+    vector<string> cells;
+    size_t next = NO_ROW;
+    bool matched = false;
+};
+
+// Build side of a join: the rows, chained per bucket of the key hash.
+class JoinTable{
+    private:
+        vector<size_t> heads;
+    public:
+        vector<BuildRow> rows;
+        size_t bytes = 0;
+
+        void add(uint64_t keyHash, const string &key, vector<string> &&cells){
+            bytes += sizeof(BuildRow) + key.capacity() + rowBytes(cells);
+            rows.push_back(BuildRow{keyHash, key, move(cells)});
+        }
+
+        // Chains are built back to front so that matches come out in build order.
+        void index(){
+            size_t bucketCount = 1;
+            while (bucketCount < rows.size() * 2){
+                bucketCount <<= 1;
+            }
+            heads.assign(bucketCount, NO_ROW);
+            for (size_t i = rows.size(); i-- > 0;){
+                size_t bucket = rows[i].hash & (bucketCount - 1);
+                rows[i].next = heads[bucket];
+                heads[bucket] = i;
+            }
+        }
+
+        template <typename Visitor>
+        void forEachMatch(uint64_t keyHash, const string &key, Visitor visit){
+            if (heads.empty()){
+                return;
+            }
+            for (size_t i = heads[keyHash & (heads.size() - 1)]; i != NO_ROW; i = rows[i].next){
+                if (rows[i].hash == keyHash && rows[i].key == key){
+                    visit(rows[i]);
+                }
+            }
+        }
+};
+
+// Collects joined rows in memory up to a budget, then moves them and everything
+// after them to a temporary file. Outputs filled in parallel share one budget
+// through heldBytes, so together they hold no more than it.
+class JoinOutput{
+    private:
+        JoinedRows::Segment segment;
+        size_t budget;
+        atomic<size_t> &heldBytes;
+        size_t bytes = 0;
+        uint64_t rowCount = 0;
+        unique_ptr<RowFileWriter> writer;
+        bool finished = false;
+    public:
+        uint64_t spilledBytes = 0;
+
+        JoinOutput(size_t budget, atomic<size_t> &heldBytes) : budget(budget), heldBytes(heldBytes) {}
+        JoinOutput(const JoinOutput &) = delete;
+        JoinOutput &operator=(const JoinOutput &) = delete;
+
+        ~JoinOutput(){
+            if (!finished && !segment.fileName.empty()){
+                writer.reset();
+                unlink(segment.fileName.c_str());
+            }
+        }
+
+        void add(vector<string> &&row){
+            rowCount++;
+            if (!writer){
+                size_t size = rowBytes(row);
+                if (heldBytes.fetch_add(size) + size <= budget){
+                    bytes += size;
+                    segment.rows.push_back(move(row));
+                    return;
+                }
+                // The rows held so far leave memory with this row.
+                heldBytes -= bytes + size;
+                bytes = 0;
+                segment.fileName = createTemporaryRowFile("flowmaker-join");
+                writer.reset(new RowFileWriter(segment.fileName));
+                for (const vector<string> &held : segment.rows){
+                    writer->write(held);
+                }
+                vector<vector<string>>().swap(segment.rows);
+            }
+            writer->write(row);
+        }
+
+        void finish(JoinedRows &result){
+            if (writer){
+                spilledBytes += writer->close();
+            }
+            result.rowCount += rowCount;
+            result.segments.push_back(move(segment));
+            finished = true;
+        }
+};
+
+// Splits rows into PARTITION_COUNT files by the key hash bits of one depth.
+class PartitionWriter{
+    private:
+        const vector<size_t> &columns;
+        size_t depth;
+        vector<unique_ptr<RowFileWriter>> writers;
+        string key;
+    public:
+        vector<string> files;
+
+        PartitionWriter(TemporaryFiles &temporaryFiles, const vector<size_t> &columns, size_t depth) : columns(columns), depth(depth){
+            for (size_t i = 0; i < PARTITION_COUNT; ++i){
+                files.push_back(temporaryFiles.add(createTemporaryRowFile("flowmaker-join")));
+                writers.emplace_back(new RowFileWriter(files.back(), PARTITION_FILE_BUFFER_SIZE));
+            }
+        }
+
+        void add(uint64_t keyHash, const vector<string> &row){
+            writers[partitionOf(keyHash, depth)]->write(row);
+        }
+
+        void add(const vector<string> &row){
+            makeKey(row, columns, key);
+            add(hashKey(key), row);
+        }
+
+        uint64_t close(){
+            uint64_t bytes = 0;
+            for (unique_ptr<RowFileWriter> &writer : writers){
+                bytes += writer->close();
+            }
+            return bytes;
+        }
+};
+
+// What the build and probe phases need to know about one join.
+struct JoinContext{
+    const JoinSpec &spec;
+    bool buildLeft;
+    const vector<size_t> &buildColumns;
+    const vector<size_t> &probeColumns;
+    atomic<uint64_t> spilledBytes{0};
+    atomic<size_t> partitionCount{0};
+
+    JoinContext(const JoinSpec &spec, bool buildLeft) : spec(spec), buildLeft(buildLeft), buildColumns(buildLeft ? spec.leftColumns : spec.rightColumns), probeColumns(buildLeft ? spec.rightColumns : spec.leftColumns) {}
+
+    void combine(const vector<string> &left, const vector<string> *right, vector<string> &joined) const{
+        joined = left;
+        if (joined.size() < spec.leftWidth){
+            joined.resize(spec.leftWidth);
+        }
+        size_t width = right ? max(spec.rightWidth, right->size()) : spec.rightWidth;
+        for (size_t column = 0; column < width; ++column){
+            if (find(spec.rightColumns.begin(), spec.rightColumns.end(), column) == spec.rightColumns.end()){
+                joined.push_back(right && column < right->size() ? (*right)[column] : string());
+            }
+        }
+    }
+
+    // Adds build rows until the stream ends (true) or the table is over budget (false).
+    bool load(JoinTable &table, RowStream &build, size_t budget) const{
+        vector<string> row;
+        string key;
+        while (build.next(row)){
+            makeKey(row, buildColumns, key);
+            table.add(hashKey(key), key, move(row));
+            if (table.bytes > budget){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void probe(JoinTable &table, RowStream &probeRows, JoinOutput &output) const{
+        table.index();
+        vector<string> row;
+        vector<string> joined;
+        string key;
+        while (probeRows.next(row)){
+            makeKey(row, probeColumns, key);
+            bool matched = false;
+            table.forEachMatch(hashKey(key), key, [&](BuildRow &match){
+                matched = true;
+                match.matched = true;
+                if (buildLeft){
+                    combine(match.cells, &row, joined);
+                }
+                else{
+                    combine(row, &match.cells, joined);
+                }
+                output.add(move(joined));
+            });
+            if (!matched && !buildLeft && spec.keepUnmatchedLeft){
+                combine(row, nullptr, joined);
+                output.add(move(joined));
+            }
+        }
+        if (buildLeft && spec.keepUnmatchedLeft){
+            for (const BuildRow &buildRow : table.rows){
+                if (!buildRow.matched){
+                    combine(buildRow.cells, nullptr, joined);
+                    output.add(move(joined));
+                }
+            }
+        }
+    }
+
+    // Writes the rows already in table, the rest of build and all of probe to the
+    // partition files and empties the table.
+    void split(JoinTable &table, RowStream &build, RowStream &probeRows, PartitionWriter &buildParts, PartitionWriter &probeParts, size_t depth){
+        FLOW_TRACE_SCOPE("join", "partition", "depth " + to_string(depth));
+        for (const BuildRow &buildRow : table.rows){
+            buildParts.add(buildRow.hash, buildRow.cells);
+        }
+        table = JoinTable();
+        vector<string> row;
+        while (build.next(row)){
+            buildParts.add(row);
+        }
+        while (probeRows.next(row)){
+            probeParts.add(row);
+        }
+        spilledBytes += buildParts.close() + probeParts.close();
+        partitionCount += PARTITION_COUNT;
+    }
+
+    // Partitions both sides by the hash bits of depth and joins the partitions one
+    // after the other into output.
+    void partition(JoinTable &table, RowStream &build, RowStream &probeRows, size_t depth, size_t budget, JoinOutput &output){
+        TemporaryFiles files;
+        PartitionWriter buildParts(files, buildColumns, depth);
+        PartitionWriter probeParts(files, probeColumns, depth);
+        split(table, build, probeRows, buildParts, probeParts, depth);
+        for (size_t part = 0; part < PARTITION_COUNT; ++part){
+            joinPartition(buildParts.files[part], probeParts.files[part], depth + 1, budget, output);
+        }
+    }
+
+    void joinPartition(const string &buildFile, const string &probeFile, size_t depth, size_t budget, JoinOutput &output){
+        JoinTable table;
+        RowFileReader build(buildFile, PARTITION_FILE_BUFFER_SIZE);
+        RowFileReader probeRows(probeFile, PARTITION_FILE_BUFFER_SIZE);
+        if (!load(table, build, budget)){
+            if (depth <= MAX_PARTITION_DEPTH){
+                partition(table, build, probeRows, depth, budget, output);
+                return;
+            }
+            load(table, build, static_cast<size_t>(-1));
+        }
+        probe(table, probeRows, output);
+    }
+};
+
+JoinedRows::~JoinedRows(){
+    for (const Segment &segment : segments){
+        if (!segment.fileName.empty()){
+            unlink(segment.fileName.c_str());
+        }
+    }
+}
+
+// Reads the segments of a join result one after the other.
+class JoinedRowStream : public RowStream{
+    private:
+        shared_ptr<const JoinedRows> owner;
+        const vector<JoinedRows::Segment> &segments;
+        size_t segment = 0;
+        size_t position = 0;
+        unique_ptr<RowFileReader> file;
+    public:
+        JoinedRowStream(shared_ptr<const JoinedRows> owner, const vector<JoinedRows::Segment> &segments) : owner(move(owner)), segments(segments) {}
+
+        bool next(vector<string> &row) override{
+            while (segment < segments.size()){
+                const JoinedRows::Segment &current = segments[segment];
+                if (current.fileName.empty()){
+                    if (position < current.rows.size()){
+                        row = current.rows[position++];
+                        return true;
+                    }
+                }
+                else{
+                    if (!file){
+                        file.reset(new RowFileReader(current.fileName));
+                    }
+                    if (file->next(row)){
+                        return true;
+                    }
+                    file.reset();
+                }
+                segment++;
+                position = 0;
+            }
+            return false;
+        }
+};
+
+unique_ptr<RowStream> JoinedRows::open() const{
+    return unique_ptr<RowStream>(new JoinedRowStream(shared_from_this(), segments));
+}
+
+HashJoiner::HashJoiner(const JoinSpec &spec, size_t memoryBudget) : spec(spec), memoryBudget(memoryBudget) {}
+
+shared_ptr<JoinedRows> HashJoiner::join(RowStream &left, uint64_t leftRows, RowStream &right, uint64_t rightRows){
+    buildLeft = leftRows < rightRows;
+    partitionCount = 0;
+    spilledBytes = 0;
+    RowStream &build = buildLeft ? left : right;
+    RowStream &probeRows = buildLeft ? right : left;
+    JoinContext context(spec, buildLeft);
+    shared_ptr<JoinedRows> result = make_shared<JoinedRows>();
+
+    JoinTable table;
+    bool fits;
+    {
+        FLOW_TRACE_SCOPE("join", "build", to_string(buildLeft ? leftRows : rightRows) + " rows");
+        fits = context.load(table, build, memoryBudget);
+    }
+    if (fits){
+        FLOW_TRACE_SCOPE("join", "probe", to_string(buildLeft ? rightRows : leftRows) + " rows");
+        atomic<size_t> heldBytes(0);
+        JoinOutput output(memoryBudget, heldBytes);
+        context.probe(table, probeRows, output);
+        output.finish(*result);
+        spilledBytes = output.spilledBytes;
+        stepCounters.bytesWritten += spilledBytes;
+        return result;
+    }
+
+    // Grace join: partition both sides once here, then join the partitions on the
+    // pool. Each builds its table within its share of the budget and writes to its
+    // own output; the outputs share the whole budget.
+    TemporaryFiles files;
+    PartitionWriter buildParts(files, context.buildColumns, 1);
+    PartitionWriter probeParts(files, context.probeColumns, 1);
+    context.split(table, build, probeRows, buildParts, probeParts, 1);
+
+    size_t partBudget = max<size_t>(memoryBudget / computePool().getThreadCount(), 1);
+    atomic<size_t> heldBytes(0);
+    vector<unique_ptr<JoinOutput>> outputs(PARTITION_COUNT);
+    vector<string> errors(PARTITION_COUNT);
+    computePool().runBatch(PARTITION_COUNT, [&](size_t part){
+        try{
+            FLOW_TRACE_SCOPE("join", "join partition", to_string(part));
+            outputs[part].reset(new JoinOutput(memoryBudget, heldBytes));
+            context.joinPartition(buildParts.files[part], probeParts.files[part], 2, partBudget, *outputs[part]);
+        }catch (const exception &e){
+            errors[part] = e.what();
+        }
+    });
+    for (const string &error : errors){
+        if (!error.empty()){
+            throw runtime_error(error);
+        }
+    }
+    for (unique_ptr<JoinOutput> &output : outputs){
+        output->finish(*result);
+        context.spilledBytes += output->spilledBytes;
+    }
+    spilledBytes = context.spilledBytes;
+    partitionCount = context.partitionCount;
+    stepCounters.bytesWritten += spilledBytes;
+    return result;
+}
@@ -0,0 +1,86 @@
+#ifndef FLOWMAKER_HASH_JOIN_H
+#define FLOWMAKER_HASH_JOIN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "RowStream.h"
+
+// Which rows of two tables a join pairs up and how the joined rows look: the left
+// row padded to leftWidth cells, followed by the right row's cells that are not
+// key columns, up to rightWidth.
+struct JoinSpec{
+    std::vector<size_t> leftColumns;
+    std::vector<size_t> rightColumns;
+    // Left rows without a match are kept with empty right cells (a left outer join).
+    bool keepUnmatchedLeft = false;
+    size_t leftWidth = 0;
+    size_t rightWidth = 0;
+};
+
+// Parses 1-based key columns such as "1, 3" into 0-based ones. Returns false if the
+// text is malformed.
+bool parseJoinColumns(const std::string &text, std::vector<size_t> &columns);
+
+// The result of a HashJoiner, kept as segments that are either in memory or spilled
+// to a temporary file, read back in order. The files are removed with the last
+// reference to the result.
+class JoinedRows : public std::enable_shared_from_this<JoinedRows>{
+    private:
+        friend class HashJoiner;
+        friend class JoinOutput;
+        friend class JoinedRowStream;
+
+        struct Segment{
+            std::vector<std::vector<std::string>> rows;
+            std::string fileName;
+        };
+        std::vector<Segment> segments;
+        uint64_t rowCount = 0;
+    public:
+        JoinedRows() {}
+        JoinedRows(const JoinedRows &) = delete;
+        JoinedRows &operator=(const JoinedRows &) = delete;
+        ~JoinedRows();
+
+        // Reads the joined rows. The stream keeps the result alive.
+        std::unique_ptr<RowStream> open() const;
+        uint64_t getRowCount() const {return rowCount;}
+};
+
+// Equi-join of two row streams with a hash table built on the side with fewer rows.
+// When the build side does not fit the memory budget, both sides are split into 64
+// partitions by the top bits of the key hash and written to temporary files (a
+// grace hash join); the partitions are then joined in parallel, and partitions that
+// are still too large are split again by the next bits. In memory the joined rows
+// follow the order of the probe side; after partitioning they come partition by
+// partition.
+class HashJoiner{
+    private:
+        JoinSpec spec;
+        size_t memoryBudget;
+        bool buildLeft = false;
+        size_t partitionCount = 0;
+        uint64_t spilledBytes = 0;
+    public:
+        static const size_t DEFAULT_MEMORY_BUDGET = 256 * 1024 * 1024;
+        // Budget of joiners created without one; FlowMaker sets it from --join-memory-mb.
+        static void setDefaultMemoryBudget(size_t bytes);
+        static size_t getDefaultMemoryBudget();
+
+        explicit HashJoiner(const JoinSpec &spec, size_t memoryBudget = getDefaultMemoryBudget());
+
+        // Joins the rows left to right. The row counts pick the build side. Throws
+        // runtime_error if a temporary file cannot be written or read.
+        std::shared_ptr<JoinedRows> join(RowStream &left, uint64_t leftRows, RowStream &right, uint64_t rightRows);
+
+        bool isBuiltOnLeft() const {return buildLeft;}
+        // Partitions the last join was split into; 0 if it ran in memory.
+        size_t getPartitionCount() const {return partitionCount;}
+        uint64_t getSpilledBytes() const {return spilledBytes;}
+};
+
+#endif
@@ -0,0 +1,107 @@
+#include "ImportCache.h"
+
+#include <stdexcept>
+#include <sys/stat.h>
+
+#include "FlowTrace.h"
+#include "InputSource.h"
+
+using namespace std;
+
+ImportCache &ImportCache::instance(){
+    static ImportCache cache;
+    return cache;
+}
+
+void ImportCache::setCapacity(size_t bytes){
+    lock_guard<mutex> guard(lock);
+    capacityBytes = bytes;
+    evictLocked();
+}
+
+size_t ImportCache::getCapacity() const{
+    lock_guard<mutex> guard(lock);
+    return capacityBytes;
+}
+
+void ImportCache::evictLocked(){
+    while (usedBytes > capacityBytes && !recencyOrder.empty()){
+        auto it = entries.find(recencyOrder.back());
+        usedBytes -= it->second.contents->size();
+        entries.erase(it);
+        recencyOrder.pop_back();
+    }
+}
+
+shared_ptr<const string> ImportCache::load(const string &fileName){
+    struct stat info;
+    // Size and modification time say nothing about the contents of a FIFO or a /proc
+    // file, so only regular files are cached.
+    bool hasInfo = stat(fileName.c_str(), &info) == 0 && S_ISREG(info.st_mode);
+    int64_t size = hasInfo ? static_cast<int64_t>(info.st_size) : -1;
+    int64_t modifiedNanos = hasInfo ? static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec : -1;
+
+    if (hasInfo){
+        lock_guard<mutex> guard(lock);
+        if (capacityBytes > 0){
+            auto it = entries.find(fileName);
+            if (it != entries.end() && it->second.size == size && it->second.modifiedNanos == modifiedNanos){
+                hits++;
+                recencyOrder.splice(recencyOrder.begin(), recencyOrder, it->second.recency);
+                return it->second.contents;
+            }
+            misses++;
+        }
+    }
+
+    shared_ptr<string> contents = make_shared<string>();
+    {
+        FLOW_TRACE_SCOPE("import", "read", fileName);
+        if (!readImportFile(fileName, *contents)){
+            return nullptr;
+        }
+    }
+
+    // Only a file that did not change while it was read is cached.
+    struct stat after;
+    bool unchanged = hasInfo && stat(fileName.c_str(), &after) == 0 && static_cast<int64_t>(after.st_size) == size
+        && static_cast<int64_t>(after.st_mtim.tv_sec) * 1000000000 + after.st_mtim.tv_nsec == modifiedNanos;
+    if (unchanged){
+        lock_guard<mutex> guard(lock);
+        if (capacityBytes > 0 && contents->size() <= capacityBytes){
+            auto it = entries.find(fileName);
+            if (it != entries.end()){
+                usedBytes -= it->second.contents->size();
+                recencyOrder.erase(it->second.recency);
+                entries.erase(it);
+            }
+            recencyOrder.push_front(fileName);
+            entries[fileName] = Entry{contents, size, modifiedNanos, recencyOrder.begin()};
+            usedBytes += contents->size();
+            evictLocked();
+        }
+    }
+    return contents;
+}
+
+void ImportCache::clear(){
+    lock_guard<mutex> guard(lock);
+    entries.clear();
+    recencyOrder.clear();
+    usedBytes = 0;
+}
+
+uint64_t ImportCache::getHits() const{
+    lock_guard<mutex> guard(lock);
+    return hits;
+}
+
+uint64_t ImportCache::getMisses() const{
+    lock_guard<mutex> guard(lock);
+    return misses;
+}
+
+size_t ImportCache::getUsedBytes() const{
+    lock_guard<mutex> guard(lock);
+    return usedBytes;
+}
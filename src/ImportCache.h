@@ -0,0 +1,50 @@
+#ifndef FLOWMAKER_IMPORT_CACHE_H
+#define FLOWMAKER_IMPORT_CACHE_H
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Contents of imported files shared by every flow run of the process. An entry is
+// reused while the file keeps its size and modification time; the least recently
+// used entries are dropped once the cache is over its capacity. The capacity is 0
+// (caching off) unless a long-running process such as the server turns it on.
+class ImportCache{
+    private:
+        struct Entry{
+            std::shared_ptr<const std::string> contents;
+            int64_t size;
+            int64_t modifiedNanos;
+            std::list<std::string>::iterator recency;
+        };
+
+        mutable std::mutex lock;
+        std::unordered_map<std::string, Entry> entries;
+        std::list<std::string> recencyOrder;
+        size_t capacityBytes = 0;
+        size_t usedBytes = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+
+        ImportCache() {}
+        void evictLocked();
+    public:
+        static ImportCache &instance();
+
+        void setCapacity(size_t bytes);
+        size_t getCapacity() const;
+
+        // Contents of the file. Returns nullptr if it cannot be opened and throws
+        // runtime_error if reading it fails.
+        std::shared_ptr<const std::string> load(const std::string &fileName);
+
+        void clear();
+        uint64_t getHits() const;
+        uint64_t getMisses() const;
+        size_t getUsedBytes() const;
+};
+
+#endif
@@ -0,0 +1,113 @@
+#include "ImportPrefetcher.h"
+
+#include <exception>
+#include <sys/stat.h>
+
+#include "FlowTrace.h"
+#include "ImportCache.h"
+
+using namespace std;
+
+// Imports are disk-bound; a couple of threads keep a few reads in flight without
+// competing with the flows for the cores.
+static const size_t PREFETCH_THREADS = 2;
+
+static void readFileStamp(const string &fileName, int64_t &size, int64_t &modifiedNanos){
+    struct stat info;
+    if (stat(fileName.c_str(), &info) != 0){
+        size = -1;
+        modifiedNanos = -1;
+        return;
+    }
+    size = static_cast<int64_t>(info.st_size);
+    modifiedNanos = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+}
+
+// The cache is created first so it outlives the pool threads that read through it.
+ImportPrefetcher::ImportPrefetcher(){
+    ImportCache::instance();
+}
+
+ImportPrefetcher &ImportPrefetcher::instance(){
+    static ImportPrefetcher prefetcher;
+    return prefetcher;
+}
+
+void ImportPrefetcher::prefetch(const string &fileName, function<void(const string &, vector<vector<string>> &)> parser){
+    lock_guard<mutex> guard(lock);
+    Pending &entry = pending[fileName];
+    entry.users++;
+    if (entry.result.valid()){
+        return;
+    }
+    if (!pool){
+        pool.reset(new ThreadPool(PREFETCH_THREADS));
+    }
+    shared_ptr<promise<shared_ptr<PrefetchedImport>>> resultPromise = make_shared<promise<shared_ptr<PrefetchedImport>>>();
+    entry.result = resultPromise->get_future().share();
+    pool->submit([fileName, parser, resultPromise](){
+        FLOW_TRACE_SCOPE("import", "prefetch", fileName);
+        StepCounters before = stepCounters;
+        shared_ptr<PrefetchedImport> import = make_shared<PrefetchedImport>();
+        readFileStamp(fileName, import->size, import->modifiedNanos);
+        try{
+            import->contents = ImportCache::instance().load(fileName);
+            if (import->contents && parser){
+                parser(*import->contents, import->rows);
+                import->parsed = true;
+            }
+        }catch (const exception &e){
+            import->contents = nullptr;
+            import->rows.clear();
+            import->parsed = false;
+            import->error = e.what();
+        }
+        import->counters = countersSince(before);
+        resultPromise->set_value(import);
+    });
+}
+
+shared_future<shared_ptr<PrefetchedImport>> ImportPrefetcher::release(const string &fileName){
+    lock_guard<mutex> guard(lock);
+    auto it = pending.find(fileName);
+    if (it == pending.end()){
+        return shared_future<shared_ptr<PrefetchedImport>>();
+    }
+    shared_future<shared_ptr<PrefetchedImport>> result = it->second.result;
+    if (--it->second.users == 0){
+        pending.erase(it);
+    }
+    return result;
+}
+
+shared_ptr<PrefetchedImport> ImportPrefetcher::take(const string &fileName){
+    shared_future<shared_ptr<PrefetchedImport>> result = release(fileName);
+    if (!result.valid()){
+        return nullptr;
+    }
+    shared_ptr<PrefetchedImport> import;
+    {
+        FLOW_TRACE_SCOPE("import", "wait for prefetch", fileName);
+        import = result.get();
+    }
+    int64_t size;
+    int64_t modifiedNanos;
+    readFileStamp(fileName, size, modifiedNanos);
+    if (size != import->size || modifiedNanos != import->modifiedNanos){
+        return nullptr;
+    }
+
+    // The work was done on another thread but belongs to the step taking the import.
+    creditCounters(import->counters);
+    used++;
+    return import;
+}
+
+void ImportPrefetcher::discard(const string &fileName){
+    release(fileName);
+}
+
+size_t ImportPrefetcher::getPendingCount(){
+    lock_guard<mutex> guard(lock);
+    return pending.size();
+}
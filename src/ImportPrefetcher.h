@@ -0,0 +1,66 @@
+#ifndef FLOWMAKER_IMPORT_PREFETCHER_H
+#define FLOWMAKER_IMPORT_PREFETCHER_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "FlowMetrics.h"
+#include "ThreadPool.h"
+
+// An import read, and optionally parsed into rows, ahead of the step that needs it.
+struct PrefetchedImport{
+    // nullptr if the file could not be opened.
+    std::shared_ptr<const std::string> contents;
+    std::vector<std::vector<std::string>> rows;
+    bool parsed = false;
+    // Set instead of contents when reading failed.
+    std::string error;
+    int64_t size = -1;
+    int64_t modifiedNanos = -1;
+    // What the background thread counted while reading and parsing, for the step
+    // that takes the import.
+    StepCounters counters;
+};
+
+// Reads imports on a small background thread pool while the flow is still busy with
+// the steps before them. Reads go through ImportCache, so a cached file is not read
+// twice. Each prefetch() is matched by exactly one take() or discard(); the result is
+// dropped once every caller that asked for it did so.
+class ImportPrefetcher{
+    private:
+        struct Pending{
+            std::shared_future<std::shared_ptr<PrefetchedImport>> result;
+            size_t users = 0;
+        };
+
+        std::mutex lock;
+        std::unordered_map<std::string, Pending> pending;
+        std::unique_ptr<ThreadPool> pool;
+        std::atomic<uint64_t> used{0};
+
+        ImportPrefetcher();
+        // Removes one user of fileName and returns its result, or an invalid future.
+        std::shared_future<std::shared_ptr<PrefetchedImport>> release(const std::string &fileName);
+    public:
+        static ImportPrefetcher &instance();
+
+        // Starts reading fileName unless it is already being read. With a parser the
+        // rows are built in the background too.
+        void prefetch(const std::string &fileName, std::function<void(const std::string &, std::vector<std::vector<std::string>> &)> parser = nullptr);
+        // Waits for the prefetch of fileName. Returns nullptr if the file changed since
+        // it was read; the caller then imports it the usual way.
+        std::shared_ptr<PrefetchedImport> take(const std::string &fileName);
+        void discard(const std::string &fileName);
+        size_t getPendingCount();
+        // Prefetches a step took and used instead of reading the file itself.
+        uint64_t getUsedCount() const {return used;}
+};
+
+#endif
@@ -0,0 +1,394 @@
+#include "InputSource.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "FlowTrace.h"
+#include "ThreadPool.h"
+
+#if FLOWMAKER_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#if FLOWMAKER_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace std;
+
+// Size of the reads from the compressed file and of the decompressed chunks.
+static const size_t INPUT_CHUNK_SIZE = 256 * 1024;
+
+CompressionFormat detectCompression(const unsigned char *header, size_t size){
+    if (size >= 2 && header[0] == 0x1f && header[1] == 0x8b){
+        return CompressionFormat::Gzip;
+    }
+    if (size >= 4 && header[0] == 0x28 && header[1] == 0xb5 && header[2] == 0x2f && header[3] == 0xfd){
+        return CompressionFormat::Zstd;
+    }
+    return CompressionFormat::None;
+}
+
+// Reads up to size bytes, retrying short reads. Throws on errors.
+static size_t readFully(int fd, char *buffer, size_t size){
+    size_t total = 0;
+    while (total < size){
+        ssize_t count = ::read(fd, buffer + total, size - total);
+        if (count < 0){
+            if (errno == EINTR){
+                continue;
+            }
+            throw runtime_error(string("read failed: ") + strerror(errno));
+        }
+        if (count == 0){
+            break;
+        }
+        total += static_cast<size_t>(count);
+    }
+    return total;
+}
+
+class FileDescriptor{
+    private:
+        int fd;
+    public:
+        explicit FileDescriptor(int fd) : fd(fd) {}
+        FileDescriptor(const FileDescriptor &) = delete;
+        FileDescriptor &operator=(const FileDescriptor &) = delete;
+        ~FileDescriptor(){
+            if (fd >= 0){
+                close(fd);
+            }
+        }
+        int get() const {return fd;}
+};
+
+class PlainSource : public InputSource{
+    private:
+        FileDescriptor file;
+    public:
+        explicit PlainSource(int fd) : file(fd) {}
+        size_t read(char *buffer, size_t size) override {return readFully(file.get(), buffer, size);}
+};
+
+#if FLOWMAKER_HAVE_ZLIB
+// Inflates gzip data as it is read. Concatenated members, as written by pigz or by
+// appending gzip files, are read one after the other.
+class GzipSource : public InputSource{
+    private:
+        FileDescriptor file;
+        z_stream stream;
+        vector<unsigned char> input;
+        bool endOfFile = false;
+        bool inMember = false;
+    public:
+        explicit GzipSource(int fd) : file(fd), input(INPUT_CHUNK_SIZE){
+            memset(&stream, 0, sizeof(stream));
+            if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK){
+                throw runtime_error("unable to start gzip decompression");
+            }
+        }
+
+        ~GzipSource() override{
+            inflateEnd(&stream);
+        }
+
+        size_t read(char *buffer, size_t size) override{
+            size = min(size, static_cast<size_t>(UINT32_MAX));
+            stream.next_out = reinterpret_cast<Bytef *>(buffer);
+            stream.avail_out = static_cast<uInt>(size);
+            while (stream.avail_out > 0){
+                if (stream.avail_in == 0 && !endOfFile){
+                    size_t count = readFully(file.get(), reinterpret_cast<char *>(input.data()), input.size());
+                    endOfFile = count == 0;
+                    stream.next_in = input.data();
+                    stream.avail_in = static_cast<uInt>(count);
+                }
+                if (stream.avail_in == 0 && !inMember){
+                    break;
+                }
+                inMember = true;
+                int result = inflate(&stream, Z_NO_FLUSH);
+                if (result == Z_STREAM_END){
+                    inMember = false;
+                    inflateReset(&stream);
+                }
+                else if (result == Z_BUF_ERROR){
+                    if (endOfFile){
+                        throw runtime_error("truncated gzip data");
+                    }
+                }
+                else if (result != Z_OK){
+                    throw runtime_error(string("corrupt gzip data") + (stream.msg ? string(": ") + stream.msg : ""));
+                }
+            }
+            return size - stream.avail_out;
+        }
+};
+#endif
+
+#if FLOWMAKER_HAVE_ZSTD
+// Decompresses zstd data as it is read, across any number of frames.
+class ZstdSource : public InputSource{
+    private:
+        FileDescriptor file;
+        ZSTD_DStream *stream;
+        vector<char> input;
+        ZSTD_inBuffer inBuffer;
+        size_t lastResult = 0;
+        bool endOfFile = false;
+    public:
+        explicit ZstdSource(int fd) : file(fd), stream(ZSTD_createDStream()), input(ZSTD_DStreamInSize()){
+            if (stream == nullptr){
+                throw runtime_error("unable to start zstd decompression");
+            }
+            ZSTD_initDStream(stream);
+            inBuffer.src = input.data();
+            inBuffer.size = 0;
+            inBuffer.pos = 0;
+        }
+
+        ~ZstdSource() override{
+            ZSTD_freeDStream(stream);
+        }
+
+        size_t read(char *buffer, size_t size) override{
+            ZSTD_outBuffer outBuffer;
+            outBuffer.dst = buffer;
+            outBuffer.size = size;
+            outBuffer.pos = 0;
+            while (outBuffer.pos < outBuffer.size){
+                if (inBuffer.pos == inBuffer.size && !endOfFile){
+                    size_t count = readFully(file.get(), input.data(), input.size());
+                    endOfFile = count == 0;
+                    inBuffer.size = count;
+                    inBuffer.pos = 0;
+                }
+                size_t producedBefore = outBuffer.pos;
+                size_t consumedBefore = inBuffer.pos;
+                size_t result = ZSTD_decompressStream(stream, &outBuffer, &inBuffer);
+                if (ZSTD_isError(result)){
+                    throw runtime_error(string("corrupt zstd data: ") + ZSTD_getErrorName(result));
+                }
+                if (outBuffer.pos == producedBefore && inBuffer.pos == consumedBefore){
+                    if (!endOfFile){
+                        continue;
+                    }
+                    // 0 from the last call that made progress means its frame was complete.
+                    if (lastResult != 0){
+                        throw runtime_error("truncated zstd data");
+                    }
+                    break;
+                }
+                lastResult = result;
+            }
+            return outBuffer.pos;
+        }
+};
+#endif
+
+static unique_ptr<InputSource> openDetectedSource(int fd, CompressionFormat format){
+    switch (format){
+    case CompressionFormat::Gzip:
+#if FLOWMAKER_HAVE_ZLIB
+        return unique_ptr<InputSource>(new GzipSource(fd));
+#else
+        close(fd);
+        throw runtime_error("gzip support was not compiled in");
+#endif
+    case CompressionFormat::Zstd:
+#if FLOWMAKER_HAVE_ZSTD
+        return unique_ptr<InputSource>(new ZstdSource(fd));
+#else
+        close(fd);
+        throw runtime_error("zstd support was not compiled in");
+#endif
+    default:
+        return unique_ptr<InputSource>(new PlainSource(fd));
+    }
+}
+
+// Opens fileName and reads its first bytes into header without moving the file offset.
+static int openWithHeader(const string &fileName, unsigned char *header, size_t headerSize, size_t &headerRead){
+    int fd = open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0){
+        return -1;
+    }
+    ssize_t count = pread(fd, header, headerSize, 0);
+    headerRead = count > 0 ? static_cast<size_t>(count) : 0;
+    return fd;
+}
+
+// Reads the rest of the file into contents. sizeHint (st_size) is only a guess: FIFOs
+// and /proc files report 0, and a file may grow while it is read.
+static void readToEnd(int fd, string &contents, size_t sizeHint){
+    size_t used = 0;
+    contents.resize(sizeHint + 1);
+    while (true){
+        size_t count = readFully(fd, &contents[used], contents.size() - used);
+        used += count;
+        if (used < contents.size()){
+            break;
+        }
+        contents.resize(used + max(used / 2, INPUT_CHUNK_SIZE));
+    }
+    contents.resize(used);
+}
+
+#if FLOWMAKER_HAVE_ZLIB
+// One BGZF block: a complete gzip member that also records its own length.
+struct BGZFBlock{
+    size_t offset;
+    size_t size;
+    size_t outputOffset;
+    size_t outputSize;
+};
+
+static uint32_t readLittleEndian(const unsigned char *bytes, size_t count){
+    uint32_t value = 0;
+    for (size_t i = count; i > 0; --i){
+        value = (value << 8) | bytes[i - 1];
+    }
+    return value;
+}
+
+// Splits data into BGZF blocks. Returns false if it is not BGZF all the way through,
+// in which case it is inflated as one stream instead.
+static bool findBGZFBlocks(const string &data, vector<BGZFBlock> &blocks){
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data.data());
+    size_t offset = 0;
+    size_t outputOffset = 0;
+    while (offset < data.size()){
+        if (data.size() - offset < 18 || bytes[offset] != 0x1f || bytes[offset + 1] != 0x8b || bytes[offset + 2] != 8 || !(bytes[offset + 3] & 4)){
+            return false;
+        }
+        size_t extraLength = readLittleEndian(bytes + offset + 10, 2);
+        size_t blockSize = 0;
+        for (size_t field = offset + 12; field + 4 <= offset + 12 + extraLength && field + 4 <= data.size();){
+            size_t fieldLength = readLittleEndian(bytes + field + 2, 2);
+            if (bytes[field] == 'B' && bytes[field + 1] == 'C' && fieldLength == 2 && field + 6 <= data.size()){
+                blockSize = readLittleEndian(bytes + field + 4, 2) + 1;
+                break;
+            }
+            field += 4 + fieldLength;
+        }
+        if (blockSize < 12 + extraLength + 8 || blockSize > data.size() - offset){
+            return false;
+        }
+        size_t outputSize = readLittleEndian(bytes + offset + blockSize - 4, 4);
+        blocks.push_back(BGZFBlock{offset, blockSize, outputOffset, outputSize});
+        offset += blockSize;
+        outputOffset += outputSize;
+    }
+    return !blocks.empty();
+}
+
+// The first member of a BGZF file carries the 'BC' extra subfield right away.
+static bool hasBGZFHeader(const unsigned char *header, size_t size){
+    return size >= 18 && header[0] == 0x1f && header[1] == 0x8b && header[2] == 8 && (header[3] & 4)
+        && header[12] == 'B' && header[13] == 'C' && header[14] == 2 && header[15] == 0;
+}
+
+// Inflates every block straight into its place in contents, a batch of neighbouring
+// blocks per job.
+static void inflateBGZFBlocks(const string &data, const vector<BGZFBlock> &blocks, string &contents){
+    FLOW_TRACE_SCOPE("import", "inflate blocks", to_string(blocks.size()) + " blocks");
+    contents.resize(blocks.back().outputOffset + blocks.back().outputSize);
+    size_t batchCount = min(blocks.size(), computePool().getThreadCount() * 4);
+    size_t blocksPerBatch = (blocks.size() + batchCount - 1) / batchCount;
+    mutex errorLock;
+    string error;
+    computePool().runBatch(batchCount, [&](size_t batch){
+        z_stream stream;
+        memset(&stream, 0, sizeof(stream));
+        if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK){
+            lock_guard<mutex> guard(errorLock);
+            error = "unable to start gzip decompression";
+            return;
+        }
+        size_t end = min(blocks.size(), (batch + 1) * blocksPerBatch);
+        for (size_t i = batch * blocksPerBatch; i < end; ++i){
+            const BGZFBlock &block = blocks[i];
+            if (block.outputSize == 0){
+                continue;
+            }
+            inflateReset(&stream);
+            stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data() + block.offset));
+            stream.avail_in = static_cast<uInt>(block.size);
+            stream.next_out = reinterpret_cast<Bytef *>(&contents[block.outputOffset]);
+            stream.avail_out = static_cast<uInt>(block.outputSize);
+            if (inflate(&stream, Z_FINISH) != Z_STREAM_END || stream.avail_out != 0){
+                lock_guard<mutex> guard(errorLock);
+                error = "corrupt BGZF block at offset " + to_string(block.offset);
+                break;
+            }
+        }
+        inflateEnd(&stream);
+    });
+    if (!error.empty()){
+        throw runtime_error(error);
+    }
+}
+#endif
+
+bool readImportFile(const string &fileName, string &contents){
+    unsigned char header[18];
+    size_t headerRead;
+    int fd = openWithHeader(fileName, header, sizeof(header), headerRead);
+    if (fd < 0){
+        return false;
+    }
+    CompressionFormat format = detectCompression(header, headerRead);
+
+    struct stat info;
+    size_t fileSize = fstat(fd, &info) == 0 && info.st_size > 0 ? static_cast<size_t>(info.st_size) : 0;
+    if (format == CompressionFormat::None){
+        FileDescriptor file(fd);
+        readToEnd(fd, contents, fileSize);
+        return true;
+    }
+
+#if FLOWMAKER_HAVE_ZLIB
+    if (format == CompressionFormat::Gzip && hasBGZFHeader(header, headerRead)){
+        // A BGZF file is read whole and its blocks inflated in parallel; other gzip
+        // files, and BGZF files with foreign members, are inflated as they are read.
+        string compressed;
+        {
+            FileDescriptor file(fd);
+            readToEnd(fd, compressed, fileSize);
+        }
+        vector<BGZFBlock> blocks;
+        if (findBGZFBlocks(compressed, blocks)){
+            inflateBGZFBlocks(compressed, blocks, contents);
+            return true;
+        }
+        fd = open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0){
+            return false;
+        }
+    }
+#endif
+
+    FLOW_TRACE_SCOPE("import", "decompress", fileName);
+    unique_ptr<InputSource> source = openDetectedSource(fd, format);
+    contents.clear();
+    size_t used = 0;
+    while (true){
+        contents.resize(used + INPUT_CHUNK_SIZE);
+        size_t count = source->read(&contents[used], INPUT_CHUNK_SIZE);
+        used += count;
+        if (count == 0){
+            break;
+        }
+    }
+    contents.resize(used);
+    return true;
+}
@@ -0,0 +1,31 @@
+#ifndef FLOWMAKER_INPUT_SOURCE_H
+#define FLOWMAKER_INPUT_SOURCE_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// Compression of an import file, told apart by its leading bytes rather than its name.
+enum class CompressionFormat{
+    None,
+    Gzip,
+    Zstd
+};
+
+CompressionFormat detectCompression(const unsigned char *header, size_t size);
+
+// Sequential bytes of an import file, decompressed on the fly if the file is compressed.
+class InputSource{
+    public:
+        virtual ~InputSource() {}
+        // Reads up to size bytes into buffer. Returns 0 at the end of the data and
+        // throws runtime_error if the file is corrupt or cannot be read.
+        virtual size_t read(char *buffer, size_t size) = 0;
+};
+
+// Reads a whole import file into contents, decompressing it without a temporary file.
+// BGZF files (blocked gzip, as written by bgzip) are inflated block-parallel. Returns
+// false if the file cannot be opened and throws runtime_error if reading it fails.
+bool readImportFile(const std::string &fileName, std::string &contents);
+
+#endif
@@ -0,0 +1,229 @@
+#include "LineIndex.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <sys/stat.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+static const char INDEX_MAGIC[8] = {'F', 'L', 'O', 'W', 'L', 'I', 'D', 'X'};
+static const string INDEX_SUFFIX = ".lidx";
+static const string PART_SUFFIX = ".part";
+
+static atomic<bool> persistentIndexes{false};
+
+void LineIndex::setPersistent(bool persistent){
+    persistentIndexes = persistent;
+}
+
+bool LineIndex::isPersistent(){
+    return persistentIndexes;
+}
+
+void LineIndex::addNewline(uint64_t nextStart){
+    if (wide){
+        wideStarts.push_back(nextStart);
+        return;
+    }
+    if ((offsets.size() & ((size_t(1) << BLOCK_SHIFT) - 1)) == 0){
+        blockStarts.push_back(nextStart);
+    }
+    uint64_t offset = nextStart - blockStarts.back();
+    if (offset > numeric_limits<uint32_t>::max()){
+        widen();
+        wideStarts.push_back(nextStart);
+        return;
+    }
+    offsets.push_back(static_cast<uint32_t>(offset));
+}
+
+void LineIndex::widen(){
+    wideStarts.reserve(offsets.size() + 1);
+    for (size_t newline = 0; newline < offsets.size(); ++newline){
+        wideStarts.push_back(getNextStart(newline));
+    }
+    wide = true;
+    blockStarts.clear();
+    blockStarts.shrink_to_fit();
+    offsets.clear();
+    offsets.shrink_to_fit();
+}
+
+void LineIndex::extend(const string &text){
+    const char *data = text.data();
+    uint64_t position = textSize;
+    uint64_t size = text.size();
+#if defined(__SSE2__)
+    __m128i newline = _mm_set1_epi8('\n');
+    while (position + 64 <= size){
+        const __m128i *block = reinterpret_cast<const __m128i *>(data + position);
+        uint64_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(block), newline)))
+            | static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(block + 1), newline)))) << 16
+            | static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(block + 2), newline)))) << 32
+            | static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(block + 3), newline)))) << 48;
+        while (mask != 0){
+            addNewline(position + __builtin_ctzll(mask) + 1);
+            mask &= mask - 1;
+        }
+        position += 64;
+    }
+#endif
+    while (position < size){
+        const void *found = memchr(data + position, '\n', size - position);
+        if (found == nullptr){
+            break;
+        }
+        position = static_cast<const char *>(found) - data + 1;
+        addNewline(position);
+    }
+    textSize = size;
+}
+
+void LineIndex::append(const LineIndex &other){
+    if (getLineCount() > 0 && getLineEnd(getLineCount() - 1) == textSize){
+        throw invalid_argument("the indexed text does not end with a newline");
+    }
+    if (textSize == 0){
+        *this = other;
+        return;
+    }
+    for (size_t newline = 0; newline < other.getNewlineCount(); ++newline){
+        addNewline(textSize + other.getNextStart(newline));
+    }
+    textSize += other.textSize;
+}
+
+size_t LineIndex::getLineCount() const{
+    size_t newlines = getNewlineCount();
+    // A last line without a newline still counts.
+    uint64_t lastStart = newlines == 0 ? 0 : getNextStart(newlines - 1);
+    return newlines + (lastStart < textSize ? 1 : 0);
+}
+
+uint64_t LineIndex::getLineEnd(size_t line) const{
+    return line < getNewlineCount() ? getNextStart(line) - 1 : textSize;
+}
+
+pair<uint64_t, uint64_t> LineIndex::getLineRange(size_t first, size_t count) const{
+    size_t lines = getLineCount();
+    if (first >= lines || count == 0){
+        return make_pair(textSize, textSize);
+    }
+    size_t last = min(first + count, lines) - 1;
+    return make_pair(getLineStart(first), getLineEnd(last));
+}
+
+size_t LineIndex::getMemoryBytes() const{
+    return blockStarts.capacity() * sizeof(uint64_t) + offsets.capacity() * sizeof(uint32_t) + wideStarts.capacity() * sizeof(uint64_t);
+}
+
+// Size and modification time of the file, which a saved index must have been made for.
+static bool fileVersion(const string &fileName, uint64_t &size, int64_t &modifiedNanos){
+    struct stat info;
+    if (stat(fileName.c_str(), &info) != 0){
+        return false;
+    }
+    size = static_cast<uint64_t>(info.st_size);
+    modifiedNanos = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    return true;
+}
+
+// The saved index holds the magic bytes, the size and modification time of the file,
+// the size of its text, the newline count and a u8 wide flag, then the offsets as
+// kept in memory, all in host byte order.
+bool LineIndex::load(const string &fileName, uint64_t textSize, LineIndex &index){
+    uint64_t sourceSize;
+    int64_t sourceModified;
+    if (!fileVersion(fileName, sourceSize, sourceModified)){
+        return false;
+    }
+    FILE *file = fopen((fileName + INDEX_SUFFIX).c_str(), "rb");
+    if (file == nullptr){
+        return false;
+    }
+    char magic[sizeof(INDEX_MAGIC)];
+    uint64_t savedSourceSize;
+    int64_t savedSourceModified;
+    uint64_t savedTextSize;
+    uint64_t newlines;
+    uint8_t savedWide;
+    bool valid = fread(magic, sizeof(magic), 1, file) == 1 && memcmp(magic, INDEX_MAGIC, sizeof(magic)) == 0
+        && fread(&savedSourceSize, sizeof(savedSourceSize), 1, file) == 1 && savedSourceSize == sourceSize
+        && fread(&savedSourceModified, sizeof(savedSourceModified), 1, file) == 1 && savedSourceModified == sourceModified
+        && fread(&savedTextSize, sizeof(savedTextSize), 1, file) == 1 && savedTextSize == textSize
+        && fread(&newlines, sizeof(newlines), 1, file) == 1 && newlines <= textSize
+        && fread(&savedWide, sizeof(savedWide), 1, file) == 1 && savedWide <= 1;
+    LineIndex loaded;
+    if (valid){
+        loaded.wide = savedWide == 1;
+        loaded.textSize = textSize;
+        if (loaded.wide){
+            loaded.wideStarts.resize(newlines);
+            valid = fread(loaded.wideStarts.data(), sizeof(uint64_t), newlines, file) == newlines;
+        }
+        else{
+            loaded.blockStarts.resize((newlines + (size_t(1) << BLOCK_SHIFT) - 1) >> BLOCK_SHIFT);
+            loaded.offsets.resize(newlines);
+            valid = fread(loaded.blockStarts.data(), sizeof(uint64_t), loaded.blockStarts.size(), file) == loaded.blockStarts.size()
+                && fread(loaded.offsets.data(), sizeof(uint32_t), newlines, file) == newlines;
+        }
+        valid = valid && fgetc(file) == EOF && (newlines == 0 || loaded.getNextStart(newlines - 1) <= textSize);
+    }
+    fclose(file);
+    if (valid){
+        index = move(loaded);
+    }
+    return valid;
+}
+
+void LineIndex::save(const string &fileName) const{
+    uint64_t sourceSize;
+    int64_t sourceModified;
+    if (!fileVersion(fileName, sourceSize, sourceModified)){
+        throw runtime_error("cannot read the modification time of '" + fileName + "'");
+    }
+    // Written under another name and renamed, so a reader never sees half an index.
+    string indexName = fileName + INDEX_SUFFIX;
+    string partName = indexName + PART_SUFFIX;
+    FILE *file = fopen(partName.c_str(), "wb");
+    if (file == nullptr){
+        throw runtime_error("cannot create '" + partName + "': " + strerror(errno));
+    }
+    uint64_t newlines = getNewlineCount();
+    uint8_t savedWide = wide ? 1 : 0;
+    bool written = fwrite(INDEX_MAGIC, sizeof(INDEX_MAGIC), 1, file) == 1
+        && fwrite(&sourceSize, sizeof(sourceSize), 1, file) == 1
+        && fwrite(&sourceModified, sizeof(sourceModified), 1, file) == 1
+        && fwrite(&textSize, sizeof(textSize), 1, file) == 1
+        && fwrite(&newlines, sizeof(newlines), 1, file) == 1
+        && fwrite(&savedWide, sizeof(savedWide), 1, file) == 1;
+    if (wide){
+        written = written && fwrite(wideStarts.data(), sizeof(uint64_t), newlines, file) == newlines;
+    }
+    else{
+        written = written && fwrite(blockStarts.data(), sizeof(uint64_t), blockStarts.size(), file) == blockStarts.size()
+            && fwrite(offsets.data(), sizeof(uint32_t), newlines, file) == newlines;
+    }
+    written = fclose(file) == 0 && written;
+    if (!written || rename(partName.c_str(), indexName.c_str()) != 0){
+        string reason = strerror(errno);
+        remove(partName.c_str());
+        throw runtime_error("cannot write '" + indexName + "': " + reason);
+    }
+}
+
+bool LineIndex::isIndexFile(const string &fileName){
+    auto endsWith = [&fileName](const string &suffix){
+        return fileName.size() >= suffix.size() && fileName.compare(fileName.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+    return endsWith(INDEX_SUFFIX) || endsWith(INDEX_SUFFIX + PART_SUFFIX);
+}
@@ -0,0 +1,70 @@
+#ifndef FLOWMAKER_LINE_INDEX_H
+#define FLOWMAKER_LINE_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Byte offsets of the lines of a text, so that any line or range of lines is found
+// in constant time instead of scanning from the start. A line ends at a newline or
+// at the end of the text.
+//
+// For every newline the index keeps the offset after it, as a 32-bit offset from the
+// start of its block of 256 lines plus one 64-bit start per block: about 4 bytes a
+// line. Should 256 lines ever span 4 GiB, it switches to plain 64-bit offsets.
+class LineIndex{
+    private:
+        static const unsigned BLOCK_SHIFT = 8;
+
+        std::vector<uint64_t> blockStarts;
+        std::vector<uint32_t> offsets;
+        std::vector<uint64_t> wideStarts;
+        bool wide = false;
+        uint64_t textSize = 0;
+
+        size_t getNewlineCount() const {return wide ? wideStarts.size() : offsets.size();}
+        // Offset after the newline-th newline.
+        uint64_t getNextStart(size_t newline) const{
+            return wide ? wideStarts[newline] : blockStarts[newline >> BLOCK_SHIFT] + offsets[newline];
+        }
+        void addNewline(uint64_t nextStart);
+        void widen();
+    public:
+        LineIndex() {}
+        explicit LineIndex(const std::string &text) {extend(text);}
+
+        // Indexes the bytes of text after the ones indexed so far, which must be
+        // unchanged. Newlines are found 64 bytes at a time with SSE2 where available.
+        void extend(const std::string &text);
+        // Appends the lines of other, an index of the bytes that follow the indexed
+        // ones. The indexed text must end with a newline, or be empty.
+        void append(const LineIndex &other);
+
+        size_t getLineCount() const;
+        uint64_t getTextSize() const {return textSize;}
+        uint64_t getLineStart(size_t line) const {return line == 0 ? 0 : getNextStart(line - 1);}
+        // Offset of the newline ending the line, or of the end of the text.
+        uint64_t getLineEnd(size_t line) const;
+        // Bytes [begin, end) of count lines from first, without the last newline.
+        std::pair<uint64_t, uint64_t> getLineRange(size_t first, size_t count) const;
+        size_t getMemoryBytes() const;
+
+        // Whether imports save their index next to each file (as "<file>.lidx") and
+        // read it back while the file is unchanged. Off unless FlowMaker is started
+        // with --line-index-files.
+        static void setPersistent(bool persistent);
+        static bool isPersistent();
+
+        // Reads the index saved for fileName into index. Returns false if there is
+        // none, or if it no longer matches the file or its textSize bytes of text.
+        static bool load(const std::string &fileName, uint64_t textSize, LineIndex &index);
+        // Saves the index of the text of fileName. Throws runtime_error on failure.
+        void save(const std::string &fileName) const;
+        // Whether fileName is a saved index, or one being written, rather than a file
+        // to import.
+        static bool isIndexFile(const std::string &fileName);
+};
+
+#endif
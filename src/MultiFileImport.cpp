@@ -0,0 +1,96 @@
+#include "MultiFileImport.h"
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+
+#include <glob.h>
+#include <sys/stat.h>
+
+#include "FlowMetrics.h"
+#include "FlowTrace.h"
+#include "ImportCache.h"
+#include "LineIndex.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+static bool isGlobPattern(const string &path){
+    return path.find_first_of("*?[") != string::npos;
+}
+
+static bool isDirectory(const string &path){
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+static bool isRegularFile(const string &path){
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode);
+}
+
+bool isMultiFileImport(const string &path){
+    return isGlobPattern(path) || isDirectory(path);
+}
+
+vector<string> expandImportPath(const string &path, const string &extension){
+    vector<string> patterns;
+    if (isGlobPattern(path)){
+        patterns.push_back(path);
+    }
+    else{
+        string directory = path.back() == '/' ? path : path + "/";
+        for (const string &suffix : {extension, extension + ".gz", extension + ".zst"}){
+            patterns.push_back(directory + "*" + suffix);
+        }
+    }
+
+    vector<string> files;
+    for (const string &pattern : patterns){
+        glob_t matches;
+        if (glob(pattern.c_str(), 0, nullptr, &matches) == 0){
+            for (size_t i = 0; i < matches.gl_pathc; ++i){
+                // The line indexes --line-index-files saves next to the imports are
+                // not imports themselves.
+                if (isRegularFile(matches.gl_pathv[i]) && !LineIndex::isIndexFile(matches.gl_pathv[i])){
+                    files.push_back(matches.gl_pathv[i]);
+                }
+            }
+        }
+        globfree(&matches);
+    }
+    sort(files.begin(), files.end());
+    return files;
+}
+
+vector<ImportShard> loadImportShards(const vector<string> &files, function<void(const string &, vector<vector<string>> &)> parser){
+    FLOW_TRACE_SCOPE("import", "load shards", to_string(files.size()) + " files");
+    vector<ImportShard> shards(files.size());
+    mutex lock;
+    StepCounters poolCounters;
+    computePool().runBatch(files.size(), [&](size_t i){
+        ImportShard &shard = shards[i];
+        shard.fileName = files[i];
+        StepCounters before = stepCounters;
+        try{
+            shard.contents = ImportCache::instance().load(shard.fileName);
+            if (shard.contents && parser){
+                FLOW_TRACE_SCOPE("import", "parse", shard.fileName);
+                parser(*shard.contents, shard.rows);
+            }
+        }catch (const exception &e){
+            shard.contents = nullptr;
+            shard.rows.clear();
+            shard.error = e.what();
+        }
+        StepCounters counters = countersSince(before);
+        lock_guard<mutex> guard(lock);
+        poolCounters.bytesRead += counters.bytesRead;
+        poolCounters.rowsParsed += counters.rowsParsed;
+        poolCounters.allocations += counters.allocations;
+        poolCounters.allocatedBytes += counters.allocatedBytes;
+        poolCounters.liveBytes += counters.liveBytes;
+    });
+    creditCounters(poolCounters);
+    return shards;
+}
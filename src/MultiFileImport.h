@@ -0,0 +1,33 @@
+#ifndef FLOWMAKER_MULTI_FILE_IMPORT_H
+#define FLOWMAKER_MULTI_FILE_IMPORT_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// True for a directory or a glob pattern entered where an import step expects a
+// file name.
+bool isMultiFileImport(const std::string &path);
+
+// Files of a multi-file import, sorted by name: the regular files of a directory
+// whose names end with extension (plain, ".gz" or ".zst"), or the regular files a
+// glob pattern matches. Saved line indexes are never part of an import.
+std::vector<std::string> expandImportPath(const std::string &path, const std::string &extension);
+
+// One file of a multi-file import.
+struct ImportShard{
+    std::string fileName;
+    // nullptr if the file could not be opened.
+    std::shared_ptr<const std::string> contents;
+    std::vector<std::vector<std::string>> rows;
+    // Set instead of contents when reading failed.
+    std::string error;
+};
+
+// Loads the files concurrently on a shared thread pool and returns them in the order
+// given. With a parser every shard is parsed into rows on the pool as well. What the
+// pool threads count is credited to the calling thread's step.
+std::vector<ImportShard> loadImportShards(const std::vector<std::string> &files, std::function<void(const std::string &, std::vector<std::vector<std::string>> &)> parser = nullptr);
+
+#endif
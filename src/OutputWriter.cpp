@@ -0,0 +1,70 @@
+#include "OutputWriter.h"
+
+#include "FlowMetrics.h"
+#include "FlowSteps.h"
+#include "FlowTrace.h"
+
+using namespace std;
+
+// Rough size of what the step will write, for the queue budget.
+static size_t outputSize(const OutputStep &step){
+    size_t size = step.getFilename().size() + step.getTitle().size();
+    for (const string &line : step.getOutputData()){
+        size += line.size() + 1;
+    }
+    if (step.getContents() != nullptr){
+        size += step.getContents()->size();
+    }
+    return size;
+}
+
+OutputWriter::OutputWriter(size_t maxQueuedBytes) : maxQueuedBytes(maxQueuedBytes), writerThread(1) {}
+
+OutputWriter &OutputWriter::instance(){
+    static OutputWriter writer;
+    return writer;
+}
+
+future<OutputWriteResult> OutputWriter::queue(unique_ptr<OutputStep> step){
+    size_t size = outputSize(*step);
+    {
+        // A write larger than the whole budget still goes through once the queue is empty.
+        FLOW_TRACE_SCOPE("output", "wait for queue space", step->getFilename());
+        unique_lock<mutex> guard(lock);
+        spaceAvailable.wait(guard, [&](){return queuedBytes == 0 || queuedBytes + size <= maxQueuedBytes;});
+        queuedBytes += size;
+    }
+
+    shared_ptr<promise<OutputWriteResult>> resultPromise = make_shared<promise<OutputWriteResult>>();
+    future<OutputWriteResult> result = resultPromise->get_future();
+    shared_ptr<OutputStep> job(step.release());
+    writerThread.submit([this, job, size, resultPromise](){
+        OutputWriteResult outcome;
+        exception_ptr error;
+        try{
+            uint64_t bytesBefore = stepCounters.bytesWritten;
+            outcome.succeeded = job->writeFile(outcome.message);
+            outcome.fileName = job->getFilename();
+            outcome.bytesWritten = stepCounters.bytesWritten - bytesBefore;
+        }catch (...){
+            error = current_exception();
+        }
+        {
+            lock_guard<mutex> guard(lock);
+            queuedBytes -= size;
+        }
+        spaceAvailable.notify_all();
+        if (error){
+            resultPromise->set_exception(error);
+        }
+        else{
+            resultPromise->set_value(move(outcome));
+        }
+    });
+    return result;
+}
+
+size_t OutputWriter::getQueuedBytes(){
+    lock_guard<mutex> guard(lock);
+    return queuedBytes;
+}
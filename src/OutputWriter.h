@@ -0,0 +1,50 @@
+#ifndef FLOWMAKER_OUTPUT_WRITER_H
+#define FLOWMAKER_OUTPUT_WRITER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "ThreadPool.h"
+
+class OutputStep;
+
+// Outcome of a queued output file write.
+struct OutputWriteResult{
+    bool succeeded = false;
+    std::string message;
+    // The name the file got once name conflicts were resolved.
+    std::string fileName;
+    uint64_t bytesWritten = 0;
+};
+
+// Writes OutputStep files on one dedicated thread, in the order they were queued, so
+// flows go on while their reports are written. Files queued one after the other get
+// the same name resolution as if they had been written in place. At most
+// maxQueuedBytes of output data wait at a time; queue() blocks beyond that.
+class OutputWriter{
+    private:
+        std::mutex lock;
+        std::condition_variable spaceAvailable;
+        size_t maxQueuedBytes;
+        size_t queuedBytes = 0;
+        // Last, so it finishes the queued writes before the members they use go away.
+        ThreadPool writerThread;
+    public:
+        OutputWriter(size_t maxQueuedBytes = 64 * 1024 * 1024);
+        OutputWriter(const OutputWriter &) = delete;
+        OutputWriter &operator=(const OutputWriter &) = delete;
+
+        // Shared by every flow run of the process.
+        static OutputWriter &instance();
+
+        // Takes over the step, which must already hold its file name, title and data.
+        std::future<OutputWriteResult> queue(std::unique_ptr<OutputStep> step);
+        size_t getQueuedBytes();
+};
+
+#endif
@@ -0,0 +1,77 @@
+#include "PipelinedRowStream.h"
+
+#include <stdexcept>
+
+using namespace std;
+
+static atomic<bool> pipeliningEnabled{true};
+
+void PipelinedRowStream::setEnabled(bool enabled){
+    pipeliningEnabled = enabled;
+}
+
+bool PipelinedRowStream::isEnabled(){
+    return pipeliningEnabled;
+}
+
+PipelinedRowStream::PipelinedRowStream(unique_ptr<RowStream> source, size_t queueBatches) : source(move(source)), queue(queueBatches){
+    producer = thread(&PipelinedRowStream::produce, this);
+}
+
+PipelinedRowStream::~PipelinedRowStream(){
+    cancelled = true;
+    // The reading thread may be waiting for room in the queue; take batches until
+    // it has handed over its last one.
+    while (!current.last){
+        current = queue.pop();
+    }
+    producer.join();
+}
+
+void PipelinedRowStream::produce(){
+    Batch batch;
+    size_t batchBytes = 0;
+    try{
+        vector<string> row;
+        while (!cancelled && source->next(row)){
+            for (const string &cell : row){
+                batchBytes += cell.size();
+            }
+            batch.rows.push_back(move(row));
+            if (batch.rows.size() == BATCH_ROWS || batchBytes >= BATCH_BYTES){
+                queue.push(move(batch));
+                batch = Batch();
+                batch.rows.reserve(BATCH_ROWS);
+                batchBytes = 0;
+            }
+        }
+    }catch (const exception &e){
+        batch.error = e.what();
+    }
+    batch.last = true;
+    queue.push(move(batch));
+}
+
+bool PipelinedRowStream::next(vector<string> &row){
+    while (position == current.rows.size()){
+        if (current.last){
+            if (!current.error.empty()){
+                string error = move(current.error);
+                current.error.clear();
+                throw runtime_error(error);
+            }
+            return false;
+        }
+        current = queue.pop();
+        position = 0;
+    }
+    row = move(current.rows[position++]);
+    return true;
+}
+
+unique_ptr<RowStream> openTableForScan(const TableProducer &table){
+    if (!PipelinedRowStream::isEnabled() || table.getRowsInMemory() != nullptr){
+        return table.openTable();
+    }
+    return unique_ptr<RowStream>(new PipelinedRowStream(table.openTable()));
+}
@@ -0,0 +1,60 @@
+#ifndef FLOWMAKER_PIPELINED_ROW_STREAM_H
+#define FLOWMAKER_PIPELINED_ROW_STREAM_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "RowStream.h"
+#include "SpscQueue.h"
+
+// Reads a stream ahead on a thread of its own and hands its rows over in batches
+// through a bounded single-producer queue, so that producing the rows (merging
+// sorted runs, reading join partitions) overlaps with whatever the reader does with
+// them. When the queue is full the reading thread waits, which bounds the rows in
+// flight to a few batches however long the stream is.
+class PipelinedRowStream : public RowStream{
+    private:
+        struct Batch{
+            std::vector<std::vector<std::string>> rows;
+            // Set on the batch that ends the stream, with the error that ended it if any.
+            bool last = false;
+            std::string error;
+        };
+
+        std::unique_ptr<RowStream> source;
+        SpscQueue<Batch> queue;
+        std::atomic<bool> cancelled{false};
+        Batch current;
+        size_t position = 0;
+        std::thread producer;
+
+        void produce();
+    public:
+        // A batch is handed over once it holds this many rows or bytes of cells.
+        static const size_t BATCH_ROWS = 1024;
+        static const size_t BATCH_BYTES = 1024 * 1024;
+        static const size_t QUEUE_BATCHES = 8;
+
+        explicit PipelinedRowStream(std::unique_ptr<RowStream> source, size_t queueBatches = QUEUE_BATCHES);
+        PipelinedRowStream(const PipelinedRowStream &) = delete;
+        PipelinedRowStream &operator=(const PipelinedRowStream &) = delete;
+        // Stops the reading thread if the stream was not read to the end.
+        ~PipelinedRowStream();
+
+        // Rethrows, after the rows read before it, an error of the source stream.
+        bool next(std::vector<std::string> &row) override;
+
+        // On unless FlowMaker is started with --no-pipeline.
+        static void setEnabled(bool enabled);
+        static bool isEnabled();
+};
+
+// Opens table for a reader that goes through all of it. Tables that are not held in
+// memory are read ahead by a PipelinedRowStream, unless pipelining is off.
+std::unique_ptr<RowStream> openTableForScan(const TableProducer &table);
+
+#endif
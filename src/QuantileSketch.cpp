@@ -0,0 +1,241 @@
+#include "QuantileSketch.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "FlowTrace.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+// Values buffered per centroid allowed before the digest is compressed.
+static const size_t BUFFER_FACTOR = 5;
+// Cells handed to each pool thread per batch.
+static const size_t BATCH_CELLS_PER_THREAD = 65536;
+
+TDigest::TDigest(double compression) : compression(compression), minimum(numeric_limits<double>::infinity()), maximum(-numeric_limits<double>::infinity()){
+    buffer.reserve(static_cast<size_t>(compression) * BUFFER_FACTOR);
+}
+
+void TDigest::add(double value){
+    buffer.push_back(Centroid{value, 1});
+    totalWeight += 1;
+    minimum = min(minimum, value);
+    maximum = max(maximum, value);
+    if (buffer.size() >= static_cast<size_t>(compression) * BUFFER_FACTOR){
+        compress();
+    }
+}
+
+void TDigest::merge(const TDigest &other){
+    buffer.insert(buffer.end(), other.centroids.begin(), other.centroids.end());
+    buffer.insert(buffer.end(), other.buffer.begin(), other.buffer.end());
+    totalWeight += other.totalWeight;
+    minimum = min(minimum, other.minimum);
+    maximum = max(maximum, other.maximum);
+    compress();
+}
+
+// Merges neighbouring centroids while the merged one stays within one unit of the
+// scale function k(q) = compression / (2 pi) * asin(2q - 1).
+void TDigest::compress(){
+    if (buffer.empty()){
+        return;
+    }
+    buffer.insert(buffer.end(), centroids.begin(), centroids.end());
+    sort(buffer.begin(), buffer.end(), [](const Centroid &a, const Centroid &b){
+        return a.mean < b.mean;
+    });
+    auto scale = [this](double q){
+        return compression / (2 * M_PI) * asin(2 * q - 1);
+    };
+    auto inverseScale = [this](double k){
+        return (sin(min(k * 2 * M_PI / compression, M_PI / 2)) + 1) / 2;
+    };
+
+    centroids.clear();
+    Centroid current = buffer[0];
+    double weightSoFar = 0;
+    double weightLimit = totalWeight * inverseScale(scale(0) + 1);
+    for (size_t i = 1; i < buffer.size(); ++i){
+        const Centroid &next = buffer[i];
+        if (weightSoFar + current.weight + next.weight <= weightLimit){
+            current.mean += (next.mean - current.mean) * next.weight / (current.weight + next.weight);
+            current.weight += next.weight;
+        }
+        else{
+            weightSoFar += current.weight;
+            centroids.push_back(current);
+            weightLimit = totalWeight * inverseScale(scale(weightSoFar / totalWeight) + 1);
+            current = next;
+        }
+    }
+    centroids.push_back(current);
+    buffer.clear();
+}
+
+double TDigest::quantile(double q){
+    compress();
+    if (centroids.empty()){
+        return numeric_limits<double>::quiet_NaN();
+    }
+    if (centroids.size() == 1){
+        return centroids[0].mean;
+    }
+    double index = min(max(q, 0.0), 1.0) * totalWeight;
+    if (index < 1){
+        return minimum;
+    }
+    if (index > totalWeight - 1){
+        return maximum;
+    }
+
+    // Between the minimum and the centre of the first centroid.
+    const Centroid &first = centroids.front();
+    if (first.weight > 1 && index < first.weight / 2){
+        return minimum + (index - 1) / (first.weight / 2 - 1) * (first.mean - minimum);
+    }
+    // Between the centres of two neighbouring centroids; a centroid of one value is
+    // that value, not spread around it.
+    double weightSoFar = first.weight / 2;
+    for (size_t i = 0; i + 1 < centroids.size(); ++i){
+        const Centroid &left = centroids[i];
+        const Centroid &right = centroids[i + 1];
+        double gap = (left.weight + right.weight) / 2;
+        if (weightSoFar + gap > index){
+            double leftUnit = 0;
+            if (left.weight == 1){
+                if (index - weightSoFar < 0.5){
+                    return left.mean;
+                }
+                leftUnit = 0.5;
+            }
+            double rightUnit = 0;
+            if (right.weight == 1){
+                if (weightSoFar + gap - index <= 0.5){
+                    return right.mean;
+                }
+                rightUnit = 0.5;
+            }
+            double toLeft = index - weightSoFar - leftUnit;
+            double toRight = weightSoFar + gap - index - rightUnit;
+            return (left.mean * toRight + right.mean * toLeft) / (toLeft + toRight);
+        }
+        weightSoFar += gap;
+    }
+    // Between the centre of the last centroid and the maximum.
+    const Centroid &last = centroids.back();
+    if (last.weight > 2){
+        double toLast = index - weightSoFar;
+        return last.mean + (maximum - last.mean) * min(toLast / (last.weight / 2 - 1), 1.0);
+    }
+    return last.mean;
+}
+
+static string trim(const string &text){
+    size_t first = text.find_first_not_of(" \t");
+    if (first == string::npos){
+        return "";
+    }
+    size_t last = text.find_last_not_of(" \t");
+    return text.substr(first, last - first + 1);
+}
+
+bool parsePercentiles(const string &text, vector<double> &ranks){
+    ranks.clear();
+    size_t start = 0;
+    while (start <= text.size()){
+        size_t comma = text.find(',', start);
+        string item = trim(text.substr(start, comma == string::npos ? string::npos : comma - start));
+        start = comma == string::npos ? text.size() + 1 : comma + 1;
+        double percentile;
+        auto parsed = from_chars(item.data(), item.data() + item.size(), percentile);
+        if (item.empty() || parsed.ec != errc() || parsed.ptr != item.data() + item.size() || !(percentile >= 0 && percentile <= 100)){
+            return false;
+        }
+        ranks.push_back(percentile / 100);
+    }
+    return !ranks.empty();
+}
+
+// Parses a cell that holds only a finite number, allowing surrounding blanks.
+static bool parseCellNumber(const string &cell, double &value){
+    const char *begin = cell.data();
+    const char *end = cell.data() + cell.size();
+    while (begin < end && (*begin == ' ' || *begin == '\t')){
+        begin++;
+    }
+    while (end > begin && (end[-1] == ' ' || end[-1] == '\t')){
+        end--;
+    }
+    if (begin < end && *begin == '+'){
+        begin++;
+    }
+    auto parsed = from_chars(begin, end, value);
+    return begin < end && parsed.ec == errc() && parsed.ptr == end && isfinite(value);
+}
+
+ColumnQuantiles computeColumnQuantiles(RowStream &rows, size_t column, const vector<double> &ranks){
+    size_t threads = computePool().getThreadCount();
+    vector<TDigest> digests(threads);
+    vector<uint64_t> skipped(threads, 0);
+    vector<string> batch;
+    batch.reserve(threads * BATCH_CELLS_PER_THREAD);
+    uint64_t missing = 0;
+
+    auto sketchBatch = [&]{
+        FLOW_TRACE_SCOPE("quantile", "sketch batch", to_string(batch.size()) + " cells");
+        size_t slice = (batch.size() + threads - 1) / threads;
+        computePool().runBatch(threads, [&](size_t thread){
+            size_t last = min(batch.size(), (thread + 1) * slice);
+            double value;
+            for (size_t i = thread * slice; i < last; ++i){
+                if (parseCellNumber(batch[i], value)){
+                    digests[thread].add(value);
+                }
+                else{
+                    skipped[thread]++;
+                }
+            }
+        });
+        batch.clear();
+    };
+
+    vector<string> row;
+    while (rows.next(row)){
+        if (column >= row.size()){
+            missing++;
+            continue;
+        }
+        batch.push_back(move(row[column]));
+        if (batch.size() == batch.capacity()){
+            sketchBatch();
+        }
+    }
+    if (!batch.empty()){
+        sketchBatch();
+    }
+
+    FLOW_TRACE_SCOPE("quantile", "merge digests", to_string(threads) + " digests");
+    TDigest &merged = digests[0];
+    for (size_t thread = 1; thread < threads; ++thread){
+        merged.merge(digests[thread]);
+    }
+    ColumnQuantiles result;
+    result.values = merged.getCount();
+    result.skipped = missing;
+    for (uint64_t count : skipped){
+        result.skipped += count;
+    }
+    if (result.values > 0){
+        result.minimum = merged.getMin();
+        result.maximum = merged.getMax();
+    }
+    for (double rank : ranks){
+        result.quantiles.push_back(merged.quantile(rank));
+    }
+    return result;
+}
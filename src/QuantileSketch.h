@@ -0,0 +1,64 @@
+#ifndef FLOWMAKER_QUANTILE_SKETCH_H
+#define FLOWMAKER_QUANTILE_SKETCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "RowStream.h"
+
+// Merging t-digest: a quantile sketch of at most about `compression` centroids,
+// whatever the number of values added. Centroids are kept small near the tails
+// (the k1 scale function), so extreme quantiles such as p99.9 stay accurate.
+// Digests of parts of the data can be merged into a digest of the whole.
+class TDigest{
+    private:
+        struct Centroid{
+            double mean;
+            double weight;
+        };
+        double compression;
+        std::vector<Centroid> centroids;
+        // Values added since the last compression.
+        std::vector<Centroid> buffer;
+        double totalWeight = 0;
+        double minimum;
+        double maximum;
+
+        void compress();
+    public:
+        static constexpr double DEFAULT_COMPRESSION = 200;
+
+        explicit TDigest(double compression = DEFAULT_COMPRESSION);
+
+        void add(double value);
+        void merge(const TDigest &other);
+        // Estimated value at rank q (0 to 1), or NaN if the digest is empty.
+        double quantile(double q);
+
+        uint64_t getCount() const {return static_cast<uint64_t>(totalWeight);}
+        double getMin() const {return minimum;}
+        double getMax() const {return maximum;}
+        size_t getCentroidCount() const {return centroids.size();}
+};
+
+// Parses percentiles such as "50, 95, 99.9" into ranks from 0 to 1. Returns false if
+// the text is malformed or a percentile is outside 0 to 100.
+bool parsePercentiles(const std::string &text, std::vector<double> &ranks);
+
+struct ColumnQuantiles{
+    uint64_t values = 0;
+    // Cells that were missing or not numbers.
+    uint64_t skipped = 0;
+    double minimum = 0;
+    double maximum = 0;
+    std::vector<double> quantiles;
+};
+
+// Sketches the numbers in column (0-based) of rows and estimates the quantiles at
+// ranks. The rows are read on the calling thread in batches whose cells are parsed
+// and added to one digest per pool thread; the digests are merged at the end.
+ColumnQuantiles computeColumnQuantiles(RowStream &rows, size_t column, const std::vector<double> &ranks);
+
+#endif
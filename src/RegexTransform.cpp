@@ -0,0 +1,170 @@
+#include "RegexTransform.h"
+
+#include <algorithm>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+#if FLOWMAKER_HAVE_RE2
+#include <re2/re2.h>
+#else
+#include <regex>
+#endif
+
+#include "FlowTrace.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+// Lines matched by one pool job.
+static const size_t CHUNK_LINES = 16384;
+
+#if FLOWMAKER_HAVE_RE2
+
+struct CompiledRegex::Engine{
+    re2::RE2 regex;
+
+    Engine(const string &pattern, const re2::RE2::Options &options) : regex(pattern, options) {}
+};
+
+CompiledRegex::CompiledRegex(const string &pattern) : pattern(pattern){
+    re2::RE2::Options options;
+    options.set_log_errors(false);
+    unique_ptr<Engine> compiled(new Engine(pattern, options));
+    if (!compiled->regex.ok()){
+        throw invalid_argument(compiled->regex.error());
+    }
+    groupCount = static_cast<size_t>(compiled->regex.NumberOfCapturingGroups());
+    engine = move(compiled);
+}
+
+bool CompiledRegex::extract(string_view line, vector<string> &fields) const{
+    size_t captures = max<size_t>(groupCount, 1);
+    // Reused across the lines a thread matches.
+    static thread_local vector<re2::StringPiece> found;
+    found.resize(captures + 1);
+    re2::StringPiece text(line.data(), line.size());
+    if (!engine->regex.Match(text, 0, text.size(), re2::RE2::UNANCHORED, found.data(), static_cast<int>(captures + 1))){
+        return false;
+    }
+    fields.resize(captures);
+    for (size_t group = 0; group < captures; ++group){
+        const re2::StringPiece &capture = found[groupCount == 0 ? 0 : group + 1];
+        fields[group].assign(capture.data() == nullptr ? "" : capture.data(), capture.size());
+    }
+    return true;
+}
+
+const char *CompiledRegex::getEngineName() {return "RE2";}
+
+#else
+
+struct CompiledRegex::Engine{
+    regex expression;
+
+    explicit Engine(const string &pattern) : expression(pattern, regex::ECMAScript | regex::optimize) {}
+};
+
+CompiledRegex::CompiledRegex(const string &pattern) : pattern(pattern){
+    try{
+        engine.reset(new Engine(pattern));
+    }catch (const regex_error &e){
+        throw invalid_argument(e.what());
+    }
+    groupCount = engine->expression.mark_count();
+}
+
+bool CompiledRegex::extract(string_view line, vector<string> &fields) const{
+    static thread_local cmatch found;
+    if (!regex_search(line.data(), line.data() + line.size(), found, engine->expression)){
+        return false;
+    }
+    size_t captures = max<size_t>(groupCount, 1);
+    fields.resize(captures);
+    for (size_t group = 0; group < captures; ++group){
+        fields[group] = found[groupCount == 0 ? 0 : group + 1].str();
+    }
+    return true;
+}
+
+const char *CompiledRegex::getEngineName() {return "std::regex";}
+
+#endif
+
+CompiledRegex::~CompiledRegex() {}
+
+shared_ptr<const CompiledRegex> compileRegex(const string &pattern){
+    static mutex lock;
+    static list<pair<string, shared_ptr<const CompiledRegex>>> recencyOrder;
+    static unordered_map<string, list<pair<string, shared_ptr<const CompiledRegex>>>::iterator> entries;
+    {
+        lock_guard<mutex> guard(lock);
+        auto it = entries.find(pattern);
+        if (it != entries.end()){
+            recencyOrder.splice(recencyOrder.begin(), recencyOrder, it->second);
+            return it->second->second;
+        }
+    }
+    // Compiled without the lock; a pattern compiled by two runs at once is kept once.
+    shared_ptr<const CompiledRegex> compiled;
+    {
+        FLOW_TRACE_SCOPE("regex", "compile", pattern);
+        compiled = make_shared<const CompiledRegex>(pattern);
+    }
+    lock_guard<mutex> guard(lock);
+    auto it = entries.find(pattern);
+    if (it != entries.end()){
+        return it->second->second;
+    }
+    recencyOrder.emplace_front(pattern, compiled);
+    entries[pattern] = recencyOrder.begin();
+    if (recencyOrder.size() > REGEX_CACHE_SIZE){
+        entries.erase(recencyOrder.back().first);
+        recencyOrder.pop_back();
+    }
+    return compiled;
+}
+
+RegexTransformResult transformLines(const string &text, const LineIndex &index, const CompiledRegex &regex){
+    size_t lines = index.getLineCount();
+    size_t chunks = (lines + CHUNK_LINES - 1) / CHUNK_LINES;
+    vector<vector<vector<string>>> chunkRows(chunks);
+    vector<string> errors(chunks);
+    {
+        FLOW_TRACE_SCOPE("regex", "match lines", to_string(lines) + " lines");
+        computePool().runBatch(chunks, [&](size_t chunk){
+            try{
+                vector<string> fields;
+                size_t last = min(lines, (chunk + 1) * CHUNK_LINES);
+                for (size_t line = chunk * CHUNK_LINES; line < last; ++line){
+                    uint64_t begin = index.getLineStart(line);
+                    if (regex.extract(string_view(text.data() + begin, index.getLineEnd(line) - begin), fields)){
+                        chunkRows[chunk].push_back(fields);
+                    }
+                }
+            }catch (const exception &e){
+                errors[chunk] = e.what();
+            }
+        });
+    }
+    for (const string &error : errors){
+        if (!error.empty()){
+            throw runtime_error(error);
+        }
+    }
+
+    RegexTransformResult result;
+    result.linesChecked = lines;
+    size_t rows = 0;
+    for (const vector<vector<string>> &chunk : chunkRows){
+        rows += chunk.size();
+    }
+    result.rows.reserve(rows);
+    for (vector<vector<string>> &chunk : chunkRows){
+        move(chunk.begin(), chunk.end(), back_inserter(result.rows));
+    }
+    return result;
+}
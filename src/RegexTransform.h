@@ -0,0 +1,60 @@
+#ifndef FLOWMAKER_REGEX_TRANSFORM_H
+#define FLOWMAKER_REGEX_TRANSFORM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "LineIndex.h"
+
+// A regular expression compiled once and then matched from any number of threads
+// at a time. It is compiled with RE2 if FlowMaker was built with it, otherwise with
+// std::regex in its ECMAScript syntax.
+class CompiledRegex{
+    private:
+        struct Engine;
+
+        std::string pattern;
+        std::unique_ptr<const Engine> engine;
+        size_t groupCount = 0;
+    public:
+        // Throws invalid_argument if pattern is not a valid regular expression.
+        explicit CompiledRegex(const std::string &pattern);
+        CompiledRegex(const CompiledRegex &) = delete;
+        CompiledRegex &operator=(const CompiledRegex &) = delete;
+        ~CompiledRegex();
+
+        const std::string &getPattern() const {return pattern;}
+        size_t getGroupCount() const {return groupCount;}
+        // Finds the first match in line. On a match sets fields to its capture groups
+        // (groups that took no part are empty), or to the whole match if the pattern
+        // has no groups, and returns true.
+        bool extract(std::string_view line, std::vector<std::string> &fields) const;
+
+        // "RE2" or "std::regex".
+        static const char *getEngineName();
+};
+
+// Patterns compiled by compileRegex that are kept for reuse.
+static const size_t REGEX_CACHE_SIZE = 64;
+
+// The compiled pattern, shared by every flow run of the process: a pattern is only
+// compiled again once it has been among the least recently used beyond
+// REGEX_CACHE_SIZE. Throws invalid_argument like CompiledRegex.
+std::shared_ptr<const CompiledRegex> compileRegex(const std::string &pattern);
+
+struct RegexTransformResult{
+    // One row of fields per matching line, in the order of the lines.
+    std::vector<std::vector<std::string>> rows;
+    uint64_t linesChecked = 0;
+};
+
+// Matches regex against every line of text, as found by index. The lines are
+// split into chunks that pool threads match in parallel; their rows are joined in
+// line order at the end. Throws runtime_error if the matcher fails.
+RegexTransformResult transformLines(const std::string &text, const LineIndex &index, const CompiledRegex &regex);
+
+#endif
@@ -0,0 +1,371 @@
+#include "ResultCache.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fstream>
+#include <stdexcept>
+#include <sys/stat.h>
+
+#include "DistinctCount.h"
+#include "FileUtils.h"
+#include "FlowRecord.h"
+#include "FlowSteps.h"
+#include "FlowTrace.h"
+#include "MultiFileImport.h"
+
+using namespace std;
+
+static const char RESULT_MAGIC[8] = {'F', 'L', 'O', 'W', 'R', 'U', 'N', '1'};
+static const string RESULT_EXTENSION = ".run";
+// Files are hashed a block at a time, so a large input is never held whole.
+static const size_t HASH_BLOCK_BYTES = 1024 * 1024;
+
+static int64_t currentNanos(){
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+static uint64_t combineHashes(uint64_t first, uint64_t second){
+    uint64_t both[2] = {first, second};
+    return hashCell(reinterpret_cast<const char *>(both), sizeof(both));
+}
+
+ResultCache &ResultCache::instance(){
+    static ResultCache cache;
+    return cache;
+}
+
+string ResultCache::entryFileName(uint64_t key) const{
+    static const char digits[] = "0123456789abcdef";
+    string name(16, '0');
+    for (int i = 15; i >= 0; --i){
+        name[i] = digits[key & 0xF];
+        key >>= 4;
+    }
+    return directory + "/" + name + RESULT_EXTENSION;
+}
+
+// An entry file holds the magic bytes and the length of its header, then the header
+// (key, flow hash, answer count and inputs), the answers and the outputs, all
+// little-endian as in the binary flow store.
+void ResultCache::open(const string &newDirectory, size_t newCapacityBytes){
+    lock_guard<mutex> guard(lock);
+    directory = newDirectory;
+    capacityBytes = newCapacityBytes;
+    entries.clear();
+    usedBytes = 0;
+    if (capacityBytes == 0){
+        return;
+    }
+    if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST){
+        throw runtime_error("Unable to create the result cache directory '" + directory + "'.");
+    }
+    DIR *listing = opendir(directory.c_str());
+    if (listing == nullptr){
+        throw runtime_error("Unable to open the result cache directory '" + directory + "'.");
+    }
+    FLOW_TRACE_SCOPE("result cache", "index", directory);
+    while (dirent *item = readdir(listing)){
+        string name = item->d_name;
+        if (name.size() <= RESULT_EXTENSION.size() || name.compare(name.size() - RESULT_EXTENSION.size(), string::npos, RESULT_EXTENSION) != 0){
+            continue;
+        }
+        string fileName = directory + "/" + name;
+        ifstream file(fileName, ios::binary);
+        char prefix[12];
+        if (!file.read(prefix, sizeof(prefix)) || memcmp(prefix, RESULT_MAGIC, sizeof(RESULT_MAGIC)) != 0){
+            continue;
+        }
+        FlowRecordReader sizeReader(prefix + sizeof(RESULT_MAGIC), prefix + sizeof(prefix));
+        string header(sizeReader.readU32(), '\0');
+        if (!file.read(&header[0], header.size())){
+            continue;
+        }
+        FlowRecordReader reader(header.data(), header.data() + header.size());
+        uint64_t key = reader.readU64();
+        Entry entry;
+        entry.flowHash = reader.readU64();
+        entry.answerCount = reader.readU32();
+        uint32_t inputCount = reader.readU32();
+        for (uint32_t i = 0; i < inputCount && !reader.hasFailed(); ++i){
+            RunInput input;
+            input.fileName = reader.readString();
+            input.extension = reader.readString();
+            entry.inputs.push_back(move(input));
+        }
+        struct stat info;
+        if (reader.hasFailed() || stat(fileName.c_str(), &info) != 0){
+            continue;
+        }
+        entry.bytes = static_cast<uint64_t>(info.st_size);
+        entry.lastUsed = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+        usedBytes += entry.bytes;
+        entries[key] = move(entry);
+    }
+    closedir(listing);
+    evictLocked();
+}
+
+bool ResultCache::isEnabled() const{
+    lock_guard<mutex> guard(lock);
+    return capacityBytes > 0;
+}
+
+uint64_t ResultCache::hashFlow(const Flow &flow){
+    const vector<FlowStep *> &steps = flow.getSteps();
+    FlowRecordWriter writer(&steps);
+    writer.writeString(flow.getName());
+    writer.writeU32(static_cast<uint32_t>(steps.size()));
+    FlowRecordWriter config(&steps);
+    for (const FlowStep *step : steps){
+        config.clear();
+        step->writeConfig(config);
+        writer.writeString(step->getType());
+        writer.writeString(config.getBuffer());
+    }
+    return hashCell(writer.getBuffer().data(), writer.getBuffer().size());
+}
+
+void ResultCache::addStepInputs(const FlowStep *step, vector<RunInput> &inputs){
+    for (const string &fileName : getImportedFiles(step)){
+        inputs.push_back(RunInput{fileName, ""});
+    }
+    if (const TextFileInputStep *text = dynamic_cast<const TextFileInputStep *>(step)){
+        if (!text->getFileName().empty() && isMultiFileImport(text->getFileName())){
+            inputs.push_back(RunInput{text->getFileName(), ".txt"});
+        }
+    }
+    else if (const CSVFileInputStep *csv = dynamic_cast<const CSVFileInputStep *>(step)){
+        if (!csv->getFileName().empty() && isMultiFileImport(csv->getFileName())){
+            inputs.push_back(RunInput{csv->getFileName(), ".csv"});
+        }
+    }
+}
+
+uint64_t ResultCache::fingerprint(const RunInput &input){
+    if (!input.extension.empty()){
+        // A pattern is known by the files it matches now.
+        uint64_t hash = 0;
+        for (const string &fileName : expandImportPath(input.fileName, input.extension)){
+            hash = combineHashes(hash, hashCell(fileName.data(), fileName.size()));
+        }
+        return hash;
+    }
+    struct stat info;
+    if (stat(input.fileName.c_str(), &info) != 0){
+        return 0;
+    }
+    int64_t size = static_cast<int64_t>(info.st_size);
+    int64_t modifiedNanos = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    {
+        lock_guard<mutex> guard(lock);
+        auto it = fingerprints.find(input.fileName);
+        if (it != fingerprints.end() && it->second.size == size && it->second.modifiedNanos == modifiedNanos){
+            return it->second.hash;
+        }
+    }
+
+    FLOW_TRACE_SCOPE("result cache", "hash input", input.fileName);
+    ifstream file(input.fileName, ios::binary);
+    string block(HASH_BLOCK_BYTES, '\0');
+    uint64_t hash = static_cast<uint64_t>(size);
+    while (file){
+        file.read(&block[0], block.size());
+        size_t count = static_cast<size_t>(file.gcount());
+        if (count == 0){
+            break;
+        }
+        hash = combineHashes(hash, hashCell(block.data(), count));
+    }
+    lock_guard<mutex> guard(lock);
+    fingerprints[input.fileName] = Fingerprint{size, modifiedNanos, hash};
+    return hash;
+}
+
+uint64_t ResultCache::computeKey(uint64_t flowHash, const vector<string> &answers, size_t answerCount, const vector<RunInput> &inputs){
+    FlowRecordWriter writer;
+    writer.writeU64(flowHash);
+    writer.writeU32(static_cast<uint32_t>(answerCount));
+    for (size_t i = 0; i < answerCount; ++i){
+        writer.writeString(answers[i]);
+    }
+    writer.writeU32(static_cast<uint32_t>(inputs.size()));
+    for (const RunInput &input : inputs){
+        writer.writeString(input.fileName);
+        writer.writeString(input.extension);
+        writer.writeU64(fingerprint(input));
+    }
+    return hashCell(writer.getBuffer().data(), writer.getBuffer().size());
+}
+
+bool ResultCache::lookup(uint64_t flowHash, const vector<string> &queued, RecordedRun &run){
+    vector<pair<uint64_t, Entry>> candidates;
+    {
+        lock_guard<mutex> guard(lock);
+        for (const auto &entry : entries){
+            if (entry.second.flowHash == flowHash && entry.second.answerCount <= queued.size()){
+                candidates.push_back(entry);
+            }
+        }
+    }
+    FLOW_TRACE_SCOPE("result cache", "lookup");
+    for (const pair<uint64_t, Entry> &candidate : candidates){
+        if (computeKey(flowHash, queued, candidate.second.answerCount, candidate.second.inputs) != candidate.first){
+            continue;
+        }
+        string fileName = entryFileName(candidate.first);
+        ifstream file(fileName, ios::binary);
+        string contents;
+        if (!file.is_open() || !readWholeFile(file, contents) || contents.size() < sizeof(RESULT_MAGIC) + 4){
+            lock_guard<mutex> guard(lock);
+            removeLocked(candidate.first);
+            continue;
+        }
+        FlowRecordReader reader(contents.data() + sizeof(RESULT_MAGIC), contents.data() + contents.size());
+        reader.readSlice(reader.readU32());
+        RecordedRun found;
+        found.inputs = candidate.second.inputs;
+        uint32_t answerCount = reader.readU32();
+        for (uint32_t i = 0; i < answerCount && !reader.hasFailed(); ++i){
+            found.answers.push_back(reader.readString());
+        }
+        uint32_t outputCount = reader.readU32();
+        for (uint32_t i = 0; i < outputCount && !reader.hasFailed(); ++i){
+            RunOutput output;
+            output.kind = static_cast<RunOutput::Kind>(reader.readU8());
+            output.fileName = reader.readString();
+            output.text = reader.readString();
+            found.outputs.push_back(move(output));
+        }
+        // The hash only stands for the answers; they are compared as well.
+        bool matches = !reader.hasFailed() && found.answers.size() == candidate.second.answerCount
+            && equal(found.answers.begin(), found.answers.end(), queued.begin());
+        lock_guard<mutex> guard(lock);
+        if (!matches){
+            continue;
+        }
+        auto it = entries.find(candidate.first);
+        if (it != entries.end()){
+            it->second.lastUsed = currentNanos();
+        }
+        // The modification time keeps the recency for the next process.
+        utimensat(AT_FDCWD, fileName.c_str(), nullptr, 0);
+        hits++;
+        run = move(found);
+        return true;
+    }
+    lock_guard<mutex> guard(lock);
+    misses++;
+    return false;
+}
+
+void ResultCache::store(uint64_t flowHash, const RecordedRun &run){
+    if (run.answers.size() > MAX_ANSWERS){
+        return;
+    }
+    FLOW_TRACE_SCOPE("result cache", "store");
+    uint64_t key = computeKey(flowHash, run.answers, run.answers.size(), run.inputs);
+
+    FlowRecordWriter header;
+    header.writeU64(key);
+    header.writeU64(flowHash);
+    header.writeU32(static_cast<uint32_t>(run.answers.size()));
+    header.writeU32(static_cast<uint32_t>(run.inputs.size()));
+    for (const RunInput &input : run.inputs){
+        header.writeString(input.fileName);
+        header.writeString(input.extension);
+    }
+    FlowRecordWriter body;
+    body.writeBytes(string(RESULT_MAGIC, sizeof(RESULT_MAGIC)));
+    body.writeString(header.getBuffer());
+    body.writeU32(static_cast<uint32_t>(run.answers.size()));
+    for (const string &answer : run.answers){
+        body.writeString(answer);
+    }
+    body.writeU32(static_cast<uint32_t>(run.outputs.size()));
+    for (const RunOutput &output : run.outputs){
+        body.writeU8(output.kind);
+        body.writeString(output.fileName);
+        body.writeString(output.text);
+    }
+    const string &contents = body.getBuffer();
+
+    lock_guard<mutex> guard(lock);
+    if (capacityBytes == 0 || contents.size() > capacityBytes){
+        return;
+    }
+    // Written under another name and renamed, so a reader never sees half an entry.
+    string fileName = entryFileName(key);
+    string partName = fileName + ".part";
+    ofstream file(partName, ios::binary | ios::trunc);
+    file.write(contents.data(), contents.size());
+    file.close();
+    if (file.fail() || rename(partName.c_str(), fileName.c_str()) != 0){
+        remove(partName.c_str());
+        return;
+    }
+    removeLocked(key);
+    entries[key] = Entry{flowHash, run.answers.size(), run.inputs, contents.size(), currentNanos()};
+    usedBytes += contents.size();
+    stores++;
+    evictLocked();
+}
+
+void ResultCache::removeLocked(uint64_t key){
+    auto it = entries.find(key);
+    if (it != entries.end()){
+        usedBytes -= it->second.bytes;
+        entries.erase(it);
+    }
+}
+
+void ResultCache::evictLocked(){
+    while (usedBytes > capacityBytes && !entries.empty()){
+        auto oldest = entries.begin();
+        for (auto it = entries.begin(); it != entries.end(); ++it){
+            if (it->second.lastUsed < oldest->second.lastUsed){
+                oldest = it;
+            }
+        }
+        remove(entryFileName(oldest->first).c_str());
+        usedBytes -= oldest->second.bytes;
+        entries.erase(oldest);
+        evictions++;
+    }
+}
+
+uint64_t ResultCache::getHits() const{
+    lock_guard<mutex> guard(lock);
+    return hits;
+}
+
+uint64_t ResultCache::getMisses() const{
+    lock_guard<mutex> guard(lock);
+    return misses;
+}
+
+uint64_t ResultCache::getStores() const{
+    lock_guard<mutex> guard(lock);
+    return stores;
+}
+
+uint64_t ResultCache::getEvictions() const{
+    lock_guard<mutex> guard(lock);
+    return evictions;
+}
+
+size_t ResultCache::getEntryCount() const{
+    lock_guard<mutex> guard(lock);
+    return entries.size();
+}
+
+uint64_t ResultCache::getUsedBytes() const{
+    lock_guard<mutex> guard(lock);
+    return usedBytes;
+}
@@ -0,0 +1,105 @@
+#ifndef FLOWMAKER_RESULT_CACHE_H
+#define FLOWMAKER_RESULT_CACHE_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Flow.h"
+
+// A file a recorded run depended on. A directory or glob import is recorded by its
+// pattern as well, with the extension it was expanded with, so that files starting or
+// stopping to match it are noticed.
+struct RunInput{
+    std::string fileName;
+    // Empty for a single file.
+    std::string extension;
+};
+
+// Something a recorded run printed or wrote, in the order it happened.
+struct RunOutput{
+    enum Kind : uint8_t {Text, Error, File};
+    Kind kind;
+    // The text printed, or the contents of the file.
+    std::string text;
+    // For a file, the name the run asked for, before name conflicts were resolved.
+    std::string fileName;
+};
+
+struct RecordedRun{
+    std::vector<std::string> answers;
+    std::vector<RunInput> inputs;
+    std::vector<RunOutput> outputs;
+};
+
+// Whole flow runs kept on disk, so that a run repeating an earlier one is replayed
+// instead of computed again. A run is found by a hash of the flow definition, the
+// answers it read and the size and content hash of every file it imported. The least
+// recently used runs are removed once the entries take more than the capacity. The
+// capacity is 0 (caching off) unless FlowMaker is started with --result-cache.
+class ResultCache{
+    private:
+        struct Entry{
+            uint64_t flowHash;
+            size_t answerCount;
+            std::vector<RunInput> inputs;
+            uint64_t bytes;
+            int64_t lastUsed;
+        };
+
+        // Content hash of a file, reused while it keeps its size and modification time.
+        struct Fingerprint{
+            int64_t size;
+            int64_t modifiedNanos;
+            uint64_t hash;
+        };
+
+        mutable std::mutex lock;
+        std::string directory;
+        size_t capacityBytes = 0;
+        std::unordered_map<uint64_t, Entry> entries;
+        uint64_t usedBytes = 0;
+        std::unordered_map<std::string, Fingerprint> fingerprints;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t stores = 0;
+        uint64_t evictions = 0;
+
+        ResultCache() {}
+        std::string entryFileName(uint64_t key) const;
+        uint64_t fingerprint(const RunInput &input);
+        uint64_t computeKey(uint64_t flowHash, const std::vector<std::string> &answers, size_t answerCount, const std::vector<RunInput> &inputs);
+        void removeLocked(uint64_t key);
+        void evictLocked();
+    public:
+        // Runs that read more answers than this are not kept.
+        static const size_t MAX_ANSWERS = 4096;
+
+        static ResultCache &instance();
+
+        // Keeps the entries in directory, which is created if missing, and indexes the
+        // entries already in it. A capacity of 0 turns the cache off.
+        void open(const std::string &directory, size_t capacityBytes);
+        bool isEnabled() const;
+
+        // Hash of the flow name and the type and configuration of every step.
+        static uint64_t hashFlow(const Flow &flow);
+        // Adds the files the step imported in the run that just ended to inputs.
+        static void addStepInputs(const FlowStep *step, std::vector<RunInput> &inputs);
+
+        // Finds a run of the flow whose answers are the first of queued and whose inputs
+        // are unchanged.
+        bool lookup(uint64_t flowHash, const std::vector<std::string> &queued, RecordedRun &run);
+        void store(uint64_t flowHash, const RecordedRun &run);
+
+        uint64_t getHits() const;
+        uint64_t getMisses() const;
+        uint64_t getStores() const;
+        uint64_t getEvictions() const;
+        size_t getEntryCount() const;
+        uint64_t getUsedBytes() const;
+};
+
+#endif
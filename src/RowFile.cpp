@@ -0,0 +1,101 @@
+#include "RowFile.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include <unistd.h>
+
+using namespace std;
+
+string createTemporaryRowFile(const string &prefix){
+    const char *environment = getenv("TMPDIR");
+    string directory = environment && *environment ? environment : "/tmp";
+    string pattern = directory + "/" + prefix + "-XXXXXX";
+    vector<char> name(pattern.begin(), pattern.end());
+    name.push_back('\0');
+    int fd = mkstemp(name.data());
+    if (fd < 0){
+        throw runtime_error("unable to create a temporary file in '" + directory + "': " + strerror(errno));
+    }
+    ::close(fd);
+    return name.data();
+}
+
+RowFileWriter::RowFileWriter(const string &fileName, size_t bufferSize) : fileName(fileName), fileBuffer(bufferSize){
+    file = fopen(fileName.c_str(), "wb");
+    if (file == nullptr){
+        throw runtime_error("unable to open the temporary file '" + fileName + "': " + strerror(errno));
+    }
+    setvbuf(file, fileBuffer.data(), _IOFBF, fileBuffer.size());
+}
+
+RowFileWriter::~RowFileWriter(){
+    if (file){
+        fclose(file);
+    }
+}
+
+void RowFileWriter::writeBytes(const void *data, size_t size){
+    if (size > 0 && fwrite(data, 1, size, file) != size){
+        throw runtime_error("unable to write the temporary file '" + fileName + "': " + strerror(errno));
+    }
+    written += size;
+}
+
+void RowFileWriter::write(const vector<string> &cells){
+    uint32_t count = static_cast<uint32_t>(cells.size());
+    writeBytes(&count, sizeof(count));
+    for (const string &cell : cells){
+        uint32_t length = static_cast<uint32_t>(cell.size());
+        writeBytes(&length, sizeof(length));
+        writeBytes(cell.data(), cell.size());
+    }
+}
+
+uint64_t RowFileWriter::close(){
+    int result = fclose(file);
+    file = nullptr;
+    if (result != 0){
+        throw runtime_error("unable to write the temporary file '" + fileName + "': " + strerror(errno));
+    }
+    return written;
+}
+
+RowFileReader::RowFileReader(const string &fileName, size_t bufferSize) : fileName(fileName), fileBuffer(bufferSize){
+    file = fopen(fileName.c_str(), "rb");
+    if (file == nullptr){
+        throw runtime_error("unable to open the temporary file '" + fileName + "': " + strerror(errno));
+    }
+    setvbuf(file, fileBuffer.data(), _IOFBF, fileBuffer.size());
+}
+
+RowFileReader::~RowFileReader(){
+    fclose(file);
+}
+
+void RowFileReader::readBytes(void *data, size_t size){
+    if (size > 0 && fread(data, 1, size, file) != size){
+        throw runtime_error("the temporary file '" + fileName + "' is truncated");
+    }
+}
+
+bool RowFileReader::next(vector<string> &row){
+    uint32_t count;
+    size_t got = fread(&count, 1, sizeof(count), file);
+    if (got == 0 && feof(file)){
+        return false;
+    }
+    if (got != sizeof(count)){
+        throw runtime_error("the temporary file '" + fileName + "' is truncated");
+    }
+    row.resize(count);
+    for (string &cell : row){
+        uint32_t length;
+        readBytes(&length, sizeof(length));
+        cell.resize(length);
+        readBytes(cell.data(), length);
+    }
+    return true;
+}
@@ -0,0 +1,59 @@
+#ifndef FLOWMAKER_ROW_FILE_H
+#define FLOWMAKER_ROW_FILE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "RowStream.h"
+
+// Temporary files of table rows, used where a step spills rows that do not fit its
+// memory budget. Per row the file holds a u32 cell count, then per cell a u32
+// length and the bytes, in host byte order.
+
+// Creates an empty file in $TMPDIR (or /tmp) named after prefix and returns its
+// name. Throws runtime_error if it cannot be created.
+std::string createTemporaryRowFile(const std::string &prefix);
+
+class RowFileWriter{
+    private:
+        FILE *file;
+        std::string fileName;
+        std::vector<char> fileBuffer;
+        uint64_t written = 0;
+
+        void writeBytes(const void *data, size_t size);
+    public:
+        static const size_t DEFAULT_BUFFER_SIZE = 1024 * 1024;
+
+        // Truncates the file. Throws runtime_error if it cannot be opened.
+        explicit RowFileWriter(const std::string &fileName, size_t bufferSize = DEFAULT_BUFFER_SIZE);
+        RowFileWriter(const RowFileWriter &) = delete;
+        RowFileWriter &operator=(const RowFileWriter &) = delete;
+        ~RowFileWriter();
+
+        void write(const std::vector<std::string> &cells);
+        // Flushes and closes the file and returns the bytes written. Throws
+        // runtime_error if writing failed.
+        uint64_t close();
+        uint64_t getBytesWritten() const {return written;}
+};
+
+class RowFileReader : public RowStream{
+    private:
+        FILE *file;
+        std::string fileName;
+        std::vector<char> fileBuffer;
+
+        void readBytes(void *data, size_t size);
+    public:
+        explicit RowFileReader(const std::string &fileName, size_t bufferSize = RowFileWriter::DEFAULT_BUFFER_SIZE);
+        RowFileReader(const RowFileReader &) = delete;
+        RowFileReader &operator=(const RowFileReader &) = delete;
+        ~RowFileReader();
+
+        bool next(std::vector<std::string> &row) override;
+};
+
+#endif
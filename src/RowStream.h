@@ -0,0 +1,55 @@
+#ifndef FLOWMAKER_ROW_STREAM_H
+#define FLOWMAKER_ROW_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Rows of a table read one at a time, so that consumers need not hold the whole
+// table in memory.
+class RowStream{
+    public:
+        virtual ~RowStream() {}
+        // Replaces row with the next row. Returns false after the last one and throws
+        // runtime_error if the rows cannot be read.
+        virtual bool next(std::vector<std::string> &row) = 0;
+};
+
+// Rows of a table held in memory. The table must outlive the stream.
+class TableRowStream : public RowStream{
+    private:
+        const std::vector<std::vector<std::string>> &rows;
+        size_t position = 0;
+    public:
+        explicit TableRowStream(const std::vector<std::vector<std::string>> &rows) : rows(rows) {}
+
+        bool next(std::vector<std::string> &row) override{
+            if (position >= rows.size()){
+                return false;
+            }
+            row = rows[position++];
+            return true;
+        }
+};
+
+// A step whose result is a table that later steps (sort, join, output) can read.
+class TableProducer{
+    public:
+        virtual ~TableProducer() {}
+        // False until the step produced its table in the current run.
+        virtual bool hasTable() const = 0;
+        // Reads the table from its first row. Unless the producer says otherwise, the
+        // stream must not outlive the step.
+        virtual std::unique_ptr<RowStream> openTable() const = 0;
+        // Rows the stream will yield, including a header row.
+        virtual uint64_t getRowCount() const = 0;
+        // Short label for prompts and listings, such as the imported file name.
+        virtual std::string getTableName() const = 0;
+        // The rows, if the table keeps them in memory, for random access; nullptr if it
+        // can only be read as a stream.
+        virtual const std::vector<std::vector<std::string>> *getRowsInMemory() const {return nullptr;}
+};
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef FLOWMAKER_SPSC_QUEUE_H
+#define FLOWMAKER_SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Bounded queue between exactly one producer thread and one consumer thread. The
+// positions are atomics, so neither side takes a lock; a side that finds the queue
+// full or empty sleeps on the other side's position (C++20 atomic wait) until it
+// moves. Capacity is rounded up to a power of two.
+template <class T>
+class SpscQueue{
+    private:
+        std::vector<T> slots;
+        size_t mask;
+        // Both only grow; they are apart by the number of queued items. Kept on
+        // separate cache lines so the two threads do not share one.
+        alignas(64) std::atomic<size_t> head{0};
+        alignas(64) std::atomic<size_t> tail{0};
+    public:
+        explicit SpscQueue(size_t capacity){
+            size_t size = 1;
+            while (size < capacity){
+                size <<= 1;
+            }
+            slots.resize(size);
+            mask = size - 1;
+        }
+        SpscQueue(const SpscQueue &) = delete;
+        SpscQueue &operator=(const SpscQueue &) = delete;
+
+        // Producer: queues item, waiting while the queue is full.
+        void push(T item){
+            size_t position = tail.load(std::memory_order_relaxed);
+            size_t consumed = head.load(std::memory_order_acquire);
+            while (position - consumed == slots.size()){
+                head.wait(consumed, std::memory_order_acquire);
+                consumed = head.load(std::memory_order_acquire);
+            }
+            slots[position & mask] = std::move(item);
+            tail.store(position + 1, std::memory_order_release);
+            tail.notify_one();
+        }
+
+        // Consumer: takes the oldest item, waiting while the queue is empty.
+        T pop(){
+            size_t position = head.load(std::memory_order_relaxed);
+            size_t produced = tail.load(std::memory_order_acquire);
+            while (produced == position){
+                tail.wait(produced, std::memory_order_acquire);
+                produced = tail.load(std::memory_order_acquire);
+            }
+            T item = std::move(slots[position & mask]);
+            head.store(position + 1, std::memory_order_release);
+            head.notify_one();
+            return item;
+        }
+
+        // Consumer: takes the oldest item into item if there is one, without waiting.
+        bool tryPop(T &item){
+            size_t position = head.load(std::memory_order_relaxed);
+            if (tail.load(std::memory_order_acquire) == position){
+                return false;
+            }
+            item = std::move(slots[position & mask]);
+            head.store(position + 1, std::memory_order_release);
+            head.notify_one();
+            return true;
+        }
+};
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef FLOWMAKER_STEP_REGISTRY_H
+#define FLOWMAKER_STEP_REGISTRY_H
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "FlowStep.h"
+
+// Metadata and factories for one step type. Filled in by StepRegistration objects at
+// static-initialization time and shared by the flow stores and the creation menu.
+struct StepTypeInfo{
+    std::string typeName;
+    char menuKey;
+    std::string summary;
+    FlowStep *(*create)();
+    FlowStep *(*createInteractive)();
+};
+
+class StepRegistry{
+    private:
+        std::unordered_map<std::string, StepTypeInfo> stepTypes;
+        std::vector<const StepTypeInfo *> menuOrder;
+
+        // Digits 1-9 first, then letters, then '0' which finishes the flow.
+        static int menuRank(char menuKey){
+            if (menuKey == '0'){
+                return 1000;
+            }
+            return static_cast<unsigned char>(menuKey);
+        }
+
+        StepRegistry() {}
+    public:
+        static StepRegistry &instance(){
+            static StepRegistry registry;
+            return registry;
+        }
+
+        bool registerStep(const StepTypeInfo &info){
+            if (info.create == nullptr || findByMenuKey(info.menuKey) != nullptr){
+                std::cerr << "Error: Step type '" << info.typeName << "' could not be registered." << std::endl;
+                return false;
+            }
+            auto inserted = stepTypes.emplace(info.typeName, info);
+            if (!inserted.second){
+                std::cerr << "Error: Step type '" << info.typeName << "' is already registered." << std::endl;
+                return false;
+            }
+            const StepTypeInfo *stored = &inserted.first->second;
+            auto position = std::upper_bound(menuOrder.begin(), menuOrder.end(), stored, [](const StepTypeInfo *a, const StepTypeInfo *b){
+                return menuRank(a->menuKey) < menuRank(b->menuKey);
+            });
+            menuOrder.insert(position, stored);
+            return true;
+        }
+
+        const StepTypeInfo *find(const std::string &typeName) const{
+            auto it = stepTypes.find(typeName);
+            return it == stepTypes.end() ? nullptr : &it->second;
+        }
+
+        const StepTypeInfo *findByMenuKey(char menuKey) const{
+            for (const StepTypeInfo *info : menuOrder){
+                if (info->menuKey == menuKey){
+                    return info;
+                }
+            }
+            return nullptr;
+        }
+
+        // Default-configured step of the given type, or nullptr if the type is unknown.
+        FlowStep *create(const std::string &typeName) const{
+            const StepTypeInfo *info = find(typeName);
+            return info ? info->create() : nullptr;
+        }
+
+        const std::vector<const StepTypeInfo *> &getStepTypes() const {return menuOrder;}
+};
+
+template <typename Step>
+FlowStep *createDefaultStep(){
+    return new Step();
+}
+
+// Asks for the description the user wants to attach to the new step.
+template <typename Step>
+FlowStep *createStepWithDescription(){
+    std::string description;
+    std::cout << "Enter description for " << Step::TYPE_NAME << ": ";
+    std::cin.ignore();
+    std::getline(std::cin, description);
+    return new Step(description);
+}
+
+// Registers Step under Step::TYPE_NAME. Declare one at namespace scope next to the step class.
+template <typename Step>
+class StepRegistration{
+    public:
+        StepRegistration(char menuKey, const std::string &summary, FlowStep *(*create)() = createDefaultStep<Step>, FlowStep *(*createInteractive)() = nullptr){
+            StepRegistry::instance().registerStep({Step::TYPE_NAME, menuKey, summary, create, createInteractive ? createInteractive : create});
+        }
+};
+
+#endif
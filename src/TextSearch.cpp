@@ -0,0 +1,352 @@
+#include "TextSearch.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "FlowTrace.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+static const uint32_t NO_STATE = static_cast<uint32_t>(-1);
+// Texts are split into line-aligned chunks of at least this many bytes per job.
+static const size_t MIN_CHUNK_SIZE = 1024 * 1024;
+// Candidate lines checked per job when searching with an index.
+static const size_t CANDIDATES_PER_JOB = 16384;
+// Most start bytes compared per block by the SSE2 prefilter.
+static const size_t MAX_VECTOR_START_BYTES = 8;
+
+static unsigned char lowerByte(unsigned char c){
+    return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+vector<string> parseSearchPatterns(const string &text){
+    vector<string> patterns;
+    size_t start = 0;
+    while (start <= text.size()){
+        size_t bar = text.find('|', start);
+        string pattern = text.substr(start, bar == string::npos ? string::npos : bar - start);
+        start = bar == string::npos ? text.size() + 1 : bar + 1;
+        if (!pattern.empty()){
+            patterns.push_back(pattern);
+        }
+    }
+    return patterns;
+}
+
+MultiPatternMatcher::MultiPatternMatcher(const vector<string> &patterns, bool ignoreCase) : patternCount(patterns.size()){
+    transitions.assign(256, NO_STATE);
+    outputs.emplace_back();
+    for (size_t index = 0; index < patterns.size(); ++index){
+        if (patterns[index].empty() || patterns[index].find('\n') != string::npos){
+            throw invalid_argument("search patterns must not be empty or span lines");
+        }
+        uint32_t state = 0;
+        for (char byte : patterns[index]){
+            unsigned char c = ignoreCase ? lowerByte(byte) : static_cast<unsigned char>(byte);
+            uint32_t &next = transitions[static_cast<size_t>(state) * 256 + c];
+            if (next == NO_STATE){
+                next = static_cast<uint32_t>(outputs.size());
+                outputs.emplace_back();
+                transitions.resize(transitions.size() + 256, NO_STATE);
+            }
+            state = transitions[static_cast<size_t>(state) * 256 + c];
+        }
+        outputs[state].push_back(static_cast<uint32_t>(index));
+    }
+
+    // Breadth-first over the trie: missing edges follow the failure link, which is
+    // always a shallower state and so already complete.
+    vector<uint32_t> failure(outputs.size(), 0);
+    vector<uint32_t> queue;
+    for (size_t c = 0; c < 256; ++c){
+        uint32_t &next = transitions[c];
+        if (next == NO_STATE){
+            next = 0;
+        }
+        else{
+            queue.push_back(next);
+        }
+    }
+    for (size_t head = 0; head < queue.size(); ++head){
+        uint32_t state = queue[head];
+        const vector<uint32_t> &inherited = outputs[failure[state]];
+        outputs[state].insert(outputs[state].end(), inherited.begin(), inherited.end());
+        for (size_t c = 0; c < 256; ++c){
+            uint32_t &next = transitions[static_cast<size_t>(state) * 256 + c];
+            uint32_t fallback = transitions[static_cast<size_t>(failure[state]) * 256 + c];
+            if (next == NO_STATE){
+                next = fallback;
+            }
+            else{
+                failure[next] = fallback;
+                queue.push_back(next);
+            }
+        }
+    }
+
+    if (ignoreCase){
+        for (size_t state = 0; state < outputs.size(); ++state){
+            for (unsigned char c = 'A'; c <= 'Z'; ++c){
+                transitions[state * 256 + c] = transitions[state * 256 + lowerByte(c)];
+            }
+        }
+    }
+    for (size_t c = 0; c < 256; ++c){
+        if (transitions[c] != 0){
+            startByte[c] = true;
+            startBytes.push_back(static_cast<unsigned char>(c));
+        }
+    }
+}
+
+size_t MultiPatternMatcher::skipToStart(const unsigned char *data, size_t position, size_t size) const{
+    if (startBytes.empty()){
+        return size;
+    }
+    if (startBytes.size() == 1){
+        const void *found = memchr(data + position, startBytes[0], size - position);
+        return found ? static_cast<const unsigned char *>(found) - data : size;
+    }
+#if defined(__SSE2__)
+    if (startBytes.size() <= MAX_VECTOR_START_BYTES){
+        __m128i needles[MAX_VECTOR_START_BYTES];
+        for (size_t i = 0; i < startBytes.size(); ++i){
+            needles[i] = _mm_set1_epi8(static_cast<char>(startBytes[i]));
+        }
+        while (position + 16 <= size){
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + position));
+            __m128i any = _mm_cmpeq_epi8(block, needles[0]);
+            for (size_t i = 1; i < startBytes.size(); ++i){
+                any = _mm_or_si128(any, _mm_cmpeq_epi8(block, needles[i]));
+            }
+            int mask = _mm_movemask_epi8(any);
+            if (mask != 0){
+                return position + __builtin_ctz(mask);
+            }
+            position += 16;
+        }
+    }
+#endif
+    while (position < size && !startByte[data[position]]){
+        position++;
+    }
+    return position;
+}
+
+// Splits [0, size) into about count ranges that each end just after a newline.
+static vector<size_t> lineAlignedBounds(const string &text, size_t count){
+    vector<size_t> bounds(1, 0);
+    for (size_t i = 1; i < count; ++i){
+        size_t target = max(text.size() / count * i, bounds.back());
+        const void *newline = memchr(text.data() + target, '\n', text.size() - target);
+        if (newline == nullptr){
+            break;
+        }
+        size_t bound = static_cast<const char *>(newline) - text.data() + 1;
+        if (bound > bounds.back() && bound < text.size()){
+            bounds.push_back(bound);
+        }
+    }
+    bounds.push_back(text.size());
+    return bounds;
+}
+
+static size_t chunkCountFor(size_t size){
+    return max<size_t>(1, min(size / MIN_CHUNK_SIZE, computePool().getThreadCount() * 4));
+}
+
+static uint32_t trigramAt(const char *bytes){
+    return (static_cast<uint32_t>(lowerByte(bytes[0])) << 16) | (static_cast<uint32_t>(lowerByte(bytes[1])) << 8) | lowerByte(bytes[2]);
+}
+
+TrigramIndex::TrigramIndex(const string &text){
+    FLOW_TRACE_SCOPE("search", "build index", to_string(text.size()) + " bytes");
+    vector<size_t> bounds = lineAlignedBounds(text, chunkCountFor(text.size()));
+    size_t chunks = bounds.size() - 1;
+    vector<vector<size_t>> chunkStarts(chunks);
+    vector<unordered_map<uint32_t, vector<uint32_t>>> chunkPostings(chunks);
+    computePool().runBatch(chunks, [&](size_t chunk){
+        const char *data = text.data();
+        uint32_t line = 0;
+        size_t start = bounds[chunk];
+        while (start < bounds[chunk + 1]){
+            const char *newline = static_cast<const char *>(memchr(data + start, '\n', bounds[chunk + 1] - start));
+            size_t end = newline ? newline - data : bounds[chunk + 1];
+            chunkStarts[chunk].push_back(start);
+            for (size_t i = start; i + 3 <= end; ++i){
+                vector<uint32_t> &lines = chunkPostings[chunk][trigramAt(data + i)];
+                if (lines.empty() || lines.back() != line){
+                    lines.push_back(line);
+                }
+            }
+            line++;
+            start = end + 1;
+        }
+    });
+    for (size_t chunk = 0; chunk < chunks; ++chunk){
+        uint32_t firstLine = static_cast<uint32_t>(lineStarts.size());
+        lineStarts.insert(lineStarts.end(), chunkStarts[chunk].begin(), chunkStarts[chunk].end());
+        for (auto &entry : chunkPostings[chunk]){
+            vector<uint32_t> &lines = postings[entry.first];
+            for (uint32_t line : entry.second){
+                lines.push_back(firstLine + line);
+            }
+        }
+        chunkPostings[chunk].clear();
+    }
+    lineStarts.push_back(text.size());
+}
+
+bool TrigramIndex::findCandidates(const vector<string> &patterns, vector<uint32_t> &lines) const{
+    lines.clear();
+    for (const string &pattern : patterns){
+        if (pattern.size() < 3){
+            return false;
+        }
+    }
+    for (const string &pattern : patterns){
+        vector<const vector<uint32_t> *> lists;
+        bool missing = false;
+        for (size_t i = 0; i + 3 <= pattern.size() && !missing; ++i){
+            auto entry = postings.find(trigramAt(pattern.data() + i));
+            if (entry == postings.end()){
+                missing = true;
+            }
+            else{
+                lists.push_back(&entry->second);
+            }
+        }
+        if (missing){
+            continue;
+        }
+        sort(lists.begin(), lists.end(), [](const vector<uint32_t> *a, const vector<uint32_t> *b){
+            return a->size() < b->size();
+        });
+        vector<uint32_t> common = *lists[0];
+        vector<uint32_t> narrowed;
+        for (size_t i = 1; i < lists.size() && !common.empty(); ++i){
+            narrowed.clear();
+            set_intersection(common.begin(), common.end(), lists[i]->begin(), lists[i]->end(), back_inserter(narrowed));
+            common.swap(narrowed);
+        }
+        narrowed.clear();
+        set_union(lines.begin(), lines.end(), common.begin(), common.end(), back_inserter(narrowed));
+        lines.swap(narrowed);
+    }
+    return true;
+}
+
+// Hits and per-pattern line counts of one job, with line numbers relative to the
+// job's first line.
+struct ChunkHits{
+    vector<SearchHit> hits;
+    vector<uint64_t> patternLines;
+    size_t lineCount = 0;
+    string error;
+};
+
+// Records a match of pattern on line, counting each line once per pattern.
+static void recordMatch(ChunkHits &result, vector<size_t> &lastLine, uint32_t pattern, size_t line, size_t begin, size_t end){
+    if (result.hits.empty() || result.hits.back().line != line){
+        result.hits.push_back(SearchHit{line, begin, end});
+    }
+    if (lastLine[pattern] != line){
+        lastLine[pattern] = line;
+        result.patternLines[pattern]++;
+    }
+}
+
+static void scanChunk(const string &text, const MultiPatternMatcher &matcher, size_t begin, size_t end, ChunkHits &result){
+    const char *data = text.data();
+    vector<size_t> lastLine(matcher.getPatternCount(), static_cast<size_t>(-1));
+    size_t line = 0;
+    size_t lineStart = begin;
+    size_t lineEnd = begin;
+    matcher.scan(data + begin, end - begin, [&](uint32_t pattern, size_t matchEnd){
+        size_t position = begin + matchEnd - 1;
+        if (position >= lineEnd){
+            // Move to the line holding the match, counting the newlines passed.
+            while (const void *newline = memchr(data + lineStart, '\n', position - lineStart)){
+                lineStart = static_cast<const char *>(newline) - data + 1;
+                line++;
+            }
+            const void *newline = memchr(data + position, '\n', end - position);
+            lineEnd = newline ? static_cast<const char *>(newline) - data : end;
+        }
+        recordMatch(result, lastLine, pattern, line, lineStart, lineEnd);
+        return true;
+    });
+    result.lineCount = count(data + begin, data + end, '\n');
+}
+
+SearchResult searchText(const string &text, const MultiPatternMatcher &matcher, const vector<string> &patterns, const TrigramIndex *index){
+    SearchResult result;
+    result.patternLines.assign(matcher.getPatternCount(), 0);
+    vector<uint32_t> candidates;
+    result.usedIndex = index != nullptr && index->findCandidates(patterns, candidates);
+
+    size_t jobs;
+    vector<size_t> bounds;
+    if (result.usedIndex){
+        jobs = (candidates.size() + CANDIDATES_PER_JOB - 1) / CANDIDATES_PER_JOB;
+        result.linesChecked = candidates.size();
+    }
+    else{
+        bounds = lineAlignedBounds(text, chunkCountFor(text.size()));
+        jobs = bounds.size() - 1;
+    }
+    vector<ChunkHits> chunks(jobs);
+    {
+        FLOW_TRACE_SCOPE("search", result.usedIndex ? "check candidates" : "scan", to_string(jobs) + " jobs");
+        computePool().runBatch(jobs, [&](size_t job){
+            ChunkHits &chunk = chunks[job];
+            try{
+                chunk.patternLines.assign(matcher.getPatternCount(), 0);
+                if (!result.usedIndex){
+                    scanChunk(text, matcher, bounds[job], bounds[job + 1], chunk);
+                    return;
+                }
+                vector<size_t> lastLine(matcher.getPatternCount(), static_cast<size_t>(-1));
+                size_t last = min(candidates.size(), (job + 1) * CANDIDATES_PER_JOB);
+                for (size_t i = job * CANDIDATES_PER_JOB; i < last; ++i){
+                    size_t line = candidates[i];
+                    size_t begin = index->getLineStart(line);
+                    size_t end = index->getLineEnd(line);
+                    matcher.scan(text.data() + begin, end - begin, [&](uint32_t pattern, size_t){
+                        recordMatch(chunk, lastLine, pattern, line, begin, end);
+                        return true;
+                    });
+                }
+            }catch (const exception &e){
+                chunk.error = e.what();
+            }
+        });
+    }
+
+    size_t firstLine = 0;
+    for (ChunkHits &chunk : chunks){
+        if (!chunk.error.empty()){
+            throw runtime_error(chunk.error);
+        }
+        for (SearchHit &hit : chunk.hits){
+            if (!result.usedIndex){
+                hit.line += firstLine;
+            }
+            result.hits.push_back(hit);
+        }
+        for (size_t pattern = 0; pattern < chunk.patternLines.size(); ++pattern){
+            result.patternLines[pattern] += chunk.patternLines[pattern];
+        }
+        firstLine += chunk.lineCount;
+    }
+    if (!result.usedIndex){
+        result.linesChecked = firstLine;
+    }
+    return result;
+}
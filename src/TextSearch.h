@@ -0,0 +1,97 @@
+#ifndef FLOWMAKER_TEXT_SEARCH_H
+#define FLOWMAKER_TEXT_SEARCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Splits "ERROR|timed out|panic" into its patterns, dropping empty ones.
+std::vector<std::string> parseSearchPatterns(const std::string &text);
+
+// Finds any of a set of byte patterns in one pass: an Aho-Corasick automaton
+// compiled to a full transition table. While no pattern is partially matched the
+// scan skips ahead to the next byte that can start one, with memchr for a single
+// start byte and 16 bytes at a time with SSE2 for up to eight.
+class MultiPatternMatcher{
+    private:
+        std::vector<uint32_t> transitions;
+        // Patterns ending at each state, longest first.
+        std::vector<std::vector<uint32_t>> outputs;
+        size_t patternCount;
+        bool startByte[256] = {};
+        std::vector<unsigned char> startBytes;
+
+        size_t skipToStart(const unsigned char *data, size_t position, size_t size) const;
+    public:
+        // Patterns must not be empty or contain a newline.
+        MultiPatternMatcher(const std::vector<std::string> &patterns, bool ignoreCase);
+
+        size_t getPatternCount() const {return patternCount;}
+
+        // Calls found(pattern, end) for every match in data, where end is the offset
+        // just past the match; returning false from found stops the scan.
+        template <typename Visitor>
+        void scan(const char *text, size_t size, Visitor found) const{
+            const unsigned char *data = reinterpret_cast<const unsigned char *>(text);
+            uint32_t state = 0;
+            size_t position = 0;
+            while (position < size){
+                if (state == 0){
+                    position = skipToStart(data, position, size);
+                    if (position >= size){
+                        return;
+                    }
+                }
+                state = transitions[static_cast<size_t>(state) * 256 + data[position++]];
+                for (uint32_t pattern : outputs[state]){
+                    if (!found(pattern, position)){
+                        return;
+                    }
+                }
+            }
+        }
+};
+
+// Inverted index from the lowercased byte trigrams of a text to the lines holding
+// them, so that a pattern of three or more bytes only needs to be checked on the
+// lines that contain all of its trigrams.
+class TrigramIndex{
+    private:
+        std::vector<size_t> lineStarts;
+        std::unordered_map<uint32_t, std::vector<uint32_t>> postings;
+    public:
+        // Indexes the lines of text in parallel; text must end with a newline.
+        explicit TrigramIndex(const std::string &text);
+
+        size_t getLineCount() const {return lineStarts.size() - 1;}
+        size_t getLineStart(size_t line) const {return lineStarts[line];}
+        size_t getLineEnd(size_t line) const {return lineStarts[line + 1] - 1;}
+        // Sorted lines that may contain any of the patterns. Returns false if one of
+        // them is too short to be looked up, in which case the text must be scanned.
+        bool findCandidates(const std::vector<std::string> &patterns, std::vector<uint32_t> &lines) const;
+};
+
+struct SearchHit{
+    // 0-based line number and the line's bytes in the text, without the newline.
+    size_t line;
+    size_t begin;
+    size_t end;
+};
+
+struct SearchResult{
+    std::vector<SearchHit> hits;
+    // Lines matching each pattern.
+    std::vector<uint64_t> patternLines;
+    bool usedIndex = false;
+    // Lines the matcher looked at: all of them for a scan, the candidates otherwise.
+    uint64_t linesChecked = 0;
+};
+
+// Finds the lines of text (which must end with a newline) that contain any pattern
+// of matcher, in line order. With an index the candidate lines are checked instead
+// of the whole text when every pattern is long enough.
+SearchResult searchText(const std::string &text, const MultiPatternMatcher &matcher, const std::vector<std::string> &patterns, const TrigramIndex *index);
+
+#endif
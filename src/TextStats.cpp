@@ -0,0 +1,171 @@
+#include "TextStats.h"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+#include "FlowTrace.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+// Texts below this many bytes per thread are counted in fewer chunks.
+static const size_t MIN_CHUNK_SIZE = 1024 * 1024;
+
+static const uint8_t SPACE_BYTE = 1;
+static const uint8_t TOKEN_BYTE = 2;
+
+static const array<uint8_t, 256> byteClasses = []{
+    array<uint8_t, 256> classes{};
+    for (unsigned char c : string(" \t\n\v\f\r")){
+        classes[c] = SPACE_BYTE;
+    }
+    for (size_t c = 0; c < 256; ++c){
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c >= 0x80){
+            classes[c] = TOKEN_BYTE;
+        }
+    }
+    return classes;
+}();
+
+// Lets the token tables be searched with a string_view without building a string.
+struct TokenHash{
+    using is_transparent = void;
+    size_t operator()(string_view token) const {return hash<string_view>()(token);}
+};
+
+typedef unordered_map<string, uint64_t, TokenHash, equal_to<>> TokenTable;
+
+struct ChunkStats{
+    uint64_t lines = 0;
+    uint64_t words = 0;
+    uint64_t tokens = 0;
+    TokenTable table;
+    string error;
+};
+
+static void countChunk(const char *data, size_t size, bool ignoreCase, ChunkStats &stats){
+    string folded;
+    auto addToken = [&](const char *token, size_t length){
+        string_view view(token, length);
+        if (ignoreCase){
+            folded.assign(token, length);
+            for (char &c : folded){
+                if (c >= 'A' && c <= 'Z'){
+                    c += 'a' - 'A';
+                }
+            }
+            view = folded;
+        }
+        auto entry = stats.table.find(view);
+        if (entry != stats.table.end()){
+            entry->second++;
+        }
+        else{
+            stats.table.emplace(string(view), 1);
+        }
+        stats.tokens++;
+    };
+
+    bool inWord = false;
+    size_t tokenStart = 0;
+    bool inToken = false;
+    for (size_t i = 0; i < size; ++i){
+        uint8_t byteClass = byteClasses[static_cast<unsigned char>(data[i])];
+        if (data[i] == '\n'){
+            stats.lines++;
+        }
+        bool space = byteClass == SPACE_BYTE;
+        if (!space && !inWord){
+            stats.words++;
+        }
+        inWord = !space;
+        if (byteClass == TOKEN_BYTE){
+            if (!inToken){
+                tokenStart = i;
+                inToken = true;
+            }
+        }
+        else if (inToken){
+            addToken(data + tokenStart, i - tokenStart);
+            inToken = false;
+        }
+    }
+    if (inToken){
+        addToken(data + tokenStart, size - tokenStart);
+    }
+}
+
+TextStats computeTextStats(const string &text, size_t topCount, bool ignoreCase){
+    TextStats result;
+    result.bytes = text.size();
+
+    // Chunks end at whitespace, so no word or token is split between two of them.
+    size_t chunkCount = max<size_t>(1, min(text.size() / MIN_CHUNK_SIZE, computePool().getThreadCount()));
+    vector<size_t> bounds(1, 0);
+    for (size_t i = 1; i < chunkCount; ++i){
+        size_t bound = max(text.size() / chunkCount * i, bounds.back());
+        while (bound < text.size() && byteClasses[static_cast<unsigned char>(text[bound])] != SPACE_BYTE){
+            bound++;
+        }
+        if (bound > bounds.back() && bound < text.size()){
+            bounds.push_back(bound);
+        }
+    }
+    bounds.push_back(text.size());
+
+    vector<ChunkStats> chunks(bounds.size() - 1);
+    {
+        FLOW_TRACE_SCOPE("stats", "count chunks", to_string(chunks.size()) + " chunks");
+        computePool().runBatch(chunks.size(), [&](size_t chunk){
+            try{
+                countChunk(text.data() + bounds[chunk], bounds[chunk + 1] - bounds[chunk], ignoreCase, chunks[chunk]);
+            }catch (const exception &e){
+                chunks[chunk].error = e.what();
+            }
+        });
+    }
+
+    FLOW_TRACE_SCOPE("stats", "merge tables", to_string(chunks.size()) + " tables");
+    for (const ChunkStats &chunk : chunks){
+        if (!chunk.error.empty()){
+            throw runtime_error(chunk.error);
+        }
+    }
+    // The largest table absorbs the others.
+    auto largest = max_element(chunks.begin(), chunks.end(), [](const ChunkStats &a, const ChunkStats &b){
+        return a.table.size() < b.table.size();
+    });
+    TokenTable merged = move(largest->table);
+    largest->table.clear();
+    for (ChunkStats &chunk : chunks){
+        result.lines += chunk.lines;
+        result.words += chunk.words;
+        result.tokens += chunk.tokens;
+        for (const auto &entry : chunk.table){
+            merged[entry.first] += entry.second;
+        }
+        chunk.table.clear();
+    }
+    result.distinctTokens = merged.size();
+
+    vector<const TokenTable::value_type *> entries;
+    entries.reserve(merged.size());
+    for (const auto &entry : merged){
+        entries.push_back(&entry);
+    }
+    size_t shown = min(topCount, entries.size());
+    partial_sort(entries.begin(), entries.begin() + shown, entries.end(), [](const TokenTable::value_type *a, const TokenTable::value_type *b){
+        if (a->second != b->second){
+            return a->second > b->second;
+        }
+        return a->first < b->first;
+    });
+    for (size_t i = 0; i < shown; ++i){
+        result.topTokens.push_back(TokenCount{entries[i]->first, entries[i]->second});
+    }
+    return result;
+}
@@ -0,0 +1,32 @@
+#ifndef FLOWMAKER_TEXT_STATS_H
+#define FLOWMAKER_TEXT_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct TokenCount{
+    std::string token;
+    uint64_t count;
+};
+
+// Counts of a text. Lines and words follow wc: newlines, and runs of bytes other
+// than ASCII whitespace. Tokens are runs of ASCII letters, digits and '_', and
+// bytes of 0x80 and above so that UTF-8 words stay whole.
+struct TextStats{
+    uint64_t lines = 0;
+    uint64_t words = 0;
+    uint64_t bytes = 0;
+    uint64_t tokens = 0;
+    uint64_t distinctTokens = 0;
+    // Most frequent tokens, most frequent first and ties in byte order.
+    std::vector<TokenCount> topTokens;
+};
+
+// Counts text as a map-reduce: the text is split at whitespace into one chunk per
+// pool thread, each chunk is counted into its own token table, and the tables are
+// merged at the end. With ignoreCase tokens are counted in ASCII lowercase.
+TextStats computeTextStats(const std::string &text, size_t topCount, bool ignoreCase);
+
+#endif
@@ -0,0 +1,124 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+using namespace std;
+
+// The pool whose job the current thread is running, if any.
+static thread_local const ThreadPool *currentPool = nullptr;
+
+static atomic<size_t> computeThreadCount(0);
+
+ThreadPool &computePool(){
+    static ThreadPool pool(computeThreadCount);
+    return pool;
+}
+
+void setComputeThreadCount(size_t threadCount){
+    computeThreadCount = threadCount;
+}
+
+ThreadPool::ThreadPool(size_t threadCount){
+    if (threadCount == 0){
+        threadCount = max(1u, thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < threadCount; ++i){
+        workers.emplace_back([this](){workerLoop();});
+    }
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    jobReady.notify_all();
+    for (thread &worker : workers){
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(function<void()> job){
+    {
+        lock_guard<mutex> guard(lock);
+        jobs.push_back(move(job));
+    }
+    jobReady.notify_one();
+}
+
+void ThreadPool::runBatch(size_t count, const function<void(size_t)> &job){
+    // Waiting here on a pool thread could leave every thread waiting on jobs that
+    // none is free to run.
+    if (currentPool == this){
+        exception_ptr firstError;
+        for (size_t i = 0; i < count; ++i){
+            try{
+                job(i);
+            }catch (...){
+                if (!firstError){
+                    firstError = current_exception();
+                }
+            }
+        }
+        if (firstError){
+            rethrow_exception(firstError);
+        }
+        return;
+    }
+    mutex batchLock;
+    condition_variable batchDone;
+    size_t remaining = count;
+    exception_ptr firstError;
+    for (size_t i = 0; i < count; ++i){
+        submit([&, i](){
+            exception_ptr error;
+            try{
+                job(i);
+            }catch (...){
+                error = current_exception();
+            }
+            lock_guard<mutex> guard(batchLock);
+            if (error && !firstError){
+                firstError = error;
+            }
+            if (--remaining == 0){
+                batchDone.notify_one();
+            }
+        });
+    }
+    {
+        unique_lock<mutex> guard(batchLock);
+        batchDone.wait(guard, [&](){return remaining == 0;});
+    }
+    if (firstError){
+        rethrow_exception(firstError);
+    }
+}
+
+void ThreadPool::waitIdle(){
+    unique_lock<mutex> guard(lock);
+    idle.wait(guard, [this](){return jobs.empty() && activeJobs == 0;});
+}
+
+void ThreadPool::workerLoop(){
+    currentPool = this;
+    unique_lock<mutex> guard(lock);
+    while (true){
+        jobReady.wait(guard, [this](){return stopping || !jobs.empty();});
+        if (jobs.empty()){
+            return;
+        }
+        function<void()> job = move(jobs.front());
+        jobs.pop_front();
+        activeJobs++;
+        guard.unlock();
+        job();
+        guard.lock();
+        activeJobs--;
+        if (jobs.empty() && activeJobs == 0){
+            idle.notify_all();
+        }
+    }
+}
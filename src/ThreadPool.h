@@ -0,0 +1,52 @@
+#ifndef FLOWMAKER_THREAD_POOL_H
+#define FLOWMAKER_THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads running submitted jobs in FIFO order.
+class ThreadPool{
+    private:
+        std::vector<std::thread> workers;
+        std::deque<std::function<void()>> jobs;
+        std::mutex lock;
+        std::condition_variable jobReady;
+        std::condition_variable idle;
+        size_t activeJobs = 0;
+        bool stopping = false;
+
+        void workerLoop();
+    public:
+        // 0 threads means one per hardware thread.
+        explicit ThreadPool(size_t threadCount = 0);
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+        // Runs the jobs still queued, then joins the workers.
+        ~ThreadPool();
+
+        // The job must not throw: as on a plain std::thread, an exception escaping it
+        // ends the process.
+        void submit(std::function<void()> job);
+        // Runs job(0) ... job(count - 1) on the pool and waits until all of them have
+        // returned. If any of them threw, the first exception is rethrown here once the
+        // others are done. Called from one of the pool's own threads, as by a job of
+        // another batch, the jobs run one after another on that thread.
+        void runBatch(size_t count, const std::function<void(size_t)> &job);
+        // Blocks until no job is queued or running.
+        void waitIdle();
+        size_t getThreadCount() const {return workers.size();}
+};
+
+// The pool that sort, join, search, the multi-file and compressed imports and the
+// statistics steps split their work over. It is created on first use with the count
+// of setComputeThreadCount(), or one thread per hardware thread.
+ThreadPool &computePool();
+// FlowMaker sets it from --workers; it has no effect once the pool exists.
+void setComputeThreadCount(size_t threadCount);
+
+#endif
@@ -0,0 +1,527 @@
+#include "XLSXReader.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+// Size of the reads from a decompressing entry reader.
+static const size_t XML_CHUNK_SIZE = 64 * 1024;
+
+// Appends the UTF-8 encoding of a code point.
+static void appendUTF8(string &out, unsigned long codePoint){
+    if (codePoint < 0x80){
+        out += static_cast<char>(codePoint);
+    }
+    else if (codePoint < 0x800){
+        out += static_cast<char>(0xc0 | codePoint >> 6);
+        out += static_cast<char>(0x80 | (codePoint & 0x3f));
+    }
+    else if (codePoint < 0x10000){
+        out += static_cast<char>(0xe0 | codePoint >> 12);
+        out += static_cast<char>(0x80 | (codePoint >> 6 & 0x3f));
+        out += static_cast<char>(0x80 | (codePoint & 0x3f));
+    }
+    else{
+        out += static_cast<char>(0xf0 | codePoint >> 18);
+        out += static_cast<char>(0x80 | (codePoint >> 12 & 0x3f));
+        out += static_cast<char>(0x80 | (codePoint >> 6 & 0x3f));
+        out += static_cast<char>(0x80 | (codePoint & 0x3f));
+    }
+}
+
+string decodeXMLText(const string &raw){
+    size_t ampersand = raw.find('&');
+    if (ampersand == string::npos){
+        return raw;
+    }
+    string decoded(raw, 0, ampersand);
+    size_t position = ampersand;
+    while (position < raw.size()){
+        char c = raw[position];
+        size_t semicolon = c == '&' ? raw.find(';', position) : string::npos;
+        if (semicolon == string::npos){
+            decoded += c;
+            position++;
+            continue;
+        }
+        string entity = raw.substr(position + 1, semicolon - position - 1);
+        if (entity == "lt"){
+            decoded += '<';
+        }
+        else if (entity == "gt"){
+            decoded += '>';
+        }
+        else if (entity == "amp"){
+            decoded += '&';
+        }
+        else if (entity == "quot"){
+            decoded += '"';
+        }
+        else if (entity == "apos"){
+            decoded += '\'';
+        }
+        else if (entity.size() > 1 && entity[0] == '#'){
+            bool hex = entity[1] == 'x' || entity[1] == 'X';
+            char *end = nullptr;
+            unsigned long codePoint = strtoul(entity.c_str() + (hex ? 2 : 1), &end, hex ? 16 : 10);
+            if (*end != '\0' || codePoint > 0x10ffff){
+                decoded.append(raw, position, semicolon - position + 1);
+            }
+            else{
+                appendUTF8(decoded, codePoint);
+            }
+        }
+        else{
+            decoded.append(raw, position, semicolon - position + 1);
+        }
+        position = semicolon + 1;
+    }
+    return decoded;
+}
+
+// Spreadsheet strings escape characters XML cannot carry as "_xHHHH_".
+static string decodeSpreadsheetEscapes(const string &text){
+    size_t escape = text.find("_x");
+    if (escape == string::npos){
+        return text;
+    }
+    string decoded(text, 0, escape);
+    size_t position = escape;
+    while (position < text.size()){
+        if (text.compare(position, 2, "_x") == 0 && position + 7 <= text.size() && text[position + 6] == '_'){
+            string digits = text.substr(position + 2, 4);
+            char *end = nullptr;
+            unsigned long codePoint = strtoul(digits.c_str(), &end, 16);
+            if (*end == '\0'){
+                appendUTF8(decoded, codePoint);
+                position += 7;
+                continue;
+            }
+        }
+        decoded += text[position];
+        position++;
+    }
+    return decoded;
+}
+
+static string localName(const string &qualifiedName){
+    size_t colon = qualifiedName.find(':');
+    return colon == string::npos ? qualifiedName : qualifiedName.substr(colon + 1);
+}
+
+bool XMLPullReader::fill(){
+    if (endOfInput){
+        return false;
+    }
+    buffer.erase(0, position);
+    position = 0;
+    size_t oldSize = buffer.size();
+    buffer.resize(oldSize + XML_CHUNK_SIZE);
+    size_t count = source->read(&buffer[oldSize], XML_CHUNK_SIZE);
+    buffer.resize(oldSize + count);
+    bytesRead += count;
+    endOfInput = count == 0;
+    return count > 0;
+}
+
+size_t XMLPullReader::find(const char *terminator){
+    size_t searched = 0;
+    size_t length = strlen(terminator);
+    while (true){
+        size_t found = buffer.find(terminator, position + searched);
+        if (found != string::npos){
+            return found - position;
+        }
+        // A terminator may straddle the end of what was read so far.
+        size_t available = buffer.size() - position;
+        searched = available >= length ? available - length + 1 : 0;
+        if (!fill()){
+            return string::npos;
+        }
+    }
+}
+
+// Like find(">"), but skips '>' inside quoted attribute values.
+size_t XMLPullReader::findTagEnd(){
+    size_t offset = 1;
+    char quote = 0;
+    while (true){
+        while (position + offset < buffer.size()){
+            char c = buffer[position + offset];
+            if (quote){
+                if (c == quote){
+                    quote = 0;
+                }
+            }
+            else if (c == '"' || c == '\''){
+                quote = c;
+            }
+            else if (c == '>'){
+                return offset;
+            }
+            offset++;
+        }
+        if (!fill()){
+            return string::npos;
+        }
+    }
+}
+
+XMLPullReader::Event XMLPullReader::next(){
+    if (pendingEnd){
+        pendingEnd = false;
+        return EndElement;
+    }
+    while (true){
+        if (position >= buffer.size() && !fill()){
+            return EndOfDocument;
+        }
+
+        if (buffer[position] != '<'){
+            size_t length = find("<");
+            if (length == string::npos){
+                length = buffer.size() - position;
+            }
+            text = decodeXMLText(buffer.substr(position, length));
+            position += length;
+            return Text;
+        }
+
+        // Markup: make sure enough is buffered to tell its kind apart.
+        while (buffer.size() - position < 9 && fill()){
+        }
+        if (buffer.compare(position, 4, "<!--") == 0){
+            size_t length = find("-->");
+            if (length == string::npos){
+                throw runtime_error("unterminated XML comment");
+            }
+            position += length + 3;
+            continue;
+        }
+        if (buffer.compare(position, 9, "<![CDATA[") == 0){
+            size_t length = find("]]>");
+            if (length == string::npos){
+                throw runtime_error("unterminated XML CDATA section");
+            }
+            text = buffer.substr(position + 9, length - 9);
+            position += length + 3;
+            return Text;
+        }
+        if (buffer.compare(position, 2, "<?") == 0 || buffer.compare(position, 2, "<!") == 0){
+            size_t length = findTagEnd();
+            if (length == string::npos){
+                throw runtime_error("unterminated XML declaration");
+            }
+            position += length + 1;
+            continue;
+        }
+
+        size_t length = findTagEnd();
+        if (length == string::npos){
+            throw runtime_error("unterminated XML tag");
+        }
+        tag.assign(buffer, position + 1, length - 1);
+        position += length + 1;
+
+        bool closing = !tag.empty() && tag[0] == '/';
+        bool empty = !closing && !tag.empty() && tag.back() == '/';
+        size_t nameStart = closing ? 1 : 0;
+        size_t nameEnd = tag.find_first_of(" \t\r\n/", nameStart);
+        if (nameEnd == string::npos){
+            nameEnd = tag.size();
+        }
+        name = localName(tag.substr(nameStart, nameEnd - nameStart));
+        if (name.empty()){
+            throw runtime_error("malformed XML tag");
+        }
+        if (closing){
+            return EndElement;
+        }
+        pendingEnd = empty;
+        return StartElement;
+    }
+}
+
+bool XMLPullReader::getAttribute(const char *attributeName, string &value) const{
+    size_t position = tag.find_first_of(" \t\r\n");
+    while (position != string::npos && position < tag.size()){
+        position = tag.find_first_not_of(" \t\r\n/", position);
+        if (position == string::npos){
+            return false;
+        }
+        size_t equals = tag.find('=', position);
+        if (equals == string::npos){
+            return false;
+        }
+        size_t nameEnd = tag.find_last_not_of(" \t\r\n", equals - 1);
+        string attribute = localName(tag.substr(position, nameEnd + 1 - position));
+        size_t quoteStart = tag.find_first_of("\"'", equals);
+        if (quoteStart == string::npos){
+            return false;
+        }
+        size_t quoteEnd = tag.find(tag[quoteStart], quoteStart + 1);
+        if (quoteEnd == string::npos){
+            return false;
+        }
+        if (attribute == attributeName){
+            value = decodeXMLText(tag.substr(quoteStart + 1, quoteEnd - quoteStart - 1));
+            return true;
+        }
+        position = quoteEnd + 1;
+    }
+    return false;
+}
+
+// Resolves a relationship target of the workbook part to an archive entry name.
+static string workbookPartName(const string &target){
+    if (!target.empty() && target[0] == '/'){
+        return target.substr(1);
+    }
+    return "xl/" + target;
+}
+
+static bool endsWith(const string &text, const string &suffix){
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Zero-based column of a cell reference such as "AB12", or -1 without one.
+static long columnIndex(const string &reference){
+    long column = 0;
+    size_t i = 0;
+    while (i < reference.size() && reference[i] >= 'A' && reference[i] <= 'Z'){
+        column = column * 26 + (reference[i] - 'A' + 1);
+        i++;
+    }
+    return i == 0 ? -1 : column - 1;
+}
+
+XLSXSheetReader::XLSXSheetReader(const string &fileName, const string &requestedSheet) : archive(new ZipArchive(fileName)){
+    // The workbook lists the sheets in tab order and points to their parts through
+    // its relationships, which also name the shared strings part.
+    vector<string> sheetRelations;
+    if (const ZipEntry *workbook = archive->find("xl/workbook.xml")){
+        XMLPullReader reader(archive->open(*workbook));
+        for (XMLPullReader::Event event = reader.next(); event != XMLPullReader::EndOfDocument; event = reader.next()){
+            string name, relation;
+            if (event == XMLPullReader::StartElement && reader.getName() == "sheet" && reader.getAttribute("name", name) && reader.getAttribute("id", relation)){
+                sheetNames.push_back(name);
+                sheetRelations.push_back(relation);
+            }
+        }
+    }
+    vector<string> sheetParts(sheetNames.size());
+    string sharedStringsPart;
+    if (const ZipEntry *relations = archive->find("xl/_rels/workbook.xml.rels")){
+        XMLPullReader reader(archive->open(*relations));
+        for (XMLPullReader::Event event = reader.next(); event != XMLPullReader::EndOfDocument; event = reader.next()){
+            string id, type, target;
+            if (event != XMLPullReader::StartElement || reader.getName() != "Relationship" || !reader.getAttribute("Id", id) || !reader.getAttribute("Target", target)){
+                continue;
+            }
+            reader.getAttribute("Type", type);
+            if (endsWith(type, "/sharedStrings")){
+                sharedStringsPart = workbookPartName(target);
+            }
+            for (size_t i = 0; i < sheetRelations.size(); ++i){
+                if (sheetRelations[i] == id){
+                    sheetParts[i] = workbookPartName(target);
+                }
+            }
+        }
+    }
+    if (sheetNames.empty()){
+        if (archive->find("xl/worksheets/sheet1.xml") == nullptr){
+            throw runtime_error("not an XLSX workbook");
+        }
+        sheetNames.push_back("Sheet1");
+        sheetParts.push_back("xl/worksheets/sheet1.xml");
+    }
+    if (sharedStringsPart.empty() && archive->find("xl/sharedStrings.xml")){
+        sharedStringsPart = "xl/sharedStrings.xml";
+    }
+
+    size_t chosen = sheetNames.size();
+    if (requestedSheet.empty()){
+        chosen = 0;
+    }
+    for (size_t i = 0; i < sheetNames.size() && chosen == sheetNames.size(); ++i){
+        if (sheetNames[i] == requestedSheet){
+            chosen = i;
+        }
+    }
+    if (chosen == sheetNames.size() && requestedSheet.find_first_not_of("0123456789") == string::npos){
+        unsigned long number = strtoul(requestedSheet.c_str(), nullptr, 10);
+        if (number >= 1 && number <= sheetNames.size()){
+            chosen = number - 1;
+        }
+    }
+    if (chosen == sheetNames.size()){
+        throw runtime_error("the workbook has no sheet '" + requestedSheet + "'");
+    }
+    sheetName = sheetNames[chosen];
+    const ZipEntry *part = archive->find(sheetParts[chosen]);
+    if (part == nullptr){
+        throw runtime_error("the data of sheet '" + sheetName + "' is missing");
+    }
+
+    if (!sharedStringsPart.empty()){
+        loadSharedStrings(sharedStringsPart);
+    }
+    sheet.reset(new XMLPullReader(archive->open(*part)));
+}
+
+// Each <si> is one string: plain <t> text, or the <t> runs of rich text. Phonetic
+// hints (<rPh>) are not part of the value.
+void XLSXSheetReader::loadSharedStrings(const string &entryName){
+    const ZipEntry *entry = archive->find(entryName);
+    if (entry == nullptr){
+        return;
+    }
+    XMLPullReader reader(archive->open(*entry));
+    string current;
+    bool inText = false;
+    int phoneticDepth = 0;
+    for (XMLPullReader::Event event = reader.next(); event != XMLPullReader::EndOfDocument; event = reader.next()){
+        const string &name = reader.getName();
+        if (event == XMLPullReader::StartElement){
+            if (name == "si"){
+                current.clear();
+            }
+            else if (name == "rPh"){
+                phoneticDepth++;
+            }
+            else if (name == "t"){
+                inText = phoneticDepth == 0;
+            }
+        }
+        else if (event == XMLPullReader::EndElement){
+            if (name == "si"){
+                sharedStrings.push_back(decodeSpreadsheetEscapes(current));
+            }
+            else if (name == "rPh"){
+                phoneticDepth--;
+            }
+            else if (name == "t"){
+                inText = false;
+            }
+        }
+        else if (event == XMLPullReader::Text && inText){
+            current += reader.getText();
+        }
+    }
+}
+
+void XLSXSheetReader::readRow(uint64_t rowNumber){
+    heldRow.clear();
+    rowHeld = true;
+    string value, type, reference;
+    long column = -1;
+    bool inValue = false;
+    bool inInlineString = false;
+    while (true){
+        XMLPullReader::Event event = sheet->next();
+        if (event == XMLPullReader::EndOfDocument){
+            throw runtime_error("sheet data ends inside row " + to_string(rowNumber));
+        }
+        const string &name = sheet->getName();
+        if (event == XMLPullReader::StartElement){
+            if (name == "c"){
+                value.clear();
+                type = "n";
+                sheet->getAttribute("t", type);
+                column = sheet->getAttribute("r", reference) ? columnIndex(reference) : -1;
+            }
+            else if (name == "v"){
+                inValue = true;
+            }
+            else if (name == "is"){
+                inInlineString = true;
+            }
+            else if (name == "t" && inInlineString){
+                inValue = true;
+            }
+        }
+        else if (event == XMLPullReader::EndElement){
+            if (name == "row"){
+                return;
+            }
+            if (name == "v" || name == "t"){
+                inValue = false;
+            }
+            else if (name == "is"){
+                inInlineString = false;
+            }
+            else if (name == "c"){
+                if (type == "s"){
+                    char *end = nullptr;
+                    unsigned long index = strtoul(value.c_str(), &end, 10);
+                    if (value.empty() || *end != '\0' || index >= sharedStrings.size()){
+                        throw runtime_error("cell refers to a missing shared string");
+                    }
+                    value = sharedStrings[index];
+                }
+                else if (type == "b"){
+                    value = value == "1" ? "TRUE" : "FALSE";
+                }
+                else if (type == "inlineStr" || type == "str"){
+                    value = decodeSpreadsheetEscapes(value);
+                }
+                size_t index = column < 0 ? heldRow.size() : static_cast<size_t>(column);
+                if (index >= heldRow.size()){
+                    heldRow.resize(index + 1);
+                }
+                heldRow[index] = move(value);
+                value.clear();
+            }
+        }
+        else if (event == XMLPullReader::Text && inValue){
+            value += sheet->getText();
+        }
+    }
+}
+
+bool XLSXSheetReader::nextRow(vector<string> &row){
+    while (true){
+        if (emptyRowsBefore > 0){
+            emptyRowsBefore--;
+            row.clear();
+            return true;
+        }
+        if (rowHeld){
+            row.swap(heldRow);
+            rowHeld = false;
+            return true;
+        }
+        if (finished){
+            return false;
+        }
+
+        XMLPullReader::Event event = sheet->next();
+        if (event == XMLPullReader::EndOfDocument){
+            finished = true;
+        }
+        else if (event == XMLPullReader::EndElement && sheet->getName() == "sheetData"){
+            // The rest of the part is read too, so that its checksum is verified.
+            while (sheet->next() != XMLPullReader::EndOfDocument){
+            }
+            finished = true;
+        }
+        else if (event == XMLPullReader::StartElement && sheet->getName() == "row"){
+            // Rows without cells are left out of the sheet; their numbers keep the
+            // rows that follow in place.
+            string reference;
+            uint64_t rowNumber = nextRowNumber;
+            if (sheet->getAttribute("r", reference)){
+                rowNumber = strtoull(reference.c_str(), nullptr, 10);
+                if (rowNumber < nextRowNumber){
+                    throw runtime_error("sheet rows are out of order at row " + reference);
+                }
+            }
+            emptyRowsBefore = rowNumber - nextRowNumber;
+            nextRowNumber = rowNumber + 1;
+            readRow(rowNumber);
+        }
+    }
+}
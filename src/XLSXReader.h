@@ -0,0 +1,94 @@
+#ifndef FLOWMAKER_XLSX_READER_H
+#define FLOWMAKER_XLSX_READER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "InputSource.h"
+#include "ZipArchive.h"
+
+// Minimal pull parser for the XML inside spreadsheet files. It reads its input in
+// chunks, so only the current element and text are held in memory. Names are
+// reported without their namespace prefix; DTDs and processing instructions are
+// skipped and CDATA sections are reported as text.
+class XMLPullReader{
+    public:
+        enum Event{
+            StartElement,
+            EndElement,
+            Text,
+            EndOfDocument
+        };
+    private:
+        std::unique_ptr<InputSource> source;
+        std::string buffer;
+        size_t position = 0;
+        bool endOfInput = false;
+        uint64_t bytesRead = 0;
+        std::string name;
+        std::string tag;
+        std::string text;
+        bool pendingEnd = false;
+
+        bool fill();
+        // Offset from position of the first byte of terminator, reading more input
+        // as needed. npos if the input ends first.
+        size_t find(const char *terminator);
+        size_t findTagEnd();
+    public:
+        explicit XMLPullReader(std::unique_ptr<InputSource> source) : source(std::move(source)) {}
+
+        // Throws runtime_error for malformed XML or unreadable input.
+        Event next();
+        // Local name of the element of the last StartElement or EndElement.
+        const std::string &getName() const {return name;}
+        // Decoded text of the last Text event.
+        const std::string &getText() const {return text;}
+        // Decoded value of an attribute of the last StartElement, matched by its local
+        // name. Returns false if the element has no such attribute.
+        bool getAttribute(const char *localName, std::string &value) const;
+        uint64_t getBytesRead() const {return bytesRead;}
+};
+
+// Replaces the five predefined XML entities and character references.
+std::string decodeXMLText(const std::string &raw);
+
+// Streams the rows of one worksheet of an XLSX workbook. The archive entries are
+// inflated and parsed as they are read: only the shared strings table and the
+// current row are held in memory, so sheets of any length can be imported. Cells
+// are placed by their column reference, missing cells and rows become empty, and
+// numbers and dates are returned as stored (dates as serial numbers).
+class XLSXSheetReader{
+    private:
+        std::unique_ptr<ZipArchive> archive;
+        std::vector<std::string> sheetNames;
+        std::string sheetName;
+        std::vector<std::string> sharedStrings;
+        std::unique_ptr<XMLPullReader> sheet;
+        std::vector<std::string> heldRow;
+        bool rowHeld = false;
+        uint64_t nextRowNumber = 1;
+        uint64_t emptyRowsBefore = 0;
+        bool finished = false;
+
+        void loadSharedStrings(const std::string &entryName);
+        void readRow(uint64_t rowNumber);
+    public:
+        // Opens the sheet with the given name, or the given 1-based position, or the
+        // first sheet if sheet is empty. Throws runtime_error if the file is not a
+        // workbook, has no such sheet or cannot be read.
+        XLSXSheetReader(const std::string &fileName, const std::string &sheet = "");
+
+        // Replaces row with the next row of the sheet. Returns false after the last
+        // one; throws runtime_error if the sheet data is corrupt.
+        bool nextRow(std::vector<std::string> &row);
+
+        const std::vector<std::string> &getSheetNames() const {return sheetNames;}
+        const std::string &getSheetName() const {return sheetName;}
+        // Uncompressed bytes of sheet XML parsed so far.
+        uint64_t getBytesRead() const {return sheet ? sheet->getBytesRead() : 0;}
+};
+
+#endif
@@ -0,0 +1,358 @@
+#include "ZipArchive.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if FLOWMAKER_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+using namespace std;
+
+static const uint32_t LOCAL_HEADER_SIGNATURE = 0x04034b50;
+static const uint32_t CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+static const uint32_t END_OF_DIRECTORY_SIGNATURE = 0x06054b50;
+static const uint32_t ZIP64_END_OF_DIRECTORY_SIGNATURE = 0x06064b50;
+static const uint32_t ZIP64_LOCATOR_SIGNATURE = 0x07064b50;
+static const uint16_t ZIP64_EXTRA_FIELD = 0x0001;
+static const size_t END_OF_DIRECTORY_SIZE = 22;
+static const size_t ZIP64_LOCATOR_SIZE = 20;
+// The end-of-directory record is followed by a comment of at most 65535 bytes.
+static const size_t MAX_END_OF_DIRECTORY_SEARCH = END_OF_DIRECTORY_SIZE + 0xffff;
+static const uint16_t METHOD_STORED = 0;
+static const uint16_t METHOD_DEFLATED = 8;
+// Size of the reads of compressed entry data.
+static const size_t ZIP_CHUNK_SIZE = 256 * 1024;
+
+static uint16_t readLE16(const unsigned char *bytes){
+    return static_cast<uint16_t>(bytes[0] | bytes[1] << 8);
+}
+
+static uint32_t readLE32(const unsigned char *bytes){
+    return static_cast<uint32_t>(bytes[0]) | static_cast<uint32_t>(bytes[1]) << 8 | static_cast<uint32_t>(bytes[2]) << 16 | static_cast<uint32_t>(bytes[3]) << 24;
+}
+
+static uint64_t readLE64(const unsigned char *bytes){
+    return static_cast<uint64_t>(readLE32(bytes)) | static_cast<uint64_t>(readLE32(bytes + 4)) << 32;
+}
+
+// Reads up to size bytes at offset, retrying short reads. Throws on errors.
+static size_t readAt(int fd, uint64_t offset, void *buffer, size_t size){
+    size_t total = 0;
+    while (total < size){
+        ssize_t count = pread(fd, static_cast<char *>(buffer) + total, size - total, static_cast<off_t>(offset + total));
+        if (count < 0){
+            if (errno == EINTR){
+                continue;
+            }
+            throw runtime_error(string("read failed: ") + strerror(errno));
+        }
+        if (count == 0){
+            break;
+        }
+        total += static_cast<size_t>(count);
+    }
+    return total;
+}
+
+static void readExactlyAt(int fd, uint64_t offset, void *buffer, size_t size){
+    if (readAt(fd, offset, buffer, size) != size){
+        throw runtime_error("truncated zip archive");
+    }
+}
+
+// Reads the compressed bytes of one entry in chunks, never past the entry's end.
+class ZipEntryData{
+    private:
+        int fd;
+        uint64_t offset;
+        uint64_t remaining;
+    public:
+        ZipEntryData(int fd, uint64_t offset, uint64_t size) : fd(fd), offset(offset), remaining(size) {}
+
+        size_t read(void *buffer, size_t size){
+            size_t count = readAt(fd, offset, buffer, static_cast<size_t>(min<uint64_t>(size, remaining)));
+            if (count == 0 && remaining > 0){
+                throw runtime_error("truncated zip entry");
+            }
+            offset += count;
+            remaining -= count;
+            return count;
+        }
+
+        bool atEnd() const {return remaining == 0;}
+};
+
+// Checks the running CRC-32 of an entry against the central directory once all of it
+// was read. Without zlib the check is skipped.
+class ZipChecksum{
+    private:
+        uint32_t expected;
+        uint64_t expectedSize;
+        uint64_t size = 0;
+#if FLOWMAKER_HAVE_ZLIB
+        uLong crc = crc32(0L, Z_NULL, 0);
+#endif
+    public:
+        ZipChecksum(uint32_t expected, uint64_t expectedSize) : expected(expected), expectedSize(expectedSize) {}
+
+        void update(const char *data, size_t count){
+            size += count;
+#if FLOWMAKER_HAVE_ZLIB
+            while (count > 0){
+                uInt part = static_cast<uInt>(min<size_t>(count, UINT32_MAX));
+                crc = crc32(crc, reinterpret_cast<const Bytef *>(data), part);
+                data += part;
+                count -= part;
+            }
+#endif
+        }
+
+        void finish() const{
+            if (size != expectedSize){
+                throw runtime_error("zip entry has the wrong size");
+            }
+#if FLOWMAKER_HAVE_ZLIB
+            if (crc != expected){
+                throw runtime_error("zip entry fails its CRC check");
+            }
+#endif
+        }
+};
+
+class StoredEntrySource : public InputSource{
+    private:
+        ZipEntryData data;
+        ZipChecksum checksum;
+    public:
+        StoredEntrySource(int fd, uint64_t offset, const ZipEntry &entry) : data(fd, offset, entry.compressedSize), checksum(entry.crc, entry.uncompressedSize) {}
+
+        size_t read(char *buffer, size_t size) override{
+            size_t count = data.read(buffer, size);
+            checksum.update(buffer, count);
+            if (count == 0){
+                checksum.finish();
+            }
+            return count;
+        }
+};
+
+#if FLOWMAKER_HAVE_ZLIB
+// Raw deflate data, without the zlib or gzip wrapper, inflated as it is read.
+class DeflatedEntrySource : public InputSource{
+    private:
+        ZipEntryData data;
+        ZipChecksum checksum;
+        z_stream stream;
+        vector<unsigned char> input;
+        bool finished = false;
+    public:
+        DeflatedEntrySource(int fd, uint64_t offset, const ZipEntry &entry) : data(fd, offset, entry.compressedSize), checksum(entry.crc, entry.uncompressedSize), input(ZIP_CHUNK_SIZE){
+            memset(&stream, 0, sizeof(stream));
+            if (inflateInit2(&stream, -MAX_WBITS) != Z_OK){
+                throw runtime_error("unable to start zip entry decompression");
+            }
+        }
+
+        ~DeflatedEntrySource() override{
+            inflateEnd(&stream);
+        }
+
+        size_t read(char *buffer, size_t size) override{
+            if (finished){
+                return 0;
+            }
+            size = min(size, static_cast<size_t>(UINT32_MAX));
+            stream.next_out = reinterpret_cast<Bytef *>(buffer);
+            stream.avail_out = static_cast<uInt>(size);
+            while (stream.avail_out > 0){
+                if (stream.avail_in == 0 && !data.atEnd()){
+                    stream.next_in = input.data();
+                    stream.avail_in = static_cast<uInt>(data.read(input.data(), input.size()));
+                }
+                int result = inflate(&stream, Z_NO_FLUSH);
+                if (result == Z_STREAM_END){
+                    finished = true;
+                    break;
+                }
+                if (result == Z_BUF_ERROR && data.atEnd() && stream.avail_in == 0){
+                    throw runtime_error("truncated zip entry");
+                }
+                if (result != Z_OK && result != Z_BUF_ERROR){
+                    throw runtime_error(string("corrupt zip entry") + (stream.msg ? string(": ") + stream.msg : ""));
+                }
+            }
+            size_t produced = size - stream.avail_out;
+            checksum.update(buffer, produced);
+            if (finished){
+                checksum.finish();
+            }
+            return produced;
+        }
+};
+#endif
+
+ZipArchive::ZipArchive(const string &fileName){
+    fd = ::open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0){
+        throw runtime_error("unable to open '" + fileName + "': " + strerror(errno));
+    }
+    try{
+        readCentralDirectory();
+    }catch (...){
+        close(fd);
+        throw;
+    }
+}
+
+ZipArchive::~ZipArchive(){
+    close(fd);
+}
+
+bool ZipArchive::isZipFile(const string &fileName){
+    int file = ::open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0){
+        return false;
+    }
+    unsigned char header[4];
+    bool zip = false;
+    try{
+        zip = readAt(file, 0, header, sizeof(header)) == sizeof(header) && readLE32(header) == LOCAL_HEADER_SIGNATURE;
+    }catch (const exception &){
+        zip = false;
+    }
+    close(file);
+    return zip;
+}
+
+void ZipArchive::readCentralDirectory(){
+    struct stat info;
+    if (fstat(fd, &info) != 0){
+        throw runtime_error(string("stat failed: ") + strerror(errno));
+    }
+    uint64_t fileSize = static_cast<uint64_t>(info.st_size);
+    if (fileSize < END_OF_DIRECTORY_SIZE){
+        throw runtime_error("not a zip archive");
+    }
+
+    // The end-of-directory record is the last one carrying its signature.
+    size_t tailSize = static_cast<size_t>(min<uint64_t>(fileSize, MAX_END_OF_DIRECTORY_SEARCH));
+    uint64_t tailOffset = fileSize - tailSize;
+    vector<unsigned char> tail(tailSize);
+    readExactlyAt(fd, tailOffset, tail.data(), tailSize);
+    size_t endRecord = tailSize - END_OF_DIRECTORY_SIZE + 1;
+    do{
+        endRecord--;
+    }while (endRecord > 0 && readLE32(&tail[endRecord]) != END_OF_DIRECTORY_SIGNATURE);
+    if (readLE32(&tail[endRecord]) != END_OF_DIRECTORY_SIGNATURE){
+        throw runtime_error("not a zip archive");
+    }
+    uint64_t entryCount = readLE16(&tail[endRecord + 10]);
+    uint64_t directorySize = readLE32(&tail[endRecord + 12]);
+    uint64_t directoryOffset = readLE32(&tail[endRecord + 16]);
+
+    uint64_t endRecordOffset = tailOffset + endRecord;
+    if (endRecordOffset >= ZIP64_LOCATOR_SIZE){
+        unsigned char locator[ZIP64_LOCATOR_SIZE];
+        readExactlyAt(fd, endRecordOffset - ZIP64_LOCATOR_SIZE, locator, sizeof(locator));
+        if (readLE32(locator) == ZIP64_LOCATOR_SIGNATURE){
+            unsigned char record[56];
+            readExactlyAt(fd, readLE64(locator + 8), record, sizeof(record));
+            if (readLE32(record) != ZIP64_END_OF_DIRECTORY_SIGNATURE){
+                throw runtime_error("corrupt zip64 directory");
+            }
+            entryCount = readLE64(record + 32);
+            directorySize = readLE64(record + 40);
+            directoryOffset = readLE64(record + 48);
+        }
+    }
+    if (directoryOffset + directorySize > fileSize){
+        throw runtime_error("truncated zip archive");
+    }
+
+    vector<unsigned char> directory(static_cast<size_t>(directorySize));
+    readExactlyAt(fd, directoryOffset, directory.data(), directory.size());
+    entries.reserve(static_cast<size_t>(min<uint64_t>(entryCount, directorySize / 46)));
+    size_t position = 0;
+    for (uint64_t i = 0; i < entryCount; ++i){
+        if (position + 46 > directory.size() || readLE32(&directory[position]) != CENTRAL_HEADER_SIGNATURE){
+            throw runtime_error("corrupt zip directory");
+        }
+        const unsigned char *header = &directory[position];
+        size_t nameLength = readLE16(header + 28);
+        size_t extraLength = readLE16(header + 30);
+        size_t commentLength = readLE16(header + 32);
+        if (position + 46 + nameLength + extraLength + commentLength > directory.size()){
+            throw runtime_error("corrupt zip directory");
+        }
+
+        ZipEntry entry;
+        entry.method = readLE16(header + 10);
+        entry.crc = readLE32(header + 16);
+        entry.compressedSize = readLE32(header + 20);
+        entry.uncompressedSize = readLE32(header + 24);
+        entry.localHeaderOffset = readLE32(header + 42);
+        entry.name.assign(reinterpret_cast<const char *>(header + 46), nameLength);
+
+        // Sizes and offsets that do not fit 32 bits are saturated and moved to the
+        // zip64 extra field, in this order.
+        const unsigned char *extra = header + 46 + nameLength;
+        const unsigned char *extraEnd = extra + extraLength;
+        while (extra + 4 <= extraEnd){
+            uint16_t id = readLE16(extra);
+            uint16_t size = readLE16(extra + 2);
+            const unsigned char *field = extra + 4;
+            const unsigned char *fieldEnd = min(field + size, extraEnd);
+            if (id == ZIP64_EXTRA_FIELD){
+                for (uint64_t *value : {&entry.uncompressedSize, &entry.compressedSize, &entry.localHeaderOffset}){
+                    if (*value == UINT32_MAX && field + 8 <= fieldEnd){
+                        *value = readLE64(field);
+                        field += 8;
+                    }
+                }
+            }
+            extra = fieldEnd;
+        }
+        entries.push_back(move(entry));
+        position += 46 + nameLength + extraLength + commentLength;
+    }
+}
+
+const ZipEntry *ZipArchive::find(const string &name) const{
+    for (const ZipEntry &entry : entries){
+        if (entry.name == name){
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+unique_ptr<InputSource> ZipArchive::open(const ZipEntry &entry) const{
+    // The local header repeats the name but may carry a different extra field, so
+    // the data offset comes from its own lengths.
+    unsigned char header[30];
+    readExactlyAt(fd, entry.localHeaderOffset, header, sizeof(header));
+    if (readLE32(header) != LOCAL_HEADER_SIGNATURE){
+        throw runtime_error("corrupt zip entry '" + entry.name + "'");
+    }
+    uint64_t dataOffset = entry.localHeaderOffset + sizeof(header) + readLE16(header + 26) + readLE16(header + 28);
+
+    switch (entry.method){
+    case METHOD_STORED:
+        return unique_ptr<InputSource>(new StoredEntrySource(fd, dataOffset, entry));
+    case METHOD_DEFLATED:
+#if FLOWMAKER_HAVE_ZLIB
+        return unique_ptr<InputSource>(new DeflatedEntrySource(fd, dataOffset, entry));
+#else
+        throw runtime_error("zlib support was not compiled in");
+#endif
+    default:
+        throw runtime_error("zip entry '" + entry.name + "' uses unsupported compression method " + to_string(entry.method));
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef FLOWMAKER_ZIP_ARCHIVE_H
+#define FLOWMAKER_ZIP_ARCHIVE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "InputSource.h"
+
+// One file stored in a zip archive, as listed by the central directory.
+struct ZipEntry{
+    std::string name;
+    uint16_t method;
+    uint32_t crc;
+    uint64_t compressedSize;
+    uint64_t uncompressedSize;
+    uint64_t localHeaderOffset;
+};
+
+// Read-only zip archive. Only the central directory is read up front; entries are
+// inflated as they are read, so an entry of any size is read in bounded memory.
+// Stored and deflated entries are supported, as are zip64 archives.
+class ZipArchive{
+    private:
+        int fd = -1;
+        std::vector<ZipEntry> entries;
+
+        void readCentralDirectory();
+    public:
+        // Throws runtime_error if the file cannot be opened or is not a zip archive.
+        explicit ZipArchive(const std::string &fileName);
+        ZipArchive(const ZipArchive &) = delete;
+        ZipArchive &operator=(const ZipArchive &) = delete;
+        ~ZipArchive();
+
+        // True if the file starts with a zip local file header.
+        static bool isZipFile(const std::string &fileName);
+
+        const std::vector<ZipEntry> &getEntries() const {return entries;}
+        // nullptr if the archive has no entry of that name.
+        const ZipEntry *find(const std::string &name) const;
+        // Decompressing reader over one entry; it must not outlive the archive. Throws
+        // runtime_error for an unsupported compression method, and the reader throws
+        // if the entry data is corrupt or fails its CRC check.
+        std::unique_ptr<InputSource> open(const ZipEntry &entry) const;
+};
+
+#endif
@@ -0,0 +1,129 @@
+// Distinct count: HyperLogLog estimates stay within a few standard errors from a
+// handful of values to millions at several precisions, merging sketches gives the
+// sketch of the union, and the column step counts exactly in exact mode.
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "DistinctCount.h"
+#include "RowStream.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool condition, const string &what){
+    if (!condition){
+        cerr << "FAILED: " << what << endl;
+        ++failures;
+    }
+}
+
+static uint64_t hashOf(const string &cell){
+    return hashCell(cell.data(), cell.size());
+}
+
+static void testErrorBounds(){
+    for (unsigned precision : {10u, 14u}){
+        HyperLogLog sketch(precision);
+        check(sketch.estimate() == 0, "empty sketch estimates 0");
+        uint64_t added = 0;
+        for (uint64_t count : {1, 10, 100, 1000, 10000, 100000, 1000000, 3000000}){
+            for (; added < count; ++added){
+                // Every value twice; repeats must not count.
+                string cell = "user-" + to_string(added);
+                sketch.addHash(hashOf(cell));
+                sketch.addHash(hashOf(cell));
+            }
+            double error = fabs(sketch.estimate() - count) / count;
+            double bound = 4 * sketch.getStandardError();
+            ostringstream what;
+            what << "precision " << precision << " estimate of " << count << " is within four standard errors (off by " << error << ")";
+            check(error <= bound, what.str());
+        }
+    }
+    check(fabs(HyperLogLog(14).getStandardError() - 1.04 / 128) < 1e-12, "standard error is 1.04 / sqrt(registers)");
+}
+
+static void testMerge(){
+    HyperLogLog first;
+    HyperLogLog second;
+    HyperLogLog both;
+    for (size_t i = 0; i < 60000; ++i){
+        uint64_t hash = hashOf(to_string(i));
+        (i < 40000 ? first : second).addHash(hash);
+        both.addHash(hash);
+        if (i >= 20000 && i < 40000){
+            second.addHash(hash);
+        }
+    }
+    first.merge(second);
+    check(first.estimate() == both.estimate(), "merged sketches estimate the union");
+
+    bool refused = false;
+    try{
+        first.merge(HyperLogLog(12));
+    }catch (const invalid_argument &){
+        refused = true;
+    }
+    check(refused, "sketches of different precision are not merged");
+
+    refused = false;
+    try{
+        HyperLogLog tooPrecise(HyperLogLog::MAX_PRECISION + 1);
+    }catch (const invalid_argument &){
+        refused = true;
+    }
+    check(refused, "precision past the maximum is refused");
+}
+
+static void testHash(){
+    check(hashOf("") != hashOf(string(1, '\0')), "empty cell and a zero byte hash apart");
+    check(hashOf("abcdefgh") != hashOf("abcdefgh" + string(1, '\0')), "cells differing by a trailing zero byte hash apart");
+    string longCell(100, 'x');
+    string other = longCell;
+    other[50] = 'y';
+    check(hashOf(longCell) != hashOf(other), "long cells differing in the middle hash apart");
+}
+
+static void testColumn(){
+    vector<vector<string>> rows;
+    for (size_t i = 0; i < 300000; ++i){
+        if (i % 100 == 0){
+            rows.push_back({to_string(i)});
+        }
+        else{
+            rows.push_back({to_string(i), "id" + to_string(i % 49999)});
+        }
+    }
+    TableRowStream exactRows(rows);
+    DistinctCountResult exact = countDistinct(exactRows, 1, HyperLogLog::DEFAULT_PRECISION, true);
+    check(exact.exact && exact.distinct == 49999, "exact mode counts the distinct cells");
+    check(exact.values == 297000 && exact.missing == 3000, "exact mode counts the cells and the rows without the column");
+
+    TableRowStream sketchRows(rows);
+    DistinctCountResult estimated = countDistinct(sketchRows, 1, HyperLogLog::DEFAULT_PRECISION, false);
+    check(!estimated.exact && estimated.values == 297000 && estimated.missing == 3000, "sketch mode counts the cells and the rows without the column");
+    check(fabs(static_cast<double>(estimated.distinct) - 49999) <= 4 * estimated.standardError * 49999, "sketch mode estimate is within four standard errors");
+}
+
+int main(){
+    // More than one thread, so the column step merges per-thread counts.
+    setComputeThreadCount(4);
+
+    testErrorBounds();
+    testMerge();
+    testHash();
+    testColumn();
+
+    if (failures > 0){
+        cerr << failures << " check(s) failed." << endl;
+        return 1;
+    }
+    cout << "All distinct count checks passed." << endl;
+    return 0;
+}
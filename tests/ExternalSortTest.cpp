@@ -0,0 +1,141 @@
+// External sort: a sort that spills runs to disk, and one that has to merge them in
+// several passes, return the rows in the order of an in-memory stable sort and
+// remove their files; sort keys parse as documented.
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ExternalSort.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool condition, const string &what){
+    if (!condition){
+        cerr << "FAILED: " << what << endl;
+        ++failures;
+    }
+}
+
+// Rows of a numeric key with some cells that are not numbers, a text key with many
+// repeats and the position the row was added at, to see that the sort is stable.
+static vector<vector<string>> makeRows(size_t count){
+    mt19937 random(7);
+    vector<vector<string>> rows;
+    for (size_t i = 0; i < count; ++i){
+        string number = random() % 20 == 0 ? "n/a" : to_string(static_cast<int>(random() % 500) - 250);
+        rows.push_back({number, "k" + to_string(random() % 37), to_string(i)});
+    }
+    return rows;
+}
+
+static double numberOf(const string &cell){
+    char *end;
+    double value = strtod(cell.c_str(), &end);
+    return *end == '\0' && !cell.empty() ? value : NAN;
+}
+
+// The order of "1:num:desc, 2": numbers from high to low with the other cells after
+// them, then the text key ascending.
+static bool expectedBefore(const vector<string> &a, const vector<string> &b){
+    double x = numberOf(a[0]);
+    double y = numberOf(b[0]);
+    if (isnan(x) != isnan(y)){
+        return !isnan(x);
+    }
+    if (!isnan(x) && x != y){
+        return x > y;
+    }
+    if (isnan(x) && a[0] != b[0]){
+        return a[0] > b[0];
+    }
+    return a[1] < b[1];
+}
+
+static vector<vector<string>> sortRows(const vector<vector<string>> &rows, size_t memoryBudget, size_t &runCount, uint64_t &spilledBytes){
+    vector<SortKey> keys;
+    parseSortKeys("1:num:desc, 2", keys);
+    ExternalSorter sorter(keys, memoryBudget);
+    for (const vector<string> &row : rows){
+        sorter.add(row);
+    }
+    shared_ptr<SortedRows> sorted = sorter.finish();
+    runCount = sorted->getRunCount();
+    spilledBytes = sorter.getSpilledBytes();
+    vector<vector<string>> result;
+    unique_ptr<RowStream> stream = sorted->open();
+    vector<string> row;
+    while (stream->next(row)){
+        result.push_back(row);
+    }
+    check(sorted->getRowCount() == rows.size(), "sorted row count matches the input");
+    return result;
+}
+
+static size_t temporaryFileCount(const string &directory){
+    size_t count = 0;
+    for (const auto &entry : filesystem::directory_iterator(directory)){
+        (void)entry;
+        ++count;
+    }
+    return count;
+}
+
+static void testParseKeys(){
+    vector<SortKey> keys;
+    check(parseSortKeys("3:num:desc, 1", keys) && keys.size() == 2, "two keys parse");
+    check(keys.size() == 2 && keys[0].column == 2 && keys[0].numeric && keys[0].descending, "first key is column 3, numeric, descending");
+    check(keys.size() == 2 && keys[1].column == 0 && !keys[1].numeric && !keys[1].descending, "second key is column 1, text, ascending");
+    check(!parseSortKeys("0", keys), "column 0 is refused");
+    check(!parseSortKeys("2:sideways", keys), "unknown key option is refused");
+    check(!parseSortKeys("", keys), "empty key list is refused");
+}
+
+static void testSortOrder(const string &directory){
+    vector<vector<string>> rows = makeRows(20000);
+    vector<vector<string>> expected = rows;
+    stable_sort(expected.begin(), expected.end(), expectedBefore);
+
+    size_t runCount;
+    uint64_t spilledBytes;
+    vector<vector<string>> inMemory = sortRows(rows, 256 * 1024 * 1024, runCount, spilledBytes);
+    check(runCount == 0 && spilledBytes == 0, "sort within the budget spills nothing");
+    check(inMemory == expected, "sort in memory matches a stable sort");
+
+    vector<vector<string>> spilled = sortRows(rows, 512 * 1024, runCount, spilledBytes);
+    check(runCount > 1 && spilledBytes > 0, "sort over the budget spills runs");
+    check(spilled == expected, "rows merged from spilled runs match a stable sort");
+
+    // Small enough for more runs than one merge takes, so some are merged first.
+    vector<vector<string>> merged = sortRows(rows, 16 * 1024, runCount, spilledBytes);
+    check(runCount > 1 && runCount <= 64, "runs past the merge fan-in are merged down before reading");
+    check(merged == expected, "rows of a multi-pass merge match a stable sort");
+
+    check(temporaryFileCount(directory) == 0, "run files are removed with the sorted rows");
+}
+
+int main(){
+    // Runs go to TMPDIR, so a directory of their own shows what is left behind.
+    char directory[] = "/tmp/externalsorttestXXXXXX";
+    if (mkdtemp(directory) == nullptr || setenv("TMPDIR", directory, 1) != 0){
+        cerr << "Cannot create a temporary directory." << endl;
+        return 1;
+    }
+
+    testParseKeys();
+    testSortOrder(directory);
+    filesystem::remove_all(directory);
+
+    if (failures > 0){
+        cerr << failures << " check(s) failed." << endl;
+        return 1;
+    }
+    cout << "All external sort checks passed." << endl;
+    return 0;
+}
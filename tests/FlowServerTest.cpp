@@ -0,0 +1,142 @@
+// Runs flows through a server and the bundled client: answers the client sends
+// ahead with --answers reach the flow before it starts, so the import they name
+// is prefetched and a repeated run is replayed from the result cache.
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "Flow.h"
+#include "FlowServer.h"
+#include "FlowSteps.h"
+#include "FlowStore.h"
+#include "ImportPrefetcher.h"
+#include "ResultCache.h"
+
+using namespace std;
+
+static int failures = 0;
+static string clientPath;
+
+static void check(bool condition, const string &what){
+    if (!condition){
+        cerr << "FAILED: " << what << endl;
+        ++failures;
+    }
+}
+
+static void writeFile(const string &fileName, const string &contents){
+    ofstream file(fileName, ios::binary | ios::trunc);
+    file << contents;
+}
+
+// Runs the client with the arguments and returns its exit status; output gets what
+// it printed.
+static int runClient(const string &arguments, string &output){
+    output.clear();
+    FILE *pipe = popen(("'" + clientPath + "' --socket test.sock " + arguments + " 2>&1").c_str(), "r");
+    if (pipe == nullptr){
+        return -1;
+    }
+    char chunk[4096];
+    size_t received;
+    while ((received = fread(chunk, 1, sizeof(chunk), pipe)) > 0){
+        output.append(chunk, received);
+    }
+    int status = pclose(pipe);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static void testAnswersSentAhead(){
+    writeFile("data.txt", "first line\nsecond line\n");
+    writeFile("answers.txt", "Y\ndata.txt\n");
+    Flow flow("Prefetch");
+    flow.addStep(new TextFileInputStep("Input a .txt file"));
+    flow.addStep(new EndStep());
+    saveFlowToBinary(flow);
+
+    uint64_t usedBefore = ImportPrefetcher::instance().getUsedCount();
+    string output;
+    int status = runClient("--answers answers.txt Prefetch", output);
+    check(status == 0, "scripted run ends normally");
+    check(output.find("File imported successfully.") != string::npos, "scripted run imports the file it names");
+    check(output.find("Flow Completed!") != string::npos, "scripted run reaches the end of the flow");
+    check(ImportPrefetcher::instance().getUsedCount() == usedBefore + 1, "import named by an answer sent ahead is prefetched");
+
+    status = runClient("--answers missing.txt Prefetch", output);
+    check(status != 0 && output.find("Unable to open the answers file") != string::npos, "missing answers file is reported");
+}
+
+// A run repeating a recorded one is replayed; a changed import or other answers make
+// the flow run again.
+static void testRunReplayed(){
+    ResultCache &cache = ResultCache::instance();
+    cache.open("cache", 1 << 20);
+    writeFile("data.txt", "first line\nsecond line\n");
+    writeFile("answers.txt", "Y\ndata.txt\n");
+    uint64_t hits = cache.getHits();
+    uint64_t misses = cache.getMisses();
+
+    string recorded;
+    string replayed;
+    check(runClient("--answers answers.txt Prefetch", recorded) == 0, "recorded run ends normally");
+    check(runClient("--answers answers.txt Prefetch", replayed) == 0, "replayed run ends normally");
+    check(cache.getMisses() == misses + 1 && cache.getHits() == hits + 1, "repeated run is replayed");
+    check(replayed == recorded, "replayed run prints what the recorded run printed");
+
+    string output;
+    writeFile("data.txt", "changed line\n");
+    runClient("--answers answers.txt Prefetch", output);
+    check(cache.getHits() == hits + 1, "run whose import changed is not replayed");
+    runClient("--answers answers.txt Prefetch", output);
+    check(cache.getHits() == hits + 2, "run with the changed import is replayed once recorded");
+
+    writeFile("answers.txt", "N\n");
+    runClient("--answers answers.txt Prefetch", output);
+    check(cache.getHits() == hits + 2 && cache.getMisses() == misses + 3, "run with other answers is not replayed");
+    cache.open("cache", 0);
+}
+
+int main(int argc, char **argv){
+    if (argc != 2){
+        cerr << "Usage: " << argv[0] << " <flowmaker_client>" << endl;
+        return 1;
+    }
+    // Resolved before the test leaves the directory it was started in.
+    char *resolved = realpath(argv[1], nullptr);
+    if (resolved == nullptr){
+        cerr << "Cannot find the client '" << argv[1] << "'." << endl;
+        return 1;
+    }
+    clientPath = resolved;
+    free(resolved);
+    // The server reads the flow store of the working directory.
+    char directory[] = "/tmp/flowservertestXXXXXX";
+    if (mkdtemp(directory) == nullptr || chdir(directory) != 0){
+        cerr << "Cannot create a working directory." << endl;
+        return 1;
+    }
+
+    {
+        FlowServer server("test.sock", 2);
+        thread loop([&server](){server.run();});
+        testAnswersSentAhead();
+        testRunReplayed();
+        server.stop();
+        loop.join();
+    }
+
+    filesystem::remove_all(directory);
+
+    if (failures > 0){
+        cerr << failures << " check(s) failed." << endl;
+        return 1;
+    }
+    cout << "All flow server checks passed." << endl;
+    return 0;
+}
@@ -0,0 +1,173 @@
+// Round trip of the binary flow store: a saved flow loads back with the same step
+// configuration, also when it was run before being saved, and stores with a bad
+// magic or a newer version are refused.
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "Flow.h"
+#include "FlowExecutor.h"
+#include "FlowIO.h"
+#include "FlowRecord.h"
+#include "FlowSteps.h"
+#include "FlowStore.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool condition, const string &what){
+    if (!condition){
+        cerr << "FAILED: " << what << endl;
+        ++failures;
+    }
+}
+
+// The configuration bytes of every step, operand indices included.
+static vector<string> stepConfigs(const Flow &flow){
+    vector<string> configs;
+    const vector<FlowStep *> &steps = flow.getSteps();
+    for (const FlowStep *step : steps){
+        FlowRecordWriter writer(&steps);
+        step->writeConfig(writer);
+        configs.push_back(step->getType() + ":" + writer.getBuffer());
+    }
+    return configs;
+}
+
+static void writeStore(const string &contents){
+    ofstream file(FLOWS_BIN_FILE, ios::binary | ios::trunc);
+    file << contents;
+}
+
+static string storeHeader(const char *magic, uint16_t version){
+    FlowRecordWriter header;
+    header.writeBytes(string(magic, sizeof(FLOWS_BIN_MAGIC)));
+    header.writeU16(version);
+    header.writeU16(0);
+    return header.getBuffer();
+}
+
+static void testRoundTrip(){
+    Flow flow("Round Trip");
+    TitleStep *title = new TitleStep("Quarterly report", "Draft");
+    flow.addStep(title);
+    NumberInputStep *first = new NumberInputStep("First number");
+    NumberInputStep *second = new NumberInputStep("Second number");
+    flow.addStep(first);
+    flow.addStep(second);
+    CalculusStep<double> *calculus = new CalculusStep<double>(ArithmeticOperation::Division, '/');
+    calculus->addNumberInput(second);
+    calculus->addNumberInput(first);
+    flow.addStep(calculus);
+    flow.addStep(new OutputStep("report.txt", "Report", "Totals"));
+    flow.addStep(new EndStep());
+
+    Flow other("Other");
+    other.addStep(new TitleStep("Not this one", ""));
+    saveFlowToBinary(other);
+    saveFlowToBinary(flow);
+
+    vector<string> names = readExistingFlowNamesFromBinary();
+    check(names == vector<string>({"Other", "Round Trip"}), "both flows are listed");
+
+    Flow loaded = loadFlowFromBinary("Round Trip");
+    check(loaded.getName() == "Round Trip", "loaded flow keeps its name");
+    check(stepConfigs(loaded) == stepConfigs(flow), "loaded steps have the saved configuration");
+
+    CalculusStep<double> *loadedCalculus = dynamic_cast<CalculusStep<double> *>(loaded.getSteps()[3]);
+    check(loadedCalculus && loadedCalculus->getNumberInputs().size() == 2 &&
+          loadedCalculus->getNumberInputs()[0] == loaded.getSteps()[2] &&
+          loadedCalculus->getNumberInputs()[1] == loaded.getSteps()[1],
+          "calculus operands point at the loaded number inputs");
+
+    Flow decoded = decodeFlowRecord(encodeFlowRecord(flow));
+    check(stepConfigs(decoded) == stepConfigs(flow), "encoded record decodes to the same configuration");
+}
+
+// Running a flow resets its steps at the EndStep; what they were configured with
+// must still be there to save.
+static void testSaveAfterRun(){
+    {
+        ofstream data("data.csv");
+        data << "a,b\n1,2\n";
+    }
+    Flow flow("Ran First");
+    flow.addStep(new TextInputStep("mydesc"));
+    flow.addStep(new CSVFileInputStep("csvdesc"));
+    flow.addStep(new EndStep());
+    vector<string> before = stepConfigs(flow);
+
+    ScriptedInput answers({"Y", "Y", "data"});
+    CallbackOutput quiet([](const string &){});
+    FlowExecutor executor(flow, answers, quiet);
+    executor.executeFlow();
+    check(answers.getRemaining() == 0, "the run read every answer");
+
+    saveFlowToBinary(flow);
+    Flow loaded = loadFlowFromBinary("Ran First");
+    check(loaded.getSteps().size() == 3, "flow saved after a run loads every step");
+    TextInputStep *textInput = loaded.getSteps().empty() ? nullptr : dynamic_cast<TextInputStep *>(loaded.getSteps()[0]);
+    check(textInput && textInput->getDescription().find(": mydesc") != string::npos, "description survives a run before the save");
+    CSVFileInputStep *csv = loaded.getSteps().size() < 2 ? nullptr : dynamic_cast<CSVFileInputStep *>(loaded.getSteps()[1]);
+    check(csv && csv->getFileName() == "data.csv", "file name entered in the run is saved");
+    check(stepConfigs(loaded) == stepConfigs(flow) && stepConfigs(flow) != before, "loaded flow has the configuration of the run");
+    remove("data.csv");
+}
+
+static void testRejectsBadMagic(){
+    Flow flow("Kept");
+    flow.addStep(new TitleStep());
+    saveFlowToBinary(flow);
+    string contents;
+    {
+        ifstream file(FLOWS_BIN_FILE, ios::binary);
+        contents.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    }
+    contents[0] = 'X';
+    writeStore(contents);
+    check(readExistingFlowNamesFromBinary().empty(), "store with a bad magic lists no flows");
+    check(loadFlowFromBinary("Kept").getSteps().empty(), "store with a bad magic loads no steps");
+}
+
+static void testRejectsNewerVersion(){
+    Flow flow("Future");
+    flow.addStep(new TitleStep());
+    writeStore(storeHeader(FLOWS_BIN_MAGIC, FLOWS_BIN_VERSION + 1) + encodeFlowRecord(flow));
+    check(readExistingFlowNamesFromBinary().empty(), "store of a newer version lists no flows");
+    check(loadFlowFromBinary("Future").getSteps().empty(), "store of a newer version loads no steps");
+
+    writeStore(storeHeader(FLOWS_BIN_MAGIC, FLOWS_BIN_VERSION) + encodeFlowRecord(flow));
+    check(loadFlowFromBinary("Future").getSteps().size() == 1, "store of the current version loads");
+}
+
+int main(){
+    // The store lives in the working directory, so each run gets a fresh one.
+    char directory[] = "/tmp/flowstoretestXXXXXX";
+    if (mkdtemp(directory) == nullptr || chdir(directory) != 0){
+        cerr << "Cannot create a working directory." << endl;
+        return 1;
+    }
+
+    testRoundTrip();
+    remove(FLOWS_BIN_FILE.c_str());
+    testSaveAfterRun();
+    remove(FLOWS_BIN_FILE.c_str());
+    testRejectsBadMagic();
+    remove(FLOWS_BIN_FILE.c_str());
+    testRejectsNewerVersion();
+    remove(FLOWS_BIN_FILE.c_str());
+    rmdir(directory);
+
+    if (failures > 0){
+        cerr << failures << " check(s) failed." << endl;
+        return 1;
+    }
+    cout << "All flow store checks passed." << endl;
+    return 0;
+}
@@ -0,0 +1,153 @@
+// Watch mode: after an imported file changes, only its import step and the steps
+// that depend on it run again, with the answers of the last run; the other steps
+// keep their results. A file replaced by a rename is seen as a change too.
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "Flow.h"
+#include "FlowIO.h"
+#include "FlowSteps.h"
+#include "FlowWatcher.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool condition, const string &what){
+    if (!condition){
+        cerr << "FAILED: " << what << endl;
+        ++failures;
+    }
+}
+
+static void writeFile(const string &fileName, const string &contents){
+    ofstream file(fileName, ios::trunc);
+    file << contents;
+}
+
+// What the watcher prints, for the test thread to wait on.
+class Transcript{
+    private:
+        mutex lock;
+        condition_variable changed;
+        string text;
+    public:
+        void add(const string &more){
+            lock_guard<mutex> guard(lock);
+            text += more;
+            changed.notify_all();
+        }
+
+        // Waits until the text after from holds needle and returns that text, or ""
+        // after ten seconds.
+        string waitFor(size_t from, const string &needle){
+            unique_lock<mutex> guard(lock);
+            bool found = changed.wait_for(guard, chrono::seconds(10), [&]{
+                return text.size() > from && text.find(needle, from) != string::npos;
+            });
+            return found ? text.substr(from) : "";
+        }
+
+        size_t size(){
+            lock_guard<mutex> guard(lock);
+            return text.size();
+        }
+};
+
+static string distinctLine(const Flow &flow){
+    const DistinctCountStep *step = dynamic_cast<const DistinctCountStep *>(flow.getSteps()[2]);
+    if (step == nullptr || !step->isComputed()){
+        return "";
+    }
+    vector<string> lines = step->describeResults();
+    return lines.size() < 2 ? "" : lines[1];
+}
+
+static void testStaleSteps(){
+    writeFile("first.csv", "x\n1\n2\n");
+    writeFile("second.csv", "a\nb\nc\n");
+
+    // Two imports, an exact distinct count of the second one, and the end of the flow,
+    // which depends on every step before it.
+    Flow flow("Watched");
+    flow.addStep(new CSVFileInputStep("first"));
+    flow.addStep(new CSVFileInputStep("second"));
+    flow.addStep(new DistinctCountStep("ids"));
+    flow.addStep(new EndStep());
+
+    Transcript transcript;
+    CallbackOutput output([&](const string &text){transcript.add(text);});
+    ScriptedInput answers({"Y", "first.csv", "Y", "second.csv", "Y", "N", "Y", "1", "Y", "N"});
+    int stop[2];
+    if (pipe(stop) != 0){
+        check(false, "stop pipe is created");
+        return;
+    }
+    {
+        FlowWatcher watcher(flow, output);
+        check(watcher.start(answers) == 2, "both imported files are watched");
+        check(answers.getRemaining() == 0, "the first run reads every answer");
+        check(distinctLine(flow) == "Distinct values: 3 (exact)", "the first run counts the second file");
+        thread watching([&]{watcher.watch(stop[0]);});
+
+        // The first file only feeds its import and the end of the flow.
+        const FlowStep *countStep = flow.getSteps()[2];
+        size_t from = transcript.size();
+        writeFile("first.csv", "x\n1\n2\n3\n");
+        string rerun = transcript.waitFor(from, "Reran");
+        check(rerun.find("Reran 2 of 4 steps") != string::npos, "a change to the first file reruns its import and the end");
+        check(flow.getSteps()[2] == countStep && distinctLine(flow) == "Distinct values: 3 (exact)", "the count of the other file keeps its result");
+
+        // The second file also feeds the count, which reruns with its old answers.
+        from = transcript.size();
+        writeFile("second.csv", "a\nb\nc\nd\nd\n");
+        rerun = transcript.waitFor(from, "Reran");
+        check(rerun.find("Reran 3 of 4 steps") != string::npos, "a change to the second file reruns its import, the count and the end");
+        check(rerun.find("fewer answers") == string::npos, "the rerun reads the answers of the last run");
+        check(distinctLine(flow) == "Distinct values: 4 (exact)", "the count is rerun on the new contents");
+
+        // Saved the way editors do: written aside and renamed over the file.
+        from = transcript.size();
+        writeFile("second.csv.tmp", "a\nb\n");
+        rename("second.csv.tmp", "second.csv");
+        rerun = transcript.waitFor(from, "Reran");
+        check(rerun.find("Reran 3 of 4 steps") != string::npos, "a file replaced by a rename is rerun");
+        check(distinctLine(flow) == "Distinct values: 2 (exact)", "the count is rerun on the renamed file");
+
+        if (write(stop[1], "x", 1) != 1){
+            check(false, "watching is stopped");
+        }
+        watching.join();
+    }
+    close(stop[0]);
+    close(stop[1]);
+    check(!dynamic_cast<const DistinctCountStep *>(flow.getSteps()[2])->isComputed(), "the steps are put back as they were before the first run");
+}
+
+int main(){
+    char directory[] = "/tmp/flowwatchertestXXXXXX";
+    if (mkdtemp(directory) == nullptr || chdir(directory) != 0){
+        cerr << "Cannot create a working directory." << endl;
+        return 1;
+    }
+
+    testStaleSteps();
+    filesystem::remove_all(directory);
+
+    if (failures > 0){
+        cerr << failures << " check(s) failed." << endl;
+        return 1;
+    }
+    cout << "All flow watcher checks passed." << endl;
+    return 0;
+}
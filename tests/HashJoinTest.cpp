@@ -0,0 +1,148 @@
+// Hash join: inner and left outer joins return the rows of a nested-loop join
+// whichever side the table is built on, also when the build side is over the memory
+// budget and both sides are partitioned to disk; key columns parse as documented.
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "HashJoin.h"
+#include "RowStream.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool condition, const string &what){
+    if (!condition){
+        cerr << "FAILED: " << what << endl;
+        ++failures;
+    }
+}
+
+typedef vector<vector<string>> Table;
+
+// Rows of a key drawn from keyCount values starting at firstKey and a value cell,
+// plus an extra cell on the right side, so keys repeat on both sides.
+static Table makeRows(size_t count, size_t firstKey, size_t keyCount, bool right, unsigned seed){
+    mt19937 random(seed);
+    Table rows;
+    for (size_t i = 0; i < count; ++i){
+        vector<string> row = {"k" + to_string(firstKey + random() % keyCount), (right ? "r" : "l") + to_string(i)};
+        if (right){
+            row.push_back("x" + to_string(i % 7));
+        }
+        rows.push_back(row);
+    }
+    return rows;
+}
+
+// Join on the first cell of both sides: the left row, then the right row without
+// its key.
+static Table expectedJoin(const Table &left, const Table &right, bool keepUnmatchedLeft){
+    multimap<string, const vector<string> *> byKey;
+    for (const vector<string> &row : right){
+        byKey.emplace(row[0], &row);
+    }
+    Table joined;
+    for (const vector<string> &row : left){
+        auto [first, last] = byKey.equal_range(row[0]);
+        for (auto match = first; match != last; ++match){
+            joined.push_back({row[0], row[1], (*match->second)[1], (*match->second)[2]});
+        }
+        if (first == last && keepUnmatchedLeft){
+            joined.push_back({row[0], row[1], "", ""});
+        }
+    }
+    sort(joined.begin(), joined.end());
+    return joined;
+}
+
+// The joined rows in sorted order, since a partitioned join does not keep the
+// order of the probe side.
+static Table join(HashJoiner &joiner, const Table &left, const Table &right){
+    TableRowStream leftStream(left);
+    TableRowStream rightStream(right);
+    shared_ptr<JoinedRows> joined = joiner.join(leftStream, left.size(), rightStream, right.size());
+    Table rows;
+    unique_ptr<RowStream> stream = joined->open();
+    vector<string> row;
+    while (stream->next(row)){
+        rows.push_back(row);
+    }
+    check(joined->getRowCount() == rows.size(), "row count of the result matches the rows read");
+    sort(rows.begin(), rows.end());
+    return rows;
+}
+
+static JoinSpec keySpec(bool keepUnmatchedLeft){
+    JoinSpec spec;
+    spec.leftColumns = {0};
+    spec.rightColumns = {0};
+    spec.keepUnmatchedLeft = keepUnmatchedLeft;
+    spec.leftWidth = 2;
+    spec.rightWidth = 3;
+    return spec;
+}
+
+static void testParseColumns(){
+    vector<size_t> columns;
+    check(parseJoinColumns("1, 3", columns) && columns == vector<size_t>({0, 2}), "key columns parse to 0-based ones");
+    check(!parseJoinColumns("0", columns), "column 0 is refused");
+    check(!parseJoinColumns("1,,2", columns), "empty column is refused");
+    check(!parseJoinColumns("a", columns), "column that is not a number is refused");
+}
+
+// Keys 0-399 on the left and 200-599 on the right, so both sides have rows without
+// a match; the smaller side is built on.
+static void testInMemory(){
+    Table small = makeRows(500, 0, 400, false, 1);
+    Table large = makeRows(2000, 200, 400, true, 2);
+    Table smallRight = makeRows(500, 200, 400, true, 3);
+    Table largeLeft = makeRows(2000, 0, 400, false, 4);
+    for (bool outer : {false, true}){
+        string kind = outer ? "left outer join" : "inner join";
+        HashJoiner joiner(keySpec(outer));
+        check(join(joiner, small, large) == expectedJoin(small, large, outer), kind + " built on the left matches a nested-loop join");
+        check(joiner.isBuiltOnLeft() && joiner.getPartitionCount() == 0, kind + " builds on the smaller left side in memory");
+        check(join(joiner, largeLeft, smallRight) == expectedJoin(largeLeft, smallRight, outer), kind + " built on the right matches a nested-loop join");
+        check(!joiner.isBuiltOnLeft() && joiner.getPartitionCount() == 0, kind + " builds on the smaller right side in memory");
+    }
+}
+
+static void testPartitioned(const string &directory){
+    Table left = makeRows(20000, 0, 5000, false, 5);
+    Table right = makeRows(30000, 2500, 5000, true, 6);
+    for (bool outer : {false, true}){
+        string kind = outer ? "left outer join" : "inner join";
+        HashJoiner joiner(keySpec(outer), 256 * 1024);
+        check(join(joiner, left, right) == expectedJoin(left, right, outer), "partitioned " + kind + " matches a nested-loop join");
+        check(joiner.getPartitionCount() > 0 && joiner.getSpilledBytes() > 0, kind + " over the budget is partitioned to disk");
+    }
+    check(filesystem::is_empty(directory), "partition files are removed with the joined rows");
+}
+
+int main(){
+    // Partitions go to TMPDIR, so a directory of their own shows what is left behind.
+    char directory[] = "/tmp/hashjointestXXXXXX";
+    if (mkdtemp(directory) == nullptr || setenv("TMPDIR", directory, 1) != 0){
+        cerr << "Cannot create a temporary directory." << endl;
+        return 1;
+    }
+
+    testParseColumns();
+    testInMemory();
+    testPartitioned(directory);
+    filesystem::remove_all(directory);
+
+    if (failures > 0){
+        cerr << failures << " check(s) failed." << endl;
+        return 1;
+    }
+    cout << "All hash join checks passed." << endl;
+    return 0;
+}
@@ -0,0 +1,220 @@
+// Compressed imports: gzip files, concatenated gzip members, BGZF files and zstd
+// files read back as the bytes that were compressed, whatever their name, and
+// truncated or corrupt files are reported instead of read short.
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+#if FLOWMAKER_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#if FLOWMAKER_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "InputSource.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool condition, const string &what){
+    if (!condition){
+        cerr << "FAILED: " << what << endl;
+        ++failures;
+    }
+}
+
+static void writeFile(const string &fileName, const string &contents){
+    ofstream file(fileName, ios::binary | ios::trunc);
+    file << contents;
+}
+
+// CSV-like lines, compressible but not trivially so.
+static string makeText(size_t bytes){
+    mt19937 random(9);
+    string text = "id,name,amount\n";
+    while (text.size() < bytes){
+        text += to_string(random() % 100000) + ",name" + to_string(random() % 300) + "," + to_string(random() % 10000) + "." + to_string(random() % 100) + "\n";
+    }
+    return text;
+}
+
+// Reads fileName, turning a runtime_error into its message so that checks can tell
+// a refused file from one read short.
+static bool readOrError(const string &fileName, string &contents, string &error){
+    error.clear();
+    try{
+        return readImportFile(fileName, contents);
+    }catch (const runtime_error &e){
+        error = e.what();
+        return false;
+    }
+}
+
+static void testPlain(){
+    string text = makeText(100000);
+    writeFile("plain.csv.gz", text);
+    string contents;
+    string error;
+    check(readOrError("plain.csv.gz", contents, error) && contents == text, "uncompressed file is read as it is, whatever its name");
+    writeFile("empty.csv", "");
+    check(readOrError("empty.csv", contents, error) && contents.empty(), "empty file is read as empty");
+    check(!readOrError("missing.csv", contents, error) && error.empty(), "missing file is not opened");
+
+    const unsigned char gzip[] = {0x1f, 0x8b, 8, 0};
+    const unsigned char zstd[] = {0x28, 0xb5, 0x2f, 0xfd};
+    const unsigned char text4[] = {'a', ',', 'b', '\n'};
+    check(detectCompression(gzip, sizeof(gzip)) == CompressionFormat::Gzip, "gzip magic is detected");
+    check(detectCompression(zstd, sizeof(zstd)) == CompressionFormat::Zstd, "zstd magic is detected");
+    check(detectCompression(text4, sizeof(text4)) == CompressionFormat::None, "text is not compressed");
+    check(detectCompression(zstd, 3) == CompressionFormat::None, "a partial magic is not detected");
+}
+
+#if FLOWMAKER_HAVE_ZLIB
+// Deflates data as one gzip member, or as a raw deflate stream for a BGZF block.
+static string deflateData(const string &data, bool gzipWrapper){
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    deflateInit2(&stream, 6, Z_DEFLATED, gzipWrapper ? 16 + MAX_WBITS : -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+    string output(deflateBound(&stream, data.size()) + 32, '\0');
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef *>(&output[0]);
+    stream.avail_out = static_cast<uInt>(output.size());
+    deflate(&stream, Z_FINISH);
+    output.resize(stream.total_out);
+    deflateEnd(&stream);
+    return output;
+}
+
+static void appendLittleEndian(string &output, uint32_t value, size_t count){
+    for (size_t i = 0; i < count; ++i){
+        output += static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+}
+
+// A BGZF block as bgzip writes it: a gzip member whose 'BC' extra subfield holds the
+// block size less one.
+static string bgzfBlock(const string &data){
+    string compressed = deflateData(data, false);
+    string block = string("\x1f\x8b\x08\x04\0\0\0\0\0\xff\x06\0BC\x02\0", 16);
+    appendLittleEndian(block, static_cast<uint32_t>(18 + compressed.size() + 8 - 1), 2);
+    block += compressed;
+    appendLittleEndian(block, static_cast<uint32_t>(crc32(0, reinterpret_cast<const Bytef *>(data.data()), static_cast<uInt>(data.size()))), 4);
+    appendLittleEndian(block, static_cast<uint32_t>(data.size()), 4);
+    return block;
+}
+
+// BGZF of text in blocks of blockSize bytes, ending with the empty block bgzip adds.
+static string bgzf(const string &text, size_t blockSize){
+    string output;
+    for (size_t offset = 0; offset < text.size(); offset += blockSize){
+        output += bgzfBlock(text.substr(offset, blockSize));
+    }
+    return output + bgzfBlock("");
+}
+
+static void testGzip(){
+    string text = makeText(3 * 1024 * 1024);
+    string contents;
+    string error;
+
+    writeFile("data.gz", deflateData(text, true));
+    check(readOrError("data.gz", contents, error) && contents == text, "gzip file is inflated");
+    writeFile("data.csv", deflateData(text, true));
+    check(readOrError("data.csv", contents, error) && contents == text, "gzip file is told by its bytes, not its name");
+
+    string second = "appended,member\n";
+    writeFile("members.gz", deflateData(text, true) + deflateData(second, true));
+    check(readOrError("members.gz", contents, error) && contents == text + second, "concatenated gzip members are read one after the other");
+
+    string compressed = deflateData(text, true);
+    writeFile("truncated.gz", compressed.substr(0, compressed.size() / 2));
+    check(!readOrError("truncated.gz", contents, error) && !error.empty(), "truncated gzip file is refused");
+    compressed[compressed.size() / 2] ^= 0x55;
+    compressed[compressed.size() / 2 + 1] ^= 0x55;
+    writeFile("corrupt.gz", compressed);
+    check(!readOrError("corrupt.gz", contents, error) && !error.empty(), "corrupt gzip file is refused");
+}
+
+static void testBGZF(){
+    string text = makeText(3 * 1024 * 1024);
+    string contents;
+    string error;
+
+    writeFile("blocks.bgz", bgzf(text, 60000));
+    check(readOrError("blocks.bgz", contents, error) && contents == text, "BGZF blocks are inflated in order");
+
+    // A plain gzip member after the blocks makes it a gzip stream like any other.
+    string tail = "plain,member\n";
+    writeFile("mixed.bgz", bgzf(text, 60000) + deflateData(tail, true));
+    check(readOrError("mixed.bgz", contents, error) && contents == text + tail, "BGZF file with a foreign member is inflated as one stream");
+
+    string single = "one,block\n";
+    writeFile("single.bgz", bgzf(single, 60000));
+    check(readOrError("single.bgz", contents, error) && contents == single, "BGZF file of one block is inflated");
+
+    string blocks = bgzf(text, 60000);
+    // Damage the compressed data of the 21st block, past its header.
+    size_t middleBlock = bgzf(text.substr(0, 20 * 60000), 60000).size() - bgzfBlock("").size();
+    for (size_t i = 40; i < 60; ++i){
+        blocks[middleBlock + i] ^= 0x5a;
+    }
+    writeFile("corrupt.bgz", blocks);
+    // Only the block-parallel path names the block, so this also shows it was taken.
+    check(!readOrError("corrupt.bgz", contents, error) && error.find("BGZF block") != string::npos, "corrupt BGZF block is refused");
+}
+#endif
+
+static void testZstd(){
+    string text = makeText(1024 * 1024);
+    string contents;
+    string error;
+#if FLOWMAKER_HAVE_ZSTD
+    string compressed(ZSTD_compressBound(text.size()), '\0');
+    size_t size = ZSTD_compress(&compressed[0], compressed.size(), text.data(), text.size(), 3);
+    check(!ZSTD_isError(size), "test data is compressed with zstd");
+    compressed.resize(size);
+    writeFile("data.zst", compressed + compressed);
+    check(readOrError("data.zst", contents, error) && contents == text + text, "zstd frames are decompressed one after the other");
+    writeFile("truncated.zst", compressed.substr(0, compressed.size() / 2));
+    check(!readOrError("truncated.zst", contents, error) && !error.empty(), "truncated zstd file is refused");
+#else
+    // Without libzstd the file is still told apart, and refused rather than read raw.
+    writeFile("data.zst", string("\x28\xb5\x2f\xfd", 4) + text);
+    check(!readOrError("data.zst", contents, error) && error.find("zstd") != string::npos, "zstd file is refused without zstd support");
+#endif
+}
+
+int main(){
+    // More than one thread, so BGZF blocks are inflated in parallel.
+    setComputeThreadCount(4);
+    char directory[] = "/tmp/inputsourcetestXXXXXX";
+    if (mkdtemp(directory) == nullptr || chdir(directory) != 0){
+        cerr << "Cannot create a working directory." << endl;
+        return 1;
+    }
+
+    testPlain();
+#if FLOWMAKER_HAVE_ZLIB
+    testGzip();
+    testBGZF();
+#endif
+    testZstd();
+    filesystem::remove_all(directory);
+
+    if (failures > 0){
+        cerr << failures << " check(s) failed." << endl;
+        return 1;
+    }
+    cout << "All input source checks passed." << endl;
+    return 0;
+}
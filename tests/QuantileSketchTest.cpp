@@ -0,0 +1,143 @@
+// Quantile sketch: t-digest estimates stay within a rank error bound on uniform and
+// skewed data, tighter at the tails, also after digests of parts are merged; the
+// column step skips cells that are not numbers and percentiles parse as documented.
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "QuantileSketch.h"
+#include "RowStream.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool condition, const string &what){
+    if (!condition){
+        cerr << "FAILED: " << what << endl;
+        ++failures;
+    }
+}
+
+static const vector<double> RANKS = {0.001, 0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99, 0.999};
+
+// Allowed distance between the rank of an estimate and the rank asked for. The
+// centroids of the k1 scale shrink towards the tails, and so does the error.
+static double rankBound(double q){
+    return 0.0005 + 0.01 * sqrt(q * (1 - q));
+}
+
+// Fraction of the sorted values below value, taking the middle of a run of equal ones.
+static double rankOf(const vector<double> &sorted, double value){
+    size_t below = lower_bound(sorted.begin(), sorted.end(), value) - sorted.begin();
+    size_t through = upper_bound(sorted.begin(), sorted.end(), value) - sorted.begin();
+    return (below + through) / 2.0 / sorted.size();
+}
+
+static void checkBounds(TDigest &digest, vector<double> values, const string &name){
+    sort(values.begin(), values.end());
+    check(digest.getCount() == values.size(), name + " counts every value");
+    check(digest.getMin() == values.front() && digest.getMax() == values.back(), name + " keeps the exact minimum and maximum");
+    for (double q : RANKS){
+        double error = fabs(rankOf(values, digest.quantile(q)) - q);
+        ostringstream what;
+        what << name << " p" << q * 100 << " is within the rank bound (off by " << error << ")";
+        check(error <= rankBound(q), what.str());
+    }
+    check(digest.getCentroidCount() <= TDigest::DEFAULT_COMPRESSION, name + " keeps at most about compression centroids");
+}
+
+static vector<double> makeValues(size_t count, int distribution, unsigned seed){
+    mt19937_64 random(seed);
+    uniform_real_distribution<double> uniform(-1000, 1000);
+    exponential_distribution<double> exponential(0.01);
+    lognormal_distribution<double> lognormal(0, 2);
+    vector<double> values;
+    for (size_t i = 0; i < count; ++i){
+        values.push_back(distribution == 0 ? uniform(random) : distribution == 1 ? exponential(random) : lognormal(random));
+    }
+    return values;
+}
+
+static void testErrorBounds(){
+    const char *names[] = {"uniform", "exponential", "lognormal"};
+    for (int distribution = 0; distribution < 3; ++distribution){
+        vector<double> values = makeValues(500000, distribution, 17 + distribution);
+        TDigest digest;
+        for (double value : values){
+            digest.add(value);
+        }
+        checkBounds(digest, values, names[distribution]);
+
+        // The same values in four digests merged into one.
+        vector<TDigest> parts(4);
+        for (size_t i = 0; i < values.size(); ++i){
+            parts[i * 4 / values.size()].add(values[i]);
+        }
+        for (size_t part = 1; part < parts.size(); ++part){
+            parts[0].merge(parts[part]);
+        }
+        checkBounds(parts[0], values, string("merged ") + names[distribution]);
+    }
+
+    TDigest empty;
+    check(isnan(empty.quantile(0.5)), "empty digest has no quantiles");
+    TDigest one;
+    one.add(7);
+    check(one.quantile(0) == 7 && one.quantile(0.5) == 7 && one.quantile(1) == 7, "digest of one value returns it at every rank");
+}
+
+static void testColumnQuantiles(){
+    vector<vector<string>> rows;
+    vector<double> values;
+    for (size_t i = 0; i < 100000; ++i){
+        if (i % 1000 == 0){
+            rows.push_back({to_string(i), "n/a"});
+        }
+        else if (i % 1000 == 1){
+            rows.push_back({to_string(i)});
+        }
+        else{
+            values.push_back(static_cast<double>((i * 7919) % 100003));
+            rows.push_back({to_string(i), " " + to_string(static_cast<long>(values.back())) + " "});
+        }
+    }
+    sort(values.begin(), values.end());
+    TableRowStream stream(rows);
+    ColumnQuantiles result = computeColumnQuantiles(stream, 1, {0.5, 0.99});
+    check(result.values == values.size(), "column quantiles count the numbers");
+    check(result.skipped == 200, "column quantiles skip missing cells and cells that are not numbers");
+    check(result.minimum == values.front() && result.maximum == values.back(), "column quantiles keep the minimum and maximum");
+    check(result.quantiles.size() == 2 && fabs(rankOf(values, result.quantiles[0]) - 0.5) <= rankBound(0.5), "column median is within the rank bound");
+    check(result.quantiles.size() == 2 && fabs(rankOf(values, result.quantiles[1]) - 0.99) <= rankBound(0.99), "column p99 is within the rank bound");
+}
+
+static void testParsePercentiles(){
+    vector<double> ranks;
+    check(parsePercentiles("50, 95, 99.9", ranks) && ranks.size() == 3 && ranks[0] == 0.5 && fabs(ranks[1] - 0.95) < 1e-12 && fabs(ranks[2] - 0.999) < 1e-12, "percentiles parse to ranks");
+    check(parsePercentiles("0,100", ranks), "0 and 100 are percentiles");
+    check(!parsePercentiles("101", ranks), "percentile over 100 is refused");
+    check(!parsePercentiles("50,,90", ranks), "empty percentile is refused");
+    check(!parsePercentiles("p50", ranks), "percentile that is not a number is refused");
+}
+
+int main(){
+    // More than one thread, so the column step merges digests.
+    setComputeThreadCount(4);
+
+    testErrorBounds();
+    testColumnQuantiles();
+    testParsePercentiles();
+
+    if (failures > 0){
+        cerr << failures << " check(s) failed." << endl;
+        return 1;
+    }
+    cout << "All quantile sketch checks passed." << endl;
+    return 0;
+}
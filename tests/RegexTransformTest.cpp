@@ -0,0 +1,121 @@
+// Regex transform: fields extracted from the lines of a text split over several
+// threads come in line order and match std::regex on each line, whichever engine
+// the library was built with; compiled patterns are shared and bad ones refused.
+#include <iostream>
+#include <random>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "LineIndex.h"
+#include "RegexTransform.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool condition, const string &what){
+    if (!condition){
+        cerr << "FAILED: " << what << endl;
+        ++failures;
+    }
+}
+
+// Log lines, some without the optional duration and some not matching at all. The
+// last line has no newline.
+static string makeLog(size_t lineCount){
+    static const char *levels[] = {"INFO", "WARN", "ERROR"};
+    mt19937 random(5);
+    string text;
+    for (size_t line = 0; line < lineCount; ++line){
+        if (line > 0){
+            text += '\n';
+        }
+        switch (random() % 4){
+            case 0:
+                text += "-- rotated --";
+                break;
+            case 1:
+                text += "2026-10-18 level=" + string(levels[random() % 3]) + " user=u" + to_string(random() % 1000);
+                break;
+            default:
+                text += "2026-10-18 level=" + string(levels[random() % 3]) + " user=u" + to_string(random() % 1000) + " took " + to_string(random() % 500) + "ms";
+        }
+    }
+    return text;
+}
+
+// Fields of every matching line, found with std::regex one line at a time.
+static vector<vector<string>> expectedRows(const string &text, const string &pattern){
+    regex expression(pattern);
+    vector<vector<string>> rows;
+    size_t start = 0;
+    while (start <= text.size()){
+        size_t end = text.find('\n', start);
+        string line = text.substr(start, end == string::npos ? string::npos : end - start);
+        smatch match;
+        if (regex_search(line, match, expression)){
+            vector<string> fields;
+            for (size_t group = match.size() > 1 ? 1 : 0; group < match.size(); ++group){
+                fields.push_back(match[group].matched ? match[group].str() : string());
+            }
+            rows.push_back(fields);
+        }
+        if (end == string::npos){
+            break;
+        }
+        start = end + 1;
+    }
+    return rows;
+}
+
+static void testExtraction(){
+    // More lines than one chunk holds, so the chunks must be joined in order.
+    string text = makeLog(60000);
+    LineIndex index(text);
+    for (const string &pattern : {string("level=(\\w+) user=(u\\d+)(?: took (\\d+)ms)?"), string("u\\d+ took \\d+ms$"), string("^-- (\\w+)")}){
+        shared_ptr<const CompiledRegex> regex = compileRegex(pattern);
+        RegexTransformResult result = transformLines(text, index, *regex);
+        vector<vector<string>> expected = expectedRows(text, pattern);
+        check(!expected.empty(), pattern + " matches some lines");
+        check(result.linesChecked == 60000, pattern + " checks every line");
+        check(result.rows == expected, pattern + " extracts the fields of std::regex in line order (" + CompiledRegex::getEngineName() + ")");
+    }
+}
+
+static void testCompile(){
+    CompiledRegex regex("(a)(b)?c");
+    check(regex.getGroupCount() == 2, "groups are counted");
+    vector<string> fields;
+    check(regex.extract("xxacx", fields) && fields == vector<string>({"a", ""}), "a group that took no part is empty");
+    check(!regex.extract("xyz", fields), "line without a match extracts nothing");
+
+    check(compileRegex("a+b") == compileRegex("a+b"), "a compiled pattern is shared");
+    bool refused = false;
+    try{
+        compileRegex("(unclosed");
+    }catch (const invalid_argument &){
+        refused = true;
+    }
+    check(refused, "invalid pattern is refused");
+
+    LineIndex empty;
+    check(transformLines("", empty, regex).rows.empty(), "empty text has no rows");
+}
+
+int main(){
+    // More than one thread, so chunks are matched in parallel.
+    setComputeThreadCount(4);
+
+    testExtraction();
+    testCompile();
+
+    if (failures > 0){
+        cerr << failures << " check(s) failed." << endl;
+        return 1;
+    }
+    cout << "All regex transform checks passed." << endl;
+    return 0;
+}
@@ -0,0 +1,177 @@
+// Result cache: a run is found again only for the same flow definition, answers and
+// input contents; a glob input misses once another file matches it; the least
+// recently used runs are evicted past the capacity, and the entries outlive the
+// process that stored them.
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#include <vector>
+
+#include "Flow.h"
+#include "FlowSteps.h"
+#include "ResultCache.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool condition, const string &what){
+    if (!condition){
+        cerr << "FAILED: " << what << endl;
+        ++failures;
+    }
+}
+
+static void writeFile(const string &fileName, const string &contents){
+    ofstream file(fileName, ios::trunc);
+    file << contents;
+}
+
+// Writes fileName and dates it at second, so that a rewrite is seen as one even
+// where modification times are coarse.
+static void writeDated(const string &fileName, const string &contents, time_t second){
+    writeFile(fileName, contents);
+    utimbuf times{second, second};
+    utime(fileName.c_str(), &times);
+}
+
+static RecordedRun makeRun(const vector<string> &answers, const vector<RunInput> &inputs, const string &printed){
+    RecordedRun run;
+    run.answers = answers;
+    run.inputs = inputs;
+    run.outputs.push_back(RunOutput{RunOutput::Text, printed, ""});
+    run.outputs.push_back(RunOutput{RunOutput::File, "total,3\n", "report.csv"});
+    run.outputs.push_back(RunOutput{RunOutput::Error, "Error: one row skipped\n", ""});
+    return run;
+}
+
+static bool found(uint64_t flowHash, const vector<string> &queued){
+    RecordedRun run;
+    return ResultCache::instance().lookup(flowHash, queued, run);
+}
+
+static void testFlowHash(){
+    Flow flow("Report");
+    flow.addStep(new TextInputStep("name"));
+    flow.addStep(new CSVFileInputStep("table"));
+    Flow same("Report");
+    same.addStep(new TextInputStep("name"));
+    same.addStep(new CSVFileInputStep("table"));
+    Flow configured("Report");
+    configured.addStep(new TextInputStep("other name"));
+    configured.addStep(new CSVFileInputStep("table"));
+    Flow renamed("Other report");
+    renamed.addStep(new TextInputStep("name"));
+    renamed.addStep(new CSVFileInputStep("table"));
+    Flow reordered("Report");
+    reordered.addStep(new CSVFileInputStep("table"));
+    reordered.addStep(new TextInputStep("name"));
+
+    uint64_t hash = ResultCache::hashFlow(flow);
+    check(hash == ResultCache::hashFlow(same), "the same definition hashes the same");
+    check(hash != ResultCache::hashFlow(configured), "a step configuration is part of the hash");
+    check(hash != ResultCache::hashFlow(renamed), "the flow name is part of the hash");
+    check(hash != ResultCache::hashFlow(reordered), "the step order is part of the hash");
+}
+
+static void testKeying(){
+    ResultCache &cache = ResultCache::instance();
+    writeDated("input.csv", "a,1\nb,2\n", 1000);
+    vector<RunInput> inputs = {RunInput{"input.csv", ""}};
+    cache.store(1, makeRun({"Y", "input.csv"}, inputs, "Flow Completed!\n"));
+
+    RecordedRun run;
+    check(cache.lookup(1, {"Y", "input.csv"}, run), "a stored run is found");
+    check(run.outputs.size() == 3 && run.outputs[0].text == "Flow Completed!\n" && run.outputs[1].kind == RunOutput::File
+          && run.outputs[1].fileName == "report.csv" && run.outputs[2].kind == RunOutput::Error, "the outputs come back in order");
+    check(found(1, {"Y", "input.csv", "more", "answers"}), "answers queued past the run's own still find it");
+    check(!found(1, {"Y", "other.csv"}), "other answers miss");
+    check(!found(1, {"Y"}), "fewer answers miss");
+    check(!found(2, {"Y", "input.csv"}), "another flow misses");
+
+    // Same size, other contents: the content hash tells them apart.
+    writeDated("input.csv", "a,1\nb,3\n", 2000);
+    check(!found(1, {"Y", "input.csv"}), "a changed input misses");
+    writeDated("input.csv", "a,1\nb,2\n", 3000);
+    check(found(1, {"Y", "input.csv"}), "the input changed back hits again");
+    utime("input.csv", nullptr);
+    check(found(1, {"Y", "input.csv"}), "an input only touched still hits");
+    remove("input.csv");
+    check(!found(1, {"Y", "input.csv"}), "a deleted input misses");
+
+    cache.store(1, makeRun(vector<string>(ResultCache::MAX_ANSWERS + 1, "Y"), {}, "long"));
+    check(!found(1, vector<string>(ResultCache::MAX_ANSWERS + 1, "Y")), "a run of too many answers is not kept");
+}
+
+static void testGlobInput(){
+    mkdir("parts", 0755);
+    writeFile("parts/1.csv", "x\n");
+    writeFile("parts/2.csv", "y\n");
+    vector<RunInput> inputs = {RunInput{"parts/*.csv", ".csv"}};
+    ResultCache::instance().store(3, makeRun({"parts/*.csv"}, inputs, "two parts\n"));
+    check(found(3, {"parts/*.csv"}), "a run of a glob import is found");
+
+    writeFile("parts/notes.txt", "not a part\n");
+    check(found(3, {"parts/*.csv"}), "a file the glob does not match is ignored");
+    writeFile("parts/3.csv", "z\n");
+    check(!found(3, {"parts/*.csv"}), "a file newly matching the glob misses");
+    remove("parts/3.csv");
+    check(found(3, {"parts/*.csv"}), "the glob matching the same files again hits");
+}
+
+static void testEviction(const string &directory){
+    ResultCache &cache = ResultCache::instance();
+    string printed(2000, 'x');
+    cache.open(directory, 7000);
+    for (int run = 0; run < 3; ++run){
+        cache.store(10 + run, makeRun({to_string(run)}, {}, printed));
+    }
+    check(cache.getEntryCount() == 3 && cache.getEvictions() == 0, "runs within the capacity are kept");
+    // Used last, so the run stored first is no longer the least recently used.
+    check(found(10, {"0"}), "the first run is found");
+    cache.store(13, makeRun({"3"}, {}, printed));
+    check(cache.getEvictions() == 1 && cache.getUsedBytes() <= 7000, "a run past the capacity evicts one");
+    check(found(10, {"0"}) && !found(11, {"1"}), "the least recently used run is the one evicted");
+
+    // A new process indexes what the last one left.
+    cache.open(directory, 7000);
+    check(cache.getEntryCount() == 3, "entries are indexed again when the cache is opened");
+    check(found(12, {"2"}) && found(13, {"3"}), "entries of an earlier process are found");
+    cache.open(directory, 3000);
+    check(cache.getEntryCount() == 1 && cache.getUsedBytes() <= 3000, "opening with a smaller capacity evicts down to it");
+
+    uint64_t stores = cache.getStores();
+    cache.open(directory, 0);
+    check(!cache.isEnabled(), "a capacity of 0 turns the cache off");
+    cache.store(20, makeRun({"off"}, {}, "off"));
+    check(cache.getStores() == stores && !found(20, {"off"}), "nothing is stored or found while the cache is off");
+}
+
+int main(){
+    char directory[] = "/tmp/resultcachetestXXXXXX";
+    if (mkdtemp(directory) == nullptr || chdir(directory) != 0){
+        cerr << "Cannot create a working directory." << endl;
+        return 1;
+    }
+    ResultCache::instance().open("cache", 1024 * 1024);
+
+    testFlowHash();
+    testKeying();
+    testGlobInput();
+    testEviction("evicted");
+    filesystem::remove_all(directory);
+
+    if (failures > 0){
+        cerr << failures << " check(s) failed." << endl;
+        return 1;
+    }
+    cout << "All result cache checks passed." << endl;
+    return 0;
+}
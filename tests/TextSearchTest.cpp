@@ -0,0 +1,179 @@
+// Text search: the Aho-Corasick matcher reports every occurrence a naive search
+// finds, for one start byte, a few and more than its vector skip handles, and a
+// search through the trigram index returns the same lines and counts as a scan.
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "TextSearch.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool condition, const string &what){
+    if (!condition){
+        cerr << "FAILED: " << what << endl;
+        ++failures;
+    }
+}
+
+static string lower(string text){
+    for (char &c : text){
+        if (c >= 'A' && c <= 'Z'){
+            c += 'a' - 'A';
+        }
+    }
+    return text;
+}
+
+// Lines of up to 80 letters from a-j and A-J with spaces, ending with a newline.
+static string makeText(size_t lineCount){
+    static const string alphabet = "abcdefghijABCDEFGHIJ ";
+    mt19937 random(11);
+    string text;
+    for (size_t line = 0; line < lineCount; ++line){
+        size_t length = random() % 81;
+        for (size_t i = 0; i < length; ++i){
+            text += alphabet[random() % alphabet.size()];
+        }
+        text += '\n';
+    }
+    return text;
+}
+
+// Every (pattern, end) pair of a naive search, overlapping matches included.
+static vector<pair<uint32_t, size_t>> naiveMatches(const string &text, const vector<string> &patterns, bool ignoreCase){
+    string haystack = ignoreCase ? lower(text) : text;
+    vector<pair<uint32_t, size_t>> matches;
+    for (uint32_t pattern = 0; pattern < patterns.size(); ++pattern){
+        string needle = ignoreCase ? lower(patterns[pattern]) : patterns[pattern];
+        for (size_t at = haystack.find(needle); at != string::npos; at = haystack.find(needle, at + 1)){
+            matches.emplace_back(pattern, at + needle.size());
+        }
+    }
+    sort(matches.begin(), matches.end());
+    return matches;
+}
+
+static vector<pair<uint32_t, size_t>> scanMatches(const string &text, const vector<string> &patterns, bool ignoreCase){
+    MultiPatternMatcher matcher(patterns, ignoreCase);
+    vector<pair<uint32_t, size_t>> matches;
+    matcher.scan(text.data(), text.size(), [&](uint32_t pattern, size_t end){
+        matches.emplace_back(pattern, end);
+        return true;
+    });
+    sort(matches.begin(), matches.end());
+    return matches;
+}
+
+static void testParsePatterns(){
+    check(parseSearchPatterns("ERROR|timed out||panic|") == vector<string>({"ERROR", "timed out", "panic"}), "patterns split on bars without empty ones");
+    check(parseSearchPatterns("").empty(), "empty text has no patterns");
+}
+
+static void testMatcher(){
+    string text = makeText(2000);
+    vector<vector<string>> patternSets = {
+        {"abc"},
+        {"aa", "aaa", "ab", "ba", "bab", "Ab"},
+        {"ab", "bc", "cd", "de", "ef", "fg", "gh", "hi", "ij", "ja", "abc", "j j"},
+    };
+    for (const vector<string> &patterns : patternSets){
+        string name = to_string(patterns.size()) + " pattern(s)";
+        for (bool ignoreCase : {false, true}){
+            vector<pair<uint32_t, size_t>> expected = naiveMatches(text, patterns, ignoreCase);
+            check(!expected.empty(), name + " occur in the text");
+            check(scanMatches(text, patterns, ignoreCase) == expected, name + (ignoreCase ? " ignoring case" : "") + " find every occurrence");
+        }
+    }
+
+    MultiPatternMatcher matcher({"abc"}, false);
+    size_t calls = 0;
+    matcher.scan(text.data(), text.size(), [&](uint32_t, size_t){
+        return ++calls < 3;
+    });
+    check(calls == 3, "scan stops when the visitor returns false");
+}
+
+// Lines holding any pattern, and the lines holding each one, found line by line.
+static void naiveSearch(const string &text, const vector<string> &patterns, bool ignoreCase, vector<size_t> &lines, vector<uint64_t> &patternLines){
+    lines.clear();
+    patternLines.assign(patterns.size(), 0);
+    size_t line = 0;
+    for (size_t start = 0; start < text.size(); ++line){
+        size_t end = text.find('\n', start);
+        string content = text.substr(start, end - start);
+        if (ignoreCase){
+            content = lower(content);
+        }
+        bool found = false;
+        for (size_t pattern = 0; pattern < patterns.size(); ++pattern){
+            if (content.find(ignoreCase ? lower(patterns[pattern]) : patterns[pattern]) != string::npos){
+                patternLines[pattern]++;
+                found = true;
+            }
+        }
+        if (found){
+            lines.push_back(line);
+        }
+        start = end + 1;
+    }
+}
+
+static void checkSearch(const string &text, const TrigramIndex &index, const vector<string> &patterns, bool ignoreCase, bool expectIndex){
+    string name = patterns[0] + (ignoreCase ? " ignoring case" : "");
+    vector<size_t> expectedLines;
+    vector<uint64_t> expectedCounts;
+    naiveSearch(text, patterns, ignoreCase, expectedLines, expectedCounts);
+    check(!expectedLines.empty(), name + " occurs in the text");
+
+    MultiPatternMatcher matcher(patterns, ignoreCase);
+    for (const TrigramIndex *used : {static_cast<const TrigramIndex *>(nullptr), &index}){
+        string how = used ? " with the index" : " by a scan";
+        SearchResult result = searchText(text, matcher, patterns, used);
+        check(result.usedIndex == (used && expectIndex), name + how + " looks up the index only when every pattern is long enough");
+        vector<size_t> lines;
+        bool bounds = true;
+        for (const SearchHit &hit : result.hits){
+            lines.push_back(hit.line);
+            bounds = bounds && hit.begin == index.getLineStart(hit.line) && hit.end == index.getLineEnd(hit.line);
+        }
+        check(lines == expectedLines, name + how + " returns the matching lines in order");
+        check(bounds, name + how + " returns the bytes of each line");
+        check(result.patternLines == expectedCounts, name + how + " counts the lines of each pattern");
+        if (result.usedIndex){
+            check(result.linesChecked < index.getLineCount(), name + " checks fewer lines with the index");
+        }
+    }
+}
+
+static void testIndexedSearch(){
+    string text = makeText(50000);
+    TrigramIndex index(text);
+    check(index.getLineCount() == 50000, "index has every line");
+
+    vector<uint32_t> candidates;
+    check(!index.findCandidates({"abc", "de"}, candidates), "a pattern of two bytes cannot be looked up");
+
+    checkSearch(text, index, {"abc", "hij", "dJa"}, false, true);
+    checkSearch(text, index, {"abc", "hij", "dJa"}, true, true);
+    checkSearch(text, index, {"aBcD", "ij ji"}, true, true);
+    checkSearch(text, index, {"abc", "hi"}, false, false);
+}
+
+int main(){
+    testParsePatterns();
+    testMatcher();
+    testIndexedSearch();
+
+    if (failures > 0){
+        cerr << failures << " check(s) failed." << endl;
+        return 1;
+    }
+    cout << "All text search checks passed." << endl;
+    return 0;
+}
@@ -0,0 +1,127 @@
+// Text statistics: the counts of a text split over several threads match a count
+// made in one pass, with and without case folding, and the top tokens come most
+// frequent first with ties in byte order.
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "TextStats.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool condition, const string &what){
+    if (!condition){
+        cerr << "FAILED: " << what << endl;
+        ++failures;
+    }
+}
+
+// Words with punctuation inside and around tokens, UTF-8 letters and mixed case,
+// separated by every kind of whitespace.
+static string makeText(size_t bytes){
+    static const vector<string> words = {"the", "The", "THE", "flow", "step-by-step", "(x_1,", "y2)", "h\xc3\xa9llo", "--", "a.b.c", "end.", "42", "Flow"};
+    static const string spaces = " \t\n\r\v\f";
+    mt19937 random(3);
+    string text;
+    while (text.size() < bytes){
+        // Skewed, so the top of the table is not a tie.
+        size_t word = min(random() % words.size(), random() % words.size());
+        text += words[word];
+        text += random() % 8 == 0 ? spaces[random() % spaces.size()] : ' ';
+    }
+    return text;
+}
+
+static bool isSpace(char c){
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+static bool isTokenByte(char c){
+    unsigned char byte = static_cast<unsigned char>(c);
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || byte >= 0x80;
+}
+
+static TextStats countOnce(const string &text, size_t topCount, bool ignoreCase){
+    TextStats stats;
+    stats.bytes = text.size();
+    map<string, uint64_t> table;
+    string token;
+    bool inWord = false;
+    for (size_t i = 0; i <= text.size(); ++i){
+        char c = i < text.size() ? text[i] : ' ';
+        if (c == '\n'){
+            stats.lines++;
+        }
+        if (!isSpace(c) && !inWord){
+            stats.words++;
+        }
+        inWord = !isSpace(c);
+        if (isTokenByte(c)){
+            token += ignoreCase && c >= 'A' && c <= 'Z' ? static_cast<char>(c + 'a' - 'A') : c;
+        }
+        else if (!token.empty()){
+            table[token]++;
+            stats.tokens++;
+            token.clear();
+        }
+    }
+    stats.distinctTokens = table.size();
+    for (const auto &[name, count] : table){
+        stats.topTokens.push_back(TokenCount{name, count});
+    }
+    stable_sort(stats.topTokens.begin(), stats.topTokens.end(), [](const TokenCount &a, const TokenCount &b){
+        return a.count > b.count;
+    });
+    if (stats.topTokens.size() > topCount){
+        stats.topTokens.resize(topCount);
+    }
+    return stats;
+}
+
+static void checkSame(const TextStats &actual, const TextStats &expected, const string &name){
+    check(actual.lines == expected.lines, name + " counts the lines");
+    check(actual.words == expected.words, name + " counts the words");
+    check(actual.bytes == expected.bytes, name + " counts the bytes");
+    check(actual.tokens == expected.tokens, name + " counts the tokens");
+    check(actual.distinctTokens == expected.distinctTokens, name + " counts the distinct tokens");
+    bool sameTop = actual.topTokens.size() == expected.topTokens.size();
+    for (size_t i = 0; sameTop && i < actual.topTokens.size(); ++i){
+        sameTop = actual.topTokens[i].token == expected.topTokens[i].token && actual.topTokens[i].count == expected.topTokens[i].count;
+    }
+    check(sameTop, name + " lists the top tokens in order");
+}
+
+static void testCounts(){
+    // Several megabytes, so the text is split into a chunk per thread.
+    string text = makeText(6 * 1024 * 1024);
+    checkSame(computeTextStats(text, 5, false), countOnce(text, 5, false), "split text");
+    checkSame(computeTextStats(text, 100, true), countOnce(text, 100, true), "split text ignoring case");
+
+    string small = "one two  two\nthree three three\n";
+    checkSame(computeTextStats(small, 10, false), countOnce(small, 10, false), "short text");
+    TextStats stats = computeTextStats(small, 2, false);
+    check(stats.topTokens.size() == 2 && stats.topTokens[0].token == "three" && stats.topTokens[1].token == "two", "top tokens are cut at the count asked for");
+
+    TextStats empty = computeTextStats("", 10, false);
+    check(empty.lines == 0 && empty.words == 0 && empty.tokens == 0 && empty.topTokens.empty(), "empty text counts nothing");
+}
+
+int main(){
+    // More than one thread, so the chunks are counted apart and merged.
+    setComputeThreadCount(4);
+
+    testCounts();
+
+    if (failures > 0){
+        cerr << failures << " check(s) failed." << endl;
+        return 1;
+    }
+    cout << "All text statistics checks passed." << endl;
+    return 0;
+}
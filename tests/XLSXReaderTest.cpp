@@ -0,0 +1,267 @@
+// XLSX import: rows of a workbook built here come back with shared, inline, rich and
+// boolean cells decoded and placed by their references, a long deflated sheet is
+// streamed whole, sheets are chosen by name or position, and files that are not
+// workbooks or have corrupt sheet data are refused.
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include <zlib.h>
+
+#include "XLSXReader.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool condition, const string &what){
+    if (!condition){
+        cerr << "FAILED: " << what << endl;
+        ++failures;
+    }
+}
+
+static void appendLittleEndian(string &output, uint32_t value, size_t count){
+    for (size_t i = 0; i < count; ++i){
+        output += static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+}
+
+static string rawDeflate(const string &data){
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    deflateInit2(&stream, 6, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+    string output(deflateBound(&stream, data.size()) + 32, '\0');
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef *>(&output[0]);
+    stream.avail_out = static_cast<uInt>(output.size());
+    deflate(&stream, Z_FINISH);
+    output.resize(stream.total_out);
+    deflateEnd(&stream);
+    return output;
+}
+
+struct ZipFile{
+    string name;
+    string contents;
+    bool deflated;
+};
+
+// A zip archive of files, stored or deflated, with a central directory.
+static void writeZip(const string &fileName, const vector<ZipFile> &files, bool damageCRC = false){
+    string archive;
+    string directory;
+    for (const ZipFile &file : files){
+        string data = file.deflated ? rawDeflate(file.contents) : file.contents;
+        uint32_t crc = static_cast<uint32_t>(crc32(0, reinterpret_cast<const Bytef *>(file.contents.data()), static_cast<uInt>(file.contents.size())));
+        if (damageCRC){
+            crc ^= 1;
+        }
+        uint32_t offset = static_cast<uint32_t>(archive.size());
+        string fields;
+        appendLittleEndian(fields, 0, 2);
+        appendLittleEndian(fields, file.deflated ? 8 : 0, 2);
+        appendLittleEndian(fields, 0, 4);
+        appendLittleEndian(fields, crc, 4);
+        appendLittleEndian(fields, static_cast<uint32_t>(data.size()), 4);
+        appendLittleEndian(fields, static_cast<uint32_t>(file.contents.size()), 4);
+        appendLittleEndian(fields, static_cast<uint32_t>(file.name.size()), 2);
+        appendLittleEndian(fields, 0, 2);
+
+        appendLittleEndian(archive, 0x04034b50, 4);
+        appendLittleEndian(archive, 20, 2);
+        archive += fields + file.name + data;
+
+        appendLittleEndian(directory, 0x02014b50, 4);
+        appendLittleEndian(directory, 20, 2);
+        appendLittleEndian(directory, 20, 2);
+        directory += fields;
+        appendLittleEndian(directory, 0, 2);
+        appendLittleEndian(directory, 0, 2);
+        appendLittleEndian(directory, 0, 2);
+        appendLittleEndian(directory, 0, 4);
+        appendLittleEndian(directory, offset, 4);
+        directory += file.name;
+    }
+    uint32_t directoryOffset = static_cast<uint32_t>(archive.size());
+    archive += directory;
+    appendLittleEndian(archive, 0x06054b50, 4);
+    appendLittleEndian(archive, 0, 4);
+    appendLittleEndian(archive, static_cast<uint32_t>(files.size()), 2);
+    appendLittleEndian(archive, static_cast<uint32_t>(files.size()), 2);
+    appendLittleEndian(archive, static_cast<uint32_t>(directory.size()), 4);
+    appendLittleEndian(archive, directoryOffset, 4);
+    appendLittleEndian(archive, 0, 2);
+    ofstream output(fileName, ios::binary | ios::trunc);
+    output << archive;
+}
+
+static const string WORKBOOK =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+    "<workbook xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\">"
+    "<sheets><sheet name=\"Data\" sheetId=\"1\" r:id=\"rId1\"/><sheet name=\"Long &amp; deflated\" sheetId=\"2\" r:id=\"rId2\"/></sheets></workbook>";
+
+static const string RELATIONS =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+    "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+    "<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/worksheet\" Target=\"worksheets/sheet1.xml\"/>"
+    "<Relationship Id=\"rId2\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/worksheet\" Target=\"/xl/worksheets/long.xml\"/>"
+    "<Relationship Id=\"rId3\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/sharedStrings\" Target=\"strings.xml\"/>"
+    "</Relationships>";
+
+// Plain text, rich text runs with a phonetic hint that is not part of the value,
+// an entity and an escaped line break.
+static const string SHARED_STRINGS =
+    "<sst xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" count=\"4\" uniqueCount=\"4\">"
+    "<si><t>name</t></si>"
+    "<si><r><rPr><b/></rPr><t xml:space=\"preserve\">Ada </t></r><r><t>Lovelace</t></r><rPh sb=\"0\" eb=\"1\"><t>ignored</t></rPh></si>"
+    "<si><t>a &amp; b</t></si>"
+    "<si><t>line_x000A_break</t></si>"
+    "</sst>";
+
+// Row 2 is left out and cell B3 is missing; the cells of row 5 have no references.
+static const string SHEET =
+    "<worksheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\"><sheetData>"
+    "<row r=\"1\"><c r=\"A1\" t=\"s\"><v>0</v></c><c r=\"B1\" t=\"s\"><v>1</v></c></row>"
+    "<row r=\"3\"><c r=\"A3\"><v>42.5</v></c><c r=\"C3\" t=\"b\"><v>1</v></c><c r=\"D3\" t=\"inlineStr\"><is><t>x &lt; y</t></is></c></row>"
+    "<row r=\"4\"><c r=\"B4\" t=\"s\"><v>2</v></c><c r=\"AA4\" t=\"s\"><v>3</v></c></row>"
+    "<row><c t=\"str\"><f>UPPER(\"calc\")</f><v>CALC</v></c><c t=\"b\"><v>0</v></c></row>"
+    "</sheetData></worksheet>";
+
+static const size_t LONG_ROWS = 50000;
+
+static string longSheet(){
+    string sheet = "<worksheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\"><sheetData>";
+    for (size_t row = 1; row <= LONG_ROWS; ++row){
+        string number = to_string(row);
+        sheet += "<row r=\"" + number + "\"><c r=\"A" + number + "\"><v>" + number + "</v></c><c r=\"B" + number + "\" t=\"inlineStr\"><is><t>row " + number + "</t></is></c></row>";
+    }
+    return sheet + "</sheetData></worksheet>";
+}
+
+static vector<ZipFile> workbookFiles(const string &sheet){
+    return {
+        {"[Content_Types].xml", "<Types/>", false},
+        {"xl/workbook.xml", WORKBOOK, true},
+        {"xl/_rels/workbook.xml.rels", RELATIONS, false},
+        {"xl/strings.xml", SHARED_STRINGS, true},
+        {"xl/worksheets/sheet1.xml", sheet, false},
+        {"xl/worksheets/long.xml", longSheet(), true},
+    };
+}
+
+static vector<vector<string>> readSheet(const string &fileName, const string &sheet){
+    XLSXSheetReader reader(fileName, sheet);
+    vector<vector<string>> rows;
+    vector<string> row;
+    while (reader.nextRow(row)){
+        rows.push_back(row);
+    }
+    return rows;
+}
+
+// Runs read and returns the message of the runtime_error it throws, or "" if none.
+template <typename Read>
+static string errorOf(Read read){
+    try{
+        read();
+    }catch (const runtime_error &e){
+        return e.what();
+    }
+    return "";
+}
+
+static void testCells(){
+    writeZip("book.xlsx", workbookFiles(SHEET));
+    XLSXSheetReader reader("book.xlsx");
+    check(reader.getSheetNames() == vector<string>({"Data", "Long & deflated"}), "sheets are listed in tab order");
+    check(reader.getSheetName() == "Data", "the first sheet is read by default");
+
+    vector<vector<string>> rows = readSheet("book.xlsx", "");
+    vector<string> fourth(27);
+    fourth[1] = "a & b";
+    fourth[26] = "line\nbreak";
+    vector<vector<string>> expected = {
+        {"name", "Ada Lovelace"},
+        {},
+        {"42.5", "", "TRUE", "x < y"},
+        fourth,
+        {"CALC", "FALSE"},
+    };
+    check(rows == expected, "cells are decoded and placed by their references");
+}
+
+static void testLongSheet(){
+    XLSXSheetReader reader("book.xlsx", "Long & deflated");
+    size_t count = 0;
+    bool inOrder = true;
+    vector<string> row;
+    while (reader.nextRow(row)){
+        ++count;
+        inOrder = inOrder && row == vector<string>({to_string(count), "row " + to_string(count)});
+    }
+    check(count == LONG_ROWS && inOrder, "every row of a long deflated sheet is read in order");
+    check(reader.getBytesRead() == longSheet().size(), "the whole sheet part is parsed");
+    check(readSheet("book.xlsx", "2").size() == LONG_ROWS, "a sheet is chosen by its position");
+    check(errorOf([]{readSheet("book.xlsx", "Missing");}).find("no sheet 'Missing'") != string::npos, "a missing sheet is refused");
+    check(errorOf([]{readSheet("book.xlsx", "3");}) != "", "a sheet position past the last is refused");
+}
+
+static void testRefused(){
+    {
+        ofstream text("plain.xlsx");
+        text << "a,b\n1,2\n";
+    }
+    check(errorOf([]{XLSXSheetReader reader("plain.xlsx");}).find("not a zip archive") != string::npos, "a file that is not a zip archive is refused");
+
+    writeZip("other.zip", {{"readme.txt", "hello", false}});
+    check(errorOf([]{XLSXSheetReader reader("other.zip");}).find("not an XLSX workbook") != string::npos, "a zip archive without a workbook is refused");
+
+    writeZip("crc.xlsx", workbookFiles(SHEET), true);
+    check(errorOf([]{readSheet("crc.xlsx", "Data");}).find("CRC") != string::npos, "sheet data failing its checksum is refused");
+
+    string outOfOrder = "<worksheet><sheetData><row r=\"2\"><c><v>1</v></c></row><row r=\"1\"><c><v>2</v></c></row></sheetData></worksheet>";
+    writeZip("order.xlsx", workbookFiles(outOfOrder));
+    check(errorOf([]{readSheet("order.xlsx", "Data");}).find("out of order") != string::npos, "rows out of order are refused");
+
+    string truncated = "<worksheet><sheetData><row r=\"1\"><c><v>1</v></c>";
+    writeZip("truncated.xlsx", workbookFiles(truncated));
+    check(errorOf([]{readSheet("truncated.xlsx", "Data");}) != "", "sheet data ending inside a row is refused");
+
+    string missingString = "<worksheet><sheetData><row r=\"1\"><c t=\"s\"><v>9</v></c></row></sheetData></worksheet>";
+    writeZip("strings.xlsx", workbookFiles(missingString));
+    check(errorOf([]{readSheet("strings.xlsx", "Data");}).find("shared string") != string::npos, "a cell pointing past the shared strings is refused");
+}
+
+static void testDecodeText(){
+    check(decodeXMLText("a &amp; b &lt;&gt; &quot;&apos; &#65;&#x42;") == "a & b <> \"' AB", "XML entities and character references are decoded");
+}
+
+int main(){
+    char directory[] = "/tmp/xlsxreadertestXXXXXX";
+    if (mkdtemp(directory) == nullptr || chdir(directory) != 0){
+        cerr << "Cannot create a working directory." << endl;
+        return 1;
+    }
+
+    testCells();
+    testLongSheet();
+    testRefused();
+    testDecodeText();
+    filesystem::remove_all(directory);
+
+    if (failures > 0){
+        cerr << failures << " check(s) failed." << endl;
+        return 1;
+    }
+    cout << "All XLSX reader checks passed." << endl;
+    return 0;
+}
@@ -0,0 +1,189 @@
+// Local client for the FlowMaker server (FlowMaker --serve).
+//
+// Usage: flowmaker_client [--socket <path>] --list
+//        flowmaker_client [--socket <path>] [--answers <file>] <flow name>
+//
+// Runs the flow in a server session, printing its output and answering every prompt
+// with the next line of stdin. The session is abandoned when stdin ends.
+//
+// With --answers, every line of the file ("-" for stdin) is sent along with the
+// request, before the flow asks for it. The server can then prefetch the files the
+// answers name and replay a recorded run of the same answers. The flow's input ends
+// after the last line.
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "FlowProtocol.h"
+
+using namespace std;
+
+bool sendAll(int fd, const string &data){
+    size_t offset = 0;
+    while (offset < data.size()){
+        ssize_t sent = send(fd, data.data() + offset, data.size() - offset, MSG_NOSIGNAL);
+        if (sent < 0){
+            if (errno == EINTR){
+                continue;
+            }
+            return false;
+        }
+        offset += static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+bool sendFrame(int fd, FrameType type, const string &payload = ""){
+    string buffer;
+    appendFrame(buffer, type, payload);
+    return sendAll(fd, buffer);
+}
+
+// Blocks until a whole frame arrived. Returns false when the server closed the socket.
+bool receiveFrame(int fd, string &buffer, size_t &offset, Frame &frame){
+    while (!takeFrame(buffer, offset, frame)){
+        buffer.erase(0, offset);
+        offset = 0;
+        char chunk[64 * 1024];
+        ssize_t received = read(fd, chunk, sizeof(chunk));
+        if (received < 0 && errno == EINTR){
+            continue;
+        }
+        if (received <= 0){
+            return false;
+        }
+        buffer.append(chunk, static_cast<size_t>(received));
+    }
+    return true;
+}
+
+int main(int argc, char **argv){
+    string socketPath = FLOWS_SOCKET_FILE;
+    string flowName;
+    string answersFile;
+    bool listFlows = false;
+    for (int i = 1; i < argc; ++i){
+        string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc){
+            socketPath = argv[++i];
+        }
+        else if (arg == "--answers" && i + 1 < argc){
+            answersFile = argv[++i];
+        }
+        else if (arg == "--list"){
+            listFlows = true;
+        }
+        else if (flowName.empty() && arg.compare(0, 2, "--") != 0){
+            flowName = arg;
+        }
+        else{
+            flowName.clear();
+            listFlows = false;
+            break;
+        }
+    }
+    if (listFlows == !flowName.empty() || (listFlows && !answersFile.empty())){
+        cerr << "Usage: " << argv[0] << " [--socket <path>] (--list | [--answers <file>] <flow name>)" << endl;
+        return 1;
+    }
+
+    bool scripted = !answersFile.empty();
+    vector<string> answers;
+    if (scripted){
+        ifstream file;
+        if (answersFile != "-"){
+            file.open(answersFile);
+            if (!file.is_open()){
+                cerr << "Error: Unable to open the answers file '" << answersFile << "'." << endl;
+                return 1;
+            }
+        }
+        istream &lines = answersFile == "-" ? cin : file;
+        string line;
+        while (getline(lines, line)){
+            answers.push_back(line);
+        }
+    }
+
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)){
+        cerr << "Error: Socket path '" << socketPath << "' is too long." << endl;
+        return 1;
+    }
+    memcpy(address.sun_path, socketPath.c_str(), socketPath.size());
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0){
+        cerr << "Error: Unable to connect to '" << socketPath << "': " << strerror(errno) << endl;
+        return 1;
+    }
+
+    int status = 1;
+    try{
+        string request;
+        appendFrame(request, listFlows ? FrameType::List : FrameType::Start, flowName);
+        for (const string &answer : answers){
+            appendFrame(request, FrameType::Answer, answer);
+        }
+        if (!sendAll(fd, request)){
+            throw runtime_error("Unable to send the request.");
+        }
+        string buffer;
+        size_t offset = 0;
+        Frame frame;
+        bool done = false;
+        while (!done && receiveFrame(fd, buffer, offset, frame)){
+            switch (frame.type){
+            case FrameType::Output:
+                cout << frame.payload << flush;
+                break;
+            case FrameType::Names:
+                cout << frame.payload << flush;
+                status = 0;
+                done = true;
+                break;
+            case FrameType::Error:
+                cerr << frame.payload << flush;
+                break;
+            case FrameType::Input:{
+                // A scripted flow only asks once every answer sent ahead was used.
+                string answer;
+                if (!scripted && getline(cin, answer)){
+                    sendFrame(fd, FrameType::Answer, answer);
+                }
+                else{
+                    sendFrame(fd, FrameType::Quit);
+                }
+                break;
+            }
+            case FrameType::Done:
+                status = frame.payload == "ok" ? 0 : 1;
+                done = true;
+                break;
+            case FrameType::Refused:
+                cerr << "Error: " << frame.payload << endl;
+                done = true;
+                break;
+            default:
+                break;
+            }
+        }
+        if (!done){
+            cerr << "Error: The server closed the connection." << endl;
+        }
+    }catch (const exception &e){
+        cerr << "Error: " << e.what() << endl;
+        status = 1;
+    }
+    close(fd);
+    return status;
+}